@@ -1302,6 +1302,36 @@ PHI_DEFINE_EXPORTED_bool(
  */
 PHI_DEFINE_EXPORTED_bool(use_autotune, false, "Whether enable autotune.");
 
+/**
+ * Performance related FLAG
+ * Name: FLAGS_use_cpu_autotune
+ * Since Version: 3.0.0
+ * Value Range: bool, default=false
+ * Example:
+ * Note: If True, the CPU kernels with several implementations, e.g. the
+ * matmul of 2-D float tensors by blas or Eigen, time them on the first
+ * calls of each shape and use the fastest one afterwards.
+ */
+PHI_DEFINE_EXPORTED_bool(use_cpu_autotune,
+                         false,
+                         "Whether enable autotune of CPU kernels.");
+
+/**
+ * Performance related FLAG
+ * Name: FLAGS_cpu_autotune_cache_file
+ * Since Version: 3.0.0
+ * Value Range: string, default=""
+ * Example: FLAGS_cpu_autotune_cache_file=/path/to/cpu_autotune.txt
+ * Note: The file the CPU autotuning results are loaded from and saved to,
+ * keyed by the CPU model and instruction sets, so that the next process on
+ * the same kind of machine skips tuning. Only used when
+ * FLAGS_use_cpu_autotune is on, and nothing is persisted if empty. The new
+ * results are written at exit.
+ */
+PHI_DEFINE_EXPORTED_string(cpu_autotune_cache_file,
+                           "",
+                           "The file of the persisted CPU autotuning results.");
+
 /**
  * CINN training related FLAG
  * Name: FLAGS_disable_dyshape_in_train
@@ -1647,6 +1677,50 @@ PHI_DEFINE_EXPORTED_bool(enable_async_trace,
                          false,
                          "enable collective async trace");
 
+/**
+ * ProcessGroupGloo related FLAG
+ * Name: gloo_async_allreduce
+ * Since Version: 3.0.0
+ * Value Range: bool, default=false
+ * Example: FLAGS_gloo_async_allreduce=true
+ * Note: Whether the data parallel reducer allreduces the gradient buckets
+ *       asynchronously with gloo on CPU, overlapping with the backward.
+ */
+PHI_DEFINE_EXPORTED_bool(gloo_async_allreduce,
+                         false,
+                         "Whether to overlap the gloo allreduce of data "
+                         "parallel with the backward on CPU.");
+
+/**
+ * ProcessGroupGloo related FLAG
+ * Name: gloo_allreduce_comm_dtype
+ * Since Version: 3.0.0
+ * Value Range: string, {"", "float16", "bfloat16"}, default=""
+ * Example: FLAGS_gloo_allreduce_comm_dtype="bfloat16"
+ * Note: Data type of float32 gradients sent over the wire when the data
+ *       parallel reducer allreduces them with gloo on CPU, empty means no
+ *       conversion.
+ */
+PHI_DEFINE_EXPORTED_string(gloo_allreduce_comm_dtype,
+                           "",
+                           "Data type of float32 gradients in the gloo "
+                           "allreduce of data parallel, float16 or bfloat16.");
+
+/**
+ * Auto parallel related FLAG
+ * Name: enable_reshard_planner
+ * Since Version: 3.0.0
+ * Value Range: bool, default=true
+ * Example:
+ * Note: Whether the reshard on the same nd mesh follows the plan with the
+ *       fewest communicated bytes, instead of the fixed order of turning
+ *       every axis to replicated and then to the target status.
+ */
+PHI_DEFINE_EXPORTED_bool(enable_reshard_planner,
+                         true,
+                         "Whether to plan the nd mesh reshard by the "
+                         "communicated bytes.");
+
 PHI_DEFINE_EXPORTED_int32(async_trace_count, 5, "collective async trace count");
 
 PHI_DEFINE_EXPORTED_bool(
@@ -1858,6 +1932,62 @@ PHI_DEFINE_EXPORTED_string(
 PHI_DEFINE_EXPORTED_bool(enable_collect_shape,
                          false,
                          "Collect shapes of value for TensorRTEngine");
+
+/**
+ * Executor related FLAG
+ * Name: enable_op_metrics
+ * Since Version: 3.0.0
+ * Value Range: bool, default=false
+ * Example: FLAGS_enable_op_metrics=true will make the executors record
+ * per-operator latency histograms, see framework::OpMetrics.
+ */
+PHI_DEFINE_EXPORTED_bool(enable_op_metrics,
+                         false,
+                         "Record per-operator latency histograms in executor");
+
+/**
+ * Executor related FLAG
+ * Name: enable_pir_shape_specialization
+ * Since Version: 3.0.0
+ * Value Range: bool, default=false
+ * Example: FLAGS_enable_pir_shape_specialization=true will make a phi kernel
+ * instruction of PirInterpreter skip InferMeta if its inputs have the same
+ * metas as in the last run, and reuse the output metas of that run.
+ */
+PHI_DEFINE_EXPORTED_bool(
+    enable_pir_shape_specialization,
+    false,
+    "Skip InferMeta of the instructions whose input metas are unchanged");
+
+/**
+ * Executor related FLAG
+ * Name: enable_pir_cpu_replay
+ * Since Version: 3.0.0
+ * Value Range: bool, default=false
+ * Example: FLAGS_enable_pir_cpu_replay=true will make PirInterpreter replay
+ * the instructions of a cpu program as a flat list from the second run on,
+ * without dependency counting, scheduling and reference counting for gc.
+ * Note: Use it with FLAGS_enable_pir_shape_specialization to skip InferMeta
+ * as well when the input shapes do not change.
+ */
+PHI_DEFINE_EXPORTED_bool(enable_pir_cpu_replay,
+                         false,
+                         "Replay the instructions of cpu programs in order");
+
+/**
+ * Executor related FLAG
+ * Name: new_executor_batched_gc
+ * Since Version: 3.0.0
+ * Value Range: bool, default=false
+ * Example: FLAGS_new_executor_batched_gc=true will make the executors of cpu
+ * programs free the garbages in bulk, by one task per batch of 64 garbages or
+ * at the end of each run, instead of one task per variable.
+ * Note: A batch holds at most FLAGS_eager_delete_tensor_gb of memory, or 64 MB
+ * when it is 0, which bounds the extra peak memory.
+ */
+PHI_DEFINE_EXPORTED_bool(new_executor_batched_gc,
+                         false,
+                         "Free the garbages of cpu programs in batches");
 // Example: FLAGS_accuracy_check_atol=1e-3 would set the atol to 1e-3.
 PHI_DEFINE_EXPORTED_double(accuracy_check_atol_fp32,
                            1e-6,
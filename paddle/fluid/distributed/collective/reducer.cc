@@ -20,6 +20,8 @@
 
 PD_DECLARE_bool(use_stream_safe_cuda_allocator);
 COMMON_DECLARE_string(allocator_strategy);
+COMMON_DECLARE_bool(gloo_async_allreduce);
+COMMON_DECLARE_string(gloo_allreduce_comm_dtype);
 
 namespace paddle {
 namespace distributed {
@@ -29,6 +31,28 @@ static bool IsStreamSafeAllocator() {
           FLAGS_use_stream_safe_cuda_allocator);
 }
 
+// Gloo runs asynchronous allreduce on its communication thread, so the
+// fused allreduce on CPU overlaps with the rest of the backward.
+static bool IsAsyncCpuAllReduce(const phi::Place &place,
+                                const ProcessGroup &process_group) {
+  return FLAGS_gloo_async_allreduce && phi::is_cpu_place(place) &&
+         process_group.GetBackendName() == "GLOO";
+}
+
+static phi::DataType GlooAllReduceCommDtype() {
+  if (FLAGS_gloo_allreduce_comm_dtype.empty()) {
+    return phi::DataType::UNDEFINED;
+  } else if (FLAGS_gloo_allreduce_comm_dtype == "float16") {
+    return phi::DataType::FLOAT16;
+  } else if (FLAGS_gloo_allreduce_comm_dtype == "bfloat16") {
+    return phi::DataType::BFLOAT16;
+  }
+  PADDLE_THROW(common::errors::InvalidArgument(
+      "FLAGS_gloo_allreduce_comm_dtype should be empty, float16 or bfloat16, "
+      "but got %s.",
+      FLAGS_gloo_allreduce_comm_dtype));
+}
+
 static Backend TransToBackend(phi::Place place) {
   static const std::map<phi::AllocationType, Backend> type_backend = {
       {phi::AllocationType::GPU, Backend::GPU},
@@ -691,6 +715,7 @@ void EagerReducer::TraverseBackwardGraph(const std::vector<Tensor> &outputs) {
 void EagerReducer::PrepareForBackward(const std::vector<Tensor> &outputs) {
   VLOG(3) << "after forward, then reset count for backward.";
   grad_need_hooks_ = true;
+  async_cpu_allreduce_ = IsAsyncCpuAllReduce(inner_place_, *process_group_);
 
   next_group_ = 0;
   std::for_each(groups_.begin(), groups_.end(), [](EagerGroup &group) {
@@ -1065,7 +1090,7 @@ void EagerReducer::FinalizeBackward() {
   for (auto &group : groups_) {
     if (!group.is_sparse_) {
       group.task->Synchronize();
-      if (!IsStreamSafeAllocator()) {
+      if (!IsStreamSafeAllocator() || async_cpu_allreduce_) {
         auto *default_ctx =
             phi::DeviceContextPool::Instance().Get(inner_place_);
         group.SplitTensors(*default_ctx);
@@ -1086,6 +1111,7 @@ void EagerReducer::FinalizeBackward() {
 void EagerReducer::FusedAllReduceSchedule(EagerGroup *group,
                                           const int curr_group_index) {
   // The overall timeline: concat > div_nranks > allreduce > split
+  // NOTE: with gloo on CPU, the split is done in FinalizeBackward
   distributed::AllreduceOptions opts;
   opts.reduce_op = ReduceOp::SUM;
 
@@ -1105,6 +1131,11 @@ void EagerReducer::FusedAllReduceSchedule(EagerGroup *group,
   for (auto &t : reduce_tensors) {
     in_out.push_back(*std::dynamic_pointer_cast<phi::DenseTensor>(t.impl()));
   }
+  if (async_cpu_allreduce_) {
+    opts.comm_dtype = GlooAllReduceCommDtype();
+    group->task = process_group_->AllReduce(in_out, in_out, opts, false);
+    return;
+  }
   group->task = process_group_->AllReduce(in_out, in_out, opts);
 
   auto *context = process_group_->GetDeviceContext(inner_place_);
@@ -127,6 +127,9 @@ class EagerReducer {
   int64_t nranks_ = -1;
 
   bool grad_need_hooks_{false};
+  // allreduce the dense groups asynchronously in this backward, decided in
+  // PrepareForBackward
+  bool async_cpu_allreduce_{false};
 
   std::vector<bool> vars_marked_ready_;
   std::vector<int32_t> local_used_vars_;
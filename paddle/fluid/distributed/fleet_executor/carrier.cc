@@ -34,6 +34,14 @@ PHI_DEFINE_EXPORTED_bool(
     "Use standalone executor to run ops. Temporary FLAGS, will be removed "
     "after all fleet executor cases are modified to run ops with standalone "
     "executor.");
+PHI_DEFINE_EXPORTED_bool(
+    fleet_executor_local_channel,
+    true,
+    "Send messages between interceptors of the same carrier through lock "
+    "free channels instead of the carrier and message bus.");
+PHI_DEFINE_EXPORTED_int32(fleet_executor_local_channel_capacity,
+                          256,
+                          "Number of message slots of each local channel.");
 COMMON_DECLARE_bool(cache_inference_while_scope);
 
 namespace paddle {
@@ -247,6 +255,42 @@ bool Carrier::Send(const InterceptorMessage& msg) {
   return GlobalVal<MessageBus>::Get()->Send(dst_rank, msg);
 }
 
+InterceptorChannel* Carrier::GetChannel(int64_t src_id, int64_t dst_id) {
+  // the same checks as Send, done once per pair since the sender keeps the
+  // channel
+  int64_t src_rank = GetRank(src_id);
+  int64_t dst_rank = GetRank(dst_id);
+  PADDLE_ENFORCE_EQ(
+      src_rank,
+      rank_,
+      common::errors::Fatal("The source rank id %lld, which is not equal to "
+                            "the carrier rank id %lld.",
+                            src_rank,
+                            rank_));
+  if (!FLAGS_fleet_executor_local_channel || dst_rank != rank_) {
+    return nullptr;
+  }
+  auto dst = interceptor_idx_to_interceptor_.find(dst_id);
+  PADDLE_ENFORCE_NE(
+      dst,
+      interceptor_idx_to_interceptor_.end(),
+      common::errors::InvalidArgument(
+          "Cannot find interceptor instance for interceptor id %lld.", dst_id));
+
+  std::lock_guard<std::mutex> lock(channel_mutex_);
+  auto& channel = channels_[std::make_pair(src_id, dst_id)];
+  if (channel == nullptr) {
+    VLOG(3) << "Create local channel from interceptor " << src_id
+            << " to interceptor " << dst_id;
+    channel = std::make_unique<InterceptorChannel>(
+        src_id,
+        dst->second.get(),
+        static_cast<size_t>(FLAGS_fleet_executor_local_channel_capacity));
+    dst->second->AddInChannel(channel.get());
+  }
+  return channel.get();
+}
+
 Interceptor* Carrier::SetInterceptor(int64_t interceptor_id,
                                      std::unique_ptr<Interceptor> interceptor) {
   auto iter = interceptor_idx_to_interceptor_.find(interceptor_id);
@@ -15,6 +15,7 @@
 #pragma once
 
 #include <condition_variable>
+#include <map>
 #include <memory>
 #include <mutex>
 #include <set>
@@ -25,6 +26,7 @@
 #include "paddle/common/errors.h"
 #include "paddle/common/macros.h"
 #include "paddle/fluid/distributed/fleet_executor/interceptor.h"
+#include "paddle/fluid/distributed/fleet_executor/interceptor_channel.h"
 #include "paddle/fluid/distributed/fleet_executor/interceptor_message.pb.h"
 #include "paddle/fluid/distributed/fleet_executor/task_loop_thread_pool.h"
 #include "paddle/fluid/framework/variable.h"
@@ -89,6 +91,11 @@ class Carrier final {
 
   bool Send(const InterceptorMessage& msg);
 
+  // Get the channel for messages from src_id to dst_id, creating it on the
+  // first call. Checks the ids like Send, returns nullptr if dst_id is on
+  // another rank or local channels are disabled.
+  InterceptorChannel* GetChannel(int64_t src_id, int64_t dst_id);
+
  private:
   DISABLE_COPY_AND_ASSIGN(Carrier);
   Carrier() = delete;
@@ -99,6 +106,12 @@ class Carrier final {
 
   int64_t GetRank(int64_t interceptor_id) const;
 
+  // channels between interceptors of this carrier, destroyed after the
+  // interceptors using them
+  std::mutex channel_mutex_;
+  std::map<std::pair<int64_t, int64_t>, std::unique_ptr<InterceptorChannel>>
+      channels_;
+
   // interceptor logic id to actually interceptor
   std::unordered_map<int64_t, std::unique_ptr<Interceptor>>
       interceptor_idx_to_interceptor_;
@@ -44,27 +44,49 @@ void Interceptor::Handle(const InterceptorMessage& msg) {
   handle_(msg);
 }
 
+void Interceptor::HandleMessage(const InterceptorMessage& msg) {
+  VLOG(3) << "Interceptor " << interceptor_id_ << " has received a message"
+          << " from interceptor " << msg.src_id()
+          << " with message: " << msg.message_type() << ".";
+  Handle(msg);
+}
+
 void Interceptor::LoopOnce() {
+  // clear the flag before taking the messages, a message arriving later
+  // queues another LoopOnce, which may find nothing to do
+  loop_scheduled_.exchange(false, std::memory_order_acq_rel);
+
   std::deque<InterceptorMessage> tmp_messages;
   {
     std::lock_guard<std::mutex> lock(mutex_);
     messages_.swap(tmp_messages);
+    if (in_channels_changed_) {
+      loop_in_channels_ = in_channels_;
+      in_channels_changed_ = false;
+    }
   }
-  PADDLE_ENFORCE_EQ(tmp_messages.empty(),
-                    false,
-                    common::errors::PreconditionNotMet(
-                        "tmp_messages must not empty in task loop"));
 
+  for (auto* channel : loop_in_channels_) {
+    channel->ConsumeAll(
+        [this](const InterceptorMessage& msg) { HandleMessage(msg); });
+  }
   for (auto& msg : tmp_messages) {
-    const MessageType message_type = msg.message_type();
-    VLOG(3) << "Interceptor " << interceptor_id_ << " has received a message"
-            << " from interceptor " << msg.src_id()
-            << " with message: " << message_type << ".";
+    HandleMessage(msg);
+  }
+}
 
-    Handle(msg);
+void Interceptor::ScheduleLoop() {
+  if (!loop_scheduled_.exchange(true, std::memory_order_acq_rel)) {
+    loop_->QueueInLoop([this]() { LoopOnce(); });
   }
 }
 
+void Interceptor::AddInChannel(InterceptorChannel* channel) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  in_channels_.push_back(channel);
+  in_channels_changed_ = true;
+}
+
 void Interceptor::StopCarrier() {
   PADDLE_ENFORCE_NOT_NULL(
       carrier_,
@@ -78,15 +100,11 @@ void Interceptor::EnqueueRemoteInterceptorMessage(
   VLOG(3) << "Enqueue message: " << message.message_type() << " into "
           << interceptor_id_ << "'s remote mailbox.";
 
-  bool empty = false;
   {
     std::lock_guard<std::mutex> lock(mutex_);
-    empty = messages_.empty();
     messages_.emplace_back(message);
   }
-  if (empty) {
-    loop_->QueueInLoop([this]() { LoopOnce(); });
-  }
+  ScheduleLoop();
 }
 
 bool Interceptor::Send(int64_t dst_id, InterceptorMessage& msg) {
@@ -95,6 +113,30 @@ bool Interceptor::Send(int64_t dst_id, InterceptorMessage& msg) {
       common::errors::PreconditionNotMet("Carrier is not registered."));
   msg.set_src_id(interceptor_id_);
   msg.set_dst_id(dst_id);
+  // All the messages from this interceptor to an interceptor of the same
+  // carrier go through one channel, whatever thread sends them, so they
+  // arrive in order; only the ones sent from the task loop use the ring.
+  if (!msg.ctrl_message()) {
+    bool in_loop = loop_ != nullptr && loop_->IsInLoopThread();
+    InterceptorChannel* channel = nullptr;
+    if (LIKELY(in_loop)) {
+      auto iter = out_channels_.find(dst_id);
+      if (UNLIKELY(iter == out_channels_.end())) {
+        iter =
+            out_channels_
+                .emplace(dst_id, carrier_->GetChannel(interceptor_id_, dst_id))
+                .first;
+      }
+      channel = iter->second;
+    } else {
+      channel = carrier_->GetChannel(interceptor_id_, dst_id);
+    }
+    if (channel != nullptr) {
+      channel->Push(msg, in_loop);
+      channel->receiver()->NotifyChannelMessage();
+      return true;
+    }
+  }
   return carrier_->Send(msg);
 }
 
@@ -14,16 +14,19 @@
 
 #pragma once
 
+#include <atomic>
 #include <condition_variable>
 #include <deque>
 #include <functional>
 #include <map>
 #include <memory>
 #include <thread>
+#include <unordered_map>
 #include <vector>
 
 #include "paddle/common/errors.h"
 #include "paddle/common/macros.h"
+#include "paddle/fluid/distributed/fleet_executor/interceptor_channel.h"
 #include "paddle/fluid/distributed/fleet_executor/interceptor_message.pb.h"
 #include "paddle/fluid/framework/blocking_queue.h"
 #include "paddle/fluid/framework/new_executor/interpretercore.h"
@@ -73,6 +76,13 @@ class Interceptor {
 
   bool Send(int64_t dst_id, InterceptorMessage& msg);  // NOLINT
 
+  // Called by Carrier, messages of the channel will be handled by this
+  // interceptor
+  void AddInChannel(InterceptorChannel* channel);
+
+  // Called after a message is pushed into one of the in channels
+  void NotifyChannelMessage() { ScheduleLoop(); }
+
   void SetPlace(const phi::Place& place) { place_ = place; }
 
   void SetRootScope(framework::Scope* scope) { root_scope_ = scope; }
@@ -117,12 +127,25 @@ class Interceptor {
 
  private:
   void LoopOnce();
+  void ScheduleLoop();
+  void HandleMessage(const InterceptorMessage& msg);
 
   // interceptor handle which process message
   MsgHandle handle_{nullptr};
 
+  // whether a LoopOnce is queued in the task loop and not started yet
+  std::atomic<bool> loop_scheduled_{false};
+
   std::mutex mutex_;
   std::deque<InterceptorMessage> messages_;
+  std::vector<InterceptorChannel*> in_channels_;
+  bool in_channels_changed_{false};
+
+  // only accessed in the task loop thread
+  std::vector<InterceptorChannel*> loop_in_channels_;
+  // channel to each destination, nullptr if the destination is not in the
+  // same carrier
+  std::unordered_map<int64_t, InterceptorChannel*> out_channels_;
 };
 
 class InterceptorFactory {
@@ -0,0 +1,119 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+#include "paddle/common/macros.h"
+#include "paddle/fluid/distributed/fleet_executor/interceptor_message.pb.h"
+
+namespace paddle {
+namespace distributed {
+
+class Interceptor;
+
+// Messages from one interceptor to another interceptor of the same carrier.
+// The task loop of the sender copies messages into preallocated slots of a
+// single producer single consumer ring and the receiver handles them in
+// place, so no lock or allocation is needed per message. Messages sent from
+// other threads, or sent while the ring is full, go to an overflow queue,
+// and the ring is not used again until the overflow is drained, which keeps
+// the messages in order.
+class InterceptorChannel {
+ public:
+  InterceptorChannel(int64_t src_id, Interceptor* receiver, size_t capacity)
+      : src_id_(src_id), receiver_(receiver) {
+    size_t size = 2;
+    while (size < capacity) {
+      size <<= 1;
+    }
+    mask_ = size - 1;
+    slots_.resize(size);
+  }
+
+  int64_t src_id() const { return src_id_; }
+  Interceptor* receiver() const { return receiver_; }
+
+  // Called by the sender, in_sender_loop tells whether the caller is the
+  // task loop of the sender, the only thread allowed to use the ring.
+  void Push(const InterceptorMessage& msg, bool in_sender_loop) {
+    if (LIKELY(in_sender_loop)) {
+      uint64_t head = head_.load(std::memory_order_relaxed);
+      if (LIKELY(overflow_size_.load(std::memory_order_acquire) == 0 &&
+                 head - tail_.load(std::memory_order_acquire) <= mask_)) {
+        slots_[head & mask_].CopyFrom(msg);
+        head_.store(head + 1, std::memory_order_release);
+        return;
+      }
+    }
+    std::lock_guard<std::mutex> lock(overflow_mutex_);
+    overflow_.push_back(msg);
+    overflow_size_.store(overflow_.size(), std::memory_order_release);
+  }
+
+  // Only called by the receiver, handles every message sent so far.
+  template <typename Handler>
+  void ConsumeAll(Handler&& handler) {
+    if (LIKELY(overflow_size_.load(std::memory_order_acquire) == 0)) {
+      ConsumeRing(handler);
+      return;
+    }
+    std::deque<InterceptorMessage> overflow;
+    {
+      std::lock_guard<std::mutex> lock(overflow_mutex_);
+      overflow.swap(overflow_);
+    }
+    // the ring is not used while the overflow is non-empty, so the messages
+    // in the ring were pushed before the ones just taken and go first; the
+    // lock makes all of them visible here
+    ConsumeRing(handler);
+    for (auto& msg : overflow) {
+      handler(msg);
+    }
+    // the ring stays unused until the overflow is handled
+    std::lock_guard<std::mutex> lock(overflow_mutex_);
+    overflow_size_.store(overflow_.size(), std::memory_order_release);
+  }
+
+ private:
+  DISABLE_COPY_AND_ASSIGN(InterceptorChannel);
+
+  template <typename Handler>
+  void ConsumeRing(Handler& handler) {
+    uint64_t tail = tail_.load(std::memory_order_relaxed);
+    uint64_t head = head_.load(std::memory_order_acquire);
+    for (; tail < head; ++tail) {
+      handler(slots_[tail & mask_]);
+      tail_.store(tail + 1, std::memory_order_release);
+    }
+  }
+
+  const int64_t src_id_;
+  Interceptor* const receiver_;
+  uint64_t mask_;
+  std::vector<InterceptorMessage> slots_;
+  alignas(64) std::atomic<uint64_t> head_{0};
+  alignas(64) std::atomic<uint64_t> tail_{0};
+
+  std::atomic<size_t> overflow_size_{0};
+  std::mutex overflow_mutex_;
+  std::deque<InterceptorMessage> overflow_;
+};
+
+}  // namespace distributed
+}  // namespace paddle
@@ -0,0 +1,185 @@
+/* Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <chrono>
+#include <iostream>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "paddle/common/flags.h"
+#include "paddle/fluid/distributed/fleet_executor/carrier.h"
+#include "paddle/fluid/distributed/fleet_executor/global.h"
+#include "paddle/fluid/distributed/fleet_executor/interceptor.h"
+#include "paddle/fluid/distributed/fleet_executor/message_bus.h"
+
+COMMON_DECLARE_bool(fleet_executor_local_channel);
+
+namespace paddle {
+namespace distributed {
+
+class CountPingPongInterceptor : public Interceptor {
+ public:
+  static constexpr int kRoundTrips = 100000;
+
+  CountPingPongInterceptor(int64_t interceptor_id, TaskNode* node)
+      : Interceptor(interceptor_id, node) {
+    RegisterMsgHandle([this](const InterceptorMessage& msg) { PingPong(msg); });
+  }
+
+  void PingPong(const InterceptorMessage& msg) {
+    if (msg.message_type() == STOP) {
+      return;
+    }
+    EXPECT_EQ(msg.scope_idx(), count_);
+    ++count_;
+    if (count_ == kRoundTrips) {
+      StopCarrier();
+      return;
+    }
+    InterceptorMessage resp;
+    resp.set_message_type(DATA_IS_READY);
+    resp.set_scope_idx(msg.scope_idx() + (GetInterceptorId() == 0 ? 1 : 0));
+    Send(msg.src_id(), resp);
+  }
+
+ private:
+  int64_t count_{0};
+};
+
+// Spins for kComputeUs on every micro batch, then passes it downstream.
+class BusyStageInterceptor : public Interceptor {
+ public:
+  static constexpr int64_t kStages = 4;
+  static constexpr int64_t kMicroBatches = 2000;
+  static constexpr int64_t kComputeUs = 20;
+
+  BusyStageInterceptor(int64_t interceptor_id, TaskNode* node)
+      : Interceptor(interceptor_id, node) {
+    RegisterMsgHandle([this](const InterceptorMessage& msg) { Compute(msg); });
+  }
+
+  void Compute(const InterceptorMessage& msg) {
+    if (msg.message_type() != DATA_IS_READY) {
+      return;
+    }
+    EXPECT_EQ(msg.scope_idx(), count_);
+    ++count_;
+    auto start = std::chrono::steady_clock::now();
+    while (std::chrono::steady_clock::now() - start <
+           std::chrono::microseconds(kComputeUs)) {
+    }
+    if (GetInterceptorId() == kStages - 1) {
+      if (count_ == kMicroBatches) {
+        StopCarrier();
+      }
+      return;
+    }
+    InterceptorMessage data;
+    data.set_message_type(DATA_IS_READY);
+    data.set_scope_idx(msg.scope_idx());
+    Send(GetInterceptorId() + 1, data);
+  }
+
+ private:
+  int64_t count_{0};
+};
+
+static MessageBus* GetMessageBus() {
+  static MessageBus* msg_bus = [] {
+    MessageBus* bus = GlobalVal<MessageBus>::Create();
+    bus->Init(0, {{0, "127.0.0.0:0"}}, "");
+    return bus;
+  }();
+  return msg_bus;
+}
+
+static double RunPingPong(const std::string& carrier_id) {
+  Carrier* carrier =
+      GlobalMap<std::string, Carrier>::Create(carrier_id, carrier_id);
+  carrier->Init(0, {{0, 0}, {1, 0}});
+  GetMessageBus();
+
+  Interceptor* a = carrier->SetInterceptor(
+      0, std::make_unique<CountPingPongInterceptor>(0, nullptr));
+  carrier->SetInterceptor(
+      1, std::make_unique<CountPingPongInterceptor>(1, nullptr));
+
+  auto start = std::chrono::steady_clock::now();
+  InterceptorMessage msg;
+  msg.set_message_type(DATA_IS_READY);
+  msg.set_scope_idx(0);
+  a->Send(1, msg);
+  carrier->Wait();
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  return 2 * CountPingPongInterceptor::kRoundTrips / seconds;
+}
+
+static double RunPipeline(const std::string& carrier_id) {
+  const int64_t stages = BusyStageInterceptor::kStages;
+  const int64_t micro_batches = BusyStageInterceptor::kMicroBatches;
+  Carrier* carrier =
+      GlobalMap<std::string, Carrier>::Create(carrier_id, carrier_id);
+  std::unordered_map<int64_t, int64_t> interceptor_id_to_rank;
+  for (int64_t i = 0; i < stages; ++i) {
+    interceptor_id_to_rank[i] = 0;
+  }
+  carrier->Init(0, interceptor_id_to_rank);
+  GetMessageBus();
+
+  for (int64_t i = 0; i < stages; ++i) {
+    carrier->SetInterceptor(
+        i, std::make_unique<BusyStageInterceptor>(i, nullptr));
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  for (int64_t i = 0; i < micro_batches; ++i) {
+    InterceptorMessage msg;
+    msg.set_message_type(DATA_IS_READY);
+    msg.set_dst_id(0);
+    msg.set_scope_idx(i);
+    carrier->EnqueueInterceptorMessage(msg);
+  }
+  carrier->Wait();
+  double total_us = std::chrono::duration<double, std::micro>(
+                        std::chrono::steady_clock::now() - start)
+                        .count();
+  // all the stages share one task loop thread, so without any messaging
+  // cost the pipeline takes stages * micro_batches * compute
+  double compute_us = static_cast<double>(stages * micro_batches *
+                                          BusyStageInterceptor::kComputeUs);
+  return (total_us - compute_us) / total_us;
+}
+
+TEST(InterceptorLocalChannelTest, PingPongRate) {
+  FLAGS_fleet_executor_local_channel = false;
+  double carrier_rate = RunPingPong("ping_pong_carrier");
+  FLAGS_fleet_executor_local_channel = true;
+  double channel_rate = RunPingPong("ping_pong_channel");
+  std::cout << "ping pong messages per second: carrier " << carrier_rate
+            << ", local channel " << channel_rate << std::endl;
+}
+
+TEST(InterceptorLocalChannelTest, PipelineBubble) {
+  FLAGS_fleet_executor_local_channel = false;
+  double carrier_bubble = RunPipeline("pipeline_carrier");
+  FLAGS_fleet_executor_local_channel = true;
+  double channel_bubble = RunPipeline("pipeline_channel");
+  std::cout << "pipeline bubble ratio: carrier " << carrier_bubble
+            << ", local channel " << channel_bubble << std::endl;
+}
+
+}  // namespace distributed
+}  // namespace paddle
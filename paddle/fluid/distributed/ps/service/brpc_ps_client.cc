@@ -82,6 +82,16 @@ PD_DEFINE_int32(pserver_sparse_table_shard_num,
                 1000,
                 "sparse table shard for save & load");
 
+PD_DEFINE_int32(pserver_pull_sparse_coalesce_window_us,
+                0,
+                "merge concurrent pull_sparse requests of the same table "
+                "arriving within this window, 0 to disable");
+
+PD_DEFINE_int32(pserver_pull_sparse_coalesce_max_keys,
+                1 << 20,
+                "issue a merged pull_sparse early once it reaches this many "
+                "keys");
+
 inline size_t get_sparse_shard(uint32_t shard_num,
                                uint32_t server_num,
                                uint64_t key) {
@@ -346,6 +356,19 @@ int32_t BrpcPsClient::Initialize() {
           ::paddle::framework::MakeChannel<SparseAsyncTask *>();
       _push_sparse_merge_count_map[table_id] = 0;
     }
+    if (worker_param.downpour_table_param(i).has_push_compress_param()) {
+      const auto &compress_param =
+          worker_param.downpour_table_param(i).push_compress_param();
+      const auto &optimizer =
+          worker_param.downpour_table_param(i).common().name();
+      if (type == PS_DENSE_TABLE && compress_param.dense_topk_ratio() < 1.0f &&
+          !PushCompressor::SupportsDenseTopk(optimizer)) {
+        LOG(ERROR) << "dense_topk_ratio of table " << table_id
+                   << " is not supported with optimizer " << optimizer;
+        return -1;
+      }
+      _push_compress_params[table_id] = compress_param;
+    }
   }
 
   auto &profiler = CostProfiler::instance();
@@ -366,6 +389,20 @@ int32_t BrpcPsClient::Initialize() {
   profiler.register_profiler("pserver_client_push_dense_rpc");
   profiler.register_profiler("pserver_client_push_dense_send");
 
+  if (FLAGS_pserver_pull_sparse_coalesce_window_us > 0) {
+    _pull_sparse_coalescer = std::make_unique<SparsePullCoalescer>(
+        [this](float **select_values,
+               size_t table_id,
+               const uint64_t *keys,
+               size_t num,
+               bool is_training) {
+          return PullSparseImpl(
+              select_values, table_id, keys, num, is_training);
+        },
+        FLAGS_pserver_pull_sparse_coalesce_window_us,
+        FLAGS_pserver_pull_sparse_coalesce_max_keys);
+  }
+
   _running = true;
   _flushing = false;
   // 启动异步push线程
@@ -443,6 +480,11 @@ int FlClientBrpcClosure::check_response(size_t request_idx, int cmd_id) {
 }
 
 std::future<int32_t> BrpcPsClient::PrintTableStat(uint32_t table_id) {
+  auto *cache = GetPullCache(table_id);
+  if (cache != nullptr) {
+    std::cout << "table id: " << table_id << ", " << cache->StatString()
+              << std::endl;
+  }
   size_t request_call_num = _server_channels.size();
   DownpourBrpcClosure *closure = new DownpourBrpcClosure(
       request_call_num, [request_call_num, table_id](void *done) {
@@ -698,6 +740,16 @@ std::future<int32_t> BrpcPsClient::Flush() {
 }
 
 void BrpcPsClient::PrintQueueSize() {
+  if (!_push_compress_params.empty()) {
+    VLOG(0) << "BrpcPsClient::PrintQueueSize: push raw bytes "
+            << _push_raw_bytes << ", wire bytes " << _push_wire_bytes;
+  }
+  if (_pull_sparse_coalescer) {
+    auto stat = _pull_sparse_coalescer->GetStat();
+    VLOG(0) << "BrpcPsClient::PrintQueueSize: pull_sparse coalescer "
+            << _pull_sparse_coalescer->StatString() << ", rpc saved: "
+            << (stat.pull_requests - stat.merged_pulls) * GetServerNums();
+  }
   for (auto &push_sparse_task_itr : _push_sparse_task_queue_map) {
     auto table_id = push_sparse_task_itr.first;
     auto queue_size = push_sparse_task_itr.second->Size();
@@ -721,6 +773,9 @@ void BrpcPsClient::PrintQueueSizeThread() {
 }
 
 void BrpcPsClient::FinalizeWorker() {
+  if (_pull_sparse_coalescer) {
+    _pull_sparse_coalescer->Stop();
+  }
   Flush();
   VLOG(0) << "BrpcPsClient::FinalizeWorker begin join thread";
   _running = false;
@@ -1010,6 +1065,7 @@ std::future<int32_t> BrpcPsClient::PushSparseRawGradient(
     const float **update_values,
     size_t num,
     void *done) {
+  NotifyPullCacheOnPush(table_id, keys, num);
   auto *accessor = GetTableAccessor(table_id);
   // 发送RPC请求
   DownpourBrpcClosure *closure = reinterpret_cast<DownpourBrpcClosure *>(done);
@@ -1051,17 +1107,12 @@ std::future<int32_t> BrpcPsClient::PushSparseRawGradient(
     push_request->set_cmd_id(PS_PUSH_SPARSE_TABLE);
     push_request->set_table_id(table_id);
     push_request->set_client_id(_client_id);
-    push_request->add_params((char *)&kv_size, sizeof(uint32_t));  // NOLINT
-    auto *push_data = push_request->mutable_data();
-    push_data->resize(kv_size * (sizeof(uint64_t) + value_size));
-    char *push_data_ptr = const_cast<char *>(push_data->data());
-    memcpy(push_data_ptr, kvs.data(), kv_size * sizeof(uint64_t));
-    push_data_ptr += kv_size * sizeof(uint64_t);
-
-    for (size_t i = 0; i < kv_size; ++i) {
-      memcpy(push_data_ptr, value_ptr[i], value_size);
-      push_data_ptr += value_size;
-    }
+    FillSparsePushRequest(table_id,
+                          kvs.data(),
+                          value_ptr.data(),
+                          kv_size,
+                          value_size,
+                          push_request);
     PsService_Stub rpc_stub(GetSparseChannel(shard_idx));
     closure->cntl(shard_idx)->set_request_compress_type(
         (brpc::CompressType)FLAGS_pserver_communicate_compress_type);
@@ -1090,14 +1141,11 @@ std::future<int32_t> BrpcPsClient::PushDenseRawGradient(
     closure->request(i)->set_cmd_id(PS_PUSH_DENSE_TABLE);
     closure->request(i)->set_table_id(table_id);
     closure->request(i)->set_client_id(_client_id);
-    auto *push_data = closure->request(i)->mutable_data();
-    push_data->clear();
-    push_data->resize(sizeof(uint32_t) + num_per_shard * sizeof(float));
-    char *push_data_ptr = const_cast<char *>(push_data->data());
-    memcpy(push_data_ptr, &num_per_shard, sizeof(uint32_t));
-    memcpy(push_data_ptr + sizeof(uint32_t),
-           total_send_data + i * num_per_shard,
-           num_per_shard * sizeof(float));
+    FillDensePushRequest(table_id,
+                         total_send_data + i * num_per_shard,
+                         num_per_shard,
+                         i * num_per_shard,
+                         closure->request(i));
     // closure->cntl(i)->set_request_compress_type(
     //     (brpc::CompressType)FLAGS_pserver_communicate_compress_type);
     PsService_Stub rpc_stub(GetDenseChannel(i));
@@ -1136,11 +1184,121 @@ std::future<int32_t> BrpcPsClient::PushGlobalStep(int table_id,
   return fut;
 }
 
+void BrpcPsClient::FillSparsePushRequest(size_t table_id,
+                                         const uint64_t *keys,
+                                         const float *const *values,
+                                         size_t num,
+                                         size_t value_size,
+                                         PsRequestMessage *request) {
+  uint32_t kv_num = static_cast<uint32_t>(num);
+  request->add_params(reinterpret_cast<char *>(&kv_num), sizeof(uint32_t));
+  auto *push_data = request->mutable_data();
+  size_t raw_bytes = num * (sizeof(uint64_t) + value_size);
+  auto iter = _push_compress_params.find(table_id);
+  if (iter != _push_compress_params.end()) {
+    const auto &param = iter->second;
+    PushCompressHeader header;
+    header.value_type = static_cast<uint8_t>(param.value_type());
+    header.key_varint = param.compress_sparse_keys() ? 1 : 0;
+    header.raw_prefix_dim = param.value_raw_prefix_dim();
+    header.value_dim = value_size / sizeof(float);
+    if (PushCompressor::IsCompressed(header)) {
+      request->add_params(reinterpret_cast<char *>(&header), sizeof(header));
+      PushCompressor::EncodeSparse(header, keys, values, num, push_data);
+      _push_raw_bytes += raw_bytes;
+      _push_wire_bytes += push_data->size();
+      return;
+    }
+  }
+  push_data->resize(raw_bytes);
+  char *push_data_ptr = const_cast<char *>(push_data->data());
+  memcpy(push_data_ptr, keys, num * sizeof(uint64_t));
+  push_data_ptr += num * sizeof(uint64_t);
+  for (size_t i = 0; i < num; ++i) {
+    memcpy(push_data_ptr, values[i], value_size);
+    push_data_ptr += value_size;
+  }
+}
+
+void BrpcPsClient::FillDensePushRequest(size_t table_id,
+                                        const float *values,
+                                        uint32_t num,
+                                        size_t offset,
+                                        PsRequestMessage *request) {
+  /*
+  Push Content:
+  |--num--|---valuesData---|
+  |--4B---|----------------|
+  */
+  auto *push_data = request->mutable_data();
+  push_data->clear();
+  auto iter = _push_compress_params.find(table_id);
+  if (iter != _push_compress_params.end()) {
+    const auto &param = iter->second;
+    PushCompressHeader header;
+    header.value_type = static_cast<uint8_t>(param.value_type());
+    header.dense_topk = param.dense_topk_ratio() < 1.0f ? 1 : 0;
+    header.value_dim = num;
+    if (PushCompressor::IsCompressed(header)) {
+      request->add_params(reinterpret_cast<char *>(&header), sizeof(header));
+      if (header.dense_topk) {
+        size_t k = static_cast<size_t>(num * param.dense_topk_ratio());
+        std::lock_guard<std::mutex> lock(_push_dense_residual_mutex);
+        auto &residual = _push_dense_residuals[table_id];
+        if (residual.size() < offset + num) {
+          residual.resize(offset + num, 0.0f);
+        }
+        PushCompressor::EncodeDense(
+            header, values, k, residual.data() + offset, push_data);
+      } else {
+        PushCompressor::EncodeDense(header, values, num, nullptr, push_data);
+      }
+      _push_raw_bytes += sizeof(uint32_t) + num * sizeof(float);
+      _push_wire_bytes += push_data->size();
+      return;
+    }
+  }
+  push_data->resize(sizeof(uint32_t) + num * sizeof(float));
+  char *push_data_ptr = const_cast<char *>(push_data->data());
+  memcpy(push_data_ptr, &num, sizeof(uint32_t));
+  memcpy(push_data_ptr + sizeof(uint32_t), values, num * sizeof(float));
+}
+
 std::future<int32_t> BrpcPsClient::PullSparse(float **select_values,
                                               size_t table_id,
                                               const uint64_t *keys,
                                               size_t num,
                                               bool is_training) {
+  auto *cache = GetPullCache(table_id);
+  if (cache != nullptr) {
+    auto pull_func = [this, table_id, is_training](
+                         float **values,
+                         const uint64_t *pull_keys,
+                         size_t n,
+                         const SparsePullDone &on_done) {
+      if (_pull_sparse_coalescer) {
+        return _pull_sparse_coalescer->Pull(
+            values, table_id, pull_keys, n, is_training, on_done);
+      }
+      return PullSparseImpl(
+          values, table_id, pull_keys, n, is_training, on_done);
+    };
+    return PullSparseWithCache(cache, select_values, keys, num, pull_func);
+  }
+  if (_pull_sparse_coalescer) {
+    return _pull_sparse_coalescer->Pull(
+        select_values, table_id, keys, num, is_training);
+  }
+  return PullSparseImpl(select_values, table_id, keys, num, is_training);
+}
+
+std::future<int32_t> BrpcPsClient::PullSparseImpl(
+    float **select_values,
+    size_t table_id,
+    const uint64_t *keys,
+    size_t num,
+    bool is_training,
+    std::function<void(int32_t)> on_done) {
   auto timer = std::make_shared<CostTimer>("pserver_client_pull_sparse");
   auto local_timer =
       std::make_shared<CostTimer>("pserver_client_pull_sparse_local");
@@ -1170,7 +1328,9 @@ std::future<int32_t> BrpcPsClient::PullSparse(float **select_values,
   size_t value_size = accessor->GetAccessorInfo().select_size;
 
   DownpourBrpcClosure *closure = new DownpourBrpcClosure(
-      request_call_num, [shard_sorted_kvs, value_size](void *done) {
+      request_call_num,
+      [shard_sorted_kvs, value_size, on_done = std::move(on_done)](
+          void *done) {
         int ret = 0;
         auto *closure = reinterpret_cast<DownpourBrpcClosure *>(done);
         for (size_t i = 0; i < shard_sorted_kvs->size(); ++i) {
@@ -1203,6 +1363,9 @@ std::future<int32_t> BrpcPsClient::PullSparse(float **select_values,
             }
           }
         }
+        if (on_done) {
+          on_done(ret);
+        }
         closure->set_promise_value(ret);
       });
   closure->add_timer(timer);
@@ -1410,6 +1573,7 @@ std::future<int32_t> BrpcPsClient::PushSparseRawGradientPartial(
     uint32_t num,
     void *done,
     int pserver_idx) {
+  NotifyPullCacheOnPush(table_id, keys, num);
   auto *accessor = GetTableAccessor(table_id);
   size_t value_size = accessor->GetAccessorInfo().update_size;
   DownpourBrpcClosure *closure = reinterpret_cast<DownpourBrpcClosure *>(done);
@@ -1422,16 +1586,8 @@ std::future<int32_t> BrpcPsClient::PushSparseRawGradientPartial(
   push_request->set_cmd_id(PS_PUSH_SPARSE_TABLE);
   push_request->set_table_id(table_id);
   push_request->set_client_id(_client_id);
-  push_request->add_params((char *)&num, sizeof(uint32_t));  // NOLINT
-  auto *push_data = push_request->mutable_data();
-  push_data->resize(num * (sizeof(uint64_t) + value_size));
-  char *push_data_ptr = const_cast<char *>(push_data->data());
-  memcpy(push_data_ptr, keys, num * sizeof(uint64_t));
-  push_data_ptr += num * sizeof(uint64_t);
-  for (uint32_t i = 0; i < num; ++i) {
-    memcpy(push_data_ptr, update_values[i], value_size);
-    push_data_ptr += value_size;
-  }
+  FillSparsePushRequest(
+      table_id, keys, update_values, num, value_size, push_request);
   PsService_Stub rpc_stub(GetSparseChannel(pserver_idx));
   closure->cntl(0)->set_request_compress_type(
       (brpc::CompressType)FLAGS_pserver_communicate_compress_type);
@@ -1530,6 +1686,7 @@ std::future<int32_t> BrpcPsClient::PushSparse(size_t table_id,
                                               const uint64_t *keys,
                                               const float **update_values,
                                               size_t num) {
+  NotifyPullCacheOnPush(table_id, keys, num);
   auto push_timer = std::make_shared<CostTimer>("pserver_client_push_sparse");
   CostTimer parse_timer("pserver_client_push_sparse_parse");
   int push_sparse_async_num = _push_sparse_task_queue_map[table_id]->Size();
@@ -1855,24 +2012,17 @@ int BrpcPsClient::PushSparseAsyncShardPush(
   push_request->set_cmd_id(PS_PUSH_SPARSE_TABLE);
   push_request->set_table_id(table_id);
   push_request->set_client_id(_client_id);
-  push_request->add_params(reinterpret_cast<char *>(&merged_kv_count),
-                           sizeof(uint32_t));  // NOLINT
-  auto *push_data = push_request->mutable_data();
-  int update_size = accessor->GetAccessorInfo().update_size;
-  push_data->resize(merged_kv_count * (sizeof(uint64_t) + update_size));
-  char *push_data_ptr = const_cast<char *>(push_data->data());
-  memcpy(push_data_ptr,
-         merged_key_list.data(),
-         merged_kv_count * sizeof(uint64_t));
-  push_data_ptr += merged_kv_count * sizeof(uint64_t);
+  std::vector<const float *> merged_value_ptrs(merged_kv_count);
   for (size_t i = 0; i < merged_kv_count; ++i) {
-    const char *task_data_ptr = merged_value_list[i].data();
-
-    memcpy(push_data_ptr,
-           (float *)(task_data_ptr),  // NOLINT
-           update_size);
-    push_data_ptr += update_size;
+    merged_value_ptrs[i] =
+        reinterpret_cast<const float *>(merged_value_list[i].data());
   }
+  FillSparsePushRequest(table_id,
+                        merged_key_list.data(),
+                        merged_value_ptrs.data(),
+                        merged_kv_count,
+                        accessor->GetAccessorInfo().update_size,
+                        push_request);
   PsService_Stub rpc_stub(GetSparseChannel(shard_idx));
   closure->cntl(shard_idx)->set_request_compress_type(
       (brpc::CompressType)FLAGS_pserver_communicate_compress_type);
@@ -2058,14 +2208,11 @@ void BrpcPsClient::PushDenseRawGradient(std::shared_ptr<DenseAsyncTask> &task,
     closure->request(i)->set_cmd_id(PS_PUSH_DENSE_TABLE);
     closure->request(i)->set_table_id(task->table_id());
     closure->request(i)->set_client_id(_client_id);
-    auto *push_data = closure->request(i)->mutable_data();
-    push_data->clear();
-    push_data->resize(sizeof(uint32_t) + num_per_shard * sizeof(float));
-    char *push_data_ptr = const_cast<char *>(push_data->data());
-    memcpy(push_data_ptr, &num_per_shard, sizeof(uint32_t));
-    memcpy(push_data_ptr + sizeof(uint32_t),
-           total_send_data + i * num_per_shard,
-           num_per_shard * sizeof(float));
+    FillDensePushRequest(task->table_id(),
+                         total_send_data + i * num_per_shard,
+                         num_per_shard,
+                         i * num_per_shard,
+                         closure->request(i));
     closure->cntl(i)->set_request_compress_type(
         (brpc::CompressType)FLAGS_pserver_communicate_compress_type);
     PsService_Stub rpc_stub(GetDenseChannel(i));
@@ -26,7 +26,9 @@
 #include "paddle/common/macros.h"
 #include "paddle/fluid/distributed/ps/service/brpc_utils.h"
 #include "paddle/fluid/distributed/ps/service/ps_client.h"
+#include "paddle/fluid/distributed/ps/service/push_compressor.h"
 #include "paddle/fluid/distributed/ps/service/sendrecv.pb.h"
+#include "paddle/fluid/distributed/ps/service/sparse_pull_coalescer.h"
 #include "paddle/fluid/framework/channel.h"
 #include "paddle/fluid/framework/lod_tensor.h"
 #include "paddle/fluid/framework/scope.h"
@@ -202,6 +204,9 @@ class BrpcPsClient : public PSClient {
  public:
   BrpcPsClient() {}
   virtual ~BrpcPsClient() {
+    if (_pull_sparse_coalescer) {
+      _pull_sparse_coalescer->Stop();
+    }
     if (_running) {
       Flush();
       _running = false;
@@ -347,6 +352,28 @@ class BrpcPsClient : public PSClient {
                                int cmd_id,
                                const std::vector<std::string> &param);
 
+  // 按表的 push_compress_param 填充 push 请求, 未开启压缩时保持原始格式
+  void FillSparsePushRequest(size_t table_id,
+                             const uint64_t *keys,
+                             const float *const *values,
+                             size_t num,
+                             size_t value_size,
+                             PsRequestMessage *request);
+  void FillDensePushRequest(size_t table_id,
+                            const float *values,
+                            uint32_t num,
+                            size_t offset,
+                            PsRequestMessage *request);
+
+  // on_done runs on the brpc callback once the values are written
+  std::future<int32_t> PullSparseImpl(
+      float **select_values,
+      size_t table_id,
+      const uint64_t *keys,
+      size_t num,
+      bool is_training,
+      std::function<void(int32_t)> on_done = nullptr);
+
   std::future<int32_t> SendSaveCmd(uint32_t table_id,
                                    int cmd_id,
                                    const std::vector<std::string> &param);
@@ -369,6 +396,17 @@ class BrpcPsClient : public PSClient {
 
   std::thread _print_thread;
 
+  // 合并并发的 pull sparse 请求, FLAGS_pserver_pull_sparse_coalesce_window_us
+  // 为 0 时不启用
+  std::unique_ptr<SparsePullCoalescer> _pull_sparse_coalescer;
+
+  // push 压缩配置及 dense top-k 未发送的残差
+  std::unordered_map<uint32_t, PushCompressParameter> _push_compress_params;
+  std::unordered_map<uint32_t, std::vector<float>> _push_dense_residuals;
+  std::mutex _push_dense_residual_mutex;
+  std::atomic<uint64_t> _push_raw_bytes{0};
+  std::atomic<uint64_t> _push_wire_bytes{0};
+
   int PushSparseAsyncShardMerge(
       std::vector<std::shared_ptr<SparseAsyncTask>> &task_list,  // NOLINT
       std::vector<int> &request_kv_num,                          // NOLINT
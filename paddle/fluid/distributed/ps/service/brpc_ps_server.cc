@@ -18,6 +18,7 @@
 
 #include "butil/object_pool.h"
 #include "paddle/fluid/distributed/common/cost_timer.h"
+#include "paddle/fluid/distributed/ps/service/push_compressor.h"
 #include "paddle/fluid/distributed/ps/table/depends/sparse_utils.h"
 #include "paddle/fluid/distributed/ps/table/table.h"
 #include "paddle/fluid/framework/archive.h"
@@ -40,6 +41,40 @@ PD_DEFINE_string(pserver_connection_type_s2s,
 
 namespace paddle::distributed {
 
+namespace {
+
+// An object of the butil object pool, held while one request is handled.
+// Unlike a thread_local buffer, it stays owned by the request when the
+// bthread of the handler yields or moves to another worker.
+template <typename T>
+class PooledObject {
+ public:
+  PooledObject() : obj_(butil::get_object<T>()) {}
+  ~PooledObject() { butil::return_object(obj_); }
+
+  T *operator->() { return obj_; }
+  T &operator*() { return *obj_; }
+
+ private:
+  T *obj_;
+
+  DISABLE_COPY_AND_ASSIGN(PooledObject);
+};
+
+// The PushCompressHeader of a compressed push, among the params from first
+// on, or nullptr for an uncompressed push.
+const std::string *FindPushCompressHeader(const PsRequestMessage &request,
+                                          int first) {
+  for (int i = first; i < request.params_size(); ++i) {
+    if (PushCompressor::IsHeader(request.params(i))) {
+      return &request.params(i);
+    }
+  }
+  return nullptr;
+}
+
+}  // namespace
+
 int32_t BrpcPsServer::Initialize() {
   auto &service_config = _config.downpour_server_param().service_param();
   if (!service_config.has_service_class()) {
@@ -341,17 +376,16 @@ int32_t BrpcPsService::PushDenseParam(Table *table,
   phi::RecordEvent record_event(
       "PsService->PushDenseParam", platform::TracerEventType::Communication, 1);
   CHECK_TABLE_EXIST(table, request, response)
-  thread_local std::string push_buffer;
   auto &req_io_buffer = cntl->request_attachment();
   auto req_buffer_size = req_io_buffer.size();
   if (req_buffer_size < 1) {
     set_response_code(response, -1, "req attachment is empty");
     return 0;
   }
-  push_buffer.resize(0);
-  push_buffer.reserve(req_buffer_size);
+  PooledObject<std::string> push_buffer;
+  push_buffer->resize(req_buffer_size);
   const char *data = (const char *)cntl->request_attachment().fetch(
-      const_cast<char *>(push_buffer.data()), req_buffer_size);
+      &(*push_buffer)[0], req_buffer_size);
 
   uint32_t num = *(const uint32_t *)data;
 
@@ -382,17 +416,37 @@ int32_t BrpcPsService::PushDense(Table *table,
   }
 
   CostTimer timer("pserver_server_push_dense");
-  /*
-  Push Content:
-  |--num--|---valuesData---|
-  |--4B---|----------------|
-  */
-  uint32_t num = *(const uint32_t *)(request.data().data());
   TableContext table_context;
   table_context.value_type = Dense;
-  table_context.push_context.values =
-      (const float *)(request.data().data() + sizeof(uint32_t));
-  table_context.num = num;
+  PooledObject<std::vector<float>> decoded_values;
+  const std::string *header_param = FindPushCompressHeader(request, 0);
+  if (header_param != nullptr) {
+    PushCompressHeader header;
+    if (!PushCompressor::ParseHeader(*header_param, &header)) {
+      set_response_code(
+          response, -1, "PushDense compress header is not supported");
+      return 0;
+    }
+    if (!PushCompressor::DecodeDense(header,
+                                     request.data().data(),
+                                     request.data().size(),
+                                     &(*decoded_values))) {
+      set_response_code(response, -1, "PushDense decompress failed");
+      return 0;
+    }
+    table_context.push_context.values = decoded_values->data();
+    table_context.num = header.value_dim;
+  } else {
+    /*
+    Push Content:
+    |--num--|---valuesData---|
+    |--4B---|----------------|
+    */
+    uint32_t num = *(const uint32_t *)(request.data().data());
+    table_context.push_context.values =
+        (const float *)(request.data().data() + sizeof(uint32_t));
+    table_context.num = num;
+  }
   // const float *values = (const float *)(request.data().data() +
   // sizeof(uint32_t));
   if (table->Push(table_context) != 0) {
@@ -474,7 +528,6 @@ int32_t BrpcPsService::PullGeoParam(Table *table,
   phi::RecordEvent record_event(
       "PsService->pull_geo_param", platform::TracerEventType::Communication, 1);
   CHECK_TABLE_EXIST(table, request, response)
-  thread_local std::string push_sparse_request_buffer;
 
   auto trainer_id = request.client_id();
 
@@ -528,11 +581,11 @@ int32_t BrpcPsService::PullSparse(Table *table,
       *(reinterpret_cast<const uint32_t *>(request.params(0).c_str()));
   auto dim = table->GetValueAccessor()->GetAccessorInfo().select_dim;
 
-  thread_local std::string req_buffer;
-  req_buffer.reserve(req_buffer_size);
+  PooledObject<std::string> req_buffer;
+  req_buffer->resize(req_buffer_size);
 
-  const void *data = cntl->request_attachment().fetch(
-      const_cast<char *>(req_buffer.data()), req_buffer_size);
+  const void *data =
+      cntl->request_attachment().fetch(&(*req_buffer)[0], req_buffer_size);
 
   auto value = PullSparseValue(num, dim);
 
@@ -575,16 +628,39 @@ int32_t BrpcPsService::PushSparse(Table *table,
   CostTimer timer("pserver_server_push_sparse");
   const uint32_t num =
       *(reinterpret_cast<const uint32_t *>(request.params(0).c_str()));
-  /*
-  Push Content:
-  |---keysData---|---valuesData---|
-  |---8*{num}B---|----------------|
-  */
   TableContext table_context;
   table_context.value_type = Sparse;
-  table_context.push_context.keys = (const uint64_t *)push_data.data();
-  table_context.push_context.values =
-      (const float *)(push_data.data() + sizeof(uint64_t) * num);
+  PooledObject<std::vector<uint64_t>> decoded_keys;
+  PooledObject<std::vector<float>> decoded_values;
+  const std::string *header_param = FindPushCompressHeader(request, 1);
+  if (header_param != nullptr) {
+    PushCompressHeader header;
+    if (!PushCompressor::ParseHeader(*header_param, &header)) {
+      set_response_code(
+          response, -1, "PushSparse compress header is not supported");
+      return 0;
+    }
+    if (!PushCompressor::DecodeSparse(header,
+                                      push_data.data(),
+                                      push_data.size(),
+                                      num,
+                                      &(*decoded_keys),
+                                      &(*decoded_values))) {
+      set_response_code(response, -1, "PushSparse decompress failed");
+      return 0;
+    }
+    table_context.push_context.keys = decoded_keys->data();
+    table_context.push_context.values = decoded_values->data();
+  } else {
+    /*
+    Push Content:
+    |---keysData---|---valuesData---|
+    |---8*{num}B---|----------------|
+    */
+    table_context.push_context.keys = (const uint64_t *)push_data.data();
+    table_context.push_context.values =
+        (const float *)(push_data.data() + sizeof(uint64_t) * num);
+  }
   table_context.num = num;
   // const uint64_t *keys = (const uint64_t *)push_data.data();
   // const float *values = (const float *)(push_data.data() + sizeof(uint64_t) *
@@ -64,10 +64,53 @@ int32_t PSClient::Configure(  // called in FleetWrapper::InitWorker
     accessor->Initialize();
     _table_accessors[work_param.downpour_table_param(i).table_id()].reset(
         accessor);
+    const auto &cache_param =
+        work_param.downpour_table_param(i).pull_cache_param();
+    if (cache_param.capacity() > 0) {
+      _pull_caches[work_param.downpour_table_param(i).table_id()].reset(
+          new SparsePullCache(cache_param.capacity(),
+                              accessor->GetAccessorInfo().select_dim,
+                              cache_param.max_staleness_steps(),
+                              cache_param.invalidate_on_push()));
+    }
   }
   return Initialize();
 }
 
+std::future<int32_t> PSClient::PullSparseWithCache(
+    SparsePullCache *cache,
+    float **select_values,
+    const uint64_t *keys,
+    size_t num,
+    const SparsePullFunc &pull_func) {
+  uint64_t step = 0;
+  std::vector<size_t> missed = cache->Lookup(keys, num, select_values, &step);
+  if (missed.empty()) {
+    std::promise<int32_t> promise;
+    promise.set_value(0);
+    return promise.get_future();
+  }
+  auto missed_keys = std::make_shared<std::vector<uint64_t>>(missed.size());
+  auto missed_values = std::make_shared<std::vector<float *>>(missed.size());
+  for (size_t i = 0; i < missed.size(); ++i) {
+    (*missed_keys)[i] = keys[missed[i]];
+    (*missed_values)[i] = select_values[missed[i]];
+  }
+  // The pulled rows are cached by the pull itself as soon as they are
+  // written, whether or not the returned future is waited on.
+  return pull_func(missed_values->data(),
+                   missed_keys->data(),
+                   missed_keys->size(),
+                   [cache, step, missed_keys, missed_values](int32_t ret) {
+                     if (ret == 0) {
+                       cache->Insert(step,
+                                     missed_keys->data(),
+                                     missed_values->data(),
+                                     missed_keys->size());
+                     }
+                   });
+}
+
 PSClient *PSClientFactory::Create(const PSParameter &ps_config) {
   const auto &config = ps_config.server_param();
   if (!config.has_downpour_server_param()) {
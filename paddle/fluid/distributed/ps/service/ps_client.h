@@ -24,6 +24,7 @@
 #include "paddle/fluid/distributed/common/cost_timer.h"
 #include "paddle/fluid/distributed/ps/service/env.h"
 #include "paddle/fluid/distributed/ps/service/sendrecv.pb.h"
+#include "paddle/fluid/distributed/ps/service/sparse_pull_cache.h"
 #include "paddle/fluid/distributed/ps/service/sparse_shard_value.h"
 #include "paddle/fluid/distributed/ps/table/accessor.h"
 #include "paddle/fluid/distributed/ps/table/graph/graph_node.h"
@@ -359,6 +360,16 @@ class PSClient {
     return nullptr;
   }
 
+  // 返回 worker 端 pull cache 的命中统计, 未开启时返回 false
+  bool GetPullCacheStat(size_t table_id, SparsePullCache::Stat *stat) {
+    auto *cache = GetPullCache(table_id);
+    if (cache == nullptr) {
+      return false;
+    }
+    *stat = cache->GetStat();
+    return true;
+  }
+
   virtual ::std::future<int32_t> SetDayId(size_t table_id, int day_id) {
     VLOG(0) << "SetDayId Did not implement";
     std::promise<int32_t> promise;
@@ -369,10 +380,42 @@ class PSClient {
 
  protected:
   virtual int32_t Initialize() = 0;
+
+  // 表配置 pull_cache_param 开启时返回该表的 worker 端 pull cache
+  inline SparsePullCache *GetPullCache(size_t table_id) {
+    auto itr = _pull_caches.find(table_id);
+    if (itr == _pull_caches.end()) {
+      return nullptr;
+    }
+    return itr->second.get();
+  }
+  // 命中 cache 的 key 本地填充, 其余 key 通过 pull_func 拉取后写入 cache.
+  // pull_func 在 values 写好后、future 就绪前调用 done, 不额外起线程
+  using SparsePullDone = std::function<void(int32_t ret)>;
+  using SparsePullFunc =
+      std::function<std::future<int32_t>(float **select_values,
+                                         const uint64_t *keys,
+                                         size_t num,
+                                         const SparsePullDone &done)>;
+  std::future<int32_t> PullSparseWithCache(SparsePullCache *cache,
+                                           float **select_values,
+                                           const uint64_t *keys,
+                                           size_t num,
+                                           const SparsePullFunc &pull_func);
+  inline void NotifyPullCacheOnPush(size_t table_id,
+                                    const uint64_t *keys,
+                                    size_t num) {
+    auto *cache = GetPullCache(table_id);
+    if (cache != nullptr) {
+      cache->OnPush(keys, num);
+    }
+  }
+
   PSParameter _config;
   std::map<uint64_t, std::vector<paddle::distributed::Region>>
       _dense_pull_regions;
   std::unordered_map<uint32_t, std::shared_ptr<ValueAccessor>> _table_accessors;
+  std::unordered_map<uint32_t, std::unique_ptr<SparsePullCache>> _pull_caches;
   std::unordered_map<int32_t, MsgHandlerFunc>
       _msg_handler_map;  // 处理client2client消息
 
@@ -224,6 +224,47 @@ int32_t PsLocalClient::Initialize() {
   return done();
 }
 
+::std::future<int32_t> PsLocalClient::PullSparse(float** select_values,
+                                                 size_t table_id,
+                                                 const uint64_t* keys,
+                                                 size_t num,
+                                                 bool is_training) {
+  auto pull_func = [this, table_id, is_training](
+                       float** values,
+                       const uint64_t* pull_keys,
+                       size_t n,
+                       const SparsePullDone& on_done) {
+    auto* accessor = GetTableAccessor(table_id);
+    auto* table_ptr = GetTable(table_id);
+    size_t select_dim = accessor->GetAccessorInfo().select_dim;
+    std::vector<uint64_t> feasigns(pull_keys, pull_keys + n);
+    std::vector<uint32_t> frequencies(n, 1);
+    std::vector<float> pull_buffer(n * select_dim);
+
+    TableContext table_context;
+    table_context.value_type = Sparse;
+    table_context.pull_context.pull_value =
+        PullSparseValue(feasigns, frequencies, select_dim);
+    table_context.pull_context.pull_value.is_training_ = is_training;
+    table_context.pull_context.values = pull_buffer.data();
+    table_context.num = n;
+    table_ptr->Pull(table_context);
+
+    for (size_t i = 0; i < n; ++i) {
+      memcpy(values[i],
+             pull_buffer.data() + i * select_dim,
+             select_dim * sizeof(float));
+    }
+    on_done(0);
+    return done();
+  };
+  auto* cache = GetPullCache(table_id);
+  if (cache == nullptr) {
+    return done();
+  }
+  return PullSparseWithCache(cache, select_values, keys, num, pull_func);
+}
+
 ::std::future<int32_t> PsLocalClient::PullSparsePtr(
     int shard_id,
     char** select_values,
@@ -261,6 +302,10 @@ int32_t PsLocalClient::Initialize() {
   std::pair<int64_t, int64_t> ret = table_ptr->PrintTableStat();
   VLOG(0) << "table id: " << table_id << ", feasign size: " << ret.first
           << ", mf size: " << ret.second;
+  auto* cache = GetPullCache(table_id);
+  if (cache != nullptr) {
+    VLOG(0) << "table id: " << table_id << ", " << cache->StatString();
+  }
   return done();
 }
 
@@ -284,6 +329,7 @@ int32_t PsLocalClient::Initialize() {
     const float** update_values,
     size_t num,
     void* callback) {
+  NotifyPullCacheOnPush(table_id, keys, num);
   PSClientClosure* closure = reinterpret_cast<PSClientClosure*>(callback);
   auto* table_ptr = GetTable(table_id);
 
@@ -304,6 +350,7 @@ int32_t PsLocalClient::Initialize() {
                                                  const uint64_t* keys,
                                                  const float** update_values,
                                                  size_t num) {
+  NotifyPullCacheOnPush(table_id, keys, num);
   auto* table_ptr = GetTable(table_id);
 
   TableContext table_context;
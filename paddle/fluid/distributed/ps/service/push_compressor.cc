@@ -0,0 +1,282 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/distributed/ps/service/push_compressor.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+
+#include "paddle/phi/common/bfloat16.h"
+#include "paddle/phi/common/float16.h"
+
+namespace paddle {
+namespace distributed {
+
+namespace {
+inline void AppendVarint(uint64_t value, std::string *out) {
+  while (value >= 0x80) {
+    out->push_back(static_cast<char>((value & 0x7F) | 0x80));
+    value >>= 7;
+  }
+  out->push_back(static_cast<char>(value));
+}
+
+inline bool ReadVarint(const char **cur, const char *end, uint64_t *value) {
+  uint64_t result = 0;
+  for (int shift = 0; shift < 64 && *cur < end; shift += 7) {
+    uint64_t byte = static_cast<uint8_t>(*(*cur)++);
+    result |= (byte & 0x7F) << shift;
+    if ((byte & 0x80) == 0) {
+      *value = result;
+      return true;
+    }
+  }
+  return false;
+}
+
+template <typename T>
+inline void AppendRaw(const T &value, std::string *out) {
+  out->append(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+template <typename T>
+inline bool ReadRaw(const char **cur, const char *end, T *value) {
+  if (end - *cur < static_cast<std::ptrdiff_t>(sizeof(T))) return false;
+  std::memcpy(value, *cur, sizeof(T));
+  *cur += sizeof(T);
+  return true;
+}
+
+// Returns the value as the receiver will decode it.
+inline float AppendValue(uint8_t value_type, float value, std::string *out) {
+  if (value_type == 1) {
+    phi::dtype::float16 half(value);
+    AppendRaw(half.x, out);
+    return static_cast<float>(half);
+  } else if (value_type == 2) {
+    phi::dtype::bfloat16 half(value);
+    AppendRaw(half.x, out);
+    return static_cast<float>(half);
+  }
+  AppendRaw(value, out);
+  return value;
+}
+
+inline float ReadValue(uint8_t value_type, const char **cur) {
+  if (value_type == 0) {
+    float value;
+    std::memcpy(&value, *cur, sizeof(float));
+    *cur += sizeof(float);
+    return value;
+  }
+  uint16_t bits;
+  std::memcpy(&bits, *cur, sizeof(uint16_t));
+  *cur += sizeof(uint16_t);
+  if (value_type == 1) {
+    return static_cast<float>(phi::dtype::raw_uint16_to_float16(bits));
+  }
+  return static_cast<float>(phi::dtype::raw_uint16_to_bfloat16(bits));
+}
+
+// Keys of a push are usually sorted per shard, but the merge path does not
+// guarantee it, hence zigzag deltas.
+inline uint64_t ZigZag(uint64_t cur, uint64_t prev) {
+  int64_t delta = static_cast<int64_t>(cur - prev);
+  return (static_cast<uint64_t>(delta) << 1) ^
+         static_cast<uint64_t>(delta >> 63);
+}
+
+inline uint64_t UnZigZag(uint64_t zigzag, uint64_t prev) {
+  int64_t delta = static_cast<int64_t>(zigzag >> 1) ^
+                  -static_cast<int64_t>(zigzag & 1);
+  return prev + static_cast<uint64_t>(delta);
+}
+}  // namespace
+
+void PushCompressor::EncodeSparse(const PushCompressHeader &header,
+                                  const uint64_t *keys,
+                                  const float *const *values,
+                                  size_t num,
+                                  std::string *out) {
+  size_t raw_dim = std::min(header.raw_prefix_dim, header.value_dim);
+  out->clear();
+  out->reserve(sizeof(uint32_t) + num * sizeof(uint64_t) +
+               num * (raw_dim * sizeof(float) +
+                      (header.value_dim - raw_dim) *
+                          ValueBytes(header.value_type)));
+  AppendRaw(static_cast<uint32_t>(0), out);
+  size_t keys_begin = out->size();
+  if (header.key_varint) {
+    uint64_t prev = 0;
+    for (size_t i = 0; i < num; ++i) {
+      AppendVarint(ZigZag(keys[i], prev), out);
+      prev = keys[i];
+    }
+  } else {
+    out->append(reinterpret_cast<const char *>(keys), num * sizeof(uint64_t));
+  }
+  uint32_t keys_bytes = static_cast<uint32_t>(out->size() - keys_begin);
+  std::memcpy(&(*out)[0], &keys_bytes, sizeof(uint32_t));
+
+  for (size_t i = 0; i < num; ++i) {
+    const float *row = values[i];
+    out->append(reinterpret_cast<const char *>(row), raw_dim * sizeof(float));
+    for (size_t j = raw_dim; j < header.value_dim; ++j) {
+      AppendValue(header.value_type, row[j], out);
+    }
+  }
+}
+
+bool PushCompressor::DecodeSparse(const PushCompressHeader &header,
+                                  const char *data,
+                                  size_t size,
+                                  size_t num,
+                                  std::vector<uint64_t> *keys,
+                                  std::vector<float> *values) {
+  const char *cur = data;
+  const char *end = data + size;
+  uint32_t keys_bytes = 0;
+  if (!ReadRaw(&cur, end, &keys_bytes) ||
+      end - cur < static_cast<std::ptrdiff_t>(keys_bytes)) {
+    return false;
+  }
+  keys->resize(num);
+  const char *keys_end = cur + keys_bytes;
+  if (header.key_varint) {
+    uint64_t prev = 0;
+    for (size_t i = 0; i < num; ++i) {
+      uint64_t zigzag = 0;
+      if (!ReadVarint(&cur, keys_end, &zigzag)) return false;
+      prev = UnZigZag(zigzag, prev);
+      (*keys)[i] = prev;
+    }
+  } else {
+    if (keys_bytes != num * sizeof(uint64_t)) return false;
+    std::memcpy(keys->data(), cur, keys_bytes);
+  }
+  cur = keys_end;
+
+  size_t raw_dim = std::min(header.raw_prefix_dim, header.value_dim);
+  size_t row_bytes = raw_dim * sizeof(float) +
+                     (header.value_dim - raw_dim) *
+                         ValueBytes(header.value_type);
+  if (static_cast<size_t>(end - cur) != num * row_bytes) {
+    return false;
+  }
+  values->resize(num * header.value_dim);
+  float *value = values->data();
+  for (size_t i = 0; i < num; ++i) {
+    std::memcpy(value, cur, raw_dim * sizeof(float));
+    cur += raw_dim * sizeof(float);
+    for (size_t j = raw_dim; j < header.value_dim; ++j) {
+      value[j] = ReadValue(header.value_type, &cur);
+    }
+    value += header.value_dim;
+  }
+  return true;
+}
+
+void PushCompressor::EncodeDense(const PushCompressHeader &header,
+                                 const float *values,
+                                 size_t k,
+                                 float *residual,
+                                 std::string *out) {
+  size_t num = header.value_dim;
+  out->clear();
+  if (!header.dense_topk) {
+    k = num;
+    out->reserve(2 * sizeof(uint32_t) + num * ValueBytes(header.value_type));
+    AppendRaw(static_cast<uint32_t>(k), out);
+    AppendRaw(static_cast<uint32_t>(0), out);
+    for (size_t i = 0; i < num; ++i) {
+      AppendValue(header.value_type, values[i], out);
+    }
+    return;
+  }
+
+  // Error feedback: what was not sent last time is added to this gradient.
+  for (size_t i = 0; i < num; ++i) {
+    residual[i] += values[i];
+  }
+  k = std::min(std::max<size_t>(k, 1), num);
+  std::vector<uint32_t> index(num);
+  std::iota(index.begin(), index.end(), 0);
+  if (k < num) {
+    std::nth_element(index.begin(),
+                     index.begin() + k,
+                     index.end(),
+                     [residual](uint32_t a, uint32_t b) {
+                       return std::fabs(residual[a]) > std::fabs(residual[b]);
+                     });
+    index.resize(k);
+    std::sort(index.begin(), index.end());
+  }
+
+  AppendRaw(static_cast<uint32_t>(k), out);
+  AppendRaw(static_cast<uint32_t>(0), out);
+  size_t index_begin = out->size();
+  uint32_t prev = 0;
+  for (uint32_t idx : index) {
+    AppendVarint(idx - prev, out);
+    prev = idx;
+  }
+  uint32_t index_bytes = static_cast<uint32_t>(out->size() - index_begin);
+  std::memcpy(&(*out)[sizeof(uint32_t)], &index_bytes, sizeof(uint32_t));
+  for (uint32_t idx : index) {
+    // The quantization error is kept as well.
+    residual[idx] -= AppendValue(header.value_type, residual[idx], out);
+  }
+}
+
+bool PushCompressor::DecodeDense(const PushCompressHeader &header,
+                                 const char *data,
+                                 size_t size,
+                                 std::vector<float> *values) {
+  const char *cur = data;
+  const char *end = data + size;
+  uint32_t k = 0;
+  uint32_t index_bytes = 0;
+  if (!ReadRaw(&cur, end, &k) || !ReadRaw(&cur, end, &index_bytes) ||
+      k > header.value_dim ||
+      end - cur < static_cast<std::ptrdiff_t>(index_bytes)) {
+    return false;
+  }
+  size_t value_bytes = ValueBytes(header.value_type);
+  values->assign(header.value_dim, 0.0f);
+  if (!header.dense_topk) {
+    if (static_cast<size_t>(end - cur) != k * value_bytes) return false;
+    for (uint32_t i = 0; i < k; ++i) {
+      (*values)[i] = ReadValue(header.value_type, &cur);
+    }
+    return true;
+  }
+  const char *index_cur = cur;
+  const char *index_end = cur + index_bytes;
+  cur = index_end;
+  if (static_cast<size_t>(end - cur) != k * value_bytes) return false;
+  uint64_t idx = 0;
+  for (uint32_t i = 0; i < k; ++i) {
+    uint64_t delta = 0;
+    if (!ReadVarint(&index_cur, index_end, &delta)) return false;
+    idx += delta;
+    if (idx >= header.value_dim) return false;
+    (*values)[idx] = ReadValue(header.value_type, &cur);
+  }
+  return true;
+}
+
+}  // namespace distributed
+}  // namespace paddle
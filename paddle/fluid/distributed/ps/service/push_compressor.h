@@ -0,0 +1,126 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace paddle {
+namespace distributed {
+
+constexpr uint32_t kPushCompressMagic = 0x50434D50;  // "PMCP"
+constexpr uint8_t kPushCompressVersion = 1;
+constexpr uint8_t kMaxPushValueType = 2;  // bf16
+
+// Describes how a push request payload is encoded. It is sent along with the
+// request (as an extra PsRequestMessage param), so the server can decode the
+// payload without knowing the client side table config. The param is told
+// apart from the other params by its magic, not by its position.
+#pragma pack(push, 1)
+struct PushCompressHeader {
+  uint32_t magic = kPushCompressMagic;
+  uint8_t version = kPushCompressVersion;
+  uint8_t value_type = 0;   // PushValueCompressType: 0 fp32, 1 fp16, 2 bf16
+  uint8_t key_varint = 0;   // sparse: keys are delta + zigzag varint encoded
+  uint8_t dense_topk = 0;   // dense: only top-k (index, value) pairs are sent
+  uint32_t raw_prefix_dim = 0;  // sparse: leading dims of a row kept in fp32
+  uint32_t value_dim = 0;       // sparse: dims of a row; dense: total dims
+};
+#pragma pack(pop)
+
+// Encodes and decodes compressed push payloads.
+//
+// Sparse payload:
+// |--keys bytes(4B)--|---keys---|---rows---|
+// rows keep the first raw_prefix_dim floats of each value in fp32 and the
+// remaining ones in value_type.
+//
+// Dense payload:
+// |--k(4B)--|--index bytes(4B)--|---indices---|---values---|
+// indices are delta varint encoded, k equals value_dim unless dense_topk.
+class PushCompressor {
+ public:
+  static bool IsCompressed(const PushCompressHeader &header) {
+    return header.value_type != 0 || header.key_varint != 0 ||
+           header.dense_topk != 0;
+  }
+
+  // Whether the param is a PushCompressHeader, of any version.
+  static bool IsHeader(const std::string &param) {
+    uint32_t magic = 0;
+    if (param.size() < sizeof(magic)) {
+      return false;
+    }
+    memcpy(&magic, param.data(), sizeof(magic));
+    return magic == kPushCompressMagic;
+  }
+
+  // Reads the header from the param, false if its size, version or value
+  // type is not supported.
+  static bool ParseHeader(const std::string &param,
+                          PushCompressHeader *header) {
+    if (param.size() != sizeof(PushCompressHeader)) {
+      return false;
+    }
+    memcpy(header, param.data(), sizeof(PushCompressHeader));
+    return header->magic == kPushCompressMagic &&
+           header->version == kPushCompressVersion &&
+           header->value_type <= kMaxPushValueType;
+  }
+
+  // A dense top-k push decodes to zeros at the unsent indices. That is a
+  // skipped step for sgd and summary, but adam and adam_d2sum would still
+  // decay their moments and move the parameters, so they need every
+  // gradient.
+  static bool SupportsDenseTopk(const std::string &optimizer) {
+    return optimizer == "sgd" || optimizer == "summary";
+  }
+
+  static void EncodeSparse(const PushCompressHeader &header,
+                           const uint64_t *keys,
+                           const float *const *values,
+                           size_t num,
+                           std::string *out);
+
+  static bool DecodeSparse(const PushCompressHeader &header,
+                           const char *data,
+                           size_t size,
+                           size_t num,
+                           std::vector<uint64_t> *keys,
+                           std::vector<float> *values);
+
+  // Sends the top `k` entries of `values + residual` by magnitude when
+  // header.dense_topk is set, the unsent part is left in `residual` for the
+  // next push (error feedback). `residual` may be null when not top-k.
+  static void EncodeDense(const PushCompressHeader &header,
+                          const float *values,
+                          size_t k,
+                          float *residual,
+                          std::string *out);
+
+  static bool DecodeDense(const PushCompressHeader &header,
+                          const char *data,
+                          size_t size,
+                          std::vector<float> *values);
+
+  static size_t ValueBytes(uint8_t value_type) {
+    return value_type == 0 ? sizeof(float) : sizeof(uint16_t);
+  }
+};
+
+}  // namespace distributed
+}  // namespace paddle
@@ -0,0 +1,156 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/distributed/ps/service/sparse_pull_cache.h"
+
+#include <cstring>
+#include <sstream>
+
+namespace paddle {
+namespace distributed {
+
+SparsePullCache::SparsePullCache(size_t capacity,
+                                 size_t row_dim,
+                                 uint32_t max_staleness_steps,
+                                 bool invalidate_on_push)
+    : row_dim_(row_dim),
+      slots_per_shard_((capacity + kShardNum - 1) / kShardNum),
+      max_staleness_steps_(max_staleness_steps),
+      invalidate_on_push_(invalidate_on_push) {
+  for (auto &shard : shards_) {
+    shard.index.reserve(slots_per_shard_);
+    shard.keys.resize(slots_per_shard_);
+    shard.steps.resize(slots_per_shard_);
+    shard.referenced.resize(slots_per_shard_, 0);
+    shard.used.resize(slots_per_shard_, 0);
+    shard.values.resize(slots_per_shard_ * row_dim_);
+  }
+}
+
+std::vector<size_t> SparsePullCache::Lookup(const uint64_t *keys,
+                                            size_t num,
+                                            float **select_values,
+                                            uint64_t *step) {
+  std::vector<size_t> missed;
+  *step = step_.load(std::memory_order_acquire);
+  uint64_t hits = 0;
+  for (size_t i = 0; i < num; ++i) {
+    Shard &shard = GetShard(keys[i]);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto iter = shard.index.find(keys[i]);
+    if (iter == shard.index.end() ||
+        *step - shard.steps[iter->second] > max_staleness_steps_) {
+      missed.push_back(i);
+      continue;
+    }
+    uint32_t slot = iter->second;
+    shard.referenced[slot] = 1;
+    std::memcpy(select_values[i],
+                shard.values.data() + slot * row_dim_,
+                row_dim_ * sizeof(float));
+    ++hits;
+  }
+  hits_.fetch_add(hits, std::memory_order_relaxed);
+  misses_.fetch_add(missed.size(), std::memory_order_relaxed);
+  return missed;
+}
+
+uint32_t SparsePullCache::EvictSlot(Shard *shard) {
+  while (true) {
+    uint32_t slot = shard->hand;
+    shard->hand = (shard->hand + 1) % slots_per_shard_;
+    if (!shard->used[slot]) {
+      return slot;
+    }
+    if (shard->referenced[slot]) {
+      shard->referenced[slot] = 0;
+      continue;
+    }
+    shard->index.erase(shard->keys[slot]);
+    shard->used[slot] = 0;
+    return slot;
+  }
+}
+
+void SparsePullCache::Insert(uint64_t step,
+                             const uint64_t *keys,
+                             const float *const *values,
+                             size_t num) {
+  if (slots_per_shard_ == 0) {
+    return;
+  }
+  for (size_t i = 0; i < num; ++i) {
+    uint64_t key = keys[i];
+    Shard &shard = GetShard(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    // A push happened while pulling, the rows may predate it. Checked under
+    // the shard lock since OnPush bumps the step before invalidating.
+    if (invalidate_on_push_ && step != step_.load(std::memory_order_acquire)) {
+      return;
+    }
+    uint32_t slot;
+    auto iter = shard.index.find(key);
+    if (iter != shard.index.end()) {
+      slot = iter->second;
+    } else {
+      slot = EvictSlot(&shard);
+      shard.index.emplace(key, slot);
+      shard.keys[slot] = key;
+      shard.used[slot] = 1;
+    }
+    shard.steps[slot] = step;
+    shard.referenced[slot] = 0;
+    std::memcpy(shard.values.data() + slot * row_dim_,
+                values[i],
+                row_dim_ * sizeof(float));
+  }
+}
+
+void SparsePullCache::OnPush(const uint64_t *keys, size_t num) {
+  step_.fetch_add(1, std::memory_order_acq_rel);
+  if (!invalidate_on_push_) {
+    return;
+  }
+  for (size_t i = 0; i < num; ++i) {
+    Shard &shard = GetShard(keys[i]);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto iter = shard.index.find(keys[i]);
+    if (iter != shard.index.end()) {
+      shard.used[iter->second] = 0;
+      shard.index.erase(iter);
+    }
+  }
+}
+
+SparsePullCache::Stat SparsePullCache::GetStat() const {
+  Stat stat;
+  stat.hits = hits_.load(std::memory_order_relaxed);
+  stat.misses = misses_.load(std::memory_order_relaxed);
+  stat.saved_bytes = stat.hits * (sizeof(uint64_t) + row_dim_ * sizeof(float));
+  return stat;
+}
+
+std::string SparsePullCache::StatString() const {
+  Stat stat = GetStat();
+  uint64_t total = stat.hits + stat.misses;
+  std::stringstream ss;
+  ss << "pull cache hits: " << stat.hits << ", misses: " << stat.misses
+     << ", hit ratio: "
+     << (total == 0 ? 0.0 : static_cast<double>(stat.hits) / total)
+     << ", saved bytes: " << stat.saved_bytes;
+  return ss.str();
+}
+
+}  // namespace distributed
+}  // namespace paddle
@@ -0,0 +1,99 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace paddle {
+namespace distributed {
+
+// A bounded worker side cache of pulled sparse rows.
+//
+// Rows are cached with the step they were pulled at, a step being one push
+// to the table. A row older than `max_staleness_steps` steps is treated as a
+// miss, and with `invalidate_on_push` pushed keys are dropped right away so
+// the next pull sees the update of this worker. The cache is split in
+// independently locked shards, each holding a fixed number of rows in a
+// contiguous slab evicted with the CLOCK (second chance) policy.
+class SparsePullCache {
+ public:
+  struct Stat {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t saved_bytes = 0;  // key and value bytes not sent over the wire
+  };
+
+  SparsePullCache(size_t capacity,
+                  size_t row_dim,
+                  uint32_t max_staleness_steps,
+                  bool invalidate_on_push);
+
+  // Copies cached rows into `select_values`, returns the indices of keys
+  // that missed and have to be pulled. `step` receives the step the lookup
+  // happened at, to be passed to Insert.
+  std::vector<size_t> Lookup(const uint64_t *keys,
+                             size_t num,
+                             float **select_values,
+                             uint64_t *step);
+
+  // Caches pulled rows. Rows pulled before a push are dropped when
+  // invalidating on push.
+  void Insert(uint64_t step,
+              const uint64_t *keys,
+              const float *const *values,
+              size_t num);
+
+  // Advances the step and, if configured, invalidates the pushed keys.
+  void OnPush(const uint64_t *keys, size_t num);
+
+  Stat GetStat() const;
+  std::string StatString() const;
+
+ private:
+  static constexpr size_t kShardNum = 16;
+
+  struct Shard {
+    std::mutex mutex;
+    std::unordered_map<uint64_t, uint32_t> index;  // key -> slot
+    std::vector<uint64_t> keys;
+    std::vector<uint64_t> steps;
+    std::vector<uint8_t> referenced;
+    std::vector<uint8_t> used;
+    std::vector<float> values;
+    uint32_t hand = 0;
+  };
+
+  Shard &GetShard(uint64_t key) { return shards_[(key >> 7) % kShardNum]; }
+  uint32_t EvictSlot(Shard *shard);
+
+  size_t row_dim_;
+  size_t slots_per_shard_;
+  uint32_t max_staleness_steps_;
+  bool invalidate_on_push_;
+  std::atomic<uint64_t> step_{0};
+  Shard shards_[kShardNum];
+
+  std::atomic<uint64_t> hits_{0};
+  std::atomic<uint64_t> misses_{0};
+};
+
+}  // namespace distributed
+}  // namespace paddle
@@ -0,0 +1,197 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/distributed/ps/service/sparse_pull_coalescer.h"
+
+#include <sstream>
+
+#include "glog/logging.h"
+
+namespace paddle {
+namespace distributed {
+
+SparsePullCoalescer::SparsePullCoalescer(PullFunc pull_func,
+                                         int64_t window_us,
+                                         size_t max_batch_keys)
+    : pull_func_(std::move(pull_func)),
+      window_(window_us),
+      max_batch_keys_(max_batch_keys) {
+  flush_thread_ = std::thread(&SparsePullCoalescer::FlushLoop, this);
+  complete_thread_ = std::thread(&SparsePullCoalescer::CompleteLoop, this);
+}
+
+SparsePullCoalescer::~SparsePullCoalescer() { Stop(); }
+
+std::future<int32_t> SparsePullCoalescer::Pull(float **select_values,
+                                               size_t table_id,
+                                               const uint64_t *keys,
+                                               size_t num,
+                                               bool is_training,
+                                               DoneFunc on_done) {
+  auto promise = std::make_shared<std::promise<int32_t>>();
+  std::future<int32_t> fut = promise->get_future();
+  pull_requests_.fetch_add(1, std::memory_order_relaxed);
+  pulled_keys_.fetch_add(num, std::memory_order_relaxed);
+  auto now = Clock::now();
+  bool notify = false;
+  {
+    std::lock_guard<std::mutex> lock(pending_mutex_);
+    if (!running_) {
+      if (on_done) {
+        on_done(-1);
+      }
+      promise->set_value(-1);
+      return fut;
+    }
+    if (pending_.empty()) {
+      oldest_pending_ = now;
+      notify = true;
+    }
+    auto &batch = pending_[BatchKey(table_id, is_training)];
+    batch.keys.insert(batch.keys.end(), keys, keys + num);
+    batch.select_values.insert(
+        batch.select_values.end(), select_values, select_values + num);
+    batch.promises.push_back(promise);
+    batch.on_dones.push_back(std::move(on_done));
+    batch.enqueue_times.push_back(now);
+    notify = notify || batch.keys.size() >= max_batch_keys_;
+  }
+  if (notify) {
+    pending_cv_.notify_one();
+  }
+  return fut;
+}
+
+bool SparsePullCoalescer::HasFullBatch() const {
+  for (auto &item : pending_) {
+    if (item.second.keys.size() >= max_batch_keys_) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void SparsePullCoalescer::FlushLoop() {
+  while (true) {
+    std::map<BatchKey, PendingBatch> batches;
+    {
+      std::unique_lock<std::mutex> lock(pending_mutex_);
+      pending_cv_.wait(lock, [this] { return !running_ || !pending_.empty(); });
+      if (pending_.empty()) {
+        break;  // stopped and drained
+      }
+      // Keep collecting callers until the window of the oldest one closes.
+      pending_cv_.wait_until(lock, oldest_pending_ + window_, [this] {
+        return !running_ || HasFullBatch();
+      });
+      batches.swap(pending_);
+    }
+    for (auto &item : batches) {
+      PendingBatch &batch = item.second;
+      InflightBatch inflight;
+      inflight.future = pull_func_(batch.select_values.data(),
+                                   item.first.first,
+                                   batch.keys.data(),
+                                   batch.keys.size(),
+                                   item.first.second);
+      inflight.batch = std::move(batch);
+      merged_pulls_.fetch_add(1, std::memory_order_relaxed);
+      {
+        std::lock_guard<std::mutex> lock(inflight_mutex_);
+        inflight_.emplace_back(std::move(inflight));
+      }
+      inflight_cv_.notify_one();
+    }
+  }
+  {
+    std::lock_guard<std::mutex> lock(inflight_mutex_);
+    flush_done_ = true;
+  }
+  inflight_cv_.notify_one();
+}
+
+void SparsePullCoalescer::CompleteLoop() {
+  while (true) {
+    InflightBatch inflight;
+    {
+      std::unique_lock<std::mutex> lock(inflight_mutex_);
+      inflight_cv_.wait(lock,
+                        [this] { return flush_done_ || !inflight_.empty(); });
+      if (inflight_.empty()) {
+        break;
+      }
+      inflight = std::move(inflight_.front());
+      inflight_.pop_front();
+    }
+    int32_t ret = inflight.future.get();
+    auto now = Clock::now();
+    auto &batch = inflight.batch;
+    for (size_t i = 0; i < batch.promises.size(); ++i) {
+      total_latency_us_.fetch_add(
+          std::chrono::duration_cast<std::chrono::microseconds>(
+              now - batch.enqueue_times[i])
+              .count(),
+          std::memory_order_relaxed);
+      if (batch.on_dones[i]) {
+        batch.on_dones[i](ret);
+      }
+      batch.promises[i]->set_value(ret);
+    }
+    completed_requests_.fetch_add(batch.promises.size(),
+                                  std::memory_order_relaxed);
+    VLOG(3) << "SparsePullCoalescer merged " << batch.promises.size()
+            << " pulls with " << batch.keys.size() << " keys, ret: " << ret;
+  }
+}
+
+void SparsePullCoalescer::Stop() {
+  {
+    std::lock_guard<std::mutex> lock(pending_mutex_);
+    if (!running_) {
+      return;
+    }
+    running_ = false;
+  }
+  pending_cv_.notify_one();
+  flush_thread_.join();
+  complete_thread_.join();
+  VLOG(0) << "SparsePullCoalescer stopped, " << StatString();
+}
+
+SparsePullCoalescer::Stat SparsePullCoalescer::GetStat() const {
+  Stat stat;
+  stat.pull_requests = pull_requests_.load(std::memory_order_relaxed);
+  stat.merged_pulls = merged_pulls_.load(std::memory_order_relaxed);
+  stat.pulled_keys = pulled_keys_.load(std::memory_order_relaxed);
+  uint64_t completed = completed_requests_.load(std::memory_order_relaxed);
+  if (completed > 0) {
+    stat.avg_latency_us =
+        static_cast<double>(total_latency_us_.load(std::memory_order_relaxed)) /
+        completed;
+  }
+  return stat;
+}
+
+std::string SparsePullCoalescer::StatString() const {
+  Stat stat = GetStat();
+  std::stringstream ss;
+  ss << "pull_requests: " << stat.pull_requests
+     << ", merged_pulls: " << stat.merged_pulls
+     << ", pulled_keys: " << stat.pulled_keys
+     << ", avg_latency_us: " << stat.avg_latency_us;
+  return ss.str();
+}
+
+}  // namespace distributed
+}  // namespace paddle
@@ -0,0 +1,131 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace paddle {
+namespace distributed {
+
+// Merges concurrent PullSparse calls on the same table into one pull.
+//
+// Callers arriving within `window_us` of the first pending call of a
+// (table_id, is_training) pair are batched together, their keys are
+// concatenated and handed to `pull_func` at once. Duplicate keys across
+// callers are deduplicated by the underlying pull (keys are sorted per shard
+// and each unique key is requested once), and the pulled values are written
+// straight into every caller's output buffers, so fanning the result back is
+// only a matter of fulfilling each caller's promise.
+//
+// Batches are issued from a flush thread and completed from a separate
+// thread, so the serialization and send of batch N+1 overlap with the
+// network round trip of batch N. A caller may pass `on_done`, which runs on
+// the completion thread once its values are written and before its future
+// becomes ready.
+class SparsePullCoalescer {
+ public:
+  using PullFunc = std::function<std::future<int32_t>(
+      float **select_values,
+      size_t table_id,
+      const uint64_t *keys,
+      size_t num,
+      bool is_training)>;
+  using DoneFunc = std::function<void(int32_t ret)>;
+
+  struct Stat {
+    uint64_t pull_requests = 0;  // PullSparse calls from callers
+    uint64_t merged_pulls = 0;   // pulls issued to the underlying client
+    uint64_t pulled_keys = 0;    // keys requested by callers
+    double avg_latency_us = 0;   // mean caller latency, enqueue to completion
+  };
+
+  SparsePullCoalescer(PullFunc pull_func,
+                      int64_t window_us,
+                      size_t max_batch_keys);
+  ~SparsePullCoalescer();
+
+  std::future<int32_t> Pull(float **select_values,
+                            size_t table_id,
+                            const uint64_t *keys,
+                            size_t num,
+                            bool is_training,
+                            DoneFunc on_done = nullptr);
+
+  // Issues all pending pulls, waits for them and joins the worker threads.
+  void Stop();
+
+  Stat GetStat() const;
+  std::string StatString() const;
+
+ private:
+  using Clock = std::chrono::steady_clock;
+  using BatchKey = std::pair<size_t, bool>;
+
+  struct PendingBatch {
+    std::vector<uint64_t> keys;
+    std::vector<float *> select_values;
+    std::vector<std::shared_ptr<std::promise<int32_t>>> promises;
+    std::vector<DoneFunc> on_dones;
+    std::vector<Clock::time_point> enqueue_times;
+  };
+
+  struct InflightBatch {
+    std::future<int32_t> future;
+    PendingBatch batch;
+  };
+
+  void FlushLoop();
+  void CompleteLoop();
+  bool HasFullBatch() const;
+
+  PullFunc pull_func_;
+  std::chrono::microseconds window_;
+  size_t max_batch_keys_;
+
+  std::mutex pending_mutex_;
+  std::condition_variable pending_cv_;
+  std::map<BatchKey, PendingBatch> pending_;
+  Clock::time_point oldest_pending_;
+  bool running_ = true;
+
+  std::mutex inflight_mutex_;
+  std::condition_variable inflight_cv_;
+  std::deque<InflightBatch> inflight_;
+  bool flush_done_ = false;
+
+  std::thread flush_thread_;
+  std::thread complete_thread_;
+
+  std::atomic<uint64_t> pull_requests_{0};
+  std::atomic<uint64_t> merged_pulls_{0};
+  std::atomic<uint64_t> pulled_keys_{0};
+  std::atomic<uint64_t> completed_requests_{0};
+  std::atomic<uint64_t> total_latency_us_{0};
+};
+
+}  // namespace distributed
+}  // namespace paddle
@@ -16,6 +16,7 @@
 
 #include <math.h>  // for sqrt in CPU and CUDA
 
+#include <algorithm>
 #include <functional>
 #include <memory>
 #include <string>
@@ -28,6 +29,11 @@
 namespace paddle {
 namespace distributed {
 
+// The optimizers update [begin, end) block by block, all the statements of a
+// block are computed while its values are in cache, so that every value is
+// read from and written to memory once per update.
+constexpr int kDenseOptimizerBlockSize = 1024;
+
 // dense optimizer
 // TODO(tangwei12) integrate with sparse optimizer later.
 class DenseOptimizer {
@@ -90,15 +96,10 @@ class DSGD : public DenseOptimizer {
               size_t num,
               int begin,
               int end) override {
-    auto update_numel = end - begin;
-    std::vector<float> grads;
-    grads.resize(update_numel);
-
-    auto blas = GetBlas<float>();
     float lr = *(global_learning_rate_) * (*learning_rate);
-    blas.VCOPY(update_numel, update_values + begin, grads.data());
-    blas.SCAL(update_numel, lr, grads.data());
-    blas.VSUB(update_numel, param + begin, grads.data(), param + begin);
+    Eigen::Map<Eigen::ArrayXf> w(param + begin, end - begin);
+    Eigen::Map<const Eigen::ArrayXf> grad(update_values + begin, end - begin);
+    w -= lr * grad;
   }
 
   float* learning_rate;
@@ -145,40 +146,23 @@ class DAdam : public DenseOptimizer {
               size_t num,
               int begin,
               int end) override {
-    auto update_numel = end - begin;
-    std::vector<float> grad, grad2, tmp;
-    grad.resize(update_numel);
-    grad2.resize(update_numel);
-    tmp.resize(update_numel);
-
-    auto blas = GetBlas<float>();
-    blas.VCOPY(update_numel, update_values + begin, grad.data());
-    blas.VCOPY(update_numel, update_values + begin, grad2.data());
-
-    blas.SCAL(update_numel, 1 - beta1, grad.data());
-    blas.VSQUARE(update_numel, grad2.data(), grad2.data());
-    blas.SCAL(update_numel, 1 - beta2, grad2.data());
-
-    blas.SCAL(update_numel, beta1, moment1 + begin);
-    blas.VADD(update_numel, moment1 + begin, grad.data(), moment1 + begin);
-    blas.SCAL(update_numel, beta2, moment2 + begin);
-    blas.VADD(update_numel, moment2 + begin, grad2.data(), moment2 + begin);
-
     beta1_pow[0] = beta1_pow[0] * beta1;
     beta2_pow[0] = beta2_pow[0] * beta2;
 
     float lr_ = *(global_learning_rate_)*learning_rate[0];
     lr_ *= sqrt(1 - beta2_pow[0]) / (1 - beta1_pow[0]);
-
-    float* tmp_ = tmp.data();
     float eps_ = epsilon * sqrt(1 - beta2_pow[0]);
 
-    SQRT<float>(update_numel, moment2 + begin, tmp_);
-    ADD<float>(update_numel, tmp_, eps_, tmp_);
-
-    blas.VDIV(update_numel, moment1 + begin, tmp_, tmp_);
-    blas.SCAL(update_numel, lr_, tmp_);
-    blas.VSUB(update_numel, param + begin, tmp_, param + begin);
+    for (int b = begin; b < end; b += kDenseOptimizerBlockSize) {
+      int numel = std::min(kDenseOptimizerBlockSize, end - b);
+      Eigen::Map<Eigen::ArrayXf> w(param + b, numel);
+      Eigen::Map<Eigen::ArrayXf> m1(moment1 + b, numel);
+      Eigen::Map<Eigen::ArrayXf> m2(moment2 + b, numel);
+      Eigen::Map<const Eigen::ArrayXf> grad(update_values + b, numel);
+      m1 = beta1 * m1 + (1 - beta1) * grad;
+      m2 = beta2 * m2 + (1 - beta2) * grad.square();
+      w -= lr_ * m1 / (m2.sqrt() + eps_);
+    }
   }
 
   float* learning_rate;
@@ -227,36 +211,21 @@ class DAdamD2Sum : public DenseOptimizer {
               size_t num,
               int begin,
               int end) override {
-    auto update_numel = end - begin;
-    Eigen::Map<Eigen::MatrixXf> mat_ada_g2sum(
-        ada_g2sum + begin, 1, update_numel);
-
-    Eigen::Map<Eigen::MatrixXf> mat_ada_d2sum(
-        ada_d2sum + begin, 1, update_numel);
-    Eigen::Map<Eigen::MatrixXf> mat_mom_velocity(
-        mom_velocity + begin, 1, update_numel);
-    Eigen::Map<Eigen::MatrixXf> mat_w(param + begin, 1, update_numel);
-
-    Eigen::Map<const Eigen::MatrixXf> mat_grad(
-        update_values + begin, 1, update_numel);
-
-    mat_ada_d2sum = (mat_ada_d2sum * ada_decay_rate[0]).array() + 1;
-    mat_ada_g2sum =
-        (mat_ada_g2sum * ada_decay_rate[0]) + mat_grad.cwiseProduct(mat_grad);
-
-    thread_local std::vector<float> scale_vec;
-    scale_vec.resize(update_numel);
-    Eigen::Map<Eigen::MatrixXf> scale(scale_vec.data(), 1, update_numel);
-    memcpy(
-        scale_vec.data(), mat_ada_d2sum.data(), sizeof(float) * update_numel);
-
-    scale = scale.array() * ada_epsilon[0];
-    scale = (mat_ada_d2sum + scale).cwiseQuotient(mat_ada_g2sum + scale);
-    scale = scale.cwiseSqrt();
-    mat_mom_velocity =
-        (mat_mom_velocity + mat_grad) * mom_decay_rate[0] - mat_grad;
-
-    mat_w += learning_rate[0] * mat_mom_velocity.cwiseProduct(scale);
+    for (int b = begin; b < end; b += kDenseOptimizerBlockSize) {
+      int numel = std::min(kDenseOptimizerBlockSize, end - b);
+      Eigen::Map<Eigen::ArrayXf> g2sum(ada_g2sum + b, numel);
+      Eigen::Map<Eigen::ArrayXf> d2sum(ada_d2sum + b, numel);
+      Eigen::Map<Eigen::ArrayXf> mom(mom_velocity + b, numel);
+      Eigen::Map<Eigen::ArrayXf> w(param + b, numel);
+      Eigen::Map<const Eigen::ArrayXf> grad(update_values + b, numel);
+
+      d2sum = d2sum * ada_decay_rate[0] + 1;
+      g2sum = g2sum * ada_decay_rate[0] + grad.square();
+      mom = (mom + grad) * mom_decay_rate[0] - grad;
+      w += learning_rate[0] * mom *
+           ((d2sum + d2sum * ada_epsilon[0]) / (g2sum + d2sum * ada_epsilon[0]))
+               .sqrt();
+    }
   }
 
   float* learning_rate;
@@ -291,11 +260,9 @@ class DSummary : public DenseOptimizer {
               size_t num,
               int begin,
               int end) override {
-    auto update_numel = end - begin;
-    Eigen::Map<Eigen::MatrixXf> mat_w(param + begin, 1, update_numel);
-    Eigen::Map<const Eigen::MatrixXf> mat_grad(
-        update_values + begin, 1, update_numel);
-    mat_w = mat_w * summary_decay_rate_d + mat_grad;
+    Eigen::Map<Eigen::ArrayXf> w(param + begin, end - begin);
+    Eigen::Map<const Eigen::ArrayXf> grad(update_values + begin, end - begin);
+    w = w * static_cast<float>(summary_decay_rate_d) + grad;
   }
 
   float* summary_decay_rate;
@@ -50,6 +50,21 @@ int32_t MemoryDenseTable::Initialize() {
 
   InitializeValue();
   InitializeOptimizer();
+
+  // Top-k pushes arrive with zeros at the unsent indices, see
+  // PushCompressor::SupportsDenseTopk.
+  if (_config.has_push_compress_param() &&
+      _config.push_compress_param().dense_topk_ratio() < 1.0f) {
+    const auto &optimizer = _config.common().name();
+    PADDLE_ENFORCE_EQ(
+        optimizer == "sgd" || optimizer == "summary",
+        true,
+        common::errors::InvalidArgument(
+            "dense_topk_ratio of table %s is only supported with sgd or "
+            "summary, but got %s.",
+            _config.common().table_name(),
+            optimizer));
+  }
   return 0;
 }
 
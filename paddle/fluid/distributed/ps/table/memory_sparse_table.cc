@@ -13,6 +13,8 @@
 // limitations under the License.
 
 #include <omp.h>
+#include <chrono>
+#include <limits>
 #include <sstream>
 
 #include "glog/logging.h"
@@ -38,9 +40,131 @@ PD_DEFINE_bool(pserver_enable_create_feasign_randomly,
 PD_DEFINE_int32(pserver_table_save_max_retry,
                 3,
                 "pserver_table_save_max_retry");
+PD_DEFINE_bool(pserver_sparse_table_columnar_save,
+               false,
+               "save the checkpoints of sparse tables in columnar binary "
+               "files, and track the rows touched since the last save for "
+               "delta checkpoints");
 
 namespace paddle::distributed {
 
+namespace {
+
+// A columnar file is a sequence of blocks of at most kColumnarBlockRows rows:
+//   uint32 magic, uint32 rows, uint32 max_dim,
+//   uint64 keys[rows], uint16 dims[rows],
+//   for column c in [0, max_dim): the floats c of the rows with dims > c.
+// A row with dim 0 is a key erased since the last checkpoint.
+constexpr uint32_t kColumnarMagic = 0x42435350;  // "PSCB"
+constexpr size_t kColumnarBlockRows = 64 * 1024;
+
+std::string ColumnarFileName(const std::string &table_path,
+                             int node_idx,
+                             size_t file_idx,
+                             bool compress) {
+  return ::paddle::string::format_string("%s/part-%03d-%05d.col%s",
+                                         table_path.c_str(),
+                                         node_idx,
+                                         file_idx,
+                                         compress ? ".gz" : "");
+}
+
+bool IsColumnarFile(const std::string &path) {
+  return ::paddle::string::ends_with(path, ".col") ||
+         ::paddle::string::ends_with(path, ".col.gz");
+}
+
+class ColumnarBlockWriter {
+ public:
+  explicit ColumnarBlockWriter(FsWriteChannel *channel) : channel_(channel) {}
+
+  // `value` must be alive until the block is written
+  int Add(uint64_t key, const float *value, size_t dim) {
+    PADDLE_ENFORCE_LE(dim,
+                      std::numeric_limits<uint16_t>::max(),
+                      common::errors::InvalidArgument(
+                          "The value dim %d of key %lu is too large for the "
+                          "columnar sparse table file.",
+                          dim,
+                          key));
+    keys_.push_back(key);
+    dims_.push_back(static_cast<uint16_t>(dim));
+    values_.push_back(value);
+    max_dim_ = std::max(max_dim_, static_cast<uint32_t>(dim));
+    return keys_.size() >= kColumnarBlockRows ? Write() : 0;
+  }
+
+  int Write() {
+    if (keys_.empty()) {
+      return 0;
+    }
+    uint32_t header[3] = {
+        kColumnarMagic, static_cast<uint32_t>(keys_.size()), max_dim_};
+    int ret = channel_->write(reinterpret_cast<const char *>(header),
+                              sizeof(header));
+    ret |= channel_->write(reinterpret_cast<const char *>(keys_.data()),
+                           keys_.size() * sizeof(uint64_t));
+    ret |= channel_->write(reinterpret_cast<const char *>(dims_.data()),
+                           dims_.size() * sizeof(uint16_t));
+    bytes_ += sizeof(header) + keys_.size() * sizeof(uint64_t) +
+              dims_.size() * sizeof(uint16_t);
+    for (uint32_t c = 0; c < max_dim_; ++c) {
+      column_.clear();
+      for (size_t r = 0; r < keys_.size(); ++r) {
+        if (dims_[r] > c) {
+          column_.push_back(values_[r][c]);
+        }
+      }
+      ret |= channel_->write(reinterpret_cast<const char *>(column_.data()),
+                             column_.size() * sizeof(float));
+      bytes_ += column_.size() * sizeof(float);
+    }
+    keys_.clear();
+    dims_.clear();
+    values_.clear();
+    max_dim_ = 0;
+    return ret;
+  }
+
+  size_t bytes() const { return bytes_; }
+
+ private:
+  FsWriteChannel *channel_;
+  std::vector<uint64_t> keys_;
+  std::vector<uint16_t> dims_;
+  std::vector<const float *> values_;
+  std::vector<float> column_;
+  uint32_t max_dim_ = 0;
+  size_t bytes_ = 0;
+};
+
+bool ReadFully(FsReadChannel *channel, void *data, size_t size) {
+  char *cursor = reinterpret_cast<char *>(data);
+  while (size > 0) {
+    int n = channel->read(cursor, size);
+    if (n <= 0) {
+      return false;
+    }
+    cursor += n;
+    size -= n;
+  }
+  return true;
+}
+
+}  // namespace
+
+void TouchedRows::Reset(size_t rows) {
+  // about 4 bits a row
+  size_t num_bits = 64 * 1024;
+  _shift = 48;
+  while (num_bits < rows * 4) {
+    num_bits *= 2;
+    --_shift;
+  }
+  _bits.assign(num_bits / 64, 0);
+  std::vector<uint64_t>().swap(_erased_keys);
+}
+
 int32_t MemorySparseTable::Initialize() {
   auto &profiler = CostProfiler::instance();
   profiler.register_profiler("pserver_sparse_update_all");
@@ -50,6 +174,10 @@ int32_t MemorySparseTable::Initialize() {
   for (auto &shards_task : _shards_task_pool) {
     shards_task.reset(new ::ThreadPool(1));
   }
+  if (FLAGS_pserver_sparse_table_columnar_save) {
+    _local_touched_rows.resize(_real_local_shard_num);
+    ResetTouchedRows();
+  }
   VLOG(0) << "initalize MemorySparseTable succ";
   return 0;
 }
@@ -145,6 +273,9 @@ int32_t MemorySparseTable::Load(const std::string &path,
   if (load_param == 5) {
     return LoadPatch(file_list, load_param);
   }
+  if (IsColumnarFile(file_list[0])) {
+    return LoadColumnar(file_list);
+  }
 
   size_t file_start_idx = _shard_idx * _avg_local_shard_num;
 
@@ -354,9 +485,21 @@ int32_t MemorySparseTable::Save(const std::string &dirname,
     _local_shards_new.reset(new shard_type[_real_local_shard_num]);  // NOLINT
     _save_patch_model_thread = std::thread(std::bind(
         &MemorySparseTable::SavePatch, this, std::string(dirname), save_param));
+    ResetTouchedRows();
     return 0;
   }
 
+  // columnar checkpoint and delta checkpoint
+  if (FLAGS_pserver_sparse_table_columnar_save &&
+      (save_param == 0 || save_param == 6)) {
+    return SaveColumnar(dirname, save_param);
+  }
+  if (save_param == 6) {
+    LOG(WARNING) << "MemorySparseTable delta checkpoint needs "
+                    "FLAGS_pserver_sparse_table_columnar_save";
+    return -1;
+  }
+
   // cache model
   int64_t tk_size = LocalSize() * _config.sparse_table_cache_rate();
   TopkCalculator tk(_real_local_shard_num, tk_size);
@@ -464,6 +607,7 @@ int32_t MemorySparseTable::Save(const std::string &dirname,
               << channel_config.path << " feasign_size: " << feasign_size;
   }
   _local_show_threshold = tk.top();
+  ResetTouchedRows();
   // int32 may overflow need to change return value
   return 0;
 }
@@ -486,6 +630,7 @@ int32_t MemorySparseTable::Save_v2(const std::string &dirname,
     _local_shards_new.reset(new shard_type[_real_local_shard_num]);
     _save_patch_model_thread = std::thread(std::bind(
         &MemorySparseTable::SavePatch, this, std::string(dirname), save_param));
+    ResetTouchedRows();
     return 0;
   }
 
@@ -665,6 +810,7 @@ int32_t MemorySparseTable::Save_v2(const std::string &dirname,
               << ", feature feasign size:" << feasign_size_for_slot_feature;
   }
   _local_show_threshold = tk.top();
+  ResetTouchedRows();
   // int32 may overflow need to change return value
   return 0;
 }
@@ -759,6 +905,252 @@ int32_t MemorySparseTable::SavePatch(const std::string &path, int save_param) {
   return 0;
 }
 
+void MemorySparseTable::ResetTouchedRows() {
+  for (size_t i = 0; i < _local_touched_rows.size(); ++i) {
+    _local_touched_rows[i].Reset(_local_shards[i].size());
+  }
+}
+
+int32_t MemorySparseTable::SaveColumnar(const std::string &path,
+                                        int save_param) {
+  auto start = std::chrono::steady_clock::now();
+  bool delta = save_param == 6;
+  std::string table_path = TableDir(path);
+  _afs_client.remove(::paddle::string::format_string(
+      "%s/part-%03d-*", table_path.c_str(), _shard_idx));
+  size_t file_start_idx = _avg_local_shard_num * _shard_idx;
+  std::atomic<size_t> bytes_all{0};
+  std::atomic<size_t> feasign_size_all{0};
+
+  int thread_num = _real_local_shard_num < 20 ? _real_local_shard_num : 20;
+  omp_set_num_threads(thread_num);
+#pragma omp parallel for schedule(dynamic)
+  for (int i = 0; i < _real_local_shard_num; ++i) {
+    FsChannelConfig channel_config = {};
+    channel_config.path = ColumnarFileName(
+        table_path, _shard_idx, file_start_idx + i, _config.compress_in_save());
+    auto &shard = _local_shards[i];
+    bool is_write_failed = false;
+    int retry_num = 0;
+    int err_no = 0;
+    size_t feasign_size = 0;
+    size_t bytes = 0;
+    do {
+      err_no = 0;
+      feasign_size = 0;
+      auto write_channel =
+          _afs_client.open_w(channel_config, 1024 * 1024 * 40, &err_no);
+      ColumnarBlockWriter writer(write_channel.get());
+      int ret = 0;
+      if (delta) {
+        // the erased keys first, as a key may be created again after it is
+        // erased
+        const auto &touched = _local_touched_rows[i];
+        for (uint64_t key : touched.erased_keys()) {
+          ret |= writer.Add(key, nullptr, 0);
+          ++feasign_size;
+        }
+        for (auto it = shard.begin(); it != shard.end(); ++it) {
+          if (touched.IsTouched(it.key())) {
+            ret |= writer.Add(it.key(), it.value().data(), it.value().size());
+            ++feasign_size;
+          }
+        }
+      } else {
+        for (auto it = shard.begin(); it != shard.end(); ++it) {
+          ret |= writer.Add(it.key(), it.value().data(), it.value().size());
+          ++feasign_size;
+        }
+      }
+      ret |= writer.Write();
+      bytes = writer.bytes();
+      write_channel->close();
+      is_write_failed = ret != 0 || err_no == -1;
+      if (is_write_failed) {
+        ++retry_num;
+        LOG(ERROR) << "MemorySparseTable save columnar failed, retry it! path:"
+                   << channel_config.path << " , retry_num=" << retry_num;
+        _afs_client.remove(channel_config.path);
+      }
+      if (retry_num > FLAGS_pserver_table_save_max_retry) {
+        LOG(ERROR) << "MemorySparseTable save columnar failed reach max limit!";
+        exit(-1);
+      }
+    } while (is_write_failed);
+    if (!delta) {
+      for (auto it = shard.begin(); it != shard.end(); ++it) {
+        _value_accessor->UpdateStatAfterSave(it.value().data(), save_param);
+      }
+    }
+    if (!_local_touched_rows.empty()) {
+      _local_touched_rows[i].Reset(shard.size());
+    }
+    feasign_size_all += feasign_size;
+    bytes_all += bytes;
+  }
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  LOG(INFO) << "MemorySparseTable save " << (delta ? "delta " : "")
+            << "columnar success, path: " << table_path
+            << " feasign_size: " << feasign_size_all << " bytes: " << bytes_all
+            << " in " << seconds << "s, "
+            << bytes_all / seconds / (1024.0 * 1024 * 1024) << " GB/s";
+  return 0;
+}
+
+int32_t MemorySparseTable::LoadColumnar(
+    const std::vector<std::string> &file_list) {
+  auto start = std::chrono::steady_clock::now();
+  size_t file_start_idx = _shard_idx * _avg_local_shard_num;
+  if (file_start_idx >= file_list.size()) {
+    return 0;
+  }
+  std::atomic<size_t> bytes_all{0};
+  const size_t value_size =
+      _value_accessor->GetAccessorInfo().size / sizeof(float);
+
+  int thread_num = _real_local_shard_num < 15 ? _real_local_shard_num : 15;
+  omp_set_num_threads(thread_num);
+#pragma omp parallel for schedule(dynamic)
+  for (int i = 0; i < _real_local_shard_num; ++i) {
+    FsChannelConfig channel_config = {};
+    channel_config.path = file_list[file_start_idx + i];
+    auto &shard = _local_shards[i];
+    std::vector<uint64_t> keys;
+    std::vector<uint16_t> dims;
+    std::vector<float> values;
+    std::vector<size_t> column_offsets;
+    size_t bytes = 0;
+    bool is_read_failed = false;
+    int retry_num = 0;
+    int err_no = 0;
+    // a file is loaded again from its start when it fails, which is fine as
+    // the rows are overwritten or erased
+    do {
+      is_read_failed = false;
+      err_no = 0;
+      bytes = 0;
+      auto read_channel = _afs_client.open_r(channel_config, 0, &err_no);
+      try {
+        uint32_t header[3];
+        while (ReadFully(read_channel.get(), header, sizeof(header))) {
+          PADDLE_ENFORCE_EQ(header[0],
+                            kColumnarMagic,
+                            common::errors::InvalidArgument(
+                                "%s is not a columnar sparse table file.",
+                                channel_config.path));
+          uint32_t rows = header[1];
+          uint32_t max_dim = header[2];
+          PADDLE_ENFORCE_EQ(
+              rows <= kColumnarBlockRows && max_dim <= value_size,
+              true,
+              common::errors::InvalidArgument(
+                  "A block of the columnar sparse table file %s has %d rows "
+                  "of at most %d floats, but a block holds at most %d rows "
+                  "of at most %d floats of the table.",
+                  channel_config.path,
+                  rows,
+                  max_dim,
+                  kColumnarBlockRows,
+                  value_size));
+          keys.resize(rows);
+          dims.resize(rows);
+          bool ok = ReadFully(
+              read_channel.get(), keys.data(), rows * sizeof(uint64_t));
+          ok = ok && ReadFully(read_channel.get(),
+                               dims.data(),
+                               rows * sizeof(uint16_t));
+          PADDLE_ENFORCE_EQ(
+              ok,
+              true,
+              common::errors::InvalidArgument(
+                  "The columnar sparse table file %s is truncated.",
+                  channel_config.path));
+          // the floats of column c start at column_offsets[c]
+          column_offsets.assign(max_dim + 1, 0);
+          for (uint32_t r = 0; r < rows; ++r) {
+            PADDLE_ENFORCE_LE(
+                dims[r],
+                max_dim,
+                common::errors::InvalidArgument(
+                    "The dim %d of key %lu in the columnar sparse table file "
+                    "%s is larger than the max dim %d of its block.",
+                    dims[r],
+                    keys[r],
+                    channel_config.path,
+                    max_dim));
+            for (uint32_t c = 0; c < dims[r]; ++c) {
+              ++column_offsets[c + 1];
+            }
+          }
+          for (uint32_t c = 0; c < max_dim; ++c) {
+            column_offsets[c + 1] += column_offsets[c];
+          }
+          values.resize(column_offsets[max_dim]);
+          ok = ReadFully(read_channel.get(),
+                         values.data(),
+                         values.size() * sizeof(float));
+          PADDLE_ENFORCE_EQ(
+              ok,
+              true,
+              common::errors::InvalidArgument(
+                  "The columnar sparse table file %s is truncated.",
+                  channel_config.path));
+          bytes += sizeof(header) + rows * sizeof(uint64_t) +
+                   rows * sizeof(uint16_t) + values.size() * sizeof(float);
+
+          for (uint32_t r = 0; r < rows; ++r) {
+            if (dims[r] == 0) {
+              shard.erase(keys[r]);
+              continue;
+            }
+            auto &value = shard[keys[r]];
+            value.resize(dims[r]);
+            float *data = value.data();
+            for (uint32_t c = 0; c < dims[r]; ++c) {
+              data[c] = values[column_offsets[c]++];
+            }
+          }
+        }
+        read_channel->close();
+        if (err_no == -1) {
+          ++retry_num;
+          is_read_failed = true;
+          LOG(ERROR) << "MemorySparseTable load columnar failed after read, "
+                        "retry it! path:"
+                     << channel_config.path << " , retry_num=" << retry_num;
+        }
+      } catch (const std::exception &e) {
+        ++retry_num;
+        is_read_failed = true;
+        LOG(ERROR) << "MemorySparseTable load columnar failed, retry it! path:"
+                   << channel_config.path << " , retry_num=" << retry_num
+                   << ", error: " << e.what();
+      } catch (...) {
+        ++retry_num;
+        is_read_failed = true;
+        LOG(ERROR) << "MemorySparseTable load columnar failed, retry it! path:"
+                   << channel_config.path << " , retry_num=" << retry_num;
+      }
+      if (retry_num > FLAGS_pserver_table_save_max_retry) {
+        LOG(ERROR) << "MemorySparseTable load columnar failed reach max limit!";
+        exit(-1);
+      }
+    } while (is_read_failed);
+    bytes_all += bytes;
+  }
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  LOG(INFO) << "MemorySparseTable load columnar success, path from "
+            << file_list[file_start_idx] << " to "
+            << file_list[file_start_idx + _real_local_shard_num - 1]
+            << " bytes: " << bytes_all << " in " << seconds << "s, "
+            << bytes_all / seconds / (1024.0 * 1024 * 1024) << " GB/s";
+  return 0;
+}
+
 int64_t MemorySparseTable::CacheShuffle(
     const std::string &path,
     const std::string &param,
@@ -1049,6 +1441,9 @@ int32_t MemorySparseTable::PullSparse(float *pull_values,
                     _value_accessor->Create(&data_buffer_ptr, 1);
                     memcpy(
                         data_ptr, data_buffer_ptr, data_size * sizeof(float));
+                    if (!_local_touched_rows.empty()) {
+                      _local_touched_rows[shard_id].Touch(key);
+                    }
                   }
                 } else {
                   data_size = itr.value().size();
@@ -1214,6 +1609,9 @@ int32_t MemorySparseTable::PushSparse(const uint64_t *keys,
                      value_data,
                      new_size * sizeof(float));
             }
+            if (!_local_touched_rows.empty()) {
+              _local_touched_rows[shard_id].Touch(key);
+            }
           }
           return 0;
         });
@@ -1282,6 +1680,9 @@ int32_t MemorySparseTable::PushSparse(const uint64_t *keys,
               }
               memcpy(value_data, data_buffer_ptr, value_size * sizeof(float));
             }
+            if (!_local_touched_rows.empty()) {
+              _local_touched_rows[shard_id].Touch(key);
+            }
           }
           return 0;
         });
@@ -1307,6 +1708,9 @@ int32_t MemorySparseTable::Shrink(const std::string &param) {
     auto &shard = _local_shards[shard_id];
     for (auto it = shard.begin(); it != shard.end();) {
       if (_value_accessor->Shrink(it.value().data())) {
+        if (!_local_touched_rows.empty()) {
+          _local_touched_rows[shard_id].Erase(it.key());
+        }
         it = shard.erase(it);
         ++feasign_size;
       } else {
@@ -36,6 +36,36 @@
 namespace paddle {
 namespace distributed {
 
+// The rows of a shard touched since the last save, for delta checkpoints. A
+// key sets the bit of its hash, so a delta may hold a few untouched rows as
+// well. The erased keys are listed, as their rows are gone.
+class TouchedRows {
+ public:
+  void Touch(uint64_t key) {
+    size_t bit = Bit(key);
+    _bits[bit / 64] |= uint64_t{1} << (bit % 64);
+  }
+  bool IsTouched(uint64_t key) const {
+    size_t bit = Bit(key);
+    return (_bits[bit / 64] >> (bit % 64)) & 1;
+  }
+  void Erase(uint64_t key) { _erased_keys.push_back(key); }
+  const std::vector<uint64_t>& erased_keys() const { return _erased_keys; }
+
+  // Clears the rows, and sizes the bits for a shard of `rows` rows.
+  void Reset(size_t rows);
+
+ private:
+  size_t Bit(uint64_t key) const {
+    // fibonacci hashing, the keys may be sequential
+    return static_cast<size_t>((key * 0x9E3779B97F4A7C15ull) >> _shift);
+  }
+
+  std::vector<uint64_t> _bits;
+  int _shift = 64;
+  std::vector<uint64_t> _erased_keys;
+};
+
 class MemorySparseTable : public Table {
  public:
   typedef SparseTableShard<uint64_t, FixedFeatureValue> shard_type;
@@ -118,6 +148,10 @@ class MemorySparseTable : public Table {
   virtual int32_t SavePatch(const std::string& path, int save_param);
   virtual int32_t LoadPatch(const std::vector<std::string>& file_list,
                             int save_param);
+  // checkpoints in columnar binary files, save_param 0 saves all the rows
+  // and save_param 6 the rows touched since the last save
+  int32_t SaveColumnar(const std::string& path, int save_param);
+  int32_t LoadColumnar(const std::vector<std::string>& file_list);
 
   int _task_pool_size = 24;
   int _avg_local_shard_num;
@@ -136,6 +170,11 @@ class MemorySparseTable : public Table {
   std::unique_ptr<shard_type[]> _local_shards_new;
   std::unique_ptr<shard_type[]> _local_shards_patch_model;
   std::thread _save_patch_model_thread;
+
+  // rows pushed, created or shrunk in each shard since the last save, only
+  // tracked when columnar checkpoints are enabled
+  std::vector<TouchedRows> _local_touched_rows;
+  void ResetTouchedRows();
   bool _use_gpu_graph = false;
 };
 
@@ -14,6 +14,7 @@ limitations under the License. */
 
 #include <ThreadPool.h>
 
+#include <chrono>
 #include <vector>
 
 #include "gtest/gtest.h"
@@ -227,5 +228,115 @@ TEST(MemoryDenseTable, SGD) {
   }
 }
 
+// A sgd table of fea_dim floats initialized to 1, with a learning rate of
+// 0.001.
+Table *MakeSgdTable(int fea_dim) {
+  TableParameter table_config;
+  table_config.set_table_class("MemoryDenseTable");
+  FsClientParameter fs_config;
+  Table *table = new MemoryDenseTable();
+  TableAccessorParameter *accessor_config = table_config.mutable_accessor();
+  accessor_config->set_accessor_class("CommMergeAccessor");
+  CommonAccessorParameter *common_config = table_config.mutable_common();
+  common_config->set_name("sgd");
+  common_config->set_table_name("sgd_push_test_table");
+  common_config->set_trainer_num(1);
+  common_config->add_params("Param");
+  common_config->add_dims(fea_dim);
+  common_config->add_initializers("fill_constant&1.0");
+  common_config->add_params("LearningRate");
+  common_config->add_dims(1);
+  common_config->add_initializers("fill_constant&0.001");
+  EXPECT_EQ(table->Initialize(table_config, fs_config), 0);
+  return table;
+}
+
+void PushDense(Table *table, std::vector<float> *values) {
+  TableContext table_context;
+  table_context.value_type = Dense;
+  table_context.push_context.values = values->data();
+  table_context.num = values->size();
+  table->Push(table_context);
+}
+
+std::vector<float> PullDense(Table *table, int fea_dim) {
+  std::vector<float> values(fea_dim);
+  TableContext table_context;
+  table_context.value_type = Dense;
+  table_context.pull_context.values = values.data();
+  table_context.num = fea_dim;
+  table->Pull(table_context);
+  return values;
+}
+
+// Pushes of many concurrent trainers. Returns the seconds spent.
+double RunConcurrentPushes(int fea_dim,
+                           int pushers,
+                           int pushes_per_pusher,
+                           std::vector<float> *pull_values) {
+  Table *table = MakeSgdTable(fea_dim);
+  std::vector<std::vector<float>> gradients(pushers);
+  for (int i = 0; i < pushers; i++) {
+    gradients[i].resize(fea_dim);
+    for (int k = 0; k < fea_dim; k++) {
+      gradients[i][k] = 0.01 * (i + 1) + 0.001 * (k % 7);
+    }
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  ::ThreadPool pool(pushers);
+  std::vector<std::future<void>> task_status;
+  for (int i = 0; i < pushers; i++) {
+    auto *push_values = &gradients[i];
+    task_status.push_back(
+        pool.enqueue([table, push_values, pushes_per_pusher] {
+          for (int n = 0; n < pushes_per_pusher; n++) {
+            PushDense(table, push_values);
+          }
+        }));
+  }
+  for (auto &status : task_status) {
+    status.wait();
+  }
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+
+  *pull_values = PullDense(table, fea_dim);
+  delete table;
+  return seconds;
+}
+
+TEST(MemoryDenseTable, ConcurrentPush) {
+  int fea_dim = 1000;
+  int pushers = 8;
+  int pushes_per_pusher = 4;
+  std::vector<float> pull_values;
+  RunConcurrentPushes(fea_dim, pushers, pushes_per_pusher, &pull_values);
+  // sgd is linear in the gradients, so the order of the pushes only changes
+  // the rounding
+  for (int k = 0; k < fea_dim; k++) {
+    float total_gradient = 0;
+    for (int i = 0; i < pushers; i++) {
+      total_gradient += 0.01 * (i + 1) + 0.001 * (k % 7);
+    }
+    float expected = 1.0 - 0.001 * total_gradient * pushes_per_pusher;
+    ASSERT_NEAR(pull_values[k], expected, 1e-5);
+  }
+}
+
+// Throughput of the fused sgd, run with --gtest_also_run_disabled_tests
+TEST(MemoryDenseTable, DISABLED_PushBenchmark) {
+  int fea_dim = 1 << 20;
+  int pushers = 32;
+  int pushes_per_pusher = 8;
+  int total_pushes = pushers * pushes_per_pusher;
+  std::vector<float> pull_values;
+  double seconds =
+      RunConcurrentPushes(fea_dim, pushers, pushes_per_pusher, &pull_values);
+  LOG(INFO) << pushers << " pushers, " << total_pushes << " pushes of "
+            << fea_dim << " floats: " << total_pushes / seconds << " pushes/s";
+}
+
 }  // namespace distributed
 }  // namespace paddle
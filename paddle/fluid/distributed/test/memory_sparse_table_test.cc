@@ -25,6 +25,8 @@ limitations under the License. */
 #include "paddle/fluid/distributed/ps/table/table.h"
 #include "paddle/fluid/distributed/the_one_ps.pb.h"
 
+PD_DECLARE_bool(pserver_sparse_table_columnar_save);
+
 namespace paddle {
 namespace distributed {
 
@@ -152,5 +154,82 @@ TEST(MemorySparseTable, SGD) {
   }
 }
 
+Table *CreateColumnarTestTable() {
+  TableParameter table_config;
+  table_config.set_table_class("MemorySparseTable");
+  table_config.set_shard_num(10);
+  FsClientParameter fs_config;
+  Table *table = new MemorySparseTable();
+  table->SetShard(0, 1);
+
+  TableAccessorParameter *accessor_config = table_config.mutable_accessor();
+  accessor_config->set_accessor_class("CtrCommonAccessor");
+  accessor_config->set_fea_dim(11);
+  accessor_config->set_embedx_dim(8);
+  accessor_config->set_embedx_threshold(5);
+  accessor_config->mutable_embed_sgd_param()->set_name("SparseNaiveSGDRule");
+  auto *naive_param =
+      accessor_config->mutable_embed_sgd_param()->mutable_naive();
+  naive_param->set_learning_rate(0.1);
+  naive_param->set_initial_range(0.3);
+  accessor_config->mutable_embedx_sgd_param()->set_name("SparseNaiveSGDRule");
+  naive_param = accessor_config->mutable_embedx_sgd_param()->mutable_naive();
+  naive_param->set_learning_rate(0.1);
+  naive_param->set_initial_range(0.3);
+  EXPECT_EQ(table->Initialize(table_config, fs_config), 0);
+  return table;
+}
+
+void PushColumnarTestKeys(Table *table, uint64_t begin, uint64_t end) {
+  std::vector<uint64_t> keys;
+  std::vector<float> gradients;
+  for (uint64_t key = begin; key < end; ++key) {
+    keys.push_back(key);
+    // slot, show, click, embed_g and 8 embedx_g
+    gradients.insert(gradients.end(), {0.f, 10.f, 1.f, 0.1f});
+    gradients.insert(gradients.end(), 8, 0.01 * (key % 13));
+  }
+  TableContext table_context;
+  table_context.value_type = Sparse;
+  table_context.push_context.keys = keys.data();
+  table_context.push_context.values = gradients.data();
+  table_context.num = keys.size();
+  table->Push(table_context);
+}
+
+TEST(MemorySparseTable, ColumnarSaveLoad) {
+  FLAGS_pserver_sparse_table_columnar_save = true;
+  Table *table = CreateColumnarTestTable();
+  PushColumnarTestKeys(table, 0, 10000);
+  ASSERT_EQ(table->Save("columnar_test_base", "0"), 0);
+  // the delta checkpoint saves the rows pushed after the base
+  PushColumnarTestKeys(table, 5000, 15000);
+  ASSERT_EQ(table->Save("columnar_test_delta", "6"), 0);
+
+  Table *loaded_table = CreateColumnarTestTable();
+  ASSERT_EQ(loaded_table->Load("columnar_test_base", "0"), 0);
+  ASSERT_EQ(loaded_table->Load("columnar_test_delta", "6"), 0);
+  FLAGS_pserver_sparse_table_columnar_save = false;
+
+  size_t rows = 0;
+  for (size_t i = 0; i < 10; ++i) {
+    auto *shard =
+        static_cast<MemorySparseTable::shard_type *>(table->GetShard(i));
+    auto *loaded_shard = static_cast<MemorySparseTable::shard_type *>(
+        loaded_table->GetShard(i));
+    ASSERT_EQ(shard->size(), loaded_shard->size());
+    for (auto it = shard->begin(); it != shard->end(); ++it) {
+      auto loaded_it = loaded_shard->find(it.key());
+      ASSERT_TRUE(loaded_it != loaded_shard->end());
+      ASSERT_EQ(it.value().size(), loaded_it.value().size());
+      for (size_t c = 0; c < it.value().size(); ++c) {
+        ASSERT_EQ(it.value().data()[c], loaded_it.value().data()[c]);
+      }
+      ++rows;
+    }
+  }
+  ASSERT_EQ(rows, 15000u);
+}
+
 }  // namespace distributed
 }  // namespace paddle
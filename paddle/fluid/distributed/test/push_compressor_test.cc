@@ -0,0 +1,212 @@
+/* Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/distributed/ps/service/push_compressor.h"
+
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "glog/logging.h"
+#include "gtest/gtest.h"
+
+namespace paddle {
+namespace distributed {
+
+namespace {
+// slot, show, click, embed_g, embedx_g * 8, as pushed by CtrCommonAccessor
+constexpr uint32_t kSparseDim = 12;
+constexpr uint32_t kRawPrefixDim = 3;
+
+void MakeSparsePush(size_t num,
+                    std::vector<uint64_t> *keys,
+                    std::vector<float> *values,
+                    std::vector<const float *> *value_ptrs) {
+  std::mt19937_64 rng(0);
+  std::normal_distribution<float> grad(0.0f, 0.01f);
+  keys->resize(num);
+  values->resize(num * kSparseDim);
+  value_ptrs->resize(num);
+  uint64_t key = 1000000007ULL;
+  for (size_t i = 0; i < num; ++i) {
+    key += rng() % 4096;  // sorted keys of one shard
+    (*keys)[i] = key;
+    float *row = values->data() + i * kSparseDim;
+    row[0] = static_cast<float>(rng() % 10000);  // slot
+    row[1] = 1.0f;                               // show
+    row[2] = static_cast<float>(rng() % 2);      // click
+    for (uint32_t j = kRawPrefixDim; j < kSparseDim; ++j) {
+      row[j] = grad(rng);
+    }
+    (*value_ptrs)[i] = row;
+  }
+}
+}  // namespace
+
+TEST(PushCompressor, SparseRoundTrip) {
+  constexpr size_t kNum = 100000;
+  std::vector<uint64_t> keys;
+  std::vector<float> values;
+  std::vector<const float *> value_ptrs;
+  MakeSparsePush(kNum, &keys, &values, &value_ptrs);
+  size_t raw_bytes = kNum * (sizeof(uint64_t) + kSparseDim * sizeof(float));
+
+  for (uint8_t value_type : {0, 1, 2}) {
+    PushCompressHeader header;
+    header.value_type = value_type;
+    header.key_varint = 1;
+    header.raw_prefix_dim = kRawPrefixDim;
+    header.value_dim = kSparseDim;
+
+    std::string payload;
+    auto start = std::chrono::steady_clock::now();
+    PushCompressor::EncodeSparse(
+        header, keys.data(), value_ptrs.data(), kNum, &payload);
+    auto encoded = std::chrono::steady_clock::now();
+    std::vector<uint64_t> decoded_keys;
+    std::vector<float> decoded_values;
+    ASSERT_TRUE(PushCompressor::DecodeSparse(header,
+                                             payload.data(),
+                                             payload.size(),
+                                             kNum,
+                                             &decoded_keys,
+                                             &decoded_values));
+    auto decoded = std::chrono::steady_clock::now();
+
+    EXPECT_EQ(decoded_keys, keys);
+    float tolerance = value_type == 0 ? 0.0f : (value_type == 1 ? 1e-3 : 1e-2);
+    for (size_t i = 0; i < kNum * kSparseDim; ++i) {
+      if (i % kSparseDim < kRawPrefixDim) {
+        ASSERT_EQ(decoded_values[i], values[i]);
+      } else {
+        ASSERT_NEAR(decoded_values[i],
+                    values[i],
+                    std::fabs(values[i]) * tolerance + 1e-7);
+      }
+    }
+    LOG(INFO) << "sparse value_type " << static_cast<int>(value_type)
+              << ": wire/raw bytes " << payload.size() << "/" << raw_bytes
+              << ", encode "
+              << std::chrono::duration<double, std::milli>(encoded - start)
+                     .count()
+              << " ms, decode "
+              << std::chrono::duration<double, std::milli>(decoded - encoded)
+                     .count()
+              << " ms";
+  }
+
+  // a corrupted payload is rejected rather than read out of bounds
+  PushCompressHeader header;
+  header.key_varint = 1;
+  header.value_dim = kSparseDim;
+  std::string payload;
+  PushCompressor::EncodeSparse(
+      header, keys.data(), value_ptrs.data(), kNum, &payload);
+  payload.resize(payload.size() / 2);
+  std::vector<uint64_t> decoded_keys;
+  std::vector<float> decoded_values;
+  EXPECT_FALSE(PushCompressor::DecodeSparse(header,
+                                            payload.data(),
+                                            payload.size(),
+                                            kNum,
+                                            &decoded_keys,
+                                            &decoded_values));
+}
+
+TEST(PushCompressor, DenseTopkErrorFeedback) {
+  constexpr uint32_t kDim = 10000;
+  constexpr size_t kSteps = 20;
+  std::mt19937 rng(0);
+  std::normal_distribution<float> grad(0.0f, 1.0f);
+
+  PushCompressHeader header;
+  header.value_type = 1;
+  header.dense_topk = 1;
+  header.value_dim = kDim;
+
+  std::vector<float> residual(kDim, 0.0f);
+  std::vector<double> sent_sum(kDim, 0.0);
+  std::vector<double> grad_sum(kDim, 0.0);
+  std::vector<float> gradient(kDim);
+  size_t wire_bytes = 0;
+  for (size_t step = 0; step < kSteps; ++step) {
+    for (uint32_t i = 0; i < kDim; ++i) {
+      gradient[i] = grad(rng);
+      grad_sum[i] += gradient[i];
+    }
+    std::string payload;
+    PushCompressor::EncodeDense(
+        header, gradient.data(), kDim / 100, residual.data(), &payload);
+    wire_bytes += payload.size();
+    std::vector<float> decoded;
+    ASSERT_TRUE(PushCompressor::DecodeDense(
+        header, payload.data(), payload.size(), &decoded));
+    size_t non_zero = 0;
+    for (uint32_t i = 0; i < kDim; ++i) {
+      sent_sum[i] += decoded[i];
+      non_zero += decoded[i] != 0.0f;
+    }
+    EXPECT_EQ(non_zero, kDim / 100);
+  }
+  // Nothing is lost: what was not sent is still in the residual.
+  for (uint32_t i = 0; i < kDim; ++i) {
+    EXPECT_NEAR(sent_sum[i] + residual[i], grad_sum[i], 1e-2);
+  }
+  LOG(INFO) << "dense top-1%: wire/raw bytes " << wire_bytes << "/"
+            << kSteps * (sizeof(uint32_t) + kDim * sizeof(float));
+}
+
+TEST(PushCompressor, Header) {
+  PushCompressHeader header;
+  header.value_type = 2;
+  header.value_dim = 11;
+  std::string param(reinterpret_cast<const char *>(&header), sizeof(header));
+  EXPECT_TRUE(PushCompressor::IsHeader(param));
+  PushCompressHeader parsed;
+  ASSERT_TRUE(PushCompressor::ParseHeader(param, &parsed));
+  EXPECT_EQ(parsed.value_type, 2);
+  EXPECT_EQ(parsed.value_dim, 11u);
+
+  // other params, e.g. the number of keys, are not headers
+  uint32_t num = sizeof(header);
+  EXPECT_FALSE(PushCompressor::IsHeader(
+      std::string(reinterpret_cast<const char *>(&num), sizeof(num))));
+  std::string other(sizeof(header), '\0');
+  EXPECT_FALSE(PushCompressor::IsHeader(other));
+  EXPECT_FALSE(PushCompressor::ParseHeader(other, &parsed));
+
+  // an unknown value type is not parsed
+  header.value_type = kMaxPushValueType + 1;
+  param.assign(reinterpret_cast<const char *>(&header), sizeof(header));
+  EXPECT_FALSE(PushCompressor::ParseHeader(param, &parsed));
+  header.value_type = 2;
+
+  // a header of another version is recognized but not parsed
+  header.version = kPushCompressVersion + 1;
+  param.assign(reinterpret_cast<const char *>(&header), sizeof(header));
+  EXPECT_TRUE(PushCompressor::IsHeader(param));
+  EXPECT_FALSE(PushCompressor::ParseHeader(param, &parsed));
+}
+
+TEST(PushCompressor, DenseTopkOptimizers) {
+  EXPECT_TRUE(PushCompressor::SupportsDenseTopk("sgd"));
+  EXPECT_TRUE(PushCompressor::SupportsDenseTopk("summary"));
+  EXPECT_FALSE(PushCompressor::SupportsDenseTopk("adam"));
+  EXPECT_FALSE(PushCompressor::SupportsDenseTopk("adam_d2sum"));
+}
+
+}  // namespace distributed
+}  // namespace paddle
@@ -0,0 +1,181 @@
+/* Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/distributed/ps/service/sparse_pull_cache.h"
+
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "paddle/fluid/distributed/ps/service/env.h"
+#include "paddle/fluid/distributed/ps/service/ps_client.h"
+#include "paddle/fluid/distributed/the_one_ps.pb.h"
+
+namespace paddle {
+namespace distributed {
+
+TEST(SparsePullCache, StalenessAndInvalidation) {
+  constexpr size_t kDim = 4;
+  std::vector<uint64_t> keys = {1, 2, 3};
+  std::vector<float> rows = {1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3};
+  std::vector<const float *> row_ptrs = {
+      rows.data(), rows.data() + kDim, rows.data() + 2 * kDim};
+  std::vector<float> out(keys.size() * kDim);
+  std::vector<float *> out_ptrs = {
+      out.data(), out.data() + kDim, out.data() + 2 * kDim};
+
+  // served for one push, invalidated on push
+  SparsePullCache cache(64, kDim, 1, true);
+  uint64_t step = 0;
+  EXPECT_EQ(cache.Lookup(keys.data(), keys.size(), out_ptrs.data(), &step)
+                .size(),
+            3UL);
+  cache.Insert(step, keys.data(), row_ptrs.data(), keys.size());
+  EXPECT_TRUE(
+      cache.Lookup(keys.data(), keys.size(), out_ptrs.data(), &step).empty());
+  EXPECT_EQ(out, rows);
+
+  cache.OnPush(keys.data(), 1);  // key 1 pushed
+  auto missed = cache.Lookup(keys.data(), keys.size(), out_ptrs.data(), &step);
+  ASSERT_EQ(missed.size(), 1UL);
+  EXPECT_EQ(missed[0], 0UL);
+
+  cache.OnPush(keys.data() + 2, 1);  // two pushes since keys 2, 3 were cached
+  missed = cache.Lookup(keys.data(), keys.size(), out_ptrs.data(), &step);
+  EXPECT_EQ(missed.size(), 3UL);
+
+  // rows pulled before a push are not cached when invalidating on push
+  cache.OnPush(keys.data(), 0);
+  cache.Insert(step, keys.data(), row_ptrs.data(), keys.size());
+  missed = cache.Lookup(keys.data(), keys.size(), out_ptrs.data(), &step);
+  EXPECT_EQ(missed.size(), 3UL);
+
+  auto stat = cache.GetStat();
+  EXPECT_EQ(stat.hits, 5UL);
+  EXPECT_EQ(stat.misses, 10UL);
+  EXPECT_EQ(stat.saved_bytes, 5 * (sizeof(uint64_t) + kDim * sizeof(float)));
+}
+
+TEST(SparsePullCache, BoundedCapacity) {
+  constexpr size_t kDim = 2;
+  constexpr size_t kCapacity = 256;
+  SparsePullCache cache(kCapacity, kDim, 1000, false);
+  std::vector<uint64_t> keys(kCapacity * 8);
+  std::vector<float> rows(keys.size() * kDim, 1.0f);
+  std::vector<const float *> row_ptrs(keys.size());
+  std::vector<float *> out_ptrs(keys.size());
+  for (size_t i = 0; i < keys.size(); ++i) {
+    keys[i] = i << 7;  // spread over the shards
+    row_ptrs[i] = rows.data() + i * kDim;
+    out_ptrs[i] = rows.data() + i * kDim;
+  }
+  cache.Insert(0, keys.data(), row_ptrs.data(), keys.size());
+  uint64_t step = 0;
+  auto missed = cache.Lookup(keys.data(), keys.size(), out_ptrs.data(), &step);
+  EXPECT_GE(missed.size(), keys.size() - kCapacity);
+  EXPECT_LT(missed.size(), keys.size());
+}
+
+namespace {
+void GetSparseTableProto(TableParameter *table_proto) {
+  table_proto->set_table_id(0);
+  table_proto->set_table_class("MemorySparseTable");
+  table_proto->set_shard_num(10);
+  auto *cache_param = table_proto->mutable_pull_cache_param();
+  cache_param->set_capacity(1024);
+  cache_param->set_max_staleness_steps(1);
+  cache_param->set_invalidate_on_push(true);
+
+  TableAccessorParameter *accessor_config = table_proto->mutable_accessor();
+  accessor_config->set_accessor_class("CtrCommonAccessor");
+  accessor_config->set_fea_dim(11);
+  accessor_config->set_embedx_dim(8);
+  accessor_config->set_embedx_threshold(0);
+  accessor_config->mutable_ctr_accessor_param()->set_nonclk_coeff(0.2);
+  accessor_config->mutable_ctr_accessor_param()->set_click_coeff(1);
+  accessor_config->mutable_ctr_accessor_param()->set_base_threshold(0.5);
+  accessor_config->mutable_ctr_accessor_param()->set_delta_threshold(0.2);
+  accessor_config->mutable_ctr_accessor_param()->set_delta_keep_days(16);
+  accessor_config->mutable_ctr_accessor_param()->set_show_click_decay_rate(
+      0.99);
+  for (auto *sgd_param : {accessor_config->mutable_embed_sgd_param(),
+                          accessor_config->mutable_embedx_sgd_param()}) {
+    sgd_param->set_name("SparseNaiveSGDRule");
+    auto *naive_param = sgd_param->mutable_naive();
+    naive_param->set_learning_rate(0.1);
+    naive_param->set_initial_range(0.3);
+    naive_param->add_weight_bounds(-10.0);
+    naive_param->add_weight_bounds(10.0);
+  }
+}
+}  // namespace
+
+TEST(SparsePullCache, PsLocalClient) {
+  PSParameter ps_param;
+  auto *server_param = ps_param.mutable_server_param()
+                           ->mutable_downpour_server_param();
+  server_param->mutable_service_param()->set_client_class("PsLocalClient");
+  GetSparseTableProto(server_param->add_downpour_table_param());
+  GetSparseTableProto(ps_param.mutable_worker_param()
+                          ->mutable_downpour_worker_param()
+                          ->add_downpour_table_param());
+
+  std::shared_ptr<PSClient> client(PSClientFactory::Create(ps_param));
+  ASSERT_NE(client, nullptr);
+  PaddlePSEnvironment env;
+  std::map<uint64_t, std::vector<Region>> regions;
+  ASSERT_EQ(client->Configure(ps_param, regions, env, 0), 0);
+
+  constexpr size_t kSelectDim = 11;  // show, click, embed_w, embedx_w * 8
+  std::vector<uint64_t> keys = {10, 20, 30, 40};
+  std::vector<float> first(keys.size() * kSelectDim);
+  std::vector<float> second(keys.size() * kSelectDim);
+  std::vector<float *> first_ptrs, second_ptrs;
+  for (size_t i = 0; i < keys.size(); ++i) {
+    first_ptrs.push_back(first.data() + i * kSelectDim);
+    second_ptrs.push_back(second.data() + i * kSelectDim);
+  }
+
+  // the pulled rows are cached without waiting on the future
+  client->PullSparse(first_ptrs.data(), 0, keys.data(), keys.size(), true);
+  EXPECT_EQ(
+      client->PullSparse(second_ptrs.data(), 0, keys.data(), keys.size(), true)
+          .get(),
+      0);
+  EXPECT_EQ(first, second);
+
+  SparsePullCache::Stat stat;
+  ASSERT_TRUE(client->GetPullCacheStat(0, &stat));
+  EXPECT_EQ(stat.misses, keys.size());
+  EXPECT_EQ(stat.hits, keys.size());
+
+  // slot, show, click, embed_g, embedx_g * 8
+  std::vector<float> grads(keys.size() * 12, 1.0f);
+  std::vector<const float *> grad_ptrs;
+  for (size_t i = 0; i < keys.size(); ++i) {
+    grad_ptrs.push_back(grads.data() + i * 12);
+  }
+  client->PushSparse(0, keys.data(), grad_ptrs.data(), 1).wait();
+  EXPECT_EQ(
+      client->PullSparse(second_ptrs.data(), 0, keys.data(), keys.size(), true)
+          .get(),
+      0);
+  ASSERT_TRUE(client->GetPullCacheStat(0, &stat));
+  EXPECT_EQ(stat.misses, keys.size() + 1);  // only the pushed key
+  client->PrintTableStat(0).wait();
+}
+
+}  // namespace distributed
+}  // namespace paddle
@@ -0,0 +1,177 @@
+/* Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/distributed/ps/service/sparse_pull_coalescer.h"
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "glog/logging.h"
+#include "gtest/gtest.h"
+
+namespace paddle {
+namespace distributed {
+
+namespace {
+constexpr size_t kValueDim = 8;
+constexpr int kRpcLatencyUs = 300;
+
+// Stands in for BrpcPsClient::PullSparseImpl: one call is one round trip to
+// every server, every value row is filled with its key.
+struct FakePull {
+  std::atomic<int> calls{0};
+
+  std::future<int32_t> operator()(float **select_values,
+                                  size_t table_id,
+                                  const uint64_t *keys,
+                                  size_t num,
+                                  bool is_training) {
+    calls.fetch_add(1);
+    std::vector<uint64_t> key_copy(keys, keys + num);
+    std::vector<float *> value_copy(select_values, select_values + num);
+    return std::async(std::launch::async, [=]() {
+      std::this_thread::sleep_for(std::chrono::microseconds(kRpcLatencyUs));
+      for (size_t i = 0; i < key_copy.size(); ++i) {
+        for (size_t j = 0; j < kValueDim; ++j) {
+          value_copy[i][j] = static_cast<float>(key_copy[i]);
+        }
+      }
+      return 0;
+    });
+  }
+};
+
+// Runs `num_threads` workers each issuing `num_pulls` pulls of overlapping
+// keys through `pull`, returns the mean latency of one pull in us.
+template <typename PullFn>
+double RunWorkers(PullFn pull, int num_threads, int num_pulls) {
+  constexpr size_t kKeysPerPull = 64;
+  std::atomic<int64_t> total_us{0};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; ++t) {
+    threads.emplace_back([&, t]() {
+      std::vector<uint64_t> keys(kKeysPerPull);
+      std::vector<float> values(kKeysPerPull * kValueDim);
+      std::vector<float *> value_ptrs(kKeysPerPull);
+      for (int n = 0; n < num_pulls; ++n) {
+        for (size_t i = 0; i < kKeysPerPull; ++i) {
+          keys[i] = (t * 7 + n * 13 + i) % 256;
+          value_ptrs[i] = values.data() + i * kValueDim;
+        }
+        auto start = std::chrono::steady_clock::now();
+        auto ret = pull(value_ptrs.data(), 0, keys.data(), keys.size(), true);
+        EXPECT_EQ(ret.get(), 0);
+        total_us += std::chrono::duration_cast<std::chrono::microseconds>(
+                        std::chrono::steady_clock::now() - start)
+                        .count();
+        for (size_t i = 0; i < kKeysPerPull; ++i) {
+          EXPECT_FLOAT_EQ(values[i * kValueDim + kValueDim - 1],
+                          static_cast<float>(keys[i]));
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  return static_cast<double>(total_us) / (num_threads * num_pulls);
+}
+}  // namespace
+
+TEST(SparsePullCoalescer, MergeAndFanOut) {
+  constexpr int kThreads = 16;
+  constexpr int kPulls = 50;
+
+  FakePull direct;
+  double direct_us = RunWorkers(
+      [&](float **v, size_t tid, const uint64_t *k, size_t n, bool train) {
+        return direct(v, tid, k, n, train);
+      },
+      kThreads,
+      kPulls);
+
+  FakePull merged;
+  SparsePullCoalescer coalescer(
+      [&](float **v, size_t tid, const uint64_t *k, size_t n, bool train) {
+        return merged(v, tid, k, n, train);
+      },
+      /*window_us=*/100,
+      /*max_batch_keys=*/1 << 16);
+  double merged_us = RunWorkers(
+      [&](float **v, size_t tid, const uint64_t *k, size_t n, bool train) {
+        return coalescer.Pull(v, tid, k, n, train);
+      },
+      kThreads,
+      kPulls);
+  coalescer.Stop();
+
+  auto stat = coalescer.GetStat();
+  EXPECT_EQ(stat.pull_requests, static_cast<uint64_t>(kThreads * kPulls));
+  EXPECT_EQ(stat.merged_pulls, static_cast<uint64_t>(merged.calls.load()));
+  EXPECT_LE(merged.calls.load(), direct.calls.load());
+  LOG(INFO) << "direct: " << direct.calls << " pulls, " << direct_us
+            << " us/pull; coalesced: " << merged.calls << " pulls, "
+            << merged_us << " us/pull; " << coalescer.StatString();
+}
+
+TEST(SparsePullCoalescer, DoneBeforeFuture) {
+  FakePull fake;
+  SparsePullCoalescer coalescer(
+      [&](float **v, size_t tid, const uint64_t *k, size_t n, bool train) {
+        return fake(v, tid, k, n, train);
+      },
+      /*window_us=*/100,
+      /*max_batch_keys=*/1 << 16);
+  uint64_t key = 3;
+  float value[kValueDim] = {0};
+  float *value_ptr = value;
+  std::atomic<int32_t> done_ret{1};
+  std::atomic<float> done_value{0};
+  auto caller = std::this_thread::get_id();
+  std::atomic<bool> other_thread{false};
+  auto fut = coalescer.Pull(
+      &value_ptr, 0, &key, 1, true, [&](int32_t ret) {
+        done_value = value[kValueDim - 1];
+        other_thread = std::this_thread::get_id() != caller;
+        done_ret = ret;
+      });
+  EXPECT_EQ(fut.get(), 0);
+  // the values are written when on_done runs, and it has run by now
+  EXPECT_EQ(done_ret.load(), 0);
+  EXPECT_FLOAT_EQ(done_value.load(), static_cast<float>(key));
+  EXPECT_TRUE(other_thread.load());
+  coalescer.Stop();
+}
+
+TEST(SparsePullCoalescer, PullAfterStop) {
+  FakePull fake;
+  SparsePullCoalescer coalescer(
+      [&](float **v, size_t tid, const uint64_t *k, size_t n, bool train) {
+        return fake(v, tid, k, n, train);
+      },
+      /*window_us=*/100,
+      /*max_batch_keys=*/1 << 16);
+  coalescer.Stop();
+  uint64_t key = 1;
+  float value[kValueDim];
+  float *value_ptr = value;
+  EXPECT_EQ(coalescer.Pull(&value_ptr, 0, &key, 1, true).get(), -1);
+  EXPECT_EQ(fake.calls.load(), 0);
+}
+
+}  // namespace distributed
+}  // namespace paddle
@@ -0,0 +1,131 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/new_executor/garbage_collector/batched_garbage_collector.h"
+
+namespace paddle {
+namespace framework {
+
+InterpreterCoreBatchedGarbageCollector::InterpreterCoreBatchedGarbageCollector()
+    : queue_(nullptr),
+      max_held_memory_size_(max_memory_size_ > 0 ? max_memory_size_
+                                                 : kMaxHeldMemorySize) {
+  WorkQueueOptions options(/*name*/ "BatchedGarbageCollector",
+                           /*num_threads*/ 1,
+                           /*allow_spinning*/ true,
+                           /*track_task*/ false);
+  queue_ = CreateSingleThreadedWorkQueue(options);
+}
+
+InterpreterCoreBatchedGarbageCollector::
+    ~InterpreterCoreBatchedGarbageCollector() {  // NOLINT
+  queue_.reset(nullptr);
+}
+
+void InterpreterCoreBatchedGarbageCollector::Add(Variable* var,
+                                                 const Instruction&) {
+  Add(var);
+}
+
+void InterpreterCoreBatchedGarbageCollector::Add(Variable* var,
+                                                 const InstructionBase*) {
+  Add(var);
+}
+
+void InterpreterCoreBatchedGarbageCollector::Add(Variable* var) {
+  if (UNLIKELY(max_memory_size_ < 0) || var == nullptr) {
+    return;
+  }
+
+  if (var->IsType<phi::DenseTensor>()) {
+    Add(var->GetMutable<phi::DenseTensor>()->MoveMemoryHolder());
+  } else if (
+      var->IsType<
+          operators::reader::
+              OrderedMultiDeviceLoDTensorBlockingQueueHolder>()) {  // NOLINT
+    // TODO(xiongkun03) in old executor, this type of variable is not support
+    // eager deletion. so we just leave it here ?
+  } else if (var->IsType<LoDRankTable>()) {
+    // TODO(xiongkun03) in old executor, this type of variable is not support
+    // eager deletion. so we just leave it here ?
+  } else if (var->IsType<phi::SelectedRows>()) {
+    Add(var->GetMutable<phi::SelectedRows>()
+            ->mutable_value()
+            ->MoveMemoryHolder());
+    var->GetMutable<phi::SelectedRows>()->mutable_rows()->clear();
+  } else if (var->IsType<phi::TensorArray>()) {
+    auto* tensor_arr = var->GetMutable<phi::TensorArray>();
+    for (auto& t : *tensor_arr) {
+      Add(t.MoveMemoryHolder());
+    }
+  } else if (var->IsType<phi::SparseCooTensor>()) {
+    Add(var->GetMutable<phi::SparseCooTensor>()
+            ->mutable_indices()
+            ->MoveMemoryHolder());
+    Add(var->GetMutable<phi::SparseCooTensor>()
+            ->mutable_values()
+            ->MoveMemoryHolder());
+  } else if (var->IsType<phi::SparseCsrTensor>()) {
+    Add(var->GetMutable<phi::SparseCsrTensor>()
+            ->mutable_cols()
+            ->MoveMemoryHolder());
+    Add(var->GetMutable<phi::SparseCsrTensor>()
+            ->mutable_crows()
+            ->MoveMemoryHolder());
+    Add(var->GetMutable<phi::SparseCsrTensor>()
+            ->mutable_values()
+            ->MoveMemoryHolder());
+  } else if (var->IsType<std::vector<Scope*>>()) {
+    // NOTE(@xiongkun03) conditional_op / while_op will create a STEP_SCOPE
+    // refer to executor.cc to see what old garbage collector does.
+    // do nothing, because the sub scope will be deleted by sub-executor.
+  } else {
+    PADDLE_THROW(common::errors::Unimplemented(
+        "The variable(%s) is not supported in eager deletion.",
+        framework::ToTypeName(var->Type())));
+  }
+}
+
+void InterpreterCoreBatchedGarbageCollector::Add(Garbage garbage) {
+  if (!garbage) {
+    return;
+  }
+
+  std::lock_guard<memory::SpinLock> guard(spinlock_);
+  num_added_garbages_.fetch_add(1, std::memory_order_relaxed);
+  cur_memory_size_ += static_cast<int64_t>(garbage->size());
+  garbages_->push_back(std::move(garbage));
+  if (garbages_->size() >= kMaxBatchSize ||
+      cur_memory_size_ >= max_held_memory_size_) {
+    FreeGarbages();
+  }
+}
+
+void InterpreterCoreBatchedGarbageCollector::Flush() {
+  std::lock_guard<memory::SpinLock> guard(spinlock_);
+  if (!garbages_->empty()) {
+    FreeGarbages();
+  }
+}
+
+void InterpreterCoreBatchedGarbageCollector::FreeGarbages() {
+  num_queued_batches_.fetch_add(1, std::memory_order_relaxed);
+  num_queued_garbages_.fetch_add(garbages_->size(), std::memory_order_relaxed);
+  queue_->AddTask([container = std::move(*garbages_)]() {});
+  cur_memory_size_ = 0;
+  garbages_->clear();
+}
+
+}  // namespace framework
+}  // namespace paddle
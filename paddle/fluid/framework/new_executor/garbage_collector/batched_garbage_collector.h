@@ -0,0 +1,66 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#pragma once
+
+#include <atomic>
+
+#include "paddle/fluid/framework/new_executor/garbage_collector/garbage_collector.h"
+#include "paddle/fluid/framework/new_executor/workqueue/workqueue.h"
+
+namespace paddle {
+namespace framework {
+
+// Garbage collector of cpu programs, enabled by FLAGS_new_executor_batched_gc.
+// Instead of one task of the background thread per variable, as the event
+// garbage collector does, the garbages are queued and freed in bulk by one
+// task, at the end of each run or once a batch is full. A batch holds at most
+// kMaxBatchSize garbages, and at most FLAGS_eager_delete_tensor_gb of memory,
+// or kMaxHeldMemorySize when the flag is 0.
+class InterpreterCoreBatchedGarbageCollector
+    : public InterpreterCoreGarbageCollector {
+ public:
+  static constexpr size_t kMaxBatchSize = 64;
+  static constexpr int64_t kMaxHeldMemorySize = 64 << 20;
+
+  InterpreterCoreBatchedGarbageCollector();
+  ~InterpreterCoreBatchedGarbageCollector();
+
+  void Add(Variable* var, const Instruction& instr) override;
+
+  void Add(Variable* var, const InstructionBase* instr) override;
+
+  void Flush() override;
+
+  // Only for test, the number of batches queued to be freed, the number of
+  // garbages added, and the number of garbages in the current batch.
+  size_t NumQueuedBatches() const { return num_queued_batches_; }
+  size_t NumAddedGarbages() const { return num_added_garbages_; }
+  size_t NumHeldGarbages() const {
+    return num_added_garbages_ - num_queued_garbages_;
+  }
+
+ private:
+  void Add(Variable* var);
+  void Add(Garbage garbage);
+  void FreeGarbages();
+
+  std::unique_ptr<WorkQueue> queue_;
+  int64_t max_held_memory_size_;
+  std::atomic<size_t> num_queued_batches_{0};
+  std::atomic<size_t> num_added_garbages_{0};
+  std::atomic<size_t> num_queued_garbages_{0};
+};
+
+}  // namespace framework
+}  // namespace paddle
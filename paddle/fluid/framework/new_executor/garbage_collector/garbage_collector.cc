@@ -14,6 +14,7 @@
 
 #include "paddle/fluid/framework/new_executor/garbage_collector/garbage_collector.h"
 #include "paddle/fluid/framework/garbage_collector.h"
+#include "paddle/fluid/framework/new_executor/garbage_collector/batched_garbage_collector.h"
 #include "paddle/fluid/framework/new_executor/garbage_collector/event_garbage_collector.h"
 #include "paddle/fluid/framework/new_executor/garbage_collector/fast_garbage_collector.h"
 #include "paddle/fluid/framework/new_executor/garbage_collector/no_event_garbage_collector.h"
@@ -51,6 +52,9 @@ CreateInterpreterCoreGarbageCollector(
   } else if (phi::is_ipu_place(place)) {
     return std::unique_ptr<InterpreterCoreGarbageCollector>(
         new InterpreterCoreNoEventGarbageCollector());
+  } else if (phi::is_cpu_place(place) && FLAGS_new_executor_batched_gc) {
+    return std::unique_ptr<InterpreterCoreGarbageCollector>(
+        new InterpreterCoreBatchedGarbageCollector());
   } else {
     return std::unique_ptr<InterpreterCoreGarbageCollector>(
         new InterpreterCoreEventGarbageCollector(vec_instruction));
@@ -80,6 +84,9 @@ CreateInterpreterCoreGarbageCollector(
   } else if (phi::is_ipu_place(place)) {
     return std::unique_ptr<InterpreterCoreGarbageCollector>(
         new InterpreterCoreNoEventGarbageCollector());
+  } else if (phi::is_cpu_place(place) && FLAGS_new_executor_batched_gc) {
+    return std::unique_ptr<InterpreterCoreGarbageCollector>(
+        new InterpreterCoreBatchedGarbageCollector());
   } else {
     return std::unique_ptr<InterpreterCoreGarbageCollector>(
         new InterpreterCoreEventGarbageCollector(vec_instruction));
@@ -24,6 +24,7 @@
 
 COMMON_DECLARE_bool(fast_eager_deletion_mode);
 COMMON_DECLARE_bool(new_executor_use_cuda_graph);
+COMMON_DECLARE_bool(new_executor_batched_gc);
 
 namespace paddle {
 namespace framework {
@@ -40,6 +41,9 @@ class InterpreterCoreGarbageCollector {
 
   virtual void Add(Variable* var, const InstructionBase* instruction) = 0;
 
+  // Called at the end of each run, to free the garbages held for the run.
+  virtual void Flush() {}
+
   DISABLE_COPY_AND_ASSIGN(InterpreterCoreGarbageCollector);
 
  protected:
@@ -80,6 +80,12 @@ class InstructionBase {
     next_instrs_in_same_thread_.push_back(id);
   }
 
+  // Whether the kernel was selected by falling back to a CPU kernel.
+  bool HasFallbackCpu() const { return has_fallback_cpu_; }
+  void SetHasFallbackCpu(bool has_fallback_cpu) {
+    has_fallback_cpu_ = has_fallback_cpu;
+  }
+
   bool IsForceRecordEvent() const { return force_record_event_; }
   void SetForceRecordEvent(bool force_record) {
     force_record_event_ = force_record;
@@ -195,6 +201,8 @@ class InstructionBase {
 
   bool force_record_event_{false};
 
+  bool has_fallback_cpu_{false};
+
   std::vector<std::string> events_to_wait_info_;
 
   std::string event_to_record_info_{"default"};
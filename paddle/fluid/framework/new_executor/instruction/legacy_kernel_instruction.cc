@@ -131,6 +131,7 @@ LegacyKernelInstruction::LegacyKernelInstruction(
   auto kernel_result = phi::KernelFactory::Instance().SelectKernelOrThrowError(
       kernel_name, kernel_key);
   phi_kernel_ = new phi::Kernel(kernel_result.kernel);
+  SetHasFallbackCpu(kernel_result.has_fallback_cpu);
   PADDLE_ENFORCE_EQ(
       phi_kernel_->IsValid(), true, "not found kernel for [%s]", kernel_name);
   VLOG(6) << "finish process select kernel: " << kernel_name;
@@ -27,12 +27,16 @@
 #include "paddle/phi/core/infermeta_utils.h"
 #include "paddle/phi/core/meta_tensor.h"
 #include "paddle/phi/core/platform/device_context.h"
+#include "paddle/phi/core/tensor_utils.h"
 #include "paddle/phi/core/type_defs.h"
 #include "paddle/pir/include/core/builtin_attribute.h"
 #include "paddle/pir/include/core/operation.h"
 #include "paddle/pir/include/core/value.h"
 
 #include "paddle/fluid/framework/new_executor/instruction/instruction_util.h"
+
+COMMON_DECLARE_bool(enable_pir_shape_specialization);
+
 namespace paddle {
 namespace framework {
 
@@ -136,6 +140,7 @@ PhiKernelInstruction::PhiKernelInstruction(
   auto kernel_result = phi::KernelFactory::Instance().SelectKernelOrThrowError(
       kernel_name, kernel_key);
   phi_kernel_ = new phi::Kernel(kernel_result.kernel);
+  SetHasFallbackCpu(kernel_result.has_fallback_cpu);
   PADDLE_ENFORCE_EQ(
       phi_kernel_->IsValid(), true, "not found kernel for [%s]", kernel_name);
   VLOG(6) << "finish process select kernel";
@@ -174,17 +179,129 @@ PhiKernelInstruction::PhiKernelInstruction(
   }
   SetNoNeedBuffer(no_need_buffer_values);
   VLOG(6) << "finish process no need buffer";
+
+  InitShapeSpecialization(yaml_info_parser);
+  VLOG(6) << "finish process shape specialization: " << shape_specializable_;
 }
 
 PhiKernelInstruction::~PhiKernelInstruction() { delete phi_kernel_; }
 
+void PhiKernelInstruction::InitShapeSpecialization(
+    const paddle::dialect::OpYamlInfoParser& yaml_info_parser) {
+  if (infer_meta_interface_ == nullptr) {
+    return;
+  }
+  // the mutable attributes are read from tensor data by InferMeta
+  auto& name2id = yaml_info_parser.InputName2Id();
+  for (auto& attr_name : yaml_info_parser.AttrParams(false)) {
+    if (name2id.count(attr_name)) {
+      return;
+    }
+  }
+
+  Scope* inner_scope = value_exec_info_->GetScope();
+  auto dense_tensor_of = [&](pir::Value value) -> phi::DenseTensor* {
+    auto* var = inner_scope->FindVar(value_exec_info_->GetVarName(value));
+    if (var == nullptr || !var->IsType<phi::DenseTensor>()) {
+      return nullptr;
+    }
+    return var->GetMutable<phi::DenseTensor>();
+  };
+  for (size_t i = 0; i < op_->num_operands(); ++i) {
+    pir::Value value = op_->operand_source(i);
+    if (!IsInvalid(value)) {
+      continue;
+    }
+    auto* tensor = dense_tensor_of(value);
+    if (tensor == nullptr) {
+      meta_inputs_.clear();
+      return;
+    }
+    meta_inputs_.push_back(tensor);
+  }
+  for (size_t i = 0; i < op_->num_results(); ++i) {
+    pir::Value value = op_->result(i);
+    if (!IsInvalid(value)) {
+      continue;
+    }
+    auto* tensor = dense_tensor_of(value);
+    if (tensor == nullptr) {
+      meta_inputs_.clear();
+      meta_outputs_.clear();
+      return;
+    }
+    meta_outputs_.push_back(tensor);
+  }
+  shape_specializable_ = true;
+}
+
+// The offset is not compared as InferMeta does not read it.
+static bool SameMetaForInferMeta(const phi::DenseTensorMeta& lhs,
+                                 const phi::DenseTensorMeta& rhs) {
+  return lhs.dims == rhs.dims && lhs.dtype == rhs.dtype &&
+         lhs.layout == rhs.layout && lhs.strides == rhs.strides &&
+         lhs.is_scalar == rhs.is_scalar && lhs.use_gpudnn == rhs.use_gpudnn &&
+         lhs.lod == rhs.lod;
+}
+
+bool PhiKernelInstruction::MatchInputMetas() const {
+  for (size_t i = 0; i < meta_inputs_.size(); ++i) {
+    if (!SameMetaForInferMeta(meta_inputs_[i]->meta(),
+                              recorded_input_metas_[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void PhiKernelInstruction::RecordInputMetas() {
+  recorded_input_metas_.resize(meta_inputs_.size());
+  for (size_t i = 0; i < meta_inputs_.size(); ++i) {
+    recorded_input_metas_[i] = meta_inputs_[i]->meta();
+  }
+}
+
+void PhiKernelInstruction::RecordOutputMetas() {
+  recorded_output_metas_.resize(meta_outputs_.size());
+  for (size_t i = 0; i < meta_outputs_.size(); ++i) {
+    recorded_output_metas_[i] = meta_outputs_[i]->meta();
+  }
+}
+
+void PhiKernelInstruction::RestoreOutputMetas() {
+  for (size_t i = 0; i < meta_outputs_.size(); ++i) {
+    const auto& recorded = recorded_output_metas_[i];
+    auto* meta = phi::DenseTensorUtils::GetMutableMeta(meta_outputs_[i]);
+    meta->dims = recorded.dims;
+    meta->dtype = recorded.dtype;
+    meta->layout = recorded.layout;
+    meta->strides = recorded.strides;
+    meta->is_scalar = recorded.is_scalar;
+    meta->use_gpudnn = recorded.use_gpudnn;
+    meta->lod = recorded.lod;
+  }
+}
+
 void PhiKernelInstruction::Run() {
   VLOG(6) << "Begin run op " << phi_op_name_ << " infer meta.";
   if (infer_meta_interface_) {
     phi::RecordEvent record_event("PhiKernelInstruction::infermeta",
                                   platform::TracerEventType::UserDefined,
                                   1);
-    infer_meta_interface_->infer_meta_(&(infer_meta_context_));
+    if (FLAGS_enable_pir_shape_specialization && shape_specializable_) {
+      if (has_recorded_metas_ && MatchInputMetas()) {
+        VLOG(6) << "Reuse the output metas of op " << phi_op_name_;
+        RestoreOutputMetas();
+      } else {
+        has_recorded_metas_ = false;
+        RecordInputMetas();
+        infer_meta_interface_->infer_meta_(&(infer_meta_context_));
+        RecordOutputMetas();
+        has_recorded_metas_ = true;
+      }
+    } else {
+      infer_meta_interface_->infer_meta_(&(infer_meta_context_));
+    }
   }
   VLOG(6) << "End run op " << phi_op_name_ << " infer meta.";
   for (auto& pair : this->InplaceInfo()) {
@@ -15,11 +15,18 @@
 #pragma once
 
 #include "paddle/fluid/framework/new_executor/instruction/instruction_base.h"
+#include "paddle/phi/core/tensor_meta.h"
 
 namespace pir {
 class Operation;
 }  // namespace pir
 
+namespace paddle {
+namespace dialect {
+class OpYamlInfoParser;
+}  // namespace dialect
+}  // namespace paddle
+
 namespace paddle {
 namespace framework {
 class Scope;
@@ -53,6 +60,16 @@ class PhiKernelInstruction : public InstructionBase {
   const std::string& Name() const override { return phi_op_name_; }
 
  private:
+  // Shape specialization, see FLAGS_enable_pir_shape_specialization. The
+  // metas of the inputs and of the outputs after InferMeta are recorded, and
+  // InferMeta is skipped in the next run if the input metas are the same.
+  void InitShapeSpecialization(
+      const paddle::dialect::OpYamlInfoParser& yaml_info_parser);
+  bool MatchInputMetas() const;
+  void RecordInputMetas();
+  void RecordOutputMetas();
+  void RestoreOutputMetas();
+
   paddle::dialect::InferMetaInterface::Concept* infer_meta_interface_{
       nullptr};  // not owned
 
@@ -67,6 +84,15 @@ class PhiKernelInstruction : public InstructionBase {
   ::pir::Operation* op_{nullptr};  // not owned
 
   const ValueExecutionInfo* value_exec_info_;  // not owned
+
+  // false if InferMeta may depend on more than the input metas, e.g. an
+  // IntArray attribute from a tensor
+  bool shape_specializable_{false};
+  bool has_recorded_metas_{false};
+  std::vector<const phi::DenseTensor*> meta_inputs_;  // not owned
+  std::vector<phi::DenseTensor*> meta_outputs_;       // not owned
+  std::vector<phi::DenseTensorMeta> recorded_input_metas_;
+  std::vector<phi::DenseTensorMeta> recorded_output_metas_;
 };
 
 }  // namespace framework
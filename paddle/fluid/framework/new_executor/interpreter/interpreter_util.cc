@@ -821,6 +821,7 @@ void BuildOpFuncList(const phi::Place& place,
                 op_with_kernel->ResetKernelType(new OpKernelType(
                     TransPhiKernelKeyToOpKernelType(phi_cpu_kernel_key)));
                 run_phi_kernel = true;
+                op_func_node.has_fallback_cpu_ = true;
               }
             }
           }
@@ -199,6 +199,9 @@ struct OpFuncNode {
 
   bool fluid_op{false};
   std::shared_ptr<RuntimeContext> runtime_ctx_{nullptr};
+
+  // the kernel was selected by falling back to a CPU kernel
+  bool has_fallback_cpu_{false};
 };
 
 class Instruction {
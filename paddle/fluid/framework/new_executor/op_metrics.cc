@@ -0,0 +1,387 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/new_executor/op_metrics.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <sstream>
+
+#include "paddle/phi/core/memory/stats.h"
+
+namespace paddle {
+namespace framework {
+
+namespace {
+
+constexpr uint64_t kSubBuckets = 1ULL << OpMetrics::kSubBucketBits;
+
+inline void RelaxedAdd(std::atomic<uint64_t>* value, uint64_t delta) {
+  // only the owner thread writes, so a read-modify-write is not needed
+  value->store(value->load(std::memory_order_relaxed) + delta,
+               std::memory_order_relaxed);
+}
+
+// index of the highest set bit, x must not be 0
+inline size_t HighestBit(uint64_t x) {
+#if defined(__clang__) || defined(__GNUC__)
+  return 63 - __builtin_clzll(x);
+#else
+  size_t bit = 0;
+  while (x >>= 1) {
+    ++bit;
+  }
+  return bit;
+#endif
+}
+
+inline uint64_t NowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+template <typename StatType>
+inline int64_t CurrentThreadStat() {
+  return phi::ThreadDataRegistry<StatType>::GetInstance()
+      .GetCurrentThreadData()
+      .current;
+}
+
+#define OP_METRICS_DEVICE_ALLOCATED_CASE(id) \
+  case id:                                   \
+    return CurrentThreadStat<memory::DeviceMemoryStatAllocated##id>()
+
+// Bytes allocated and not yet freed by the current thread on the place.
+int64_t CurrentThreadAllocated(const phi::Place& place) {
+  if (phi::is_cpu_place(place) || phi::is_cuda_pinned_place(place)) {
+    return CurrentThreadStat<memory::HostMemoryStatAllocated0>();
+  }
+  switch (place.GetDeviceId()) {
+    OP_METRICS_DEVICE_ALLOCATED_CASE(0);
+    OP_METRICS_DEVICE_ALLOCATED_CASE(1);
+    OP_METRICS_DEVICE_ALLOCATED_CASE(2);
+    OP_METRICS_DEVICE_ALLOCATED_CASE(3);
+    OP_METRICS_DEVICE_ALLOCATED_CASE(4);
+    OP_METRICS_DEVICE_ALLOCATED_CASE(5);
+    OP_METRICS_DEVICE_ALLOCATED_CASE(6);
+    OP_METRICS_DEVICE_ALLOCATED_CASE(7);
+    OP_METRICS_DEVICE_ALLOCATED_CASE(8);
+    OP_METRICS_DEVICE_ALLOCATED_CASE(9);
+    OP_METRICS_DEVICE_ALLOCATED_CASE(10);
+    OP_METRICS_DEVICE_ALLOCATED_CASE(11);
+    OP_METRICS_DEVICE_ALLOCATED_CASE(12);
+    OP_METRICS_DEVICE_ALLOCATED_CASE(13);
+    OP_METRICS_DEVICE_ALLOCATED_CASE(14);
+    OP_METRICS_DEVICE_ALLOCATED_CASE(15);
+    default:
+      return 0;
+  }
+}
+
+#undef OP_METRICS_DEVICE_ALLOCATED_CASE
+
+std::string EscapeLabel(const std::string& value) {
+  std::string escaped;
+  escaped.reserve(value.size());
+  for (char c : value) {
+    if (c == '\\' || c == '"') {
+      escaped.push_back('\\');
+      escaped.push_back(c);
+    } else if (c == '\n') {
+      escaped += "\\n";
+    } else {
+      escaped.push_back(c);
+    }
+  }
+  return escaped;
+}
+
+// Boundaries of the exported Prometheus histogram, in seconds.
+const double kPrometheusBuckets[] = {1e-6,   2.5e-6, 5e-6,  1e-5,   2.5e-5,
+                                     5e-5,   1e-4,   2.5e-4, 5e-4,  1e-3,
+                                     2.5e-3, 5e-3,   1e-2,  2.5e-2, 5e-2,
+                                     0.1,    0.25,   0.5,   1,      2.5,
+                                     5,      10};
+
+}  // namespace
+
+struct OpMetrics::Slot {
+  explicit Slot(const std::string& op_type) : op_type(op_type) {
+    for (auto& bucket : buckets) {
+      bucket.store(0, std::memory_order_relaxed);
+    }
+  }
+
+  const std::string op_type;
+  std::atomic<uint64_t> count{0};
+  std::atomic<uint64_t> total_ns{0};
+  std::atomic<uint64_t> allocated_bytes{0};
+  std::atomic<uint64_t> cpu_fallback_count{0};
+  std::atomic<uint64_t> buckets[kNumBuckets];
+};
+
+struct OpMetrics::ThreadSlots {
+  // guards slots, only the owner thread appends to it
+  std::mutex mutex;
+  std::vector<std::unique_ptr<Slot>> slots;
+  // only accessed by the owner thread
+  std::unordered_map<std::string, Slot*> index;
+};
+
+double OpMetricsStats::QuantileNs(double q) const {
+  if (count == 0) {
+    return 0;
+  }
+  double rank = std::min(std::max(q, 0.0), 1.0) * static_cast<double>(count);
+  uint64_t seen = 0;
+  for (size_t i = 0; i < buckets.size(); ++i) {
+    if (buckets[i] == 0) {
+      continue;
+    }
+    if (static_cast<double>(seen + buckets[i]) >= rank) {
+      double lower = static_cast<double>(OpMetrics::BucketLowerBound(i));
+      double upper = static_cast<double>(OpMetrics::BucketUpperBound(i));
+      double fraction =
+          std::max(rank - static_cast<double>(seen), 0.0) / buckets[i];
+      return lower + (upper - lower) * fraction;
+    }
+    seen += buckets[i];
+  }
+  return static_cast<double>(OpMetrics::BucketUpperBound(buckets.size() - 1));
+}
+
+OpMetrics& OpMetrics::Instance() {
+  static OpMetrics instance;
+  return instance;
+}
+
+size_t OpMetrics::BucketIndex(uint64_t ns) {
+  if (ns < kSubBuckets) {
+    return ns;
+  }
+  size_t exponent = HighestBit(ns);
+  size_t shift = exponent - kSubBucketBits;
+  return ((shift + 1) << kSubBucketBits) + ((ns >> shift) & (kSubBuckets - 1));
+}
+
+uint64_t OpMetrics::BucketLowerBound(size_t index) {
+  if (index < kSubBuckets) {
+    return index;
+  }
+  size_t shift = (index >> kSubBucketBits) - 1;
+  return (kSubBuckets + (index & (kSubBuckets - 1))) << shift;
+}
+
+uint64_t OpMetrics::BucketUpperBound(size_t index) {
+  if (index < kSubBuckets) {
+    return index + 1;
+  }
+  size_t shift = (index >> kSubBucketBits) - 1;
+  uint64_t base = kSubBuckets + (index & (kSubBuckets - 1)) + 1;
+  if (base > (UINT64_MAX >> shift)) {
+    return UINT64_MAX;
+  }
+  return base << shift;
+}
+
+OpMetrics::ThreadSlots* OpMetrics::GetThreadSlots() {
+  static thread_local std::shared_ptr<ThreadSlots> thread_slots;
+  if (UNLIKELY(thread_slots == nullptr)) {
+    thread_slots = std::make_shared<ThreadSlots>();
+    std::lock_guard<std::mutex> lock(mutex_);
+    threads_.push_back(thread_slots);
+  }
+  return thread_slots.get();
+}
+
+void OpMetrics::Record(const std::string& op_type,
+                       uint64_t latency_ns,
+                       int64_t allocated_bytes,
+                       bool cpu_fallback) {
+  ThreadSlots* thread_slots = GetThreadSlots();
+  Slot* slot = nullptr;
+  auto it = thread_slots->index.find(op_type);
+  if (LIKELY(it != thread_slots->index.end())) {
+    slot = it->second;
+  } else {
+    std::lock_guard<std::mutex> lock(thread_slots->mutex);
+    thread_slots->slots.emplace_back(std::make_unique<Slot>(op_type));
+    slot = thread_slots->slots.back().get();
+    thread_slots->index.emplace(op_type, slot);
+  }
+
+  RelaxedAdd(&slot->count, 1);
+  RelaxedAdd(&slot->total_ns, latency_ns);
+  if (allocated_bytes > 0) {
+    RelaxedAdd(&slot->allocated_bytes, allocated_bytes);
+  }
+  if (cpu_fallback) {
+    RelaxedAdd(&slot->cpu_fallback_count, 1);
+  }
+  RelaxedAdd(&slot->buckets[BucketIndex(latency_ns)], 1);
+}
+
+std::vector<OpMetricsStats> OpMetrics::Aggregate() {
+  std::vector<std::shared_ptr<ThreadSlots>> threads;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    threads = threads_;
+  }
+  std::map<std::string, OpMetricsStats> merged;
+  for (auto& thread_slots : threads) {
+    std::lock_guard<std::mutex> lock(thread_slots->mutex);
+    for (auto& slot : thread_slots->slots) {
+      auto& stats = merged[slot->op_type];
+      if (stats.buckets.empty()) {
+        stats.op_type = slot->op_type;
+        stats.buckets.resize(kNumBuckets, 0);
+      }
+      stats.count += slot->count.load(std::memory_order_relaxed);
+      stats.total_ns += slot->total_ns.load(std::memory_order_relaxed);
+      stats.allocated_bytes +=
+          slot->allocated_bytes.load(std::memory_order_relaxed);
+      stats.cpu_fallback_count +=
+          slot->cpu_fallback_count.load(std::memory_order_relaxed);
+      for (size_t i = 0; i < kNumBuckets; ++i) {
+        stats.buckets[i] += slot->buckets[i].load(std::memory_order_relaxed);
+      }
+    }
+  }
+  std::vector<OpMetricsStats> result;
+  result.reserve(merged.size());
+  for (auto& item : merged) {
+    result.push_back(std::move(item.second));
+  }
+  return result;
+}
+
+std::vector<OpMetricsStats> OpMetrics::Snapshot() {
+  std::vector<OpMetricsStats> result = Aggregate();
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto& stats : result) {
+    auto it = baseline_.find(stats.op_type);
+    if (it == baseline_.end()) {
+      continue;
+    }
+    const OpMetricsStats& base = it->second;
+    stats.count -= base.count;
+    stats.total_ns -= base.total_ns;
+    stats.allocated_bytes -= base.allocated_bytes;
+    stats.cpu_fallback_count -= base.cpu_fallback_count;
+    for (size_t i = 0; i < kNumBuckets; ++i) {
+      stats.buckets[i] -= base.buckets[i];
+    }
+  }
+  result.erase(std::remove_if(result.begin(),
+                              result.end(),
+                              [](const OpMetricsStats& stats) {
+                                return stats.count == 0;
+                              }),
+               result.end());
+  return result;
+}
+
+void OpMetrics::Reset() {
+  // the slots are only written by their threads, so a reset keeps the
+  // current values as the baseline instead of clearing them
+  std::vector<OpMetricsStats> current = Aggregate();
+  std::lock_guard<std::mutex> lock(mutex_);
+  baseline_.clear();
+  for (auto& stats : current) {
+    std::string op_type = stats.op_type;
+    baseline_.emplace(std::move(op_type), std::move(stats));
+  }
+}
+
+std::string OpMetrics::DumpPrometheus() {
+  std::vector<OpMetricsStats> snapshot = Snapshot();
+  std::ostringstream os;
+  os << "# HELP paddle_op_latency_seconds Latency of operators run by the "
+        "executor.\n"
+     << "# TYPE paddle_op_latency_seconds histogram\n";
+  for (const auto& stats : snapshot) {
+    std::string op = EscapeLabel(stats.op_type);
+    // a bucket of the fine histogram is counted under the first boundary
+    // at or above its upper bound
+    size_t fine_index = 0;
+    uint64_t cumulative = 0;
+    for (double le : kPrometheusBuckets) {
+      double le_ns = le * 1e9;
+      while (fine_index < kNumBuckets &&
+             static_cast<double>(BucketUpperBound(fine_index)) <= le_ns) {
+        cumulative += stats.buckets[fine_index++];
+      }
+      os << "paddle_op_latency_seconds_bucket{op=\"" << op << "\",le=\"" << le
+         << "\"} " << cumulative << "\n";
+    }
+    os << "paddle_op_latency_seconds_bucket{op=\"" << op << "\",le=\"+Inf\"} "
+       << stats.count << "\n";
+    os << "paddle_op_latency_seconds_sum{op=\"" << op << "\"} "
+       << stats.total_ns / 1e9 << "\n";
+    os << "paddle_op_latency_seconds_count{op=\"" << op << "\"} "
+       << stats.count << "\n";
+  }
+
+  os << "# HELP paddle_op_latency_quantile_seconds Estimated latency "
+        "quantiles of operators.\n"
+     << "# TYPE paddle_op_latency_quantile_seconds gauge\n";
+  for (const auto& stats : snapshot) {
+    std::string op = EscapeLabel(stats.op_type);
+    for (double q : {0.5, 0.9, 0.99}) {
+      os << "paddle_op_latency_quantile_seconds{op=\"" << op
+         << "\",quantile=\"" << q << "\"} " << stats.QuantileNs(q) / 1e9
+         << "\n";
+    }
+  }
+
+  os << "# HELP paddle_op_allocated_bytes_total Bytes allocated by "
+        "operators.\n"
+     << "# TYPE paddle_op_allocated_bytes_total counter\n";
+  for (const auto& stats : snapshot) {
+    os << "paddle_op_allocated_bytes_total{op=\"" << EscapeLabel(stats.op_type)
+       << "\"} " << stats.allocated_bytes << "\n";
+  }
+
+  os << "# HELP paddle_op_cpu_fallback_total Runs of kernels selected by "
+        "falling back to CPU.\n"
+     << "# TYPE paddle_op_cpu_fallback_total counter\n";
+  for (const auto& stats : snapshot) {
+    os << "paddle_op_cpu_fallback_total{op=\"" << EscapeLabel(stats.op_type)
+       << "\"} " << stats.cpu_fallback_count << "\n";
+  }
+  return os.str();
+}
+
+void OpMetricsScope::Begin(const std::string& op_type,
+                           const phi::Place& place,
+                           bool cpu_fallback) {
+  op_type_ = &op_type;
+  place_ = place;
+  cpu_fallback_ = cpu_fallback;
+  start_allocated_ = CurrentThreadAllocated(place);
+  start_ns_ = NowNs();
+}
+
+void OpMetricsScope::End() {
+  uint64_t end_ns = NowNs();
+  int64_t allocated = CurrentThreadAllocated(place_) - start_allocated_;
+  OpMetrics::Instance().Record(
+      *op_type_, end_ns - start_ns_, allocated, cpu_fallback_);
+}
+
+}  // namespace framework
+}  // namespace paddle
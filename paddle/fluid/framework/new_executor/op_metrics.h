@@ -0,0 +1,131 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "paddle/common/flags.h"
+#include "paddle/common/macros.h"
+#include "paddle/phi/common/place.h"
+#include "paddle/utils/test_macros.h"
+
+COMMON_DECLARE_bool(enable_op_metrics);
+
+namespace paddle {
+namespace framework {
+
+// Aggregated metrics of one operator type.
+struct OpMetricsStats {
+  std::string op_type;
+  uint64_t count = 0;
+  uint64_t total_ns = 0;
+  // bytes allocated by the running thread while the operator ran, net of
+  // the bytes it freed
+  uint64_t allocated_bytes = 0;
+  // runs of a kernel that was selected by falling back to CPU
+  uint64_t cpu_fallback_count = 0;
+  // latency histogram, see OpMetrics::BucketIndex
+  std::vector<uint64_t> buckets;
+
+  // Estimated latency quantile in nanoseconds, q in [0, 1].
+  double QuantileNs(double q) const;
+};
+
+// Continuous per-operator metrics of the executors, enabled by
+// FLAGS_enable_op_metrics. Every thread records into its own slots with
+// relaxed stores only, Snapshot aggregates the slots of all threads on
+// demand. The latency histogram is log-linear with 4 buckets per power of
+// two, so quantiles have less than 25% relative error.
+class TEST_API OpMetrics {
+ public:
+  static constexpr size_t kSubBucketBits = 2;
+  static constexpr size_t kNumBuckets = (64 - kSubBucketBits + 1)
+                                        << kSubBucketBits;
+
+  static OpMetrics& Instance();
+
+  static bool IsEnabled() { return FLAGS_enable_op_metrics; }
+
+  static size_t BucketIndex(uint64_t ns);
+  // Latency range [lower, upper) of a bucket in nanoseconds.
+  static uint64_t BucketLowerBound(size_t index);
+  static uint64_t BucketUpperBound(size_t index);
+
+  void Record(const std::string& op_type,
+              uint64_t latency_ns,
+              int64_t allocated_bytes,
+              bool cpu_fallback);
+
+  // Metrics recorded since the last Reset, sorted by op type.
+  std::vector<OpMetricsStats> Snapshot();
+  void Reset();
+
+  // Snapshot in the Prometheus text exposition format.
+  std::string DumpPrometheus();
+
+ private:
+  struct Slot;
+  struct ThreadSlots;
+
+  OpMetrics() = default;
+  DISABLE_COPY_AND_ASSIGN(OpMetrics);
+
+  ThreadSlots* GetThreadSlots();
+  std::vector<OpMetricsStats> Aggregate();
+
+  std::mutex mutex_;
+  std::vector<std::shared_ptr<ThreadSlots>> threads_;
+  // value of every op type at the last Reset
+  std::unordered_map<std::string, OpMetricsStats> baseline_;
+};
+
+// Records one operator run into OpMetrics, does nothing unless
+// OpMetrics::IsEnabled() when constructed.
+class OpMetricsScope {
+ public:
+  OpMetricsScope(const std::string& op_type,
+                 const phi::Place& place,
+                 bool cpu_fallback) {
+    if (UNLIKELY(OpMetrics::IsEnabled())) {
+      Begin(op_type, place, cpu_fallback);
+    }
+  }
+
+  ~OpMetricsScope() {
+    if (UNLIKELY(op_type_ != nullptr)) {
+      End();
+    }
+  }
+
+ private:
+  void Begin(const std::string& op_type,
+             const phi::Place& place,
+             bool cpu_fallback);
+  void End();
+
+  const std::string* op_type_{nullptr};
+  phi::Place place_;
+  bool cpu_fallback_{false};
+  uint64_t start_ns_{0};
+  int64_t start_allocated_{0};
+};
+
+}  // namespace framework
+}  // namespace paddle
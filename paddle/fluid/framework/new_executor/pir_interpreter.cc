@@ -84,10 +84,12 @@ COMMON_DECLARE_bool(dynamic_static_unified_comm);
 #endif
 #include "paddle/fluid/framework/new_executor/collect_shape_manager.h"
 #include "paddle/fluid/framework/new_executor/nan_inf_utils.h"
+#include "paddle/fluid/framework/new_executor/op_metrics.h"
 
 COMMON_DECLARE_bool(enable_pir_in_executor);
 COMMON_DECLARE_bool(enable_pir_in_executor_trace_run);
 COMMON_DECLARE_bool(enable_collect_shape);
+COMMON_DECLARE_bool(enable_pir_cpu_replay);
 COMMON_DECLARE_int32(low_precision_op_list);
 
 #define CREATE_INSTR(instr_name)                                   \
@@ -769,6 +771,8 @@ void PirInterpreter::AnalyseExecuteOrderForTrace(
 void PirInterpreter::BuildInstruction() {
   VLOG(6) << "Build Instructions for pir ... ";
   vec_instruction_base_.clear();
+  replay_plan_.clear();
+  is_replay_plan_built_ = false;
   size_t op_idx = 0;
   for (auto& op : *ir_block_) {
     VLOG(6) << "Build Instruction for op: " << op_idx;
@@ -1486,10 +1490,13 @@ paddle::framework::FetchList PirInterpreter::Run(
     is_build_ = true;
     is_shared_results_build_ = true;
   } else {
-    if (FLAGS_enable_pir_in_executor_trace_run || onednn_op_num_ ||
-        execution_config_.used_for_inference ||
-        ((execution_config_.used_for_jit || execution_config_.used_for_cinn) &&
-         (sync_op_num_ == 0))) {
+    if (CanReplay()) {
+      ReplayRunImpl();
+    } else if (FLAGS_enable_pir_in_executor_trace_run || onednn_op_num_ ||
+               execution_config_.used_for_inference ||
+               ((execution_config_.used_for_jit ||
+                 execution_config_.used_for_cinn) &&
+                (sync_op_num_ == 0))) {
       TraceRunImpl();
     } else {
       MultiThreadRunImpl();
@@ -1571,10 +1578,13 @@ FetchList PirInterpreter::Run(const std::vector<std::string>& feed_names,
     is_build_ = true;
     is_shared_results_build_ = true;
   } else {
-    if (FLAGS_enable_pir_in_executor_trace_run || onednn_op_num_ ||
-        execution_config_.used_for_inference ||
-        ((execution_config_.used_for_jit || execution_config_.used_for_cinn) &&
-         (sync_op_num_ == 0))) {
+    if (CanReplay()) {
+      ReplayRunImpl();
+    } else if (FLAGS_enable_pir_in_executor_trace_run || onednn_op_num_ ||
+               execution_config_.used_for_inference ||
+               ((execution_config_.used_for_jit ||
+                 execution_config_.used_for_cinn) &&
+                (sync_op_num_ == 0))) {
       TraceRunImpl();
     } else {
       MultiThreadRunImpl();
@@ -1612,6 +1622,7 @@ void PirInterpreter::TraceRunImpl() {
 
   TraceRunInstructionList(vec_instruction_base_);
   VLOG(4) << "Done TraceRunInstructionList";
+  gc_->Flush();
 #ifdef PADDLE_WITH_CUSTOM_DEVICE
   if (phi::is_custom_place(place_)) {
     phi::DeviceContextPool::Instance().Get(place_)->Wait();
@@ -1619,6 +1630,107 @@ void PirInterpreter::TraceRunImpl() {
 #endif
 }
 
+bool PirInterpreter::CanReplay() {
+  // the debug and profiling features work in RunInstructionBase only
+  if (!FLAGS_enable_pir_cpu_replay || !phi::is_cpu_place(place_) ||
+      FLAGS_check_nan_inf || FLAGS_benchmark || FLAGS_enable_collect_shape ||
+      FLAGS_low_precision_op_list || OpMetrics::IsEnabled() ||
+      enable_job_schedule_profiler_ || !pir_input_hookfuncs_.empty() ||
+      !pir_output_hookfuncs_.empty()) {
+    return false;
+  }
+  if (!is_replay_plan_built_) {
+    BuildReplayPlan();
+  }
+  return !replay_plan_.empty();
+}
+
+void PirInterpreter::BuildReplayPlan() {
+  is_replay_plan_built_ = true;
+  replay_plan_.clear();
+  for (auto& instr : vec_instruction_base_) {
+    if (instr->KernelType() != OpFuncType::kCpuSync) {
+      VLOG(4) << "Can not replay the program, " << instr->Name()
+              << " is not a cpu sync instruction";
+      return;
+    }
+    // The control flow instructions run sub blocks, and CheckGCEarly of
+    // WhileInstruction reads refs_, which the replay does not count.
+    if (dynamic_cast<IfInstruction*>(instr.get()) != nullptr ||
+        dynamic_cast<WhileInstruction*>(instr.get()) != nullptr ||
+        dynamic_cast<PyLayerInstruction*>(instr.get()) != nullptr) {
+      VLOG(4) << "Can not replay the program, " << instr->Name()
+              << " is a control flow instruction";
+      return;
+    }
+  }
+
+  // A var is collected after the last instruction that checks it, i.e. when
+  // its reference count in CheckGC drops to zero. CheckGC is not called for
+  // artificial instructions, so the vars they check are never collected.
+  std::unordered_set<size_t> visited_var_ids;
+  for (auto& instr : vec_instruction_base_) {
+    if (instr->IsArtificial()) {
+      visited_var_ids.insert(instr->GCCheckVars().begin(),
+                             instr->GCCheckVars().end());
+    }
+  }
+  std::vector<ReplayStep> plan(trace_execute_order_.size());
+  for (size_t i = trace_execute_order_.size(); i-- > 0;) {
+    InstructionBase* instr =
+        vec_instruction_base_.at(trace_execute_order_[i]).get();
+    plan[i].instr = instr;
+    if (instr->IsArtificial()) {
+      continue;
+    }
+    for (auto var_id : instr->GCCheckVars()) {
+      if (!visited_var_ids.insert(var_id).second ||
+          parameter_var_names_.count(
+              value_exe_info_->GetNameById(static_cast<int>(var_id)))) {
+        continue;
+      }
+      plan[i].gc_var_ids.push_back(var_id);
+    }
+  }
+  replay_plan_ = std::move(plan);
+  VLOG(4) << "Build replay plan of " << replay_plan_.size() << " instructions";
+}
+
+void PirInterpreter::ReplayRunImpl() {
+  if (!gc_) {
+    gc_ = CreateInterpreterCoreGarbageCollector(place_, vec_instruction_base_);
+  }
+  VLOG(4) << "Replay Instruction List";
+
+  for (auto& step : replay_plan_) {
+    InstructionBase* instr_node = step.instr;
+    phi::RecordEvent instruction_event(
+        instr_node->Name(), platform::TracerEventType::Operator, 1);
+    if (instr_node->IsArtificial()) {
+      continue;
+    }
+    try {
+      instr_node->Run();
+    } catch (platform::EnforceNotMet& ex) {
+      auto* op = instr_node->Operation();
+      const std::vector<std::string> op_callstack_attr =
+          interpreter::GetInstructionCallStack(op->name(), op->attributes());
+      framework::InsertCallStackInfo(op->name(), op_callstack_attr, &ex);
+      throw;
+    }
+    for (auto var_id : step.gc_var_ids) {
+      gc_->Add(refs_[var_id]->Var(), instr_node);
+    }
+    for (auto var : instr_node->EagerGCVars()) {
+      gc_->Add(var, instr_node);
+    }
+    instr_node->ClearEagerGCVars();
+  }
+  VLOG(4) << "Done Replay Instruction List";
+  gc_->Flush();
+  ++replayed_run_count_;
+}
+
 void PirInterpreter::MultiThreadRunImpl() {
   // lazy initialization of gc, do not create gc is the program only run once
   if (!gc_) {
@@ -1631,6 +1743,7 @@ void PirInterpreter::MultiThreadRunImpl() {
   async_work_queue_ = GetWorkQueue();
   MultiThreadRunInstructionList(vec_instruction_base_);
   VLOG(4) << "Done MultiThreadRunInstructionList";
+  gc_->Flush();
 #ifdef PADDLE_WITH_CUSTOM_DEVICE
   if (phi::is_custom_place(place_)) {
     phi::DeviceContextPool::Instance().Get(place_)->Wait();
@@ -1899,6 +2012,8 @@ void PirInterpreter::RunInstructionBase(InstructionBase* instr_node) {
       {
         phi::RecordEvent record(
             "InstrRun", platform::TracerEventType::UserDefined, 10);
+        OpMetricsScope metrics(
+            instr_node->Name(), cur_place, instr_node->HasFallbackCpu());
         instr_node->Run();
       }
 
@@ -113,6 +113,15 @@ class PirInterpreter : public InterpreterBaseImpl {
   // Only for debug
   Variable* DebugVar(const std::string& name) const override;
 
+  // Only for test, the number of runs replayed, see
+  // FLAGS_enable_pir_cpu_replay
+  size_t ReplayedRunCount() const { return replayed_run_count_; }
+
+  // Only for test
+  const InterpreterCoreGarbageCollector* GarbageCollector() const {
+    return gc_.get();
+  }
+
   std::unordered_map<std::string, std::shared_ptr<EventInter>>*
   GetForceEventsToWaitInfo() {
     return force_events_to_wait_;
@@ -204,6 +213,16 @@ class PirInterpreter : public InterpreterBaseImpl {
   int64_t onednn_op_num_{-1};
   std::vector<size_t> trace_execute_order_;
 
+  // used for Replay, the instructions in trace_execute_order_ and the vars
+  // to gc after each of them. It is empty if the program can not be replayed.
+  struct ReplayStep {
+    InstructionBase* instr;  // not owned
+    std::vector<size_t> gc_var_ids;
+  };
+  std::vector<ReplayStep> replay_plan_;
+  bool is_replay_plan_built_{false};
+  size_t replayed_run_count_{0};
+
   std::vector<PirHookFunc> pir_output_hookfuncs_;
   std::vector<PirHookFunc> pir_input_hookfuncs_;
 
@@ -241,6 +260,13 @@ class PirInterpreter : public InterpreterBaseImpl {
 
   void RunInstructionBase(InstructionBase* instr_node);
 
+  // replay, see FLAGS_enable_pir_cpu_replay
+  bool CanReplay();
+
+  void BuildReplayPlan();
+
+  void ReplayRunImpl();
+
   void RecordMemcpyD2H(InstructionBase* instr_node);
 
   ::pir::Value GetValueByName(const std::string& var_name);
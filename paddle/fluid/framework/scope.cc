@@ -14,6 +14,9 @@ limitations under the License. */
 
 #include "paddle/fluid/framework/scope.h"
 
+#include <deque>
+#include <mutex>
+
 #include "glog/logging.h"
 #include "paddle/common/flags.h"
 #include "paddle/fluid/framework/threadpool.h"
@@ -27,8 +30,361 @@ COMMON_DECLARE_bool(eager_delete_scope);
 #define SCOPE_VARS_WRITER_LOCK phi::AutoWRLock auto_lock(&vars_lock_);
 
 namespace paddle::framework {
-Scope::Scope() : vars_(), kids_() {}
-Scope::~Scope() { DropKids(); }  // NOLINT
+
+namespace {
+
+// The interned variable names. An entry is referenced by the scopes having a
+// variable of its name and is released with the last of them, as the names
+// of the temporaries of an executor are unique to the executor. The lookups
+// are lock free: the readers are counted, and the released entries and the
+// replaced tables are freed when no reader is seen. The index of a released
+// entry is reused with the next generation, so an id is never reused.
+class VarNameInterner {
+ public:
+  static VarNameInterner& Instance() {
+    // never destroyed, scopes may be released during static destruction
+    static auto* interner = new VarNameInterner();
+    return *interner;
+  }
+
+  VarNameId Find(const std::string& name) const {
+    ReaderGuard guard(this);
+    const Entry* entry =
+        FindIn(table_.load(std::memory_order_seq_cst), name, Hash(name));
+    return entry == nullptr ? kInvalidVarNameId : entry->id;
+  }
+
+  // Returns the id of the name and holds a reference to it, which is dropped
+  // by Release.
+  VarNameId Acquire(const std::string& name) {
+    const size_t hash = Hash(name);
+    {
+      ReaderGuard guard(this);
+      Entry* entry =
+          FindIn(table_.load(std::memory_order_seq_cst), name, hash);
+      // an entry without references is being released
+      size_t refs =
+          entry == nullptr ? 0 : entry->refs.load(std::memory_order_relaxed);
+      while (refs > 0) {
+        if (entry->refs.compare_exchange_weak(
+                refs, refs + 1, std::memory_order_relaxed)) {
+          return entry->id;
+        }
+      }
+    }
+    std::lock_guard<std::mutex> guard(mutex_);
+    Table* table = table_.load(std::memory_order_relaxed);
+    Entry* entry = FindIn(table, name, hash);
+    if (entry != nullptr) {
+      entry->refs.fetch_add(1, std::memory_order_relaxed);
+      return entry->id;
+    }
+    uint32_t index = 0;
+    if (free_indices_.empty()) {
+      PADDLE_ENFORCE_LT(
+          entries_.size(),
+          static_cast<size_t>(UINT32_MAX),
+          common::errors::ResourceExhausted("Too many variable names."));
+      index = static_cast<uint32_t>(entries_.size());
+      entries_.emplace_back();
+      generations_.push_back(0);
+    } else {
+      index = free_indices_.back();
+      free_indices_.pop_back();
+    }
+    if ((num_used_ + 1) * 2 > table->capacity) {
+      table = Rebuild();
+    }
+    entries_[index] = std::make_unique<Entry>(
+        hash,
+        name,
+        static_cast<VarNameId>(generations_[index]) << 32 | index);
+    if (!Insert(table, entries_[index].get())) {
+      ++num_used_;
+    }
+    ++num_live_;
+    return entries_[index]->id;
+  }
+
+  // Drops the references to the ids held by Acquire.
+  void Release(const std::vector<VarNameId>& ids) {
+    if (ids.empty()) {
+      return;
+    }
+    std::lock_guard<std::mutex> guard(mutex_);
+    for (VarNameId id : ids) {
+      Entry* entry = EntryOfId(id);
+      if (entry->refs.fetch_sub(1, std::memory_order_relaxed) == 1) {
+        Remove(entry);
+      }
+    }
+    Reclaim();
+  }
+
+  const std::string& Name(VarNameId id) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    return EntryOfId(id)->name;
+  }
+
+  size_t Size() {
+    std::lock_guard<std::mutex> guard(mutex_);
+    return num_live_;
+  }
+
+ private:
+  struct Entry {
+    Entry(size_t hash, const std::string& name, VarNameId id)
+        : hash(hash), name(name), id(id) {}
+
+    const size_t hash;
+    const std::string name;
+    const VarNameId id;
+    std::atomic<size_t> refs{1};
+  };
+
+  struct Table {
+    explicit Table(size_t capacity)
+        : capacity(capacity), slots(new std::atomic<Entry*>[capacity]) {
+      for (size_t i = 0; i < capacity; ++i) {
+        slots[i].store(nullptr, std::memory_order_relaxed);
+      }
+    }
+
+    size_t capacity;  // a power of 2
+    std::unique_ptr<std::atomic<Entry*>[]> slots;
+  };
+
+  // The readers are spread over a few counters to keep them off a shared
+  // cache line.
+  static constexpr int kReaderShards = 16;
+
+  struct alignas(64) ReaderCount {
+    std::atomic<int> value{0};
+  };
+
+  class ReaderGuard {
+   public:
+    explicit ReaderGuard(const VarNameInterner* interner)
+        : count_(&interner->readers_[Shard()].value) {
+      count_->fetch_add(1, std::memory_order_seq_cst);
+    }
+    ~ReaderGuard() { count_->fetch_sub(1, std::memory_order_release); }
+
+   private:
+    static int Shard() {
+      static std::atomic<int> next_shard{0};
+      // constant initialized, so no guard is checked on the lookups
+      static thread_local int shard = -1;
+      if (shard < 0) {
+        shard =
+            next_shard.fetch_add(1, std::memory_order_relaxed) % kReaderShards;
+      }
+      return shard;
+    }
+
+    std::atomic<int>* count_;
+  };
+
+  VarNameInterner()
+      : tombstone_(0, "", kInvalidVarNameId),
+        current_(std::make_unique<Table>(1024)) {
+    table_.store(current_.get(), std::memory_order_release);
+  }
+
+  static size_t Hash(const std::string& name) {
+    return XXH32(name.c_str(), name.size(), 1);
+  }
+
+  // Called by the readers and by the writers holding mutex_. The slots are
+  // read in the same total order as the stores of Remove, see Reclaim.
+  Entry* FindIn(const Table* table,
+                const std::string& name,
+                size_t hash) const {
+    const size_t mask = table->capacity - 1;
+    for (size_t i = hash & mask;; i = (i + 1) & mask) {
+      Entry* entry = table->slots[i].load(std::memory_order_seq_cst);
+      if (entry == nullptr) {
+        return nullptr;
+      }
+      if (entry != &tombstone_ && entry->hash == hash && entry->name == name) {
+        return entry;
+      }
+    }
+  }
+
+  // Called holding mutex_, returns whether a released slot is reused.
+  bool Insert(Table* table, Entry* entry) {
+    const size_t mask = table->capacity - 1;
+    for (size_t i = entry->hash & mask;; i = (i + 1) & mask) {
+      Entry* slot = table->slots[i].load(std::memory_order_relaxed);
+      if (slot == nullptr || slot == &tombstone_) {
+        table->slots[i].store(entry, std::memory_order_release);
+        return slot == &tombstone_;
+      }
+    }
+  }
+
+  // Called holding mutex_.
+  Entry* EntryOfId(VarNameId id) {
+    const size_t index = static_cast<uint32_t>(id);
+    PADDLE_ENFORCE_EQ(
+        index < entries_.size() && entries_[index] != nullptr &&
+            entries_[index]->id == id,
+        true,
+        common::errors::InvalidArgument(
+            "The variable name id %d is not interned.", id));
+    return entries_[index].get();
+  }
+
+  // Called holding mutex_. The slot of the entry is kept as a tombstone
+  // until the table is rebuilt.
+  void Remove(Entry* entry) {
+    Table* table = table_.load(std::memory_order_relaxed);
+    const size_t mask = table->capacity - 1;
+    for (size_t i = entry->hash & mask;; i = (i + 1) & mask) {
+      if (table->slots[i].load(std::memory_order_relaxed) == entry) {
+        table->slots[i].store(&tombstone_, std::memory_order_seq_cst);
+        break;
+      }
+    }
+    --num_live_;
+    const uint32_t index = static_cast<uint32_t>(entry->id);
+    ++generations_[index];
+    free_indices_.push_back(index);
+    retired_entries_.push_back(std::move(entries_[index]));
+  }
+
+  // Called holding mutex_. Replaces the table by one without tombstones,
+  // which is at most half full.
+  Table* Rebuild() {
+    size_t capacity = 1024;
+    while (capacity < (num_live_ + 1) * 4) {
+      capacity *= 2;
+    }
+    auto table = std::make_unique<Table>(capacity);
+    for (auto& entry : entries_) {
+      if (entry != nullptr) {
+        Insert(table.get(), entry.get());
+      }
+    }
+    num_used_ = num_live_;
+    retired_tables_.push_back(std::move(current_));
+    current_ = std::move(table);
+    table_.store(current_.get(), std::memory_order_seq_cst);
+    Reclaim();
+    return current_.get();
+  }
+
+  // Called holding mutex_. A reader counts itself before it loads the table
+  // and the slots, so a shard seen without readers after an entry or a table
+  // is unlinked has no reader left that may use them.
+  void Reclaim() {
+    if (retired_entries_.empty() && retired_tables_.empty()) {
+      return;
+    }
+    for (auto& readers : readers_) {
+      if (readers.value.load(std::memory_order_seq_cst) != 0) {
+        return;
+      }
+    }
+    retired_entries_.clear();
+    retired_tables_.clear();
+  }
+
+  Entry tombstone_;
+  mutable ReaderCount readers_[kReaderShards];
+  std::atomic<Table*> table_{nullptr};
+  std::mutex mutex_;
+  // the entries, tables and counters below are guarded by mutex_
+  std::unique_ptr<Table> current_;
+  std::vector<std::unique_ptr<Entry>> entries_;  // indexed by the low 32 bits
+  std::vector<uint32_t> generations_;
+  std::vector<uint32_t> free_indices_;
+  size_t num_live_{0};
+  size_t num_used_{0};  // the slots of live entries and tombstones
+  std::vector<std::unique_ptr<Entry>> retired_entries_;
+  std::vector<std::unique_ptr<Table>> retired_tables_;
+};
+
+// Counts the readers of the variable tables of a scope, see
+// Scope::ReplaceVarTable.
+class VarReaderGuard {
+ public:
+  explicit VarReaderGuard(std::atomic<int>* num_readers)
+      : num_readers_(num_readers) {
+    num_readers_->fetch_add(1, std::memory_order_seq_cst);
+  }
+  ~VarReaderGuard() { num_readers_->fetch_sub(1, std::memory_order_release); }
+
+ private:
+  std::atomic<int>* num_readers_;
+};
+
+}  // namespace
+
+VarNameId FindVarNameId(const std::string& name) {
+  return VarNameInterner::Instance().Find(name);
+}
+
+const std::string& VarNameOfId(VarNameId id) {
+  return VarNameInterner::Instance().Name(id);
+}
+
+size_t NumInternedVarNames() { return VarNameInterner::Instance().Size(); }
+
+// Open addressing with linear probing. A slot gets an id once and keeps it
+// until the table is replaced, the variable of an erased id is set to
+// nullptr, so a lookup stops at the first slot without id. The table is
+// replaced when more than half of the slots have ids. A slot holds a
+// reference to the name of its id, and the names of the erased ids are
+// released when the table is replaced.
+struct Scope::VarTable {
+  struct Slot {
+    std::atomic<VarNameId> id{kInvalidVarNameId};
+    std::atomic<Variable*> var{nullptr};
+  };
+
+  explicit VarTable(size_t capacity)
+      : capacity(capacity), slots(new Slot[capacity]) {
+    while ((size_t{1} << (64 - shift)) < capacity) {
+      --shift;
+    }
+  }
+
+  size_t Index(VarNameId id) const {
+    // fibonacci hashing, the low bits of the ids are consecutive integers
+    return static_cast<size_t>((id * 0x9E3779B97F4A7C15ull) >> shift) &
+           (capacity - 1);
+  }
+
+  size_t capacity;  // a power of 2
+  int shift{64};
+  std::unique_ptr<Slot[]> slots;
+  size_t num_ids{0};
+};
+
+Scope::Scope() : kids_() {}
+
+Scope::Scope(Scope const* parent) : parent_(parent) {}
+
+Scope::~Scope() {  // NOLINT
+  DropKids();
+  if (vars_ != nullptr) {
+    std::vector<VarNameId> ids;
+    ids.reserve(vars_->num_ids);
+    for (size_t i = 0; i < vars_->capacity; ++i) {
+      delete vars_->slots[i].var.load(std::memory_order_relaxed);
+      VarNameId id = vars_->slots[i].id.load(std::memory_order_relaxed);
+      if (id != kInvalidVarNameId) {
+        ids.push_back(id);
+      }
+    }
+    VarNameInterner::Instance().Release(ids);
+  }
+  for (auto& pair : generated_vars_) {
+    delete pair.second;
+  }
+}
 
 Scope& Scope::NewScope() const {
   Scope* child = new Scope(this);
@@ -60,18 +416,44 @@ Variable* Scope::Var(std::string* name) {
   {
     SCOPE_VARS_WRITER_LOCK
     new_name = std::to_string(reinterpret_cast<uintptr_t>(this)) + "." +
-               std::to_string(vars_.size());
+               std::to_string(num_vars_.load(std::memory_order_relaxed));
     if (name != nullptr) {
       *name = new_name;
     }
-    ret = VarInternal(new_name);
+    ret = FindGeneratedVarInternal(new_name);
+    if (ret == nullptr) {
+      ret = new Variable();
+      generated_vars_.emplace(new_name, ret);
+      num_generated_vars_.fetch_add(1, std::memory_order_relaxed);
+      num_vars_.fetch_add(1, std::memory_order_relaxed);
+    }
   }
   return ret;
 }
 
 Variable* Scope::FindVar(const std::string& name) const {
-  SCOPE_VARS_READER_LOCK
-  return FindVarInternal(name);
+  VarNameId id = FindVarNameId(name);
+  for (const Scope* scope = this; scope != nullptr; scope = scope->parent_) {
+    Variable* var =
+        id == kInvalidVarNameId ? nullptr : scope->FindVarLocally(id);
+    if (var == nullptr) {
+      var = scope->FindGeneratedVar(name);
+    }
+    if (var != nullptr) {
+      return var;
+    }
+  }
+  return nullptr;
+}
+
+Variable* Scope::FindVarById(VarNameId id) const {
+  for (const Scope* scope = this; scope != nullptr; scope = scope->parent_) {
+    Variable* var = scope->FindVarLocally(id);
+    if (var != nullptr) {
+      return var;
+    }
+  }
+  return nullptr;
 }
 
 Variable* Scope::GetVar(const std::string& name) const {
@@ -82,8 +464,9 @@ Variable* Scope::GetVar(const std::string& name) const {
 }
 
 Variable* Scope::FindLocalVar(const std::string& name) const {
-  SCOPE_VARS_READER_LOCK
-  return FindVarLocally(name);
+  VarNameId id = FindVarNameId(name);
+  Variable* var = id == kInvalidVarNameId ? nullptr : FindVarLocally(id);
+  return var == nullptr ? FindGeneratedVar(name) : var;
 }
 
 const Scope* Scope::FindScope(const Variable* var) const {
@@ -125,9 +508,15 @@ std::vector<std::string> Scope::LocalVarNames() const {
   std::vector<std::string> known_vars;
   {
     SCOPE_VARS_READER_LOCK
-    known_vars.reserve(this->vars_.size());
-    for (auto& p : vars_) {
-      known_vars.emplace_back(p.first);
+    known_vars.reserve(num_vars_.load(std::memory_order_relaxed));
+    for (size_t i = 0; vars_ != nullptr && i < vars_->capacity; ++i) {
+      if (vars_->slots[i].var.load(std::memory_order_relaxed) != nullptr) {
+        known_vars.emplace_back(
+            VarNameOfId(vars_->slots[i].id.load(std::memory_order_relaxed)));
+      }
+    }
+    for (auto& pair : generated_vars_) {
+      known_vars.emplace_back(pair.first);
     }
   }
   return known_vars;
@@ -137,9 +526,15 @@ std::vector<Variable*> Scope::LocalVars() {
   std::vector<Variable*> known_vars;
   {
     SCOPE_VARS_READER_LOCK
-    known_vars.reserve(this->vars_.size());
-    for (auto& p : vars_) {
-      known_vars.emplace_back(p.second.get());
+    known_vars.reserve(num_vars_.load(std::memory_order_relaxed));
+    for (size_t i = 0; vars_ != nullptr && i < vars_->capacity; ++i) {
+      Variable* var = vars_->slots[i].var.load(std::memory_order_relaxed);
+      if (var != nullptr) {
+        known_vars.emplace_back(var);
+      }
+    }
+    for (auto& pair : generated_vars_) {
+      known_vars.emplace_back(pair.second);
     }
   }
   return known_vars;
@@ -165,13 +560,18 @@ void Scope::DeleteScope(Scope* scope) const {
 
 void Scope::EraseVars(const std::vector<std::string>& var_names) {
   {
-    std::set<std::string> var_set(var_names.begin(), var_names.end());
     SCOPE_VARS_WRITER_LOCK
-    for (auto it = vars_.begin(); it != vars_.end();) {
-      if (var_set.find(it->first) != var_set.end()) {
-        it = vars_.erase(it);
-      } else {
-        ++it;
+    for (auto& name : var_names) {
+      VarNameId id = FindVarNameId(name);
+      if (id != kInvalidVarNameId) {
+        EraseVarInternal(id);
+      }
+      auto iter = generated_vars_.find(name);
+      if (iter != generated_vars_.end()) {
+        delete iter->second;
+        generated_vars_.erase(iter);
+        num_generated_vars_.fetch_sub(1, std::memory_order_relaxed);
+        num_vars_.fetch_sub(1, std::memory_order_relaxed);
       }
     }
   }
@@ -181,31 +581,133 @@ void Scope::Rename(const std::string& origin_name,
                    const std::string& new_name) const {
   {
     SCOPE_VARS_WRITER_LOCK
-    RenameInternal(origin_name, new_name);
+    RenameInternal(origin_name, new_name, false);
   }
 }
 
 std::string Scope::Rename(const std::string& origin_name) const {
-  auto new_name = string::Sprintf("%p.%d", this, vars_.size());
+  auto new_name = string::Sprintf(
+      "%p.%d", this, num_vars_.load(std::memory_order_relaxed));
   {
     SCOPE_VARS_WRITER_LOCK
-    RenameInternal(origin_name, new_name);
+    RenameInternal(origin_name, new_name, true);
   }
   return new_name;
 }
 
 Variable* Scope::VarInternal(const std::string& name) {
-  auto* v = FindVarLocally(name);
+  auto* v = FindGeneratedVarInternal(name);
+  if (v != nullptr) return v;
+  VarNameId id = FindVarNameId(name);
+  v = id == kInvalidVarNameId ? nullptr : FindVarLocally(id);
   if (v != nullptr) return v;
   v = new Variable();
-  vars_.emplace(name, std::unique_ptr<Variable>(v));
+  InsertVarInternal(VarNameInterner::Instance().Acquire(name), v);
   VLOG(3) << "Create variable " << name;
   return v;
 }
 
+void Scope::InsertVarInternal(VarNameId id, Variable* var) const {
+  if (!retired_vars_.empty() &&
+      num_var_readers_.load(std::memory_order_seq_cst) == 0) {
+    retired_vars_.clear();
+  }
+  if (vars_ == nullptr || (vars_->num_ids + 1) * 2 > vars_->capacity) {
+    // the erased ids are dropped from the new table
+    size_t capacity = 16;
+    while (capacity < (num_vars_.load(std::memory_order_relaxed) + 1) * 4) {
+      capacity *= 2;
+    }
+    ReplaceVarTable(capacity);
+  }
+  const size_t mask = vars_->capacity - 1;
+  for (size_t i = vars_->Index(id);; i = (i + 1) & mask) {
+    auto& slot = vars_->slots[i];
+    VarNameId slot_id = slot.id.load(std::memory_order_relaxed);
+    if (slot_id == id) {
+      // the slot holds a reference to the id already
+      slot.var.store(var, std::memory_order_release);
+      VarNameInterner::Instance().Release({id});
+      break;
+    }
+    if (slot_id == kInvalidVarNameId) {
+      // the variable is visible to the readers once they see the id
+      slot.var.store(var, std::memory_order_relaxed);
+      slot.id.store(id, std::memory_order_release);
+      ++vars_->num_ids;
+      break;
+    }
+  }
+  num_vars_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Scope::EraseVarInternal(VarNameId id) const {
+  if (vars_ == nullptr) {
+    return;
+  }
+  const size_t mask = vars_->capacity - 1;
+  for (size_t i = vars_->Index(id);; i = (i + 1) & mask) {
+    auto& slot = vars_->slots[i];
+    VarNameId slot_id = slot.id.load(std::memory_order_relaxed);
+    if (slot_id == kInvalidVarNameId) {
+      return;
+    }
+    if (slot_id == id) {
+      Variable* var = slot.var.exchange(nullptr, std::memory_order_acq_rel);
+      if (var != nullptr) {
+        num_vars_.fetch_sub(1, std::memory_order_relaxed);
+        delete var;
+      }
+      return;
+    }
+  }
+}
+
+void Scope::ReplaceVarTable(size_t capacity) const {
+  auto table = std::make_unique<VarTable>(capacity);
+  std::vector<VarNameId> erased_ids;
+  if (vars_ != nullptr) {
+    const size_t mask = capacity - 1;
+    for (size_t i = 0; i < vars_->capacity; ++i) {
+      Variable* var = vars_->slots[i].var.load(std::memory_order_relaxed);
+      VarNameId id = vars_->slots[i].id.load(std::memory_order_relaxed);
+      if (var == nullptr) {
+        if (id != kInvalidVarNameId) {
+          erased_ids.push_back(id);
+        }
+        continue;
+      }
+      size_t j = table->Index(id);
+      while (table->slots[j].id.load(std::memory_order_relaxed) !=
+             kInvalidVarNameId) {
+        j = (j + 1) & mask;
+      }
+      table->slots[j].var.store(var, std::memory_order_relaxed);
+      table->slots[j].id.store(id, std::memory_order_relaxed);
+      ++table->num_ids;
+    }
+    retired_vars_.push_back(std::move(vars_));
+  }
+  vars_ = std::move(table);
+  // A reader counts itself before it loads the table, so when no reader is
+  // seen after the new table is published, the later readers can only load
+  // the new table and the retired ones can be released.
+  published_vars_.store(vars_.get(), std::memory_order_seq_cst);
+  if (num_var_readers_.load(std::memory_order_seq_cst) == 0) {
+    retired_vars_.clear();
+  }
+  // the readers compare the ids only, so the names can go at once
+  VarNameInterner::Instance().Release(erased_ids);
+}
+
 const Scope* Scope::FindScopeInternal(const Variable* var) const {
-  for (auto& kv : vars_) {
-    if (kv.second.get() == var) {
+  for (size_t i = 0; vars_ != nullptr && i < vars_->capacity; ++i) {
+    if (vars_->slots[i].var.load(std::memory_order_relaxed) == var) {
+      return this;
+    }
+  }
+  for (auto& pair : generated_vars_) {
+    if (pair.second == var) {
       return this;
     }
   }
@@ -213,54 +715,121 @@ const Scope* Scope::FindScopeInternal(const Variable* var) const {
 }
 
 const Scope* Scope::FindScopeInternal(const std::string& name) const {
-  if (vars_.find(name) != vars_.end()) {
+  VarNameId id = FindVarNameId(name);
+  if ((id != kInvalidVarNameId && FindVarLocally(id) != nullptr) ||
+      FindGeneratedVarInternal(name) != nullptr) {
     return this;
   }
   return (parent_ == nullptr) ? nullptr : parent_->FindScope(name);
 }
 
 void Scope::RenameInternal(const std::string& origin_name,
-                           const std::string& new_name) const {
-  auto origin_it = vars_.find(origin_name);
-  PADDLE_ENFORCE_NE(
-      origin_it,
-      vars_.end(),
-      common::errors::NotFound(
-          "Original variable with name %s is not found in the scope.",
-          origin_name));
-  auto new_it = vars_.find(new_name);
+                           const std::string& new_name,
+                           bool generated) const {
   PADDLE_ENFORCE_EQ(
-      new_it,
-      vars_.end(),
+      FindGeneratedVarInternal(new_name) == nullptr &&
+          (generated || FindVarNameId(new_name) == kInvalidVarNameId ||
+           FindVarLocally(FindVarNameId(new_name)) == nullptr),
+      true,
       common::errors::AlreadyExists(
           "The variable with name %s already exists in the scope.", new_name));
-  vars_[new_name].reset(origin_it->second.release());
-  vars_.erase(origin_it);
+  Variable* var = DetachVarInternal(origin_name);
+  PADDLE_ENFORCE_NOT_NULL(
+      var,
+      common::errors::NotFound(
+          "Original variable with name %s is not found in the scope.",
+          origin_name));
+  if (generated) {
+    generated_vars_.emplace(new_name, var);
+    num_generated_vars_.fetch_add(1, std::memory_order_relaxed);
+    num_vars_.fetch_add(1, std::memory_order_relaxed);
+  } else {
+    InsertVarInternal(VarNameInterner::Instance().Acquire(new_name), var);
+  }
 }
 
-Variable* Scope::FindVarInternal(const std::string& name) const {
-  auto var = FindVarLocally(name);
-  if (var != nullptr) {
+Variable* Scope::DetachVarInternal(const std::string& name) const {
+  auto iter = generated_vars_.find(name);
+  if (iter != generated_vars_.end()) {
+    Variable* var = iter->second;
+    generated_vars_.erase(iter);
+    num_generated_vars_.fetch_sub(1, std::memory_order_relaxed);
+    num_vars_.fetch_sub(1, std::memory_order_relaxed);
     return var;
   }
-  return (parent_ == nullptr) ? nullptr : parent_->FindVar(name);
+  VarNameId id = FindVarNameId(name);
+  if (id == kInvalidVarNameId || vars_ == nullptr) {
+    return nullptr;
+  }
+  const size_t mask = vars_->capacity - 1;
+  for (size_t i = vars_->Index(id);; i = (i + 1) & mask) {
+    auto& slot = vars_->slots[i];
+    VarNameId slot_id = slot.id.load(std::memory_order_relaxed);
+    if (slot_id == kInvalidVarNameId) {
+      return nullptr;
+    }
+    if (slot_id == id) {
+      Variable* var = slot.var.exchange(nullptr, std::memory_order_acq_rel);
+      if (var != nullptr) {
+        num_vars_.fetch_sub(1, std::memory_order_relaxed);
+      }
+      return var;
+    }
+  }
 }
 
-Variable* Scope::FindVarLocally(const std::string& name) const {
-  auto it = vars_.find(name);
-  if (it != vars_.end()) {
-    return it->second.get();
+Variable* Scope::FindGeneratedVarInternal(const std::string& name) const {
+  if (generated_vars_.empty()) {
+    return nullptr;
+  }
+  auto iter = generated_vars_.find(name);
+  return iter == generated_vars_.end() ? nullptr : iter->second;
+}
+
+Variable* Scope::FindGeneratedVar(const std::string& name) const {
+  if (num_generated_vars_.load(std::memory_order_acquire) == 0) {
+    return nullptr;
+  }
+  SCOPE_VARS_READER_LOCK
+  return FindGeneratedVarInternal(name);
+}
+
+Variable* Scope::FindVarLocally(VarNameId id) const {
+  VarReaderGuard guard(&num_var_readers_);
+  const VarTable* table = published_vars_.load(std::memory_order_seq_cst);
+  if (table == nullptr) {
+    return nullptr;
+  }
+  const size_t mask = table->capacity - 1;
+  for (size_t i = table->Index(id);; i = (i + 1) & mask) {
+    VarNameId slot_id = table->slots[i].id.load(std::memory_order_acquire);
+    if (slot_id == id) {
+      return table->slots[i].var.load(std::memory_order_acquire);
+    }
+    if (slot_id == kInvalidVarNameId) {
+      return nullptr;
+    }
   }
-  return nullptr;
 }
 
 void Scope::EraseVarsExcept(const std::unordered_set<Variable*>& vars) {
   SCOPE_VARS_WRITER_LOCK
-  for (auto iter = vars_.begin(); iter != vars_.end();) {
-    if (vars.count(iter->second.get()) != 0) {
-      ++iter;
+  for (size_t i = 0; vars_ != nullptr && i < vars_->capacity; ++i) {
+    Variable* var = vars_->slots[i].var.load(std::memory_order_relaxed);
+    if (var != nullptr && vars.count(var) == 0) {
+      vars_->slots[i].var.store(nullptr, std::memory_order_release);
+      num_vars_.fetch_sub(1, std::memory_order_relaxed);
+      delete var;
+    }
+  }
+  for (auto iter = generated_vars_.begin(); iter != generated_vars_.end();) {
+    if (vars.count(iter->second) == 0) {
+      delete iter->second;
+      iter = generated_vars_.erase(iter);
+      num_generated_vars_.fetch_sub(1, std::memory_order_relaxed);
+      num_vars_.fetch_sub(1, std::memory_order_relaxed);
     } else {
-      vars_.erase(iter++);
+      ++iter;
     }
   }
 }
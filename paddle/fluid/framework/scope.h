@@ -18,6 +18,8 @@ extern "C" {
 #include <xxhash.h>
 }
 
+#include <atomic>
+#include <cstdint>
 #include <list>
 #include <memory>
 #include <string>
@@ -39,6 +41,27 @@ class Variable;
 
 namespace paddle {
 namespace framework {
+
+/// Id of an interned variable name. The variable names of all scopes are
+/// interned in a process wide table, so that scopes are keyed by integers
+/// and can be read without locks. A name is released when no scope has a
+/// variable of it, and its id is not given to another name, so a stale id
+/// finds nothing. The scope-unique names generated by
+/// Scope::Var(std::string*) and Scope::Rename(origin_name) are not interned.
+using VarNameId = uint64_t;
+constexpr VarNameId kInvalidVarNameId = UINT64_MAX;
+
+/// Return the id of a variable name, or kInvalidVarNameId if no scope has a
+/// variable of the name.
+TEST_API VarNameId FindVarNameId(const std::string& name);
+
+/// Return the variable name of an id, which is valid while a scope has a
+/// variable of the name.
+TEST_API const std::string& VarNameOfId(VarNameId id);
+
+/// Return the number of the interned variable names.
+TEST_API size_t NumInternedVarNames();
+
 /**
  * @brief Scope that manage all variables.
  *
@@ -79,6 +102,11 @@ class TEST_API Scope {
   /// Caller doesn't own the returned Variable.
   Variable* FindVar(const std::string& name) const;
 
+  /// The same as FindVar, with the id of the name from FindVarNameId, so an
+  /// executor can resolve the names of a program once. The variables of
+  /// generated names are not found by id.
+  Variable* FindVarById(VarNameId id) const;
+
   // Get a variable in the scope or any of its ancestors. Enforce
   /// the returned Variable is not nullptr
   Variable* GetVar(const std::string& name) const;
@@ -119,7 +147,7 @@ class TEST_API Scope {
               const std::string& new_name) const;
 
   // Return the number of variables in scope
-  size_t Size() { return vars_.size(); }
+  size_t Size() { return num_vars_.load(std::memory_order_relaxed); }
 
   // Rename variable to a new name and return the new name
   std::string Rename(const std::string& origin_name) const;
@@ -129,38 +157,45 @@ class TEST_API Scope {
 
   void SetCanReused(bool can_reused) { can_reused_ = can_reused; }
 
- protected:
-  struct KeyHasher {
-    std::size_t operator()(const std::string& key) const {
-      return XXH32(key.c_str(), key.size(), 1);
-    }
-  };
-
-  mutable std::unordered_map<std::string, std::unique_ptr<Variable>, KeyHasher>
-      vars_;
-
  private:
+  // An open addressing table from VarNameId to Variable, see scope.cc.
+  struct VarTable;
+
   // Call Scope::NewScope for a sub-scope.
-  explicit Scope(Scope const* parent) : parent_(parent) {}
+  explicit Scope(Scope const* parent);
 
   // Called by Var.
   Variable* VarInternal(const std::string& name);
 
+  // Called by the writers holding vars_lock_. The reference to the id
+  // taken by the caller is kept by the slot of the id.
+  void InsertVarInternal(VarNameId id, Variable* var) const;
+  void EraseVarInternal(VarNameId id) const;
+  void ReplaceVarTable(size_t capacity) const;
+
   // Called by FindScope.
   const Scope* FindScopeInternal(const Variable* var) const;
 
   // Called by FindScope.
   const Scope* FindScopeInternal(const std::string& name) const;
 
-  // Called by Rename.
+  // Called by Rename, new_name is not interned if it is generated.
   void RenameInternal(const std::string& origin_name,
-                      const std::string& new_name) const;
+                      const std::string& new_name,
+                      bool generated) const;
 
-  // Called by FindVar recursively.
-  Variable* FindVarInternal(const std::string& name) const;
+  // Called by the writers holding vars_lock_. Removes the variable of the
+  // name from the scope without deleting it.
+  Variable* DetachVarInternal(const std::string& name) const;
 
-  // Called by FindVarInternal and Var.
-  Variable* FindVarLocally(const std::string& name) const;
+  // Called holding vars_lock_.
+  Variable* FindGeneratedVarInternal(const std::string& name) const;
+
+  // Called by FindVar and FindLocalVar.
+  Variable* FindGeneratedVar(const std::string& name) const;
+
+  // Called by FindVarById and Var, without locks.
+  Variable* FindVarLocally(VarNameId id) const;
 
   // Scope in `kids_` are owned by this class.
   mutable std::list<Scope*> kids_;
@@ -174,6 +209,22 @@ class TEST_API Scope {
  private:
   mutable phi::RWLock kids_lock_;
   mutable phi::RWLock vars_lock_;
+
+  // The variables, owned by this scope. vars_ is changed by the writers
+  // holding vars_lock_ only, and read through published_vars_ by the readers
+  // without locks. A replaced table is kept in retired_vars_ until no reader
+  // may use it.
+  mutable std::unique_ptr<VarTable> vars_;
+  mutable std::atomic<const VarTable*> published_vars_{nullptr};
+  mutable std::vector<std::unique_ptr<VarTable>> retired_vars_;
+  mutable std::atomic<int> num_var_readers_{0};
+  mutable std::atomic<size_t> num_vars_{0};
+
+  // The variables of generated names, which are used by a few ops for
+  // temporaries and are not interned. Guarded by vars_lock_, the readers
+  // skip it while num_generated_vars_ is 0.
+  mutable std::unordered_map<std::string, Variable*> generated_vars_;
+  mutable std::atomic<size_t> num_generated_vars_{0};
 };
 
 // Generate some debug string about the inherience structure of scope, quite
@@ -16,12 +16,18 @@ limitations under the License. */
 
 #include <utf8proc.h>
 
+#include <atomic>
 #include <exception>
 
 #include "glog/logging.h"
 
 namespace paddle::framework {
 
+uint64_t Vocab::NextVersion() {
+  static std::atomic<uint64_t> version{0};
+  return version.fetch_add(1, std::memory_order_relaxed) + 1;
+}
+
 std::wstring_convert<std::codecvt_utf8<wchar_t>> kConverter;
 
 // Convert the std::string type to the std::wstring type.
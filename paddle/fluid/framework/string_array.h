@@ -15,6 +15,7 @@ limitations under the License. */
 #pragma once
 
 #include <codecvt>
+#include <cstdint>
 #include <iostream>
 #include <locale>
 #include <string>
@@ -36,17 +37,29 @@ class Vocab : public phi::ExtendedTensor,
  public:
   Vocab() = default;
 
-  Vocab(Vocab&& other) = default;
+  Vocab(Vocab&& other) : data_(std::move(other.data_)) {
+    other.version_ = NextVersion();
+  }
 
-  Vocab(const Vocab& other) = default;
+  Vocab(const Vocab& other) : data_(other.data_) {}
 
-  Vocab& operator=(const Vocab& other) = default;
+  Vocab& operator=(const Vocab& other) {
+    this->data_ = other.data_;
+    version_ = NextVersion();
+    return *this;
+  }
 
-  Vocab& operator=(Vocab&& other) = default;
+  Vocab& operator=(Vocab&& other) {
+    this->data_ = std::move(other.data_);
+    version_ = NextVersion();
+    other.version_ = NextVersion();
+    return *this;
+  }
 
   Vocab& operator=(
       const std::unordered_map<std::wstring, std::int32_t>& other) {
     this->data_ = other;
+    version_ = NextVersion();
     return *this;
   }
 
@@ -60,44 +73,41 @@ class Vocab : public phi::ExtendedTensor,
 
   size_t size() const { return data_.size(); }
 
-  void clear() { data_.clear(); }
+  /// \brief Returns the version of the content, which changes with every
+  /// modification and is never shared by two vocabs, so that data built
+  /// from a vocab can be cached by its address and version.
+  uint64_t version() const { return version_; }
+
+  void clear() {
+    data_.clear();
+    version_ = NextVersion();
+  }
 
   void emplace(const std::wstring& key, std::int32_t value) {
     data_.emplace(key, value);
+    version_ = NextVersion();
   }
 
-  std::int32_t at(const std::wstring& key) { return data_.at(key); }
-
   std::int32_t at(const std::wstring& key) const { return data_.at(key); }
 
-  std::unordered_map<std::wstring, std::int32_t>::iterator find(
-      const std::wstring& key) {
-    return data_.find(key);
-  }
-
   std::unordered_map<std::wstring, std::int32_t>::const_iterator find(
       const std::wstring& key) const {
     return data_.find(key);
   }
 
-  std::unordered_map<std::wstring, std::int32_t>::iterator begin() {
-    return data_.begin();
-  }
-
   std::unordered_map<std::wstring, std::int32_t>::const_iterator begin() const {
     return data_.begin();
   }
 
-  std::unordered_map<std::wstring, std::int32_t>::iterator end() {
-    return data_.end();
-  }
-
   std::unordered_map<std::wstring, std::int32_t>::const_iterator end() const {
     return data_.end();
   }
 
  private:
+  static uint64_t NextVersion();
+
   std::unordered_map<std::wstring, std::int32_t> data_;
+  uint64_t version_{NextVersion()};
 };
 
 // Note(YuanRisheng): PhiVector is essentially a vector that only used for PHI
@@ -19,9 +19,13 @@
 #include <algorithm>
 #include <cstdlib>
 #include <fstream>
+#include <future>
 #include <memory>
 #include <set>
+#include <sstream>
 #include <string>
+#include <string_view>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
@@ -36,6 +40,7 @@
 #include "paddle/fluid/framework/op_proto_maker.h"
 #include "paddle/fluid/framework/operator.h"
 #include "paddle/fluid/framework/scope.h"
+#include "paddle/fluid/framework/tensor_util.h"
 #include "paddle/fluid/framework/transfer_scope_cache.h"
 #include "paddle/fluid/framework/var_type_traits.h"
 #include "paddle/fluid/framework/version.h"
@@ -66,6 +71,7 @@
 #include "paddle/phi/core/platform/device/gpu/gpu_types.h"
 #include "paddle/phi/core/platform/device_context.h"
 #include "paddle/phi/core/platform/profiler.h"
+#include "paddle/phi/core/threadpool.h"
 
 #include "paddle/phi/core/generator.h"
 #include "paddle/phi/kernels/funcs/data_type_transform.h"
@@ -206,6 +212,43 @@ using inference::tensorrt::TRTInt8Calibrator;
 int AnalysisPredictor::clone_num_ = 1;
 
 namespace {
+// Appends the hash of the content of a file to os. The file is hashed by
+// chunks, to not hold a copy of a large file in memory.
+void HashFileContent(const std::string &path, std::ostream *os) {
+  std::ifstream fin(path, std::ios::in | std::ios::binary);
+  std::string chunk(1 << 20, '\0');
+  int64_t size = 0;
+  while (fin.read(&chunk[0], static_cast<std::streamsize>(chunk.size())) ||
+         fin.gcount() > 0) {
+    *os << std::hash<std::string_view>()(
+               std::string_view(chunk.data(), fin.gcount()))
+        << ",";
+    size += fin.gcount();
+  }
+  *os << "size:" << size;
+}
+
+// The path, size and mtime of a file, empty if it does not exist. The
+// mtime is in ns where available, files rewritten within a second differ.
+std::string FileFingerprint(const std::string &path) {
+  struct stat info;
+  if (stat(path.c_str(), &info) != 0) {
+    return "";
+  }
+  std::ostringstream os;
+  os << path << ",size:" << info.st_size
+     << ",mtime:" << static_cast<int64_t>(info.st_mtime);
+#if defined(__APPLE__)
+  os << "." << info.st_mtimespec.tv_nsec;
+#elif !defined(_WIN32)
+  os << "." << info.st_mtim.tv_nsec;
+#endif
+  return os.str();
+}
+
+// The prefix of the files of an optimized pir model in the cache directory.
+constexpr char kOptimizedModelPrefix[] = "_optimized_";
+
 bool IsPersistable(const framework::VarDesc *var) {
   if (var->Persistable() &&
       var->GetType() != framework::proto::VarType::FEED_MINIBATCH &&
@@ -431,6 +474,7 @@ bool AnalysisPredictor::Init(
     const std::shared_ptr<framework::Scope> &parent_scope,
     const std::shared_ptr<framework::ProgramDesc> &program) {
   VLOG(3) << "Predictor::init()";
+  init_timer_.tic();
 #ifdef PADDLE_WITH_NVTX
   if (config_.with_profile_) {
     LOG(WARNING) << "Profiler is activated, which might affect the performance";
@@ -459,18 +503,32 @@ bool AnalysisPredictor::Init(
             "config.EnableNewExecutor(true)) and config.EnableNewIR(true)"));
   }
 
+  // The key is computed from the original model, before it is replaced by
+  // the optimized one. Clones get the key of the predictor they clone.
+  if (config_.new_ir_enabled() && optimized_model_key_.empty() &&
+      (config_.use_optimized_model_ || config_.save_optimized_model_)) {
+    inference::Timer timer;
+    timer.tic();
+    optimized_model_key_ = GetOptimizedPirModelKey();
+    startup_phases_.emplace_back("hash model", timer.toc());
+  }
+
   // Use Optimized model to inference
   if (config_.use_optimized_model_) {
     std::string optimized_model_path = GetOptimizedModelPath();
     std::string optimized_model;
+    std::string optimized_params;
     if (config_.new_ir_enabled()) {
-      optimized_model = optimized_model_path + "/" + "_optimized.json";
+      optimized_model = optimized_model_path + "/" + kOptimizedModelPrefix +
+                        optimized_model_key_ + ".json";
+      optimized_params = optimized_model_path + "/" + kOptimizedModelPrefix +
+                         optimized_model_key_ + ".pdiparams";
     } else {
       optimized_model = optimized_model_path + "/" + "_optimized.pdmodel";
+      optimized_params = optimized_model_path + "/" + "_optimized.pdiparams";
     }
-    std::string optimized_params =
-        optimized_model_path + "/" + "_optimized.pdiparams";
     if (FileExists(optimized_model) && FileExists(optimized_params)) {
+      optimized_model_cache_ = "hit";
       config_.SetModel(optimized_model, optimized_params);
       if (config_.new_ir_enabled()) {
         load_pir_model_ = true;
@@ -483,6 +541,7 @@ bool AnalysisPredictor::Init(
           << "The optimized model is not found, fallback to original model. "
              "EnableSaveOptimModel will be turned on and the optimized model "
              "can be available next time.";
+      optimized_model_cache_ = "miss";
       config_.EnableSaveOptimModel(true);
       config_.UseOptimizedModel(false);
     }
@@ -512,9 +571,12 @@ bool AnalysisPredictor::Init(
   PrepareFeedFetch();
 
   // Prepare executor, create local variables.
+  inference::Timer timer;
+  timer.tic();
   if (!PrepareExecutor()) {
     return true;
   }
+  startup_phases_.emplace_back("prepare executor", timer.toc());
 
 #if defined(PADDLE_WITH_CUDA) || defined(PADDLE_WITH_HIP)
   // TODO(inference): Now only gpu with external stream support private
@@ -555,9 +617,30 @@ bool AnalysisPredictor::Init(
   TryShrinkMemory();
 
   inference::DisplayMemoryInfo(place_, "Init predictor");
+  if (!config_.glog_info_disabled()) {
+    std::stringstream ss;
+    double total_ms = 0;
+    for (auto &phase : startup_phases_) {
+      ss << "\n  " << phase.first << ": " << phase.second << " ms";
+      total_ms += phase.second;
+    }
+    LOG(INFO) << "======= predictor startup: " << total_ms
+              << " ms =======" << ss.str();
+  }
   return true;
 }
 
+void AnalysisPredictor::ReportFirstRun() {
+  if (first_run_reported_) {
+    return;
+  }
+  first_run_reported_ = true;
+  if (!config_.glog_info_disabled()) {
+    LOG(INFO) << "time to first inference: " << init_timer_.toc()
+              << " ms, optimized model cache: " << optimized_model_cache_;
+  }
+}
+
 void AnalysisPredictor::InitPlace() {
   if (config_.use_gpu()) {
     PADDLE_ENFORCE_EQ(config_.use_xpu(),
@@ -625,6 +708,87 @@ std::string AnalysisPredictor::GetOptimizedModelPath() {
   return model_opt_cache_dir;
 }
 
+std::string AnalysisPredictor::GetModelFilesHash() {
+  // The content hash is kept in a sidecar file of the cache directory with
+  // the path, size and mtime of the model files, and reused while they are
+  // unchanged, so that a warm start does not read the params twice.
+  std::string fingerprint = FileFingerprint(config_.prog_file()) + "|" +
+                            FileFingerprint(config_.params_file());
+  std::string sidecar =
+      GetOptimizedModelPath() + "/_model_files_" +
+      std::to_string(std::hash<std::string>()(config_.prog_file() + "|" +
+                                              config_.params_file())) +
+      ".hash";
+  {
+    std::ifstream fin(sidecar);
+    std::string cached_fingerprint, cached_hash;
+    if (std::getline(fin, cached_fingerprint) &&
+        std::getline(fin, cached_hash) && cached_fingerprint == fingerprint) {
+      VLOG(3) << "Reuse the model files hash in " << sidecar;
+      return cached_hash;
+    }
+  }
+  // The params are hashed by content, since retrained params usually keep
+  // their shapes and so the size of the file.
+  std::ostringstream os;
+  HashFileContent(config_.prog_file(), &os);
+  os << "|";
+  if (!config_.params_file().empty()) {
+    HashFileContent(config_.params_file(), &os);
+  }
+  std::string hash = std::to_string(std::hash<std::string>()(os.str()));
+  std::ofstream fout(sidecar, std::ios::out | std::ios::trunc);
+  fout << fingerprint << "\n" << hash << "\n";
+  if (!fout) {
+    VLOG(3) << "Can not write the model files hash to " << sidecar;
+  }
+  return hash;
+}
+
+std::string AnalysisPredictor::GetOptimizedPirModelKey() {
+  // A config pointing at an optimized model, e.g. after a cache hit, keeps
+  // the key of the model it was optimized from.
+  const std::string prefix = kOptimizedModelPrefix;
+  const std::string suffix = ".json";
+  std::string prog_name = config_.prog_file().substr(
+      config_.prog_file().find_last_of("/\\") + 1);
+  if (prog_name.size() > prefix.size() + suffix.size() &&
+      prog_name.compare(0, prefix.size(), prefix) == 0 &&
+      prog_name.compare(prog_name.size() - suffix.size(),
+                        suffix.size(),
+                        suffix) == 0) {
+    return prog_name.substr(
+        prefix.size(), prog_name.size() - prefix.size() - suffix.size());
+  }
+  // The optimized program depends on the model, the place and the passes
+  // applied to it, so all of them are hashed into the key.
+  std::ostringstream os;
+  os << config_.model_dir() << "|";
+  if (config_.model_from_memory()) {
+    os << config_.prog_file() << "|"
+       << std::hash<std::string_view>()(config_.params_file())
+       << ",size:" << config_.params_file().size();
+  } else {
+    os << GetModelFilesHash();
+  }
+  os << "|place:" << config_.use_gpu() << config_.gpu_device_id()
+     << config_.use_xpu() << config_.xpu_device_id()
+     << config_.mkldnn_enabled() << config_.use_custom_device()
+     << config_.custom_device_type() << config_.custom_device_id();
+  os << "|passes:" << config_.pm_opt_level_ << config_.custom_pass_only_
+     << config_.ir_optim() << config_.use_cutlass_ << config_.cinn_enabled();
+  for (const auto &pass : config_.custom_passes_) {
+    os << "+" << pass;
+  }
+  for (const auto &pass : config_.deleted_passes_) {
+    os << "-" << pass;
+  }
+  os << "|precision:" << config_.enable_gpu_mixed_
+     << static_cast<int>(config_.mixed_precision_mode_)
+     << config_.enable_low_precision_io_;
+  return std::to_string(std::hash<std::string>()(os.str()));
+}
+
 void AnalysisPredictor::ClearExtraParams() {
   auto var_names = scope_->LocalVarNames();
   std::vector<std::string> trt_repetitive_params;
@@ -933,26 +1097,25 @@ void AnalysisPredictor::OptimizeInferencePirProgram() {
               ir_printing_conditions, ir_printing_conditions));
     }
 
+    inference::Timer timer;
+    timer.tic();
     pass_pm.Run(pir_program_.get());
-
-    if (config_.save_optimized_model_) {
-      std::string optimized_model =
-          GetOptimizedModelPath() + "/" + "_optimized.json";
-      pir::WriteModule(*pir_program_, optimized_model, 1, true, false, true);
-      LOG(INFO) << "Optimized model saved to " << optimized_model;
-      SaveOrLoadPirParameters(true);
-    }
+    startup_phases_.emplace_back("inference passes", timer.toc());
   }
 
-  // Apply some basic passes required by the framework
+  // Apply some basic passes required by the framework. The optimized model
+  // is saved after them, so that the folded constants are saved as well and
+  // only params_sync_among_devices_pass is applied when it is loaded.
+  const bool basic_passes_applied = config_.use_optimized_model_;
   ::pir::PassManager basic_pass_pm(::pir::IrContext::Instance(),
                                    config_.pm_opt_level_);
   auto common_subexpression_elimination_pass =
       ::pir::CreateCommonSubexpressionEliminationPass();
-  if (std::find(config_.deleted_passes_.begin(),
+  if (!basic_passes_applied &&
+      std::find(config_.deleted_passes_.begin(),
                 config_.deleted_passes_.end(),
                 common_subexpression_elimination_pass->name()) ==
-      config_.deleted_passes_.end()) {
+          config_.deleted_passes_.end()) {
     basic_pass_pm.AddPass(std::move(common_subexpression_elimination_pass));
   }
   auto params_sync_among_devices_pass =
@@ -967,24 +1130,25 @@ void AnalysisPredictor::OptimizeInferencePirProgram() {
     basic_pass_pm.AddPass(std::move(params_sync_among_devices_pass));
   }
   auto constant_folding_pass = ::pir::CreateConstantFoldingPass();
-  if (std::find(config_.deleted_passes_.begin(),
+  if (!basic_passes_applied &&
+      std::find(config_.deleted_passes_.begin(),
                 config_.deleted_passes_.end(),
                 constant_folding_pass->name()) ==
-      config_.deleted_passes_.end()) {
+          config_.deleted_passes_.end()) {
     constant_folding_pass->SetNotOwned(pir::Pass::kPlaceAttr, &place_);
     constant_folding_pass->SetNotOwned(pir::Pass::kParamScopeAttr, sub_scope_);
     basic_pass_pm.AddPass(std::move(constant_folding_pass));
   }
   auto dead_code_elimination_pass = ::pir::CreateDeadCodeEliminationPass();
-  if (std::find(config_.deleted_passes_.begin(),
+  if (!basic_passes_applied &&
+      std::find(config_.deleted_passes_.begin(),
                 config_.deleted_passes_.end(),
                 dead_code_elimination_pass->name()) ==
-      config_.deleted_passes_.end()) {
+          config_.deleted_passes_.end()) {
     dead_code_elimination_pass->SetNotOwned(pir::Pass::kParamScopeAttr,
                                             sub_scope_);
     basic_pass_pm.AddPass(std::move(dead_code_elimination_pass));
   }
-  basic_pass_pm.AddPass(::pir::CreateReplaceFetchWithShadowOutputPass());
   if (!config_.glog_info_disabled()) {
     basic_pass_pm.EnablePrintStatistics();
   }
@@ -993,11 +1157,35 @@ void AnalysisPredictor::OptimizeInferencePirProgram() {
         std::make_unique<pir::PassManager::IRPrinterOption>(
             ir_printing_conditions, ir_printing_conditions));
   }
+  inference::Timer timer;
+  timer.tic();
   basic_pass_pm.Run(pir_program_.get());
+  startup_phases_.emplace_back("basic passes", timer.toc());
+
+  if (config_.save_optimized_model_ && !config_.use_optimized_model_) {
+    timer.tic();
+    std::string optimized_model = GetOptimizedModelPath() + "/" +
+                                  kOptimizedModelPrefix + optimized_model_key_ +
+                                  ".json";
+    pir::WriteModule(*pir_program_, optimized_model, 1, true, false, true);
+    LOG(INFO) << "Optimized model saved to " << optimized_model;
+    SaveOrLoadPirParameters(true);
+    startup_phases_.emplace_back("save optimized model", timer.toc());
+  }
+
+  ::pir::PassManager fetch_pm(::pir::IrContext::Instance(),
+                              config_.pm_opt_level_);
+  fetch_pm.AddPass(::pir::CreateReplaceFetchWithShadowOutputPass());
+  fetch_pm.Run(pir_program_.get());
   //----------------------------------------------------------------------------------------------//
 
+  // Runs on one thread: the kernel of an op is chosen from the lowered types
+  // of its inputs, and building ops appends to the use lists of values
+  // shared by the whole program.
+  timer.tic();
   pir_program_ =
       paddle::dialect::PdOpLowerToKernelPass(pir_program_.get(), place_);
+  startup_phases_.emplace_back("kernel lowering", timer.toc());
 
   ::pir::PassManager lowered_pm(::pir::IrContext::Instance(), 3);
   auto remove_shadow_feed_pass = ::pir::CreateRemoveShadowFeedPass();
@@ -1014,13 +1202,17 @@ void AnalysisPredictor::OptimizeInferencePirProgram() {
         std::make_unique<pir::PassManager::IRPrinterOption>(
             ir_printing_conditions, ir_printing_conditions));
   }
+  timer.tic();
   lowered_pm.Run(pir_program_.get());
+  startup_phases_.emplace_back("lowered passes", timer.toc());
 
   LOG(INFO) << "======= pir optimization completed =======";
 }
 
-bool AnalysisPredictor::SaveOrLoadPirParameters(bool for_save) {
+bool AnalysisPredictor::SaveOrLoadPirParameters(
+    bool for_save, std::vector<phi::DenseTensor> *loaded_params) {
   std::vector<std::pair<std::string, pir::Value>> param_name_var_pairs;
+  std::unordered_set<std::string> constant_names;
   int feed_idx = 0;
   pir_feeds_.clear();
   for (auto op : pir_program_->block()->ops()) {
@@ -1052,6 +1244,14 @@ bool AnalysisPredictor::SaveOrLoadPirParameters(bool for_save) {
           op->attribute<pir::StrAttribute>("parameter_name").AsString();
       auto var = op->result(0);
       param_name_var_pairs.emplace_back(var_name, var);
+    } else if (op->isa<::pir::ConstantTensorOp>() &&
+               (for_save || config_.use_optimized_model_)) {
+      // The constants folded by constant_folding_pass are saved with the
+      // optimized model.
+      std::string var_name =
+          op->dyn_cast<::pir::ConstantTensorOp>().tensor_name();
+      constant_names.insert(var_name);
+      param_name_var_pairs.emplace_back(var_name, op->result(0));
     }
   }
 
@@ -1070,12 +1270,24 @@ bool AnalysisPredictor::SaveOrLoadPirParameters(bool for_save) {
   }
 
   size_t len = vars.size();
+  if (loaded_params != nullptr) {
+    PADDLE_ENFORCE_EQ(loaded_params->size(),
+                      len,
+                      common::errors::InvalidArgument(
+                          "The params file %s has %d tensors, but the program "
+                          "has %d parameters.",
+                          config_.params_file(),
+                          loaded_params->size(),
+                          len));
+  }
   std::vector<phi::DenseTensor *> tensor_out;
   for (size_t i = 0; i < len; ++i) {
     auto *var = sub_scope_->FindVar(param_names[i]);
     pir::Value value = vars[i];
 
-    if (var == nullptr) {
+    if (var == nullptr && loaded_params != nullptr) {
+      var = sub_scope_->Var(param_names[i]);
+    } else if (var == nullptr) {
       if (value && value.type().isa<pir::DenseTensorType>()) {
         var = sub_scope_->Var(param_names[i]);
         auto *tensor_temp = var->GetMutable<phi::DenseTensor>();
@@ -1103,10 +1315,28 @@ bool AnalysisPredictor::SaveOrLoadPirParameters(bool for_save) {
     pir::SaveCombineFunction(
         const_tensor_out, param_names, optimized_params, true, false, true);
     LOG(INFO) << "Optimized params saved to " << optimized_params;
+  } else if (loaded_params != nullptr) {
+    for (size_t i = 0; i < len; ++i) {
+      *tensor_out[i] = std::move(loaded_params->at(i));
+    }
+    loaded_params->clear();
   } else {
     pir::LoadCombineFunction(
         config_.params_file(), param_names, &tensor_out, false, place_);
   }
+
+  // The operands of ConstantTensorOp are kept on cpu.
+  if (!for_save && !constant_names.empty() && !phi::is_cpu_place(place_)) {
+    for (size_t i = 0; i < len; ++i) {
+      if (constant_names.count(param_names[i]) == 0 ||
+          phi::is_cpu_place(tensor_out[i]->place())) {
+        continue;
+      }
+      phi::DenseTensor cpu_tensor;
+      framework::TensorCopySync(*tensor_out[i], phi::CPUPlace(), &cpu_tensor);
+      *tensor_out[i] = std::move(cpu_tensor);
+    }
+  }
   return true;
 }
 
@@ -1119,9 +1349,43 @@ bool AnalysisPredictor::PreparePirProgram() {
       nullptr,
       common::errors::Fatal("Here, pir_program must be a nullptr!"));
 
+  // The params file is read on the io thread pool while the program is read,
+  // and its tensors are given to the parameters in the order of their names
+  // afterwards. The task owns what it writes, in case ReadModule throws.
+  auto loaded_params = std::make_shared<std::vector<phi::DenseTensor>>();
+  auto load_params_ms = std::make_shared<double>(0);
+  std::future<void> load_params;
+  if (!config_.params_file().empty()) {
+    load_params = phi::AsyncIO([params_file = config_.params_file(),
+                                place = place_,
+                                loaded_params,
+                                load_params_ms] {
+      inference::Timer timer;
+      timer.tic();
+      pir::LoadCombineFunction(params_file, loaded_params.get(), false, place);
+      *load_params_ms = timer.toc();
+    });
+  }
+
+  inference::Timer timer;
+  timer.tic();
   pir_program_ = std::make_shared<pir::Program>(pir::IrContext::Instance());
   pir::ReadModule(config_.prog_file(), pir_program_.get(), 1 /*pir_version*/);
-  if (!SaveOrLoadPirParameters(false)) {
+  startup_phases_.emplace_back("read program", timer.toc());
+
+  timer.tic();
+  bool loaded = false;
+  if (load_params.valid()) {
+    load_params.get();
+    startup_phases_.emplace_back("wait for params", timer.toc());
+    loaded = SaveOrLoadPirParameters(false, loaded_params.get());
+    // not counted in the total, as it overlaps with reading the program
+    VLOG(3) << "Params are read in " << *load_params_ms << " ms";
+  } else {
+    loaded = SaveOrLoadPirParameters(false);
+    startup_phases_.emplace_back("load params", timer.toc());
+  }
+  if (!loaded) {
     return false;
   }
   OptimizeInferencePirProgram();
@@ -1130,8 +1394,11 @@ bool AnalysisPredictor::PreparePirProgram() {
 
 bool AnalysisPredictor::PrepareProgram(
     const std::shared_ptr<framework::ProgramDesc> &program) {
+  inference::Timer timer;
   if (!program) {
+    timer.tic();
     if (!LoadProgramDesc()) return false;
+    startup_phases_.emplace_back("read program", timer.toc());
     // If not cloned, the parameters should be loaded.
     // If config_.ir_optim() is True, parameters is loaded in
     // OptimizeInferenceProgram(), but other persistable variables
@@ -1154,6 +1421,7 @@ bool AnalysisPredictor::PrepareProgram(
               << inference::tensorrt::TensorRTEngine::predictor_id_per_thread;
     }
 #endif
+    timer.tic();
     if (config_.use_optimized_model_) {
       LoadParameters();
       ClearExtraParams();
@@ -1162,8 +1430,10 @@ bool AnalysisPredictor::PrepareProgram(
         paddle::platform::EmptyCache();
       }
 #endif
+      startup_phases_.emplace_back("load params", timer.toc());
     } else {
       OptimizeInferenceProgram();
+      startup_phases_.emplace_back("analysis and load params", timer.toc());
     }
   } else {
     // If the program is passed from external, no need to optimize it, this
@@ -1183,7 +1453,11 @@ bool AnalysisPredictor::PrepareProgram(
         pir_program_,
         nullptr,
         common::errors::Fatal("Here, pir_program must be a nullptr!"));
+    // Runs on one thread, like the kernel lowering: sub-blocks are
+    // translated against the values and parameter map of their parent block.
+    timer.tic();
     pir_program_ = paddle::TranslateLegacyProgramToProgram(*inference_program_);
+    startup_phases_.emplace_back("translate program", timer.toc());
     OptimizeInferencePirProgram();
   }
   return true;
@@ -1718,6 +1992,7 @@ bool AnalysisPredictor::Run(const std::vector<PaddleTensor> &inputs,
   // https://software.intel.com/en-us/mkl-developer-reference-c-mkl-free-buffers
   phi::dynload::MKL_Free_Buffers();
 #endif
+  ReportFirstRun();
   return true;
 }
 
@@ -1844,6 +2119,7 @@ bool AnalysisPredictor::Run(const std::vector<paddle::Tensor> &inputs,
   // https://software.intel.com/en-us/mkl-developer-reference-c-mkl-free-buffers
   phi::dynload::MKL_Free_Buffers();
 #endif
+  ReportFirstRun();
   return true;
 }
 
@@ -2816,6 +3092,7 @@ bool AnalysisPredictor::ZeroCopyRun(bool switch_stream) {
   // https://software.intel.com/en-us/mkl-developer-reference-c-mkl-free-buffers
   phi::dynload::MKL_Free_Buffers();
 #endif
+  ReportFirstRun();
   return true;
 }
 
@@ -3160,6 +3437,23 @@ uint64_t AnalysisPredictor::TryShrinkMemory() {
   return paddle::memory::Release(place_);
 }
 
+void AnalysisPredictor::EnableOpMetrics(bool enable) {
+  FLAGS_enable_op_metrics = enable;
+}
+
+std::vector<framework::OpMetricsStats> AnalysisPredictor::GetOpMetrics()
+    const {
+  return framework::OpMetrics::Instance().Snapshot();
+}
+
+std::string AnalysisPredictor::DumpOpMetricsPrometheus() const {
+  return framework::OpMetrics::Instance().DumpPrometheus();
+}
+
+void AnalysisPredictor::ResetOpMetrics() {
+  framework::OpMetrics::Instance().Reset();
+}
+
 void AnalysisPredictor::ClearIntermediateTensor() {
   PADDLE_ENFORCE_NOT_NULL(inference_program_.get(),
                           common::errors::PreconditionNotMet(
@@ -3297,6 +3591,7 @@ std::unique_ptr<PaddlePredictor> AnalysisPredictor::Clone(void *stream) {
   x->status_is_cloned_ = true;
   x->root_predictor_id_ = this->root_predictor_id_;
   x->config_.apply_optim_ = false;
+  x->optimized_model_key_ = optimized_model_key_;
   if (config_.use_external_stream_ && stream == nullptr) {
     PADDLE_THROW(common::errors::InvalidArgument(
         "config has been configured to use external stream, but the Clone "
@@ -18,9 +18,11 @@
 #include <map>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "paddle/fluid/framework/naive_executor.h"
+#include "paddle/fluid/framework/new_executor/op_metrics.h"
 #include "paddle/fluid/framework/op_compatible_info.h"
 #include "paddle/fluid/inference/analysis/analyzer.h"
 #include "paddle/fluid/inference/api/api_impl.h"
@@ -277,6 +279,29 @@ class AnalysisPredictor : public PaddlePredictor {
   ///
   uint64_t TryShrinkMemory() override;
 
+  ///
+  /// \brief Turn on or off the per-operator metrics of the executor, it
+  /// sets FLAGS_enable_op_metrics, so it affects all predictors of the
+  /// process.
+  ///
+  void EnableOpMetrics(bool enable = true);
+  ///
+  /// \brief Get the per-operator latency histograms, allocated bytes and
+  /// CPU fallback counts recorded since the last ResetOpMetrics. The
+  /// metrics are process-wide and shared by all predictors.
+  ///
+  /// \return the metrics sorted by operator type
+  ///
+  std::vector<framework::OpMetricsStats> GetOpMetrics() const;
+  ///
+  /// \brief Same as GetOpMetrics, in the Prometheus text format.
+  ///
+  std::string DumpOpMetricsPrometheus() const;
+  ///
+  /// \brief Restart the per-operator metrics from zero.
+  ///
+  void ResetOpMetrics();
+
   ///
   /// \brief Get the argument used by predictor
   ///
@@ -395,9 +420,15 @@ class AnalysisPredictor : public PaddlePredictor {
   ///
   /// \brief Save or Load pir model parameters.
   ///
+  /// \param[in] for_save Save the parameters if true, load them otherwise.
+  /// \param[in] loaded_params The parameters read from the params file in
+  /// advance. If not null, they are moved into the scope in the order of
+  /// their names instead of reading the params file.
+  ///
   /// \return Whether the function executed successfully
   ///
-  bool SaveOrLoadPirParameters(bool for_save);
+  bool SaveOrLoadPirParameters(
+      bool for_save, std::vector<phi::DenseTensor> *loaded_params = nullptr);
 
   ///
   /// \brief Prepare input data, only used in Run()
@@ -518,6 +549,11 @@ class AnalysisPredictor : public PaddlePredictor {
   void InitDeviceContexts();
   void InitResourceManager(void *stream);
   std::string GetOptimizedModelPath();
+  std::string GetOptimizedPirModelKey();
+  // The content hash of the program and params files.
+  std::string GetModelFilesHash();
+  // Logs the time from the beginning of Init to the end of the first run.
+  void ReportFirstRun();
   void ClearExtraParams();
 
 #if defined(PADDLE_WITH_DISTRIBUTE) && defined(PADDLE_WITH_PSCORE)
@@ -580,6 +616,17 @@ class AnalysisPredictor : public PaddlePredictor {
   std::shared_ptr<framework::ProgramDesc> inference_program_;
   std::shared_ptr<pir::Program> pir_program_;
   bool load_pir_model_{false};
+  // The time in ms of every phase of Init, which are reported at its end.
+  std::vector<std::pair<std::string, double>> startup_phases_;
+  // The suffix of the optimized pir model in the cache directory, which
+  // changes with the model and the config the program is optimized for.
+  std::string optimized_model_key_;
+  // hit, miss or off, reported with the time to first inference.
+  std::string optimized_model_cache_{"off"};
+  // Started when Init begins, so that the first run reports the time to
+  // first inference, i.e. the startup and the first run.
+  inference::Timer init_timer_;
+  bool first_run_reported_{false};
   std::vector<framework::OpDesc *> feeds_;
   std::vector<pir::Operation *> pir_feeds_;
   std::map<std::string, size_t> feed_names_;
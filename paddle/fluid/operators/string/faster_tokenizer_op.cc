@@ -18,6 +18,7 @@ limitations under the License. */
 #include <codecvt>
 #include <fstream>
 #include <iostream>
+#include <mutex>
 #include <numeric>
 #include <string>
 #include <unordered_map>
@@ -38,16 +39,14 @@ using std::unordered_set;
 using std::vector;
 using std::wstring;
 
-const wstring kStripChars = L" \t\n\r\v\f";
-
-inline bool IsControl(const wchar_t& ch) {
+inline bool IsControl(const int32_t& ch) {
   if (ch == L'\t' || ch == L'\n' || ch == L'\r') return false;
   auto cat = utf8proc_category(ch);
   if (cat == UTF8PROC_CATEGORY_CC || cat == UTF8PROC_CATEGORY_CF) return true;
   return false;
 }
 
-inline bool IsChineseChar(const wchar_t& ch) {
+inline bool IsChineseChar(const int32_t& ch) {
   if ((ch >= 0x4E00 && ch <= 0x9FFF) || (ch >= 0x3400 && ch <= 0x4DBF) ||
       (ch >= 0x20000 && ch <= 0x2A6DF) || (ch >= 0x2A700 && ch <= 0x2B73F) ||
       (ch >= 0x2B740 && ch <= 0x2B81F) || (ch >= 0x2B820 && ch <= 0x2CEAF) ||
@@ -56,14 +55,14 @@ inline bool IsChineseChar(const wchar_t& ch) {
   return false;
 }
 
-inline bool IsWhiteSpace(const wchar_t& ch) {
+inline bool IsWhiteSpace(const int32_t& ch) {
   if (ch == L' ' || ch == L'\t' || ch == L'\n' || ch == L'\r') return true;
   auto cat = utf8proc_category(ch);
   if (cat == UTF8PROC_CATEGORY_ZS) return true;
   return false;
 }
 
-inline bool IsPunctuation(const wchar_t& ch) {
+inline bool IsPunctuation(const int32_t& ch) {
   if ((ch >= 33 && ch <= 47) || (ch >= 58 && ch <= 64) ||
       (ch >= 91 && ch <= 96) || (ch >= 123 && ch <= 126))
     return true;
@@ -76,29 +75,201 @@ inline bool IsPunctuation(const wchar_t& ch) {
   return false;
 }
 
+// Decodes the code point at text[0, len) into *ch and returns its length in
+// bytes, or a non-positive value if the text is not valid UTF-8.
+inline int DecodeUTF8(const char* text, size_t len, int32_t* ch) {
+  auto byte = static_cast<unsigned char>(text[0]);
+  if (byte < 0x80) {
+    *ch = byte;
+    return 1;
+  }
+  return static_cast<int>(
+      utf8proc_iterate(reinterpret_cast<const utf8proc_uint8_t*>(text),
+                       static_cast<utf8proc_ssize_t>(len),
+                       ch));
+}
+
+inline void AppendUTF8(int32_t ch, string* out) {
+  if (ch < 0x80) {
+    out->push_back(static_cast<char>(ch));
+    return;
+  }
+  utf8proc_uint8_t buf[4];
+  auto len = utf8proc_encode_char(ch, buf);
+  out->append(reinterpret_cast<const char*>(buf), len);
+}
+
+WordPieceTrie::WordPieceTrie(const framework::Vocab& vocab) {
+  vector<std::pair<string, int32_t>> keys;
+  keys.reserve(vocab.size());
+  for (const auto& item : vocab) {
+    string key;
+    for (auto ch : item.first) {
+      AppendUTF8(static_cast<int32_t>(ch), &key);
+    }
+    if (!key.empty()) {
+      keys.emplace_back(std::move(key), item.second);
+    }
+  }
+  std::sort(keys.begin(), keys.end());
+
+  base_.assign(256, 0);
+  check_.assign(256, -1);
+  value_.assign(256, -1);
+  check_[0] = -2;  // the root is never a child
+  Build(Root(), 0, 0, keys.size(), keys);
+
+  int32_t node = Root();
+  for (char c : string("##")) {
+    if (node < 0) break;
+    node = Next(node, static_cast<uint8_t>(c));
+  }
+  suffix_root_ = node;
+}
+
+void WordPieceTrie::Build(int32_t node,
+                          size_t depth,
+                          size_t begin,
+                          size_t end,
+                          const vector<std::pair<string, int32_t>>& keys) {
+  if (begin < end && keys[begin].first.size() == depth) {
+    value_[node] = keys[begin].second;
+    ++begin;
+  }
+  if (begin == end) return;
+
+  // keys[begin, end) are sorted, so the children come in label order
+  vector<uint8_t> labels;
+  vector<size_t> bounds;
+  for (size_t i = begin; i < end; ++i) {
+    auto label = static_cast<uint8_t>(keys[i].first[depth]);
+    if (labels.empty() || labels.back() != label) {
+      labels.push_back(label);
+      bounds.push_back(i);
+    }
+  }
+  bounds.push_back(end);
+
+  int32_t base = FindBase(labels);
+  base_[node] = base;
+  for (auto label : labels) {
+    check_[base + label] = node;
+  }
+  for (size_t i = 0; i < labels.size(); ++i) {
+    Build(base + labels[i], depth + 1, bounds[i], bounds[i + 1], keys);
+  }
+}
+
+int32_t WordPieceTrie::FindBase(const vector<uint8_t>& labels) {
+  while (first_free_ < check_.size() && check_[first_free_] != -1) {
+    ++first_free_;
+  }
+  size_t base = first_free_ > labels[0] ? first_free_ - labels[0] : 1;
+  for (;; ++base) {
+    if (base + 256 > check_.size()) {
+      size_t new_size = std::max(check_.size() * 2, base + 256);
+      base_.resize(new_size, 0);
+      check_.resize(new_size, -1);
+      value_.resize(new_size, -1);
+    }
+    bool fit = true;
+    for (auto label : labels) {
+      if (check_[base + label] != -1) {
+        fit = false;
+        break;
+      }
+    }
+    if (fit) return static_cast<int32_t>(base);
+  }
+}
+
+int64_t WordPieceTrie::Find(const char* text, size_t len) const {
+  int32_t node = Root();
+  for (size_t i = 0; i < len && node >= 0; ++i) {
+    node = Next(node, static_cast<uint8_t>(text[i]));
+  }
+  return node < 0 ? -1 : value_[node];
+}
+
+int64_t WordPieceTrie::LongestPrefix(int32_t node,
+                                     const char* text,
+                                     size_t len,
+                                     size_t* match_len) const {
+  int64_t id = -1;
+  for (size_t i = 0; i < len && node >= 0; ++i) {
+    node = Next(node, static_cast<uint8_t>(text[i]));
+    if (node >= 0 && value_[node] >= 0) {
+      id = value_[node];
+      *match_len = i + 1;
+    }
+  }
+  return id;
+}
+
+std::shared_ptr<const WordPieceTrie> WordPieceTrie::Get(
+    const framework::Vocab* vocab) {
+  // The version of a vocab changes with its content and is never reused,
+  // so a trie built for another vocab at the same address is not returned.
+  // Only the most recently used tries are kept, the tokenizers hold theirs.
+  constexpr size_t kMaxCachedTries = 8;
+  struct CachedTrie {
+    uint64_t version;
+    uint64_t last_use;
+    std::shared_ptr<const WordPieceTrie> trie;
+  };
+  static std::mutex mutex;
+  static std::unordered_map<const framework::Vocab*, CachedTrie> tries;
+  static uint64_t use_count = 0;
+
+  std::lock_guard<std::mutex> lock(mutex);
+  auto it = tries.find(vocab);
+  if (it == tries.end() || it->second.version != vocab->version()) {
+    if (it == tries.end() && tries.size() >= kMaxCachedTries) {
+      tries.erase(std::min_element(tries.begin(),
+                                   tries.end(),
+                                   [](const auto& a, const auto& b) {
+                                     return a.second.last_use <
+                                            b.second.last_use;
+                                   }));
+    }
+    auto trie = std::make_shared<const WordPieceTrie>(*vocab);
+    it = tries.insert_or_assign(vocab, CachedTrie{vocab->version(), 0, trie})
+             .first;
+  }
+  it->second.last_use = ++use_count;
+  return it->second.trie;
+}
+
 BasicTokenizer::BasicTokenizer(bool do_lower_case /* = true */)
     : do_lower_case_(do_lower_case) {}
 
-wchar_t BasicTokenizer::do_lower_case(wchar_t ch) const {
-  wchar_t new_ch = utf8proc_tolower(ch);
-  return new_ch;
+int32_t BasicTokenizer::do_lower_case(int32_t ch) const {
+  if (ch < 0x80) {
+    return (ch >= 'A' && ch <= 'Z') ? ch + ('a' - 'A') : ch;
+  }
+  return utf8proc_tolower(ch);
 }
 
-void BasicTokenizer::Tokenize(const string& text, vector<wstring>* res) const {
-  std::wstring unicode_text;
-  bool status = framework::ConvertStrToWstr(text, &unicode_text);
-  if (!status) {
-    // String is converted into wstring failedly.
-    return;
-  }
-  std::wstring cache_text = L"";
+void BasicTokenizer::Tokenize(const string& text, vector<string>* res) const {
+  const size_t origin_size = res->size();
+  string cache_text;
   auto PushCacheText = [&]() {
     if (!cache_text.empty()) {
-      res->emplace_back(cache_text);
-      cache_text = L"";
+      res->emplace_back(std::move(cache_text));
+      cache_text.clear();
     }
   };
-  for (auto& ch : unicode_text) {
+  const char* data = text.data();
+  const size_t len = text.size();
+  for (size_t pos = 0; pos < len;) {
+    int32_t ch = 0;
+    int ch_len = DecodeUTF8(data + pos, len - pos, &ch);
+    if (ch_len <= 0) {
+      // The text is not valid UTF-8.
+      res->resize(origin_size);
+      return;
+    }
+    pos += ch_len;
     if (ch == 0 || ch == 0xfffd || IsControl(ch)) {
       continue;
     }
@@ -107,11 +278,12 @@ void BasicTokenizer::Tokenize(const string& text, vector<wstring>* res) const {
     }
     if (IsChineseChar(ch) || IsPunctuation(ch)) {
       PushCacheText();
-      res->emplace_back(std::wstring{ch});
+      res->emplace_back();
+      AppendUTF8(ch, &res->back());
     } else if (IsWhiteSpace(ch)) {
       PushCacheText();
     } else {
-      cache_text += ch;
+      AppendUTF8(ch, &cache_text);
     }
   }
   PushCacheText();
@@ -122,55 +294,38 @@ WordPieceTokenizer::WordPieceTokenizer(
     const wstring& unk_token /* = L"[UNK]"*/,
     const size_t max_input_chars_per_word /* = 100 */)
     : vocab_(vocab),
+      trie_(WordPieceTrie::Get(vocab)),
       unk_token_(unk_token),
       max_input_chars_per_word_(max_input_chars_per_word) {
   unk_token_id_ = vocab_->at(unk_token_);
 }
 
-void WordPieceTokenizer::Tokenize(const wstring& text,
+void WordPieceTokenizer::Tokenize(const string& text,
                                   vector<int64_t>* token_ids) const {
   size_t len = text.size();
-  if (len > max_input_chars_per_word_) {
-    token_ids->emplace_back(unk_token_id_);
-    return;
+  size_t num_chars = 0;
+  for (char c : text) {
+    num_chars += (static_cast<unsigned char>(c) & 0xC0) != 0x80;
   }
-
-  auto it = vocab_->find(text);
-  if (it != vocab_->end()) {
-    token_ids->emplace_back(it->second);
+  if (num_chars > max_input_chars_per_word_) {
+    token_ids->emplace_back(unk_token_id_);
     return;
   }
 
   size_t start = 0;
-  vector<int64_t> wordpiece_ids;
+  size_t origin_size = token_ids->size();
   while (start < len) {
-    size_t end = len;
-    std::wstring cur_substr;
-    int64_t cur_substr_id = 0;
-    while (start < end) {
-      std::wstring sub = text.substr(start, end - start);
-      if (start > 0) {
-        sub.insert(0, L"##");
-      }
-      auto it = vocab_->find(sub);
-      if (it != vocab_->end()) {
-        cur_substr = sub;
-        cur_substr_id = it->second;
-        break;
-      }
-      end -= 1;
-    }
-
-    if (cur_substr.empty()) {
+    size_t match_len = 0;
+    int32_t node = start == 0 ? trie_->Root() : trie_->SuffixRoot();
+    int64_t id = trie_->LongestPrefix(
+        node, text.data() + start, len - start, &match_len);
+    if (id < 0) {
+      token_ids->resize(origin_size);
       token_ids->emplace_back(unk_token_id_);
       return;
-    } else {
-      start = end;
-      wordpiece_ids.emplace_back(cur_substr_id);
     }
-  }
-  for (auto& token_id : wordpiece_ids) {
-    token_ids->emplace_back(token_id);
+    start += match_len;
+    token_ids->emplace_back(id);
   }
 }
 
@@ -190,6 +345,7 @@ BertTokenizer::BertTokenizer(const framework::Vocab* vocab,
       sep_token_(sep_token),
       padding_site_(padding_site),
       vocab_(vocab),
+      trie_(WordPieceTrie::Get(vocab)),
       basic_tokenizer_(do_lower_case_),
       word_piece_tokenizer_(vocab_, unk_token) {
   unk_token_id_ = vocab_->at(unk_token_);
@@ -209,27 +365,18 @@ BertTokenizer::BertTokenizer(const framework::Vocab* vocab,
 
 void BertTokenizer::Tokenize(const string& text,
                              vector<int64_t>* split_token_ids) const {
-  std::vector<std::wstring> tmp_tokens;
+  std::vector<std::string> tmp_tokens;
   basic_tokenizer_.Tokenize(text, &tmp_tokens);
   if (tmp_tokens.empty()) return;
   split_token_ids->reserve(tmp_tokens.size());
-  for (auto& w_token : tmp_tokens) {
-    const auto& vec_size = w_token.size();
-    if (vec_size == 1) {
-      if (IsChineseChar(w_token[0])) {
-        auto vocab_it = vocab_->find(w_token);
-        if (vocab_it != vocab_->end()) {
-          split_token_ids->emplace_back(vocab_it->second);
-        } else {
-          split_token_ids->emplace_back(unk_token_id_);
-        }
-      } else {
-        word_piece_tokenizer_.Tokenize(w_token, split_token_ids);
-      }
-    } else if (vec_size > 1) {
-      word_piece_tokenizer_.Tokenize(w_token, split_token_ids);
-    } else {
-      continue;
+  for (auto& token : tmp_tokens) {
+    int32_t ch = 0;
+    int ch_len = DecodeUTF8(token.data(), token.size(), &ch);
+    if (ch_len == static_cast<int>(token.size()) && IsChineseChar(ch)) {
+      int64_t id = trie_->Find(token.data(), token.size());
+      split_token_ids->emplace_back(id >= 0 ? id : unk_token_id_);
+    } else if (!token.empty()) {
+      word_piece_tokenizer_.Tokenize(token, split_token_ids);
     }
   }
 }
@@ -324,19 +471,15 @@ int BertTokenizer::Encode(
       if (pair_ids.empty()) return 0;
     }
   } else {
-    std::wstring unicode_text;
-    bool status_a = framework::ConvertStrToWstr(text, &unicode_text);
-    if (!status_a) {
-      return 0;
-    }
-    for (size_t i = 0; i < unicode_text.size(); i++) {
-      wstring token = unicode_text.substr(i, 1);
-      auto it = vocab_->find(token);
-      if (it != vocab_->end()) {
-        ids.emplace_back(it->second);
-      } else {
-        ids.emplace_back(unk_token_id_);
+    for (size_t pos = 0; pos < text.size();) {
+      int32_t ch = 0;
+      int ch_len = DecodeUTF8(text.data() + pos, text.size() - pos, &ch);
+      if (ch_len <= 0) {
+        return 0;
       }
+      int64_t id = trie_->Find(text.data() + pos, ch_len);
+      ids.emplace_back(id >= 0 ? id : unk_token_id_);
+      pos += ch_len;
     }
   }
 
@@ -411,8 +554,9 @@ void BertTokenizer::BatchEncode(
   }
 
   size_t batch_size = batch_text.size();
+  // rows differ a lot in length, hand them out dynamically
 #ifdef PADDLE_WITH_MKLML
-#pragma omp parallel for
+#pragma omp parallel for schedule(dynamic)
 #endif
   for (size_t i = 0; i < batch_size; i++) {
     unordered_map<string, vector<int64_t>> res;
@@ -13,6 +13,7 @@ limitations under the License. */
 
 #include <utf8proc.h>
 
+#include <memory>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
@@ -35,20 +36,73 @@ using std::vector;
 using std::wcout;
 using std::wstring;
 
-inline bool IsControl(const wchar_t& ch);
-inline bool IsChineseChar(const wchar_t& ch);
-inline bool IsWhiteSpace(const wchar_t& ch);
+inline bool IsControl(const int32_t& ch);
+inline bool IsChineseChar(const int32_t& ch);
+inline bool IsWhiteSpace(const int32_t& ch);
 
 using Vocab = unordered_map<wstring, int>;
 using InvVocab = unordered_map<int, wstring>;
 
+// Double-array trie over the UTF-8 bytes of the vocab tokens. WordPiece
+// longest-match is a single walk over the word instead of one hash lookup
+// per candidate substring.
+class WordPieceTrie {
+ public:
+  explicit WordPieceTrie(const framework::Vocab& vocab);
+
+  // Returns the token id of text[0, len), or -1 if it is not in the vocab.
+  int64_t Find(const char* text, size_t len) const;
+
+  // Returns the id of the longest non-empty token that continues from `node`
+  // and is a prefix of text[0, len), and stores its length in bytes in
+  // *match_len. Returns -1 if there is none.
+  int64_t LongestPrefix(int32_t node,
+                        const char* text,
+                        size_t len,
+                        size_t* match_len) const;
+
+  int32_t Root() const { return 0; }
+  // The node reached by "##", where WordPiece continuation tokens start, or
+  // -1 if the vocab has none.
+  int32_t SuffixRoot() const { return suffix_root_; }
+
+  // Tries are built once per vocab version and shared by all the kernels
+  // using it.
+  static std::shared_ptr<const WordPieceTrie> Get(
+      const framework::Vocab* vocab);
+
+ private:
+  int32_t Next(int32_t node, uint8_t label) const {
+    int64_t pos = static_cast<int64_t>(base_[node]) + label;
+    if (pos >= static_cast<int64_t>(check_.size()) || check_[pos] != node) {
+      return -1;
+    }
+    return static_cast<int32_t>(pos);
+  }
+
+  void Build(int32_t node,
+             size_t depth,
+             size_t begin,
+             size_t end,
+             const vector<std::pair<string, int32_t>>& keys);
+  int32_t FindBase(const vector<uint8_t>& labels);
+
+  vector<int32_t> base_;
+  vector<int32_t> check_;
+  vector<int32_t> value_;
+  size_t first_free_{1};
+  int32_t suffix_root_{-1};
+};
+
 class BasicTokenizer {
  public:
   explicit BasicTokenizer(bool do_lower_case = true);
-  void Tokenize(const string& text, vector<wstring>* res) const;
+  // Splits the UTF-8 text into UTF-8 tokens, res is left empty if the text
+  // is not valid UTF-8.
+  void Tokenize(const string& text, vector<string>* res) const;
 
  private:
-  wchar_t do_lower_case(wchar_t ch) const;
+  int32_t do_lower_case(int32_t ch) const;
 
   bool do_lower_case_;
 };
@@ -58,10 +112,11 @@ class WordPieceTokenizer {
   explicit WordPieceTokenizer(const framework::Vocab* vocab,
                               const wstring& unk_token = L"[UNK]",
                               const size_t max_input_chars_per_word = 100);
-  void Tokenize(const wstring& text, vector<int64_t>* output) const;
+  void Tokenize(const string& text, vector<int64_t>* output) const;
 
  private:
   const framework::Vocab* vocab_;
+  std::shared_ptr<const WordPieceTrie> trie_;
   wstring unk_token_{L"[UNK]"};
   int64_t unk_token_id_;
   size_t max_input_chars_per_word_;
@@ -113,6 +168,7 @@ class BertTokenizer {
   wstring unk_token_, pad_token_, cls_token_, mask_token_, sep_token_;
   string padding_site_;
   const framework::Vocab* vocab_;
+  std::shared_ptr<const WordPieceTrie> trie_;
   BasicTokenizer basic_tokenizer_;
   WordPieceTokenizer word_piece_tokenizer_;
   int64_t unk_token_id_, cls_token_id_, mask_token_id_, pad_token_id_,
@@ -0,0 +1,46 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#pragma once
+
+#include <string>
+#include "paddle/fluid/pir/serialize_deserialize/include/third_party.h"
+#include "paddle/pir/include/core/dll_decl.h"
+
+namespace pir {
+/**
+ * The binary format of pir programs holds the same json object as the json
+ * format, so that ProgramReader and the version patches work on both. All
+ * strings of the json object, keys included, are interned into a table at
+ * the beginning of the file and referred to by their indices. So the file
+ * stores every distinct string once, and decoding parses no text.
+ *
+ * file         := "PIRB" format_version:u8 string_table value
+ * string_table := count:varint (size:varint char*)*
+ * value        := tag:u8 payload, where the payload of
+ *                 null/false/true is empty,
+ *                 integer is a zigzag varint, unsigned is a varint,
+ *                 float is 8 bytes of little endian double,
+ *                 string is the varint index in the table,
+ *                 array is size:varint value*,
+ *                 object is size:varint (key_index:varint value)*.
+ */
+
+/** IsBinaryModule checks the magic at the beginning of the file content. */
+bool IR_API IsBinaryModule(const std::string& content);
+
+std::string IR_API EncodeBinaryModule(const Json& json);
+
+Json IR_API DecodeBinaryModule(const std::string& content);
+
+}  // namespace pir
@@ -33,6 +33,10 @@ namespace pir {
  * operation has opresult_attrs for training like stop_gradient,persistable;
  * Otherwise, it may only has opinfo attrs.
  *
+ * @param[in] binary       (Optional parameter, default to false) If true, the
+ * file is written in the binary format of binary_format.h, which is smaller
+ * and faster to read. readable is ignored then.
+ *
  * @return void。
  *
  * @note readable and trainable Parameters may affect the content and format of
@@ -43,7 +47,8 @@ void IR_API WriteModule(const pir::Program& program,
                         const uint64_t& pir_version,
                         bool overwrite,
                         bool readable = false,
-                        bool trainable = true);
+                        bool trainable = true,
+                        bool binary = false);
 
 /**
  * @brief Gets a PIR program from the specified file path.
@@ -59,7 +64,8 @@ void IR_API WriteModule(const pir::Program& program,
  * funtune.
  *
  * @note If 'pir_version' is larger than the version of file, will trigger
- * version compatibility modification rule.
+ * version compatibility modification rule. Files in the json format and in
+ * the binary format are both accepted.
  */
 bool IR_API ReadModule(const std::string& file_path,
                        pir::Program* program,
@@ -150,4 +156,22 @@ void IR_API LoadCombineFunction(const std::string& file_path,
                                 std::vector<phi::DenseTensor*>* out,
                                 bool load_as_fp16,
                                 phi::Place place = phi::Place());
+
+/**
+ * @brief Load all the tensors of a combined file in the order they are saved,
+ * without knowing their names in advance.
+ *
+ * @param[in] file_path         The path of the file to be read.
+ * @param[out] out              The tensors loaded.
+ * @param[in] load_as_fp16      If the flag is true, the tensor will be loaded
+ * as fp16 type.
+ * @param[in] place             The place to load the tensors to.
+ *
+ * @return void。
+ *
+ */
+void IR_API LoadCombineFunction(const std::string& file_path,
+                                std::vector<phi::DenseTensor>* out,
+                                bool load_as_fp16,
+                                phi::Place place);
 }  // namespace pir
@@ -0,0 +1,308 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/pir/serialize_deserialize/include/binary_format.h"
+
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+#include "paddle/common/enforce.h"
+
+namespace pir {
+
+namespace {
+
+constexpr char kMagic[] = "PIRB";
+constexpr size_t kMagicSize = 4;
+constexpr uint8_t kFormatVersion = 1;
+// The nesting depth of the arrays and objects is bounded, so that a corrupt
+// file can not overflow the stack of the recursive reader. The programs
+// nest a few levels per block, far below it.
+constexpr int kMaxDepth = 1024;
+
+enum Tag : uint8_t {
+  kNull = 0,
+  kFalse = 1,
+  kTrue = 2,
+  kInteger = 3,
+  kUnsigned = 4,
+  kFloat = 5,
+  kString = 6,
+  kArray = 7,
+  kObject = 8,
+};
+
+class BinaryWriter {
+ public:
+  std::string Encode(const Json& json) {
+    WriteValue(json);
+    std::string out(kMagic, kMagicSize);
+    out.push_back(static_cast<char>(kFormatVersion));
+    WriteVarint(strings_.size(), &out);
+    for (auto* str : strings_) {
+      WriteVarint(str->size(), &out);
+      out.append(*str);
+    }
+    out.append(body_);
+    return out;
+  }
+
+ private:
+  static void WriteVarint(uint64_t value, std::string* out) {
+    while (value >= 0x80) {
+      out->push_back(static_cast<char>((value & 0x7f) | 0x80));
+      value >>= 7;
+    }
+    out->push_back(static_cast<char>(value));
+  }
+
+  void WriteString(const std::string& str) {
+    auto it = string_ids_.find(str);
+    if (it == string_ids_.end()) {
+      it = string_ids_.emplace(str, strings_.size()).first;
+      strings_.push_back(&it->first);
+    }
+    WriteVarint(it->second, &body_);
+  }
+
+  void WriteValue(const Json& json) {
+    switch (json.type()) {
+      case Json::value_t::null:
+        body_.push_back(kNull);
+        break;
+      case Json::value_t::boolean:
+        body_.push_back(json.get<bool>() ? kTrue : kFalse);
+        break;
+      case Json::value_t::number_integer: {
+        int64_t value = json.get<int64_t>();
+        body_.push_back(kInteger);
+        WriteVarint((static_cast<uint64_t>(value) << 1) ^
+                        static_cast<uint64_t>(value >> 63),
+                    &body_);
+        break;
+      }
+      case Json::value_t::number_unsigned:
+        body_.push_back(kUnsigned);
+        WriteVarint(json.get<uint64_t>(), &body_);
+        break;
+      case Json::value_t::number_float: {
+        double value = json.get<double>();
+        uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(double));
+        body_.push_back(kFloat);
+        // little endian, whatever the byte order of the host
+        for (size_t i = 0; i < sizeof(double); ++i) {
+          body_.push_back(static_cast<char>((bits >> (8 * i)) & 0xff));
+        }
+        break;
+      }
+      case Json::value_t::string:
+        body_.push_back(kString);
+        WriteString(json.get_ref<const std::string&>());
+        break;
+      case Json::value_t::array:
+        body_.push_back(kArray);
+        WriteVarint(json.size(), &body_);
+        for (auto& item : json) {
+          WriteValue(item);
+        }
+        break;
+      case Json::value_t::object:
+        body_.push_back(kObject);
+        WriteVarint(json.size(), &body_);
+        for (auto& item : json.items()) {
+          WriteString(item.key());
+          WriteValue(item.value());
+        }
+        break;
+      default:
+        PADDLE_THROW(common::errors::Unimplemented(
+            "The json value of type %s can not be saved in the binary format.",
+            json.type_name()));
+    }
+  }
+
+  std::string body_;
+  std::unordered_map<std::string, uint64_t> string_ids_;
+  std::vector<const std::string*> strings_;
+};
+
+class BinaryReader {
+ public:
+  explicit BinaryReader(const std::string& content)
+      : data_(content.data()), size_(content.size()) {}
+
+  Json Decode() {
+    Check(kMagicSize + 1);
+    PADDLE_ENFORCE_EQ(
+        std::memcmp(data_, kMagic, kMagicSize),
+        0,
+        common::errors::InvalidArgument("Invalid binary pir model file."));
+    pos_ = kMagicSize;
+    uint8_t version = static_cast<uint8_t>(data_[pos_++]);
+    PADDLE_ENFORCE_LE(
+        version,
+        kFormatVersion,
+        common::errors::InvalidArgument(
+            "The binary pir model file is of format version %d, which is "
+            "newer than the supported version %d.",
+            version,
+            kFormatVersion));
+    uint64_t num_strings = ReadVarint();
+    // every string takes at least one byte of size
+    Check(num_strings);
+    strings_.reserve(num_strings);
+    for (uint64_t i = 0; i < num_strings; ++i) {
+      uint64_t size = ReadVarint();
+      Check(size);
+      strings_.emplace_back(data_ + pos_, size);
+      pos_ += size;
+    }
+    Json json = ReadValue(0);
+    PADDLE_ENFORCE_EQ(pos_,
+                      size_,
+                      common::errors::InvalidArgument(
+                          "The binary pir model file has %d trailing bytes.",
+                          size_ - pos_));
+    return json;
+  }
+
+ private:
+  void Check(uint64_t size) const {
+    PADDLE_ENFORCE_LE(
+        size,
+        size_ - pos_,
+        common::errors::InvalidArgument(
+            "The binary pir model file is truncated at byte %d.", pos_));
+  }
+
+  uint64_t ReadVarint() {
+    uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+      Check(1);
+      uint8_t byte = static_cast<uint8_t>(data_[pos_++]);
+      value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+      if (byte < 0x80) {
+        return value;
+      }
+    }
+    PADDLE_THROW(common::errors::InvalidArgument(
+        "Invalid varint at byte %d of the binary pir model file.", pos_));
+  }
+
+  const std::string& ReadString() {
+    uint64_t index = ReadVarint();
+    PADDLE_ENFORCE_LT(index,
+                      strings_.size(),
+                      common::errors::InvalidArgument(
+                          "The string index %d is out of the string table "
+                          "of size %d.",
+                          index,
+                          strings_.size()));
+    return strings_[index];
+  }
+
+  Json ReadValue(int depth) {
+    PADDLE_ENFORCE_LE(
+        depth,
+        kMaxDepth,
+        common::errors::InvalidArgument(
+            "The values of the binary pir model file are nested deeper than "
+            "%d at byte %d.",
+            kMaxDepth,
+            pos_));
+    Check(1);
+    uint8_t tag = static_cast<uint8_t>(data_[pos_++]);
+    switch (tag) {
+      case kNull:
+        return Json(nullptr);
+      case kFalse:
+        return Json(false);
+      case kTrue:
+        return Json(true);
+      case kInteger: {
+        uint64_t value = ReadVarint();
+        return Json(static_cast<int64_t>(value >> 1) ^
+                    -static_cast<int64_t>(value & 1));
+      }
+      case kUnsigned:
+        return Json(ReadVarint());
+      case kFloat: {
+        Check(sizeof(double));
+        uint64_t bits = 0;
+        for (size_t i = 0; i < sizeof(double); ++i) {
+          bits |= static_cast<uint64_t>(static_cast<uint8_t>(data_[pos_ + i]))
+                  << (8 * i);
+        }
+        pos_ += sizeof(double);
+        double value;
+        std::memcpy(&value, &bits, sizeof(double));
+        return Json(value);
+      }
+      case kString:
+        return Json(ReadString());
+      case kArray: {
+        uint64_t size = ReadVarint();
+        // every value takes at least one byte of tag
+        Check(size);
+        Json json = Json::array();
+        auto& array = json.get_ref<Json::array_t&>();
+        array.reserve(size);
+        for (uint64_t i = 0; i < size; ++i) {
+          array.push_back(ReadValue(depth + 1));
+        }
+        return json;
+      }
+      case kObject: {
+        uint64_t size = ReadVarint();
+        Check(size);
+        Json json = Json::object();
+        auto& object = json.get_ref<Json::object_t&>();
+        for (uint64_t i = 0; i < size; ++i) {
+          const std::string& key = ReadString();
+          object.emplace_hint(object.end(), key, ReadValue(depth + 1));
+        }
+        return json;
+      }
+      default:
+        PADDLE_THROW(common::errors::InvalidArgument(
+            "Invalid tag %d at byte %d of the binary pir model file.",
+            tag,
+            pos_ - 1));
+    }
+  }
+
+  const char* data_;
+  size_t size_;
+  size_t pos_ = 0;
+  std::vector<std::string> strings_;
+};
+
+}  // namespace
+
+bool IsBinaryModule(const std::string& content) {
+  return content.size() > kMagicSize &&
+         content.compare(0, kMagicSize, kMagic) == 0;
+}
+
+std::string EncodeBinaryModule(const Json& json) {
+  return BinaryWriter().Encode(json);
+}
+
+Json DecodeBinaryModule(const std::string& content) {
+  return BinaryReader(content).Decode();
+}
+
+}  // namespace pir
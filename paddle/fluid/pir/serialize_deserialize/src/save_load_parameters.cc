@@ -225,4 +225,33 @@ void LoadCombineFunction(const std::string& file_path,
                         "load_combine_op, please use load_op instead."));
 }
 
+void LoadCombineFunction(const std::string& file_path,
+                         std::vector<phi::DenseTensor>* out,
+                         bool load_as_fp16,
+                         phi::Place place) {
+  std::ifstream fin(file_path, std::ios::binary);
+  PADDLE_ENFORCE_EQ(static_cast<bool>(fin),
+                    true,
+                    common::errors::Unavailable(
+                        "Load operator fail to open file %s, please check "
+                        "whether the model file is complete or damaged.",
+                        file_path));
+
+  phi::DeviceContextPool& pool = phi::DeviceContextPool::Instance();
+  const phi::DeviceContext* dev_ctx = pool.Get(place);
+  out->clear();
+  while (fin.peek() != EOF) {
+    out->emplace_back();
+    auto* tensor = &out->back();
+    paddle::framework::DeserializeFromStream(fin, tensor, *dev_ctx);
+
+    auto in_dtype = tensor->dtype();
+    auto out_dtype = load_as_fp16 ? phi::DataType::FLOAT16 : in_dtype;
+    if (in_dtype != out_dtype) {
+      auto cast_in = *tensor;
+      *tensor = CastTensorType(dev_ctx, cast_in, out_dtype);
+    }
+  }
+}
+
 }  // namespace pir
@@ -0,0 +1,209 @@
+/* Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/platform/profiler/dump/host_event_stream_writer.h"
+
+#include <chrono>
+#include <list>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "glog/logging.h"
+#include "paddle/fluid/platform/profiler/chrometracing_logger.h"
+#include "paddle/fluid/platform/profiler/dump/nodetree.pb.h"
+#include "paddle/fluid/platform/profiler/event_node.h"
+#include "paddle/fluid/platform/profiler/profiler.h"
+#include "paddle/phi/api/profiler/host_event_stream.h"
+#include "paddle/phi/api/profiler/host_tracer.h"
+#include "paddle/phi/core/enforce.h"
+#include "paddle/phi/core/os_info.h"
+
+namespace paddle::platform {
+
+HostEventStreamWriter::HostEventStreamWriter(
+    const std::string& filename, const HostEventStreamOptions& options)
+    : filename_(filename), options_(options) {}
+
+HostEventStreamWriter::~HostEventStreamWriter() { Stop(); }
+
+void HostEventStreamWriter::Start() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (running_) {
+    return;
+  }
+  output_file_stream_.open(
+      filename_,
+      std::ofstream::out | std::ofstream::trunc | std::ofstream::binary);
+  PADDLE_ENFORCE_EQ(
+      output_file_stream_.is_open(),
+      true,
+      common::errors::Unavailable(
+          "Can not open file %s to stream host events.", filename_));
+
+  phi::HostTraceLevel::GetInstance().SetLevel(options_.trace_level);
+  phi::HostEventStream::GetInstance().Enable(options_.ring_capacity,
+                                             options_.sample_ratio);
+  running_ = true;
+  flush_thread_ = std::thread([this] { FlushLoop(); });
+}
+
+void HostEventStreamWriter::Stop() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!running_) {
+      return;
+    }
+    running_ = false;
+  }
+  cv_.notify_all();
+  flush_thread_.join();
+
+  phi::HostEventStream::GetInstance().Disable();
+  phi::HostTraceLevel::GetInstance().SetLevel(phi::HostTraceLevel::kDisabled);
+  Flush();
+  output_file_stream_.close();
+  VLOG(1) << "Streamed " << WrittenEvents() << " host events ("
+          << WrittenBytes() << " bytes) to " << filename_ << ", dropped "
+          << DroppedEvents();
+}
+
+void HostEventStreamWriter::FlushLoop() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (running_) {
+    cv_.wait_for(lock,
+                 std::chrono::milliseconds(options_.flush_interval_ms),
+                 [this] { return !running_; });
+    lock.unlock();
+    Flush();
+    lock.lock();
+  }
+}
+
+void HostEventStreamWriter::Flush() {
+  auto& stream = phi::HostEventStream::GetInstance();
+  // drain the events before the names, so that every drained event has its
+  // name in this chunk or an earlier one
+  std::vector<phi::HostEventStream::ThreadEvents> threads;
+  stream.Drain(&threads);
+  std::vector<std::pair<uint32_t, std::string>> names;
+  stream.DrainNewNames(&names);
+  if (threads.empty() && names.empty()) {
+    return;
+  }
+
+  HostEventStreamChunkProto chunk;
+  chunk.set_process_id(phi::GetProcessId());
+  for (auto& name : names) {
+    auto* name_proto = chunk.add_names();
+    name_proto->set_id(name.first);
+    name_proto->set_name(std::move(name.second));
+  }
+  uint64_t num_events = 0, num_dropped = 0;
+  for (const auto& thread : threads) {
+    auto* thread_proto = chunk.add_threads();
+    thread_proto->set_thread_id(thread.thread_id);
+    thread_proto->set_thread_name(thread.thread_name);
+    if (thread.dropped > 0) {
+      thread_proto->set_dropped(thread.dropped);
+    }
+    int64_t prev_start_ns = 0;
+    for (const auto& event : thread.events) {
+      auto* event_proto = thread_proto->add_events();
+      event_proto->set_name_id(event.name_id);
+      event_proto->set_type(static_cast<TracerEventTypeProto>(event.type));
+      int64_t start_ns = static_cast<int64_t>(event.start_ns);
+      event_proto->set_start_delta_ns(start_ns - prev_start_ns);
+      event_proto->set_duration_ns(
+          event.end_ns > event.start_ns ? event.end_ns - event.start_ns : 0);
+      prev_start_ns = start_ns;
+    }
+    num_events += thread.events.size();
+    num_dropped += thread.dropped;
+  }
+
+  std::string bytes;
+  chunk.SerializeToString(&bytes);
+  uint32_t size = static_cast<uint32_t>(bytes.size());
+  char size_bytes[4];
+  for (int i = 0; i < 4; ++i) {
+    size_bytes[i] = static_cast<char>((size >> (8 * i)) & 0xff);
+  }
+  output_file_stream_.write(size_bytes, sizeof(size_bytes));
+  output_file_stream_.write(bytes.data(), static_cast<std::streamsize>(size));
+  output_file_stream_.flush();
+  written_events_ += num_events;
+  dropped_events_ += num_dropped;
+  written_bytes_ += sizeof(size_bytes) + size;
+}
+
+void ConvertHostEventStreamToChromeTracing(const std::string& stream_file,
+                                           const std::string& json_file) {
+  std::ifstream input(stream_file, std::ifstream::in | std::ifstream::binary);
+  PADDLE_ENFORCE_EQ(input.is_open(),
+                    true,
+                    common::errors::Unavailable(
+                        "Can not open host event stream %s.", stream_file));
+
+  std::unordered_map<uint32_t, std::string> names;
+  std::list<HostTraceEvent> host_events;
+  std::vector<uint32_t> name_ids;
+  std::string bytes;
+  char size_bytes[4];
+  while (input.read(size_bytes, sizeof(size_bytes))) {
+    uint32_t size = 0;
+    for (int i = 0; i < 4; ++i) {
+      size |= static_cast<uint32_t>(static_cast<unsigned char>(size_bytes[i]))
+              << (8 * i);
+    }
+    bytes.resize(size);
+    if (!input.read(&bytes[0], size)) {
+      // the writer was killed in the middle of a chunk
+      LOG(WARNING) << "Truncated chunk at the end of " << stream_file;
+      break;
+    }
+    HostEventStreamChunkProto chunk;
+    PADDLE_ENFORCE_EQ(chunk.ParseFromString(bytes),
+                      true,
+                      common::errors::InvalidArgument(
+                          "Host event stream %s is corrupted.", stream_file));
+    for (const auto& name : chunk.names()) {
+      names[name.id()] = name.name();
+    }
+    for (const auto& thread : chunk.threads()) {
+      int64_t start_ns = 0;
+      for (const auto& event : thread.events()) {
+        start_ns += event.start_delta_ns();
+        host_events.emplace_back(std::string(),
+                                 static_cast<TracerEventType>(event.type()),
+                                 static_cast<uint64_t>(start_ns),
+                                 start_ns + event.duration_ns(),
+                                 chunk.process_id(),
+                                 thread.thread_id());
+        name_ids.push_back(event.name_id());
+      }
+    }
+  }
+
+  // resolve the names once every chunk is read
+  auto name_id = name_ids.begin();
+  for (auto& event : host_events) {
+    auto it = names.find(*name_id++);
+    event.name = it != names.end() ? it->second : "unknown";
+  }
+
+  NodeTrees trees(host_events, {}, {}, {}, {});
+  ChromeTracingLogger logger(json_file);
+  logger.LogMetaInfo(Profiler::version, 0);
+  trees.LogMe(&logger);
+}
+
+}  // namespace paddle::platform
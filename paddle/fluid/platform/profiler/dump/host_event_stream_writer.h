@@ -0,0 +1,75 @@
+/* Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "paddle/phi/api/profiler/event_tracing.h"
+
+namespace paddle {
+namespace platform {
+
+struct HostEventStreamOptions {
+  // events buffered per thread between two flushes
+  size_t ring_capacity = 1 << 16;
+  // probability that a top level RecordEvent scope is recorded
+  double sample_ratio = 1.0;
+  uint32_t flush_interval_ms = 100;
+  uint32_t trace_level = phi::kDefaultTraceLevel;
+};
+
+// Streams host events to a file while the job is running, for always-on
+// tracing with bounded memory. RecordEvent scopes go to the per thread
+// rings of phi::HostEventStream, a background thread drains them every
+// flush_interval_ms and appends HostEventStreamChunkProto records (see
+// nodetree.proto) to the file. Use ConvertHostEventStreamToChromeTracing
+// to view the file in chrome://tracing.
+class HostEventStreamWriter {
+ public:
+  HostEventStreamWriter(const std::string& filename,
+                        const HostEventStreamOptions& options);
+  ~HostEventStreamWriter();
+
+  void Start();
+  void Stop();
+
+  uint64_t WrittenEvents() const { return written_events_.load(); }
+  uint64_t DroppedEvents() const { return dropped_events_.load(); }
+  uint64_t WrittenBytes() const { return written_bytes_.load(); }
+
+ private:
+  void FlushLoop();
+  void Flush();
+
+  std::string filename_;
+  HostEventStreamOptions options_;
+  std::ofstream output_file_stream_;
+  std::thread flush_thread_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  bool running_ = false;
+  std::atomic<uint64_t> written_events_{0};
+  std::atomic<uint64_t> dropped_events_{0};
+  std::atomic<uint64_t> written_bytes_{0};
+};
+
+// Converts a file written by HostEventStreamWriter to chrome tracing json.
+void ConvertHostEventStreamToChromeTracing(const std::string& stream_file,
+                                           const std::string& json_file);
+
+}  // namespace platform
+}  // namespace paddle
@@ -0,0 +1,146 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "glog/logging.h"
+#include "gtest/gtest.h"
+#include "paddle/common/flags.h"
+#include "paddle/fluid/platform/profiler/dump/host_event_stream_writer.h"
+#include "paddle/phi/api/profiler/event_tracing.h"
+#include "paddle/phi/api/profiler/host_event_stream.h"
+
+PHI_DECLARE_bool(enable_host_event_recorder_hook);
+
+using paddle::platform::ConvertHostEventStreamToChromeTracing;
+using paddle::platform::HostEventStreamOptions;
+using paddle::platform::HostEventStreamWriter;
+using phi::RecordEvent;
+
+TEST(HostEventStreamTest, MultiThreadAndConvert) {
+  HostEventStreamOptions options;
+  options.flush_interval_ms = 5;
+  HostEventStreamWriter writer("test_host_event_stream.pb", options);
+  writer.Start();
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([] {
+      for (int i = 0; i < 1000; ++i) {
+        RecordEvent outer("stream_outer");
+        RecordEvent inner(std::string("stream_inner"));
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  writer.Stop();
+  EXPECT_EQ(writer.WrittenEvents(), 8000u);
+  EXPECT_EQ(writer.DroppedEvents(), 0u);
+  EXPECT_FALSE(phi::HostEventStream::IsEnabled());
+
+  ConvertHostEventStreamToChromeTracing("test_host_event_stream.pb",
+                                        "test_host_event_stream.json");
+  std::ifstream json("test_host_event_stream.json");
+  ASSERT_TRUE(json.is_open());
+  std::stringstream content;
+  content << json.rdbuf();
+  EXPECT_NE(content.str().find("stream_outer"), std::string::npos);
+  EXPECT_NE(content.str().find("stream_inner"), std::string::npos);
+}
+
+TEST(HostEventStreamTest, ReleaseExitedThreads) {
+  HostEventStreamOptions options;
+  options.flush_interval_ms = 100000;
+  HostEventStreamWriter writer("test_host_event_stream_exited.pb", options);
+  writer.Start();
+  // the stream does not depend on the HostEventRecorder hook
+  EXPECT_FALSE(FLAGS_enable_host_event_recorder_hook);
+  for (int round = 0; round < 8; ++round) {
+    std::thread thread([] {
+      for (int i = 0; i < 10; ++i) {
+        RecordEvent event("stream_short_lived");
+      }
+    });
+    thread.join();
+  }
+  EXPECT_EQ(phi::HostEventStream::GetInstance().NumThreadRings(), 8u);
+  writer.Stop();
+  EXPECT_EQ(writer.WrittenEvents(), 80u);
+  EXPECT_EQ(phi::HostEventStream::GetInstance().NumThreadRings(), 0u);
+  EXPECT_FALSE(FLAGS_enable_host_event_recorder_hook);
+}
+
+TEST(HostEventStreamTest, BoundedRing) {
+  HostEventStreamOptions options;
+  options.ring_capacity = 16;
+  // no periodic flush, everything is left for the final one
+  options.flush_interval_ms = 100000;
+  HostEventStreamWriter writer("test_host_event_stream_bounded.pb", options);
+  writer.Start();
+  for (int i = 0; i < 1000; ++i) {
+    RecordEvent event("stream_bounded");
+  }
+  writer.Stop();
+  EXPECT_EQ(writer.WrittenEvents(), 16u);
+  EXPECT_EQ(writer.DroppedEvents(), 984u);
+}
+
+TEST(HostEventStreamTest, Sampling) {
+  HostEventStreamOptions options;
+  options.sample_ratio = 0.2;
+  HostEventStreamWriter writer("test_host_event_stream_sampled.pb", options);
+  writer.Start();
+  for (int i = 0; i < 10000; ++i) {
+    RecordEvent outer("stream_sampled_outer");
+    RecordEvent inner("stream_sampled_inner");
+  }
+  writer.Stop();
+  // nested scopes follow the decision of the top level scope
+  EXPECT_EQ(writer.WrittenEvents() % 2, 0u);
+  EXPECT_GT(writer.WrittenEvents(), 2000u);
+  EXPECT_LT(writer.WrittenEvents(), 6000u);
+}
+
+TEST(HostEventStreamTest, Overhead) {
+  const int kEvents = 1000000;
+  auto measure = [kEvents] {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kEvents; ++i) {
+      RecordEvent event("stream_overhead");
+    }
+    return std::chrono::duration<double, std::nano>(
+               std::chrono::steady_clock::now() - start)
+               .count() /
+           kEvents;
+  };
+  double disabled_ns = measure();
+
+  HostEventStreamOptions options;
+  options.flush_interval_ms = 1;
+  HostEventStreamWriter writer("test_host_event_stream_overhead.pb", options);
+  writer.Start();
+  double streamed_ns = measure();
+  writer.Stop();
+  LOG(INFO) << "RecordEvent cost: disabled " << disabled_ns << " ns, streamed "
+            << streamed_ns << " ns, dropped " << writer.DroppedEvents()
+            << " of " << kEvents;
+  EXPECT_EQ(writer.WrittenEvents() + writer.DroppedEvents(),
+            static_cast<uint64_t>(kEvents));
+}
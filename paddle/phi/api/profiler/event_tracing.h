@@ -79,8 +79,13 @@ class TEST_API RecordEvent {
                          const EventRole role,
                          const std::string& attr);
 
+  // Whether the scope is recorded when HostEventStream is enabled.
+  bool SampleStreamScope();
+
   bool is_enabled_{false};
   bool is_pushed_{false};
+  // entered a HostEventStream sampling scope
+  bool stream_scope_{false};
   // Event name
   std::string* name_{nullptr};
   const char* shallow_copy_name_{nullptr};
@@ -0,0 +1,284 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/phi/api/profiler/host_event_stream.h"
+
+#include <algorithm>
+
+#include "paddle/phi/core/os_info.h"
+
+namespace phi {
+
+std::atomic<bool> HostEventStream::enabled_{false};
+
+struct HostEventStream::Ring {
+  explicit Ring(size_t capacity)
+      : mask(capacity - 1),
+        events(capacity),
+        thread_id(GetCurrentThreadSysId()),
+        thread_name(GetCurrentThreadName()) {}
+
+  const uint64_t mask;
+  std::vector<StreamedHostEvent> events;
+  // head is only written by the owner thread, tail only by the drainer
+  alignas(64) std::atomic<uint64_t> head{0};
+  alignas(64) std::atomic<uint64_t> tail{0};
+  std::atomic<uint64_t> dropped{0};
+  // set when the owner thread exits, nothing is pushed after it
+  std::atomic<bool> exited{false};
+  const uint64_t thread_id;
+  const std::string thread_name;
+};
+
+// Owns the ring of the current thread, marks it exited at thread exit so
+// that the drainer releases it.
+struct HostEventStream::ThreadRing {
+  ~ThreadRing() { Reset(); }
+
+  void Reset() {
+    if (ring != nullptr) {
+      ring->exited.store(true, std::memory_order_release);
+      ring.reset();
+    }
+  }
+
+  std::shared_ptr<Ring> ring;
+  uint64_t generation = UINT64_MAX;
+};
+
+namespace {
+
+struct ThreadStreamState {
+  uint64_t generation = UINT64_MAX;
+  std::unordered_map<const char*, uint32_t> literal_ids;
+  std::unordered_map<std::string, uint32_t> string_ids;
+  uint32_t depth = 0;
+  bool sampled = true;
+  uint64_t rng = 0;
+};
+
+ThreadStreamState& GetThreadStreamState(uint64_t generation) {
+  static thread_local ThreadStreamState state;
+  if (UNLIKELY(state.generation != generation)) {
+    state.generation = generation;
+    state.literal_ids.clear();
+    state.string_ids.clear();
+    if (state.rng == 0) {
+      state.rng = GetCurrentThreadSysId() * 0x9E3779B97F4A7C15ULL | 1;
+    }
+  }
+  return state;
+}
+
+// xorshift64*
+inline uint64_t NextRandom(uint64_t* state) {
+  uint64_t x = *state;
+  x ^= x >> 12;
+  x ^= x << 25;
+  x ^= x >> 27;
+  *state = x;
+  return x * 0x2545F4914F6CDD1DULL;
+}
+
+}  // namespace
+
+HostEventStream& HostEventStream::GetInstance() {
+  static HostEventStream instance;
+  return instance;
+}
+
+void HostEventStream::Enable(size_t ring_capacity, double sample_ratio) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  size_t capacity = 16;
+  while (capacity < ring_capacity) {
+    capacity <<= 1;
+  }
+  uint64_t sample_threshold = UINT64_MAX;
+  if (sample_ratio <= 0.0) {
+    sample_threshold = 0;
+  } else if (sample_ratio < 1.0) {
+    sample_threshold = static_cast<uint64_t>(
+        sample_ratio * static_cast<double>(UINT64_MAX));
+  }
+  ring_capacity_.store(capacity, std::memory_order_relaxed);
+  sample_threshold_.store(sample_threshold, std::memory_order_relaxed);
+  rings_.clear();
+  name_ids_.clear();
+  new_names_.clear();
+  generation_.fetch_add(1, std::memory_order_release);
+  enabled_.store(true, std::memory_order_release);
+}
+
+void HostEventStream::Disable() {
+  // the rings are kept so that the last events can still be drained
+  enabled_.store(false, std::memory_order_release);
+}
+
+bool HostEventStream::BeginScope() {
+  auto& state =
+      GetThreadStreamState(generation_.load(std::memory_order_acquire));
+  if (state.depth++ == 0) {
+    uint64_t threshold = sample_threshold_.load(std::memory_order_relaxed);
+    state.sampled =
+        threshold == UINT64_MAX || NextRandom(&state.rng) < threshold;
+  }
+  return state.sampled;
+}
+
+void HostEventStream::EndScope() {
+  auto& state =
+      GetThreadStreamState(generation_.load(std::memory_order_acquire));
+  if (state.depth > 0) {
+    --state.depth;
+  }
+}
+
+HostEventStream::Ring* HostEventStream::GetThreadRing() {
+  static thread_local ThreadRing holder;
+  uint64_t generation = generation_.load(std::memory_order_acquire);
+  if (UNLIKELY(holder.ring == nullptr || holder.generation != generation)) {
+    holder.Reset();
+    std::lock_guard<std::mutex> lock(mutex_);
+    holder.ring = std::make_shared<Ring>(
+        ring_capacity_.load(std::memory_order_relaxed));
+    holder.generation = generation;
+    rings_.push_back(holder.ring);
+  }
+  return holder.ring.get();
+}
+
+uint32_t HostEventStream::InternName(const std::string& name) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = name_ids_.find(name);
+  if (it != name_ids_.end()) {
+    return it->second;
+  }
+  uint32_t id = static_cast<uint32_t>(name_ids_.size());
+  name_ids_.emplace(name, id);
+  new_names_.emplace_back(id, name);
+  return id;
+}
+
+void HostEventStream::Push(uint32_t name_id,
+                           uint64_t start_ns,
+                           uint64_t end_ns,
+                           TracerEventType type) {
+  Ring* ring = GetThreadRing();
+  uint64_t head = ring->head.load(std::memory_order_relaxed);
+  uint64_t tail = ring->tail.load(std::memory_order_acquire);
+  if (UNLIKELY(head - tail > ring->mask)) {
+    ring->dropped.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  auto& event = ring->events[head & ring->mask];
+  event.name_id = name_id;
+  event.type = type;
+  event.start_ns = start_ns;
+  event.end_ns = end_ns;
+  ring->head.store(head + 1, std::memory_order_release);
+}
+
+void HostEventStream::Record(const char* name,
+                             uint64_t start_ns,
+                             uint64_t end_ns,
+                             TracerEventType type) {
+  auto& state =
+      GetThreadStreamState(generation_.load(std::memory_order_acquire));
+  auto it = state.literal_ids.find(name);
+  uint32_t name_id = 0;
+  if (LIKELY(it != state.literal_ids.end())) {
+    name_id = it->second;
+  } else {
+    name_id = InternName(name);
+    state.literal_ids.emplace(name, name_id);
+  }
+  Push(name_id, start_ns, end_ns, type);
+}
+
+void HostEventStream::Record(const std::string& name,
+                             uint64_t start_ns,
+                             uint64_t end_ns,
+                             TracerEventType type) {
+  auto& state =
+      GetThreadStreamState(generation_.load(std::memory_order_acquire));
+  auto it = state.string_ids.find(name);
+  uint32_t name_id = 0;
+  if (LIKELY(it != state.string_ids.end())) {
+    name_id = it->second;
+  } else {
+    name_id = InternName(name);
+    state.string_ids.emplace(name, name_id);
+  }
+  Push(name_id, start_ns, end_ns, type);
+}
+
+void HostEventStream::Drain(std::vector<ThreadEvents>* threads) {
+  std::vector<std::shared_ptr<Ring>> rings;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    rings = rings_;
+  }
+  std::vector<Ring*> exited_rings;
+  for (auto& ring : rings) {
+    // read before head, so that an exited ring is empty once drained
+    bool exited = ring->exited.load(std::memory_order_acquire);
+    uint64_t tail = ring->tail.load(std::memory_order_relaxed);
+    uint64_t head = ring->head.load(std::memory_order_acquire);
+    uint64_t dropped = ring->dropped.exchange(0, std::memory_order_relaxed);
+    if (exited) {
+      exited_rings.push_back(ring.get());
+    }
+    if (head == tail && dropped == 0) {
+      continue;
+    }
+    ThreadEvents thread_events;
+    thread_events.thread_id = ring->thread_id;
+    thread_events.thread_name = ring->thread_name;
+    thread_events.dropped = dropped;
+    thread_events.events.reserve(head - tail);
+    for (uint64_t i = tail; i < head; ++i) {
+      thread_events.events.push_back(ring->events[i & ring->mask]);
+    }
+    ring->tail.store(head, std::memory_order_release);
+    threads->push_back(std::move(thread_events));
+  }
+  if (!exited_rings.empty()) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    rings_.erase(std::remove_if(rings_.begin(),
+                                rings_.end(),
+                                [&](const std::shared_ptr<Ring>& ring) {
+                                  return std::find(exited_rings.begin(),
+                                                   exited_rings.end(),
+                                                   ring.get()) !=
+                                         exited_rings.end();
+                                }),
+                 rings_.end());
+  }
+}
+
+void HostEventStream::DrainNewNames(
+    std::vector<std::pair<uint32_t, std::string>>* names) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto& name : new_names_) {
+    names->push_back(std::move(name));
+  }
+  new_names_.clear();
+}
+
+size_t HostEventStream::NumThreadRings() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return rings_.size();
+}
+
+}  // namespace phi
@@ -0,0 +1,121 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "paddle/common/macros.h"
+#include "paddle/phi/api/profiler/trace_event.h"
+#include "paddle/utils/test_macros.h"
+
+namespace phi {
+
+// A fixed size host event record, the name is interned.
+struct StreamedHostEvent {
+  uint32_t name_id = 0;
+  TracerEventType type = TracerEventType::UserDefined;
+  uint64_t start_ns = 0;
+  uint64_t end_ns = 0;
+};
+
+// Streaming mode of host event recording, meant to stay enabled on
+// production jobs. Unlike HostEventRecorder, which keeps every event until
+// the profiler stops, every thread writes into a bounded single producer
+// single consumer ring and a flusher drains the rings periodically. When a
+// ring is full the new event is dropped and counted. Top level RecordEvent
+// scopes are sampled with a probability, nested scopes follow their top
+// level scope so sampled call trees stay complete. The ring of a thread is
+// released by the first drain after the thread exits.
+class TEST_API HostEventStream {
+ public:
+  struct ThreadEvents {
+    uint64_t thread_id = 0;
+    std::string thread_name;
+    std::vector<StreamedHostEvent> events;
+    // events dropped because the ring was full, since the last drain
+    uint64_t dropped = 0;
+  };
+
+  static HostEventStream& GetInstance();
+
+  static bool IsEnabled() { return enabled_.load(std::memory_order_relaxed); }
+
+  // ring_capacity is rounded up to a power of two, sample_ratio is the
+  // probability in (0, 1] that a top level scope is recorded.
+  void Enable(size_t ring_capacity, double sample_ratio);
+  void Disable();
+
+  // Called when a RecordEvent scope starts, returns whether it is sampled.
+  // Every call must be paired with an EndScope.
+  bool BeginScope();
+  void EndScope();
+
+  // thread-safe, lock-free unless the name is seen for the first time by
+  // this thread
+  void Record(const char* name,
+              uint64_t start_ns,
+              uint64_t end_ns,
+              TracerEventType type);
+  void Record(const std::string& name,
+              uint64_t start_ns,
+              uint64_t end_ns,
+              TracerEventType type);
+
+  // Moves out the buffered events of every thread, may run concurrently
+  // with Record. Only one thread may drain at a time.
+  void Drain(std::vector<ThreadEvents>* threads);
+
+  // Names interned since the last call, as (name_id, name).
+  void DrainNewNames(std::vector<std::pair<uint32_t, std::string>>* names);
+
+  // Rings not yet released, for tests.
+  size_t NumThreadRings();
+
+ private:
+  struct Ring;
+  struct ThreadRing;
+
+  HostEventStream() = default;
+  DISABLE_COPY_AND_ASSIGN(HostEventStream);
+
+  Ring* GetThreadRing();
+  uint32_t InternName(const std::string& name);
+  void Push(uint32_t name_id,
+            uint64_t start_ns,
+            uint64_t end_ns,
+            TracerEventType type);
+
+  static std::atomic<bool> enabled_;
+
+  // written by Enable while recording threads read them
+  std::atomic<size_t> ring_capacity_{1 << 16};
+  std::atomic<uint64_t> sample_threshold_{UINT64_MAX};
+  // a new generation invalidates the thread local rings and name caches
+  std::atomic<uint64_t> generation_{0};
+
+  std::mutex mutex_;
+  std::vector<std::shared_ptr<Ring>> rings_;
+  std::unordered_map<std::string, uint32_t> name_ids_;
+  std::vector<std::pair<uint32_t, std::string>> new_names_;
+};
+
+}  // namespace phi
@@ -25,6 +25,7 @@ limitations under the License. */
 #include "paddle/phi/api/profiler/common_event.h"
 #include "paddle/phi/api/profiler/device_tracer.h"
 #include "paddle/phi/api/profiler/host_event_recorder.h"
+#include "paddle/phi/api/profiler/host_event_stream.h"
 #include "paddle/phi/api/profiler/host_tracer.h"
 #include "paddle/phi/api/profiler/profiler_helper.h"
 #include "paddle/phi/core/enforce.h"
@@ -111,7 +112,8 @@ RecordEvent::RecordEvent(const char *name,
   if (UNLIKELY(HostTraceLevel::GetInstance().NeedTrace(level) == false)) {
     return;
   }
-  if (FLAGS_enable_host_event_recorder_hook == false) {
+  if (FLAGS_enable_host_event_recorder_hook == false &&
+      LIKELY(!HostEventStream::IsEnabled())) {
     if (ProfilerHelper::g_state !=
         ProfilerState::kDisabled) {  // avoid temp string
       if (type == TracerEventType::Operator ||
@@ -123,6 +125,10 @@ RecordEvent::RecordEvent(const char *name,
     return;
   }
 
+  if (UNLIKELY(!SampleStreamScope())) {
+    return;
+  }
+
   is_enabled_ = true;
   shallow_copy_name_ = name;
   role_ = role;
@@ -146,7 +152,8 @@ RecordEvent::RecordEvent(const std::string &name,
     return;
   }
 
-  if (FLAGS_enable_host_event_recorder_hook == false) {
+  if (FLAGS_enable_host_event_recorder_hook == false &&
+      LIKELY(!HostEventStream::IsEnabled())) {
     if (type == TracerEventType::Operator ||
         type == TracerEventType::OperatorInner ||
         type == TracerEventType::UserDefined) {
@@ -155,6 +162,10 @@ RecordEvent::RecordEvent(const std::string &name,
     return;
   }
 
+  if (UNLIKELY(!SampleStreamScope())) {
+    return;
+  }
+
   is_enabled_ = true;
   name_ = new std::string(name);
   role_ = role;
@@ -180,7 +191,8 @@ RecordEvent::RecordEvent(const std::string &name,
     return;
   }
 
-  if (FLAGS_enable_host_event_recorder_hook == false) {
+  if (FLAGS_enable_host_event_recorder_hook == false &&
+      LIKELY(!HostEventStream::IsEnabled())) {
     if (type == TracerEventType::Operator ||
         type == TracerEventType::OperatorInner ||
         type == TracerEventType::UserDefined) {
@@ -189,6 +201,10 @@ RecordEvent::RecordEvent(const std::string &name,
     return;
   }
 
+  if (UNLIKELY(!SampleStreamScope())) {
+    return;
+  }
+
   is_enabled_ = true;
   type_ = type;
   name_ = new std::string(name);
@@ -215,7 +231,20 @@ void RecordEvent::OriginalConstruct(const std::string &name,
   *name_ = e->name();
 }
 
+bool RecordEvent::SampleStreamScope() {
+  if (LIKELY(!HostEventStream::IsEnabled())) {
+    return true;
+  }
+  stream_scope_ = true;
+  return HostEventStream::GetInstance().BeginScope();
+}
+
 void RecordEvent::End() {
+  bool stream_scope = stream_scope_;
+  if (UNLIKELY(stream_scope_)) {
+    stream_scope_ = false;
+    HostEventStream::GetInstance().EndScope();
+  }
 #ifndef _WIN32
 #ifdef PADDLE_WITH_CUDA
   if (ProfilerHelper::g_enable_nvprof_hook && is_pushed_) {
@@ -224,6 +253,23 @@ void RecordEvent::End() {
   }
 #endif
 #endif
+  // scopes started while HostEventStream was enabled go to the stream,
+  // whatever FLAGS_enable_host_event_recorder_hook is
+  if (UNLIKELY(stream_scope && is_enabled_)) {
+    uint64_t end_ns = PosixInNsec();
+    auto &stream = HostEventStream::GetInstance();
+    if (shallow_copy_name_ != nullptr) {
+      stream.Record(shallow_copy_name_, start_ns_, end_ns, type_);
+    } else if (name_ != nullptr) {
+      stream.Record(*name_, start_ns_, end_ns, type_);
+    }
+    delete name_;
+    delete attr_;
+    name_ = nullptr;
+    attr_ = nullptr;
+    is_enabled_ = false;
+    return;
+  }
   if (LIKELY(FLAGS_enable_host_event_recorder_hook && is_enabled_)) {
     uint64_t end_ns = PosixInNsec();
     if (LIKELY(shallow_copy_name_ != nullptr)) {
@@ -267,6 +313,7 @@ void RecordEvent::End() {
 
 bool RecordEvent::IsEnabled() {
   return FLAGS_enable_host_event_recorder_hook ||
+         HostEventStream::IsEnabled() ||
          ProfilerHelper::g_enable_nvprof_hook ||
          ProfilerHelper::g_state != ProfilerState::kDisabled;
 }
@@ -15,6 +15,7 @@
 #include "paddle/phi/core/distributed/auto_parallel/reshard/nd_mesh_reshard_function.h"
 
 #include "glog/logging.h"
+#include "paddle/common/flags.h"
 #include "paddle/phi/common/int_array.h"
 #include "paddle/phi/core/distributed/auto_parallel/dist_attr.h"
 #include "paddle/phi/core/distributed/auto_parallel/dist_tensor.h"
@@ -22,11 +23,15 @@
 #include "paddle/phi/core/distributed/auto_parallel/reshard/p_to_s_reshard_function.h"
 #include "paddle/phi/core/distributed/auto_parallel/reshard/r_to_p_reshard_function.h"
 #include "paddle/phi/core/distributed/auto_parallel/reshard/r_to_s_reshard_function.h"
+#include "paddle/phi/core/distributed/auto_parallel/reshard/reshard_planner.h"
 #include "paddle/phi/core/distributed/auto_parallel/reshard/reshard_utils.h"
 #include "paddle/phi/core/distributed/auto_parallel/reshard/s_to_r_reshard_function.h"
+#include "paddle/phi/core/distributed/auto_parallel/reshard/s_to_s_reshard_function.h"
 #include "paddle/phi/core/distributed/auto_parallel/reshard/same_status_reshard_function.h"
 #include "paddle/phi/core/distributed/store/store_utils.h"
 
+COMMON_DECLARE_bool(enable_reshard_planner);
+
 namespace phi::distributed {
 
 namespace {
@@ -73,6 +78,21 @@ int64_t FindFirstDiffShardAxis(const TensorDistAttr& in_dist_attr,
   return axis;
 }
 
+// The dims seen by the sub mesh along mesh_axis, i.e. the global dims with
+// the tensor axes sharded on the other mesh axes divided.
+DDim GetSubMeshDims(const DDim& dims,
+                    const TensorDistAttr& dist_attr,
+                    int64_t mesh_axis) {
+  std::vector<int64_t> shape = common::vectorize(dims);
+  const auto& dims_mapping = dist_attr.dims_mapping();
+  for (size_t i = 0; i < dims_mapping.size(); ++i) {
+    if (dims_mapping[i] != -1 && dims_mapping[i] != mesh_axis) {
+      shape[i] /= dist_attr.process_mesh().dim_size(dims_mapping[i]);
+    }
+  }
+  return common::make_ddim(shape);
+}
+
 }  // namespace
 
 bool SameNdMeshReshardFunction::IsSuitable(
@@ -103,6 +123,26 @@ void SameNdMeshReshardFunction::Eval(phi::DeviceContext* dev_ctx,
   SetValue(out, in.value());
   SetDistProps(out, in.dims(), in_dist_attr);
 
+  if (FLAGS_enable_reshard_planner) {
+    // There is no reduce scatter kernel on cpu.
+    bool support_reduce_scatter =
+        dev_ctx->GetPlace().GetType() != AllocationType::CPU;
+    const ReshardPlan* plan =
+        ReshardPlanner::Instance().GetPlan(in_dist_attr,
+                                           out_dist_attr_orig,
+                                           in.dims(),
+                                           in.dtype(),
+                                           support_reduce_scatter);
+    if (plan != nullptr) {
+      for (const auto& step : plan->steps) {
+        EvalStep(dev_ctx, step, in.dims(), out);
+      }
+      SetDistProps(out, in.dims(), out_dist_attr_orig);
+      ReshardPlanner::Instance().AddExecutedBytes(plan->bytes);
+      return;
+    }
+  }
+
   // 1. change all the partial status to replicated status if needed
   if (in_dist_attr.is_partial()) {
     // Copy in_dist_attr.partial_status to avoid overwriting the value of
@@ -272,6 +312,80 @@ void SameNdMeshReshardFunction::Eval(phi::DeviceContext* dev_ctx,
   }
 }
 
+void SameNdMeshReshardFunction::EvalStep(phi::DeviceContext* dev_ctx,
+                                         const ReshardStep& step,
+                                         const DDim& global_dims,
+                                         DistTensor* out) {
+  const TensorDistAttr cur_dist_attr = out->dist_attr();
+  const int64_t mesh_axis = step.mesh_axis;
+  DDim sub_dims = GetSubMeshDims(global_dims, cur_dist_attr, mesh_axis);
+  ProcessMesh sub_mesh =
+      GetSubProcessMesh(cur_dist_attr.process_mesh(), mesh_axis);
+
+  TensorDistAttr in_one_dim_dist_attr(common::vectorize(sub_dims));
+  in_one_dim_dist_attr.set_process_mesh(sub_mesh);
+  TensorDistAttr out_one_dim_dist_attr(common::vectorize(sub_dims));
+  out_one_dim_dist_attr.set_process_mesh(sub_mesh);
+  TensorDistAttr real_out_dist_attr(cur_dist_attr);
+  std::vector<int64_t> in_one_dims_mapping =
+      in_one_dim_dist_attr.dims_mapping();
+  std::vector<int64_t> out_one_dims_mapping =
+      out_one_dim_dist_attr.dims_mapping();
+  std::vector<int64_t> real_dims_mapping = real_out_dist_attr.dims_mapping();
+
+  if (step.in_tensor_axis != -1) {
+    in_one_dims_mapping[step.in_tensor_axis] = 0;
+    real_dims_mapping[step.in_tensor_axis] = -1;
+  }
+  if (step.out_tensor_axis != -1) {
+    out_one_dims_mapping[step.out_tensor_axis] = 0;
+    real_dims_mapping[step.out_tensor_axis] = mesh_axis;
+  }
+  in_one_dim_dist_attr.set_dims_mapping(in_one_dims_mapping);
+  out_one_dim_dist_attr.set_dims_mapping(out_one_dims_mapping);
+  real_out_dist_attr.set_dims_mapping(real_dims_mapping);
+
+  std::unique_ptr<ReshardFunction> func;
+  switch (step.type) {
+    case ReshardStep::Type::kPToR:
+      func = std::make_unique<PToRReshardFunction>();
+      break;
+    case ReshardStep::Type::kPToS:
+      func = std::make_unique<PToSReshardFunction>();
+      break;
+    case ReshardStep::Type::kSToR:
+      func = std::make_unique<SToRReshardFunction>();
+      break;
+    case ReshardStep::Type::kRToS:
+      func = std::make_unique<RToSReshardFunction>();
+      break;
+    case ReshardStep::Type::kSToS:
+      func = std::make_unique<SToSReshardFunction>();
+      break;
+    case ReshardStep::Type::kRToP:
+      func = std::make_unique<RToPReshardFunction>();
+      break;
+  }
+  if (step.type == ReshardStep::Type::kPToR ||
+      step.type == ReshardStep::Type::kPToS) {
+    in_one_dim_dist_attr.set_partial_status(std::vector<int64_t>{0},
+                                            step.reduce_type);
+    real_out_dist_attr.clean_partial_dims({mesh_axis});
+  } else if (step.type == ReshardStep::Type::kRToP) {
+    out_one_dim_dist_attr.set_partial_status(std::vector<int64_t>{0},
+                                             step.reduce_type);
+    real_out_dist_attr.set_partial_status(std::vector<int64_t>{mesh_axis},
+                                          step.reduce_type);
+  }
+
+  VLOG(3) << "Planned step " << step.to_string();
+  SetDistProps(out, sub_dims, in_one_dim_dist_attr);
+  DistTensor tmp_result;
+  func->Eval(dev_ctx, *out, out_one_dim_dist_attr, &tmp_result);
+  SetValue(out, tmp_result.value());
+  SetDistProps(out, global_dims, real_out_dist_attr);
+}
+
 bool CrossNdMeshReshardFunction::IsSuitable(
     const DistTensor& in, const TensorDistAttr& out_dist_attr) {
   const ProcessMesh& in_process_mesh = in.dist_attr().process_mesh();
@@ -19,6 +19,8 @@
 namespace phi {
 namespace distributed {
 
+struct ReshardStep;
+
 class SameNdMeshReshardFunction final : public ReshardFunction {
  public:
   bool IsSuitable(const DistTensor& in,
@@ -30,6 +32,14 @@ class SameNdMeshReshardFunction final : public ReshardFunction {
             DistTensor* out) override;
 
   std::string Name() override { return "SameNdMeshReshard"; }
+
+ private:
+  // Runs one step of the reshard plan with the 1-D reshard function on the
+  // sub mesh along its mesh axis.
+  void EvalStep(DeviceContext* dev_ctx,
+                const ReshardStep& step,
+                const DDim& global_dims,
+                DistTensor* out);
 };
 
 class CrossNdMeshReshardFunction final : public ReshardFunction {
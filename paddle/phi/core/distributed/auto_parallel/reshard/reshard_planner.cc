@@ -0,0 +1,309 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/phi/core/distributed/auto_parallel/reshard/reshard_planner.h"
+
+#include <algorithm>
+#include <map>
+#include <queue>
+#include <sstream>
+#include <tuple>
+
+#include "glog/logging.h"
+#include "paddle/phi/core/distributed/auto_parallel/dist_attr.h"
+
+namespace phi::distributed {
+
+namespace {
+
+const char* StepTypeName(ReshardStep::Type type) {
+  switch (type) {
+    case ReshardStep::Type::kPToR:
+      return "p->r";
+    case ReshardStep::Type::kPToS:
+      return "p->s";
+    case ReshardStep::Type::kSToR:
+      return "s->r";
+    case ReshardStep::Type::kRToS:
+      return "r->s";
+    case ReshardStep::Type::kSToS:
+      return "s->s";
+    case ReshardStep::Type::kRToP:
+      return "r->p";
+  }
+  return "unknown";
+}
+
+// Status of every mesh axis, empty if the dist attr is not supported.
+std::vector<int64_t> GetMeshAxisStatus(const TensorDistAttr& dist_attr) {
+  std::vector<int64_t> status(dist_attr.process_mesh().ndim(),
+                              kReplicatedStatus);
+  const auto& dims_mapping = dist_attr.dims_mapping();
+  for (int64_t i = 0; i < static_cast<int64_t>(dims_mapping.size()); ++i) {
+    if (dims_mapping[i] != -1) {
+      status[dims_mapping[i]] = i;
+    }
+  }
+  for (const auto& item : dist_attr.partial_status()) {
+    if (status[item.first] != kReplicatedStatus) {
+      return {};
+    }
+    status[item.first] = kPartialStatus;
+  }
+  return status;
+}
+
+// Every tensor axis is sharded at most once and evenly.
+bool IsValidStatus(const std::vector<int64_t>& mesh_shape,
+                   const std::vector<int64_t>& tensor_shape,
+                   const std::vector<int64_t>& status) {
+  std::vector<bool> sharded(tensor_shape.size(), false);
+  for (size_t axis = 0; axis < status.size(); ++axis) {
+    int64_t tensor_axis = status[axis];
+    if (tensor_axis < 0) {
+      continue;
+    }
+    if (tensor_axis >= static_cast<int64_t>(tensor_shape.size()) ||
+        sharded[tensor_axis] ||
+        tensor_shape[tensor_axis] % mesh_shape[axis] != 0) {
+      return false;
+    }
+    sharded[tensor_axis] = true;
+  }
+  return true;
+}
+
+}  // namespace
+
+std::string ReshardStep::to_string() const {
+  std::stringstream ss;
+  ss << StepTypeName(type) << "(mesh_axis=" << mesh_axis;
+  if (in_tensor_axis != -1) {
+    ss << ", in_tensor_axis=" << in_tensor_axis;
+  }
+  if (out_tensor_axis != -1) {
+    ss << ", out_tensor_axis=" << out_tensor_axis;
+  }
+  ss << ", bytes=" << bytes << ")";
+  return ss.str();
+}
+
+std::string ReshardPlan::to_string() const {
+  std::stringstream ss;
+  ss << "{steps: [";
+  for (size_t i = 0; i < steps.size(); ++i) {
+    ss << (i == 0 ? "" : ", ") << steps[i].to_string();
+  }
+  ss << "], bytes: " << bytes << "}";
+  return ss.str();
+}
+
+ReshardPlanner& ReshardPlanner::Instance() {
+  static ReshardPlanner planner;
+  return planner;
+}
+
+std::unique_ptr<ReshardPlan> ReshardPlanner::Plan(
+    const std::vector<int64_t>& mesh_shape,
+    const std::vector<int64_t>& tensor_shape,
+    int64_t element_size,
+    const std::vector<int64_t>& in_status,
+    const std::vector<int64_t>& out_status,
+    bool support_reduce_scatter) {
+  if (!IsValidStatus(mesh_shape, tensor_shape, in_status) ||
+      !IsValidStatus(mesh_shape, tensor_shape, out_status)) {
+    return nullptr;
+  }
+  int64_t global_bytes = element_size;
+  for (int64_t size : tensor_shape) {
+    global_bytes *= size;
+  }
+
+  // Dijkstra over the status of all mesh axes, ordered by the bytes and
+  // then the number of steps.
+  using Cost = std::pair<int64_t, int64_t>;
+  struct Node {
+    Cost cost;
+    std::vector<int64_t> prev;
+    ReshardStep step;
+    bool visited{false};
+  };
+  std::map<std::vector<int64_t>, Node> nodes;
+  using Entry = std::pair<Cost, std::vector<int64_t>>;
+  std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> queue;
+
+  nodes[in_status].cost = {0, 0};
+  queue.emplace(Cost{0, 0}, in_status);
+  while (!queue.empty()) {
+    Cost cost = queue.top().first;
+    std::vector<int64_t> status = queue.top().second;
+    queue.pop();
+    Node& node = nodes[status];
+    if (node.visited) {
+      continue;
+    }
+    node.visited = true;
+    if (status == out_status) {
+      break;
+    }
+
+    int64_t local_bytes = global_bytes;
+    std::vector<bool> sharded(tensor_shape.size(), false);
+    for (size_t axis = 0; axis < status.size(); ++axis) {
+      if (status[axis] >= 0) {
+        local_bytes /= mesh_shape[axis];
+        sharded[status[axis]] = true;
+      }
+    }
+
+    auto relax = [&](int64_t axis,
+                     int64_t new_status,
+                     ReshardStep::Type type,
+                     int64_t bytes) {
+      std::vector<int64_t> next = status;
+      next[axis] = new_status;
+      Cost next_cost{cost.first + bytes, cost.second + 1};
+      auto iter = nodes.find(next);
+      if (iter != nodes.end() &&
+          (iter->second.visited || iter->second.cost <= next_cost)) {
+        return;
+      }
+      Node& next_node = nodes[next];
+      next_node.cost = next_cost;
+      next_node.prev = status;
+      next_node.step.type = type;
+      next_node.step.mesh_axis = axis;
+      next_node.step.in_tensor_axis = std::max<int64_t>(status[axis], -1);
+      next_node.step.out_tensor_axis = std::max<int64_t>(new_status, -1);
+      next_node.step.bytes = bytes;
+      queue.emplace(next_cost, std::move(next));
+    };
+
+    for (int64_t axis = 0; axis < static_cast<int64_t>(status.size());
+         ++axis) {
+      int64_t n = mesh_shape[axis];
+      auto for_each_free_tensor_axis = [&](auto&& func) {
+        for (int64_t i = 0; i < static_cast<int64_t>(tensor_shape.size());
+             ++i) {
+          if (!sharded[i] && tensor_shape[i] % n == 0) {
+            func(i);
+          }
+        }
+      };
+      if (status[axis] == kPartialStatus) {
+        relax(axis,
+              kReplicatedStatus,
+              ReshardStep::Type::kPToR,
+              2 * local_bytes * (n - 1) / n);
+        if (support_reduce_scatter) {
+          for_each_free_tensor_axis([&](int64_t i) {
+            relax(axis,
+                  i,
+                  ReshardStep::Type::kPToS,
+                  local_bytes * (n - 1) / n);
+          });
+        }
+      } else if (status[axis] == kReplicatedStatus) {
+        for_each_free_tensor_axis([&](int64_t i) {
+          relax(axis, i, ReshardStep::Type::kRToS, 0);
+        });
+        if (out_status[axis] == kPartialStatus) {
+          relax(axis, kPartialStatus, ReshardStep::Type::kRToP, 0);
+        }
+      } else {
+        relax(axis,
+              kReplicatedStatus,
+              ReshardStep::Type::kSToR,
+              local_bytes * (n - 1));
+        for_each_free_tensor_axis([&](int64_t i) {
+          relax(axis,
+                i,
+                ReshardStep::Type::kSToS,
+                local_bytes * (n - 1) / n);
+        });
+      }
+    }
+  }
+
+  auto iter = nodes.find(out_status);
+  if (iter == nodes.end() || !iter->second.visited) {
+    return nullptr;
+  }
+  auto plan = std::make_unique<ReshardPlan>();
+  plan->bytes = iter->second.cost.first;
+  for (auto status = out_status; status != in_status;) {
+    const Node& node = nodes[status];
+    plan->steps.push_back(node.step);
+    status = node.prev;
+  }
+  std::reverse(plan->steps.begin(), plan->steps.end());
+  return plan;
+}
+
+const ReshardPlan* ReshardPlanner::GetPlan(const TensorDistAttr& in_dist_attr,
+                                           const TensorDistAttr& out_dist_attr,
+                                           const DDim& dims,
+                                           DataType dtype,
+                                           bool support_reduce_scatter) {
+  std::stringstream key;
+  key << in_dist_attr.to_string() << ";" << out_dist_attr.to_string() << ";"
+      << dims << ";" << dtype << ";" << support_reduce_scatter;
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto iter = plans_.find(key.str());
+  if (iter != plans_.end()) {
+    return iter->second.get();
+  }
+
+  std::unique_ptr<ReshardPlan> plan;
+  auto in_status = GetMeshAxisStatus(in_dist_attr);
+  auto out_status = GetMeshAxisStatus(out_dist_attr);
+  // changing the reduce type of a partial mesh axis is not a step
+  bool same_reduce_type = true;
+  for (const auto& item : in_dist_attr.partial_status()) {
+    auto out_item = out_dist_attr.partial_status().find(item.first);
+    if (out_item != out_dist_attr.partial_status().end() &&
+        out_item->second != item.second) {
+      same_reduce_type = false;
+    }
+  }
+  if (!in_status.empty() && !out_status.empty() && same_reduce_type) {
+    plan = Plan(in_dist_attr.process_mesh().shape(),
+                common::vectorize(dims),
+                static_cast<int64_t>(SizeOf(dtype)),
+                in_status,
+                out_status,
+                support_reduce_scatter);
+  }
+  if (plan != nullptr) {
+    for (auto& step : plan->steps) {
+      const auto& partial_status =
+          step.type == ReshardStep::Type::kRToP
+              ? out_dist_attr.partial_status()
+              : in_dist_attr.partial_status();
+      auto partial = partial_status.find(step.mesh_axis);
+      if (partial != partial_status.end()) {
+        step.reduce_type = partial->second;
+      }
+    }
+    VLOG(3) << "Reshard plan from " << in_dist_attr.to_string() << " to "
+            << out_dist_attr.to_string() << ": " << plan->to_string();
+  } else {
+    VLOG(3) << "Can not plan reshard from " << in_dist_attr.to_string()
+            << " to " << out_dist_attr.to_string();
+  }
+  return plans_.emplace(key.str(), std::move(plan)).first->second.get();
+}
+
+}  // namespace phi::distributed
@@ -0,0 +1,112 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "paddle/common/macros.h"
+#include "paddle/phi/common/data_type.h"
+#include "paddle/phi/common/reduce_type.h"
+#include "paddle/phi/core/ddim.h"
+#include "paddle/utils/test_macros.h"
+
+namespace phi {
+namespace distributed {
+
+class TensorDistAttr;
+
+// Status of one mesh axis, a value >= 0 is the tensor axis sharded on it.
+constexpr int64_t kReplicatedStatus = -1;
+constexpr int64_t kPartialStatus = -2;
+
+// A reshard on a single mesh axis, done by the 1-D reshard functions on the
+// sub mesh along the axis.
+struct ReshardStep {
+  enum class Type { kPToR, kPToS, kSToR, kRToS, kSToS, kRToP };
+
+  Type type;
+  int64_t mesh_axis;
+  // tensor axis sharded on mesh_axis before and after the step, -1 if none
+  int64_t in_tensor_axis{-1};
+  int64_t out_tensor_axis{-1};
+  // reduce type of the partial status before or after the step
+  ReduceType reduce_type{ReduceType::kRedSum};
+  // estimated bytes sent by every rank in the step
+  int64_t bytes{0};
+
+  std::string to_string() const;
+};
+
+struct ReshardPlan {
+  std::vector<ReshardStep> steps;
+  int64_t bytes{0};
+
+  std::string to_string() const;
+};
+
+// Plans the reshard between two dist attrs on the same nd mesh as the
+// sequence of 1-D reshard steps that sends the fewest bytes. The cost of a
+// step is the bytes every rank sends with ring algorithms on the sub mesh
+// along its mesh axis:
+//   p->r allreduce  2 * (n - 1) / n * local_bytes
+//   p->s reduce scatter  (n - 1) / n * local_bytes
+//   s->r allgather  (n - 1) * local_bytes
+//   s->s all to all  (n - 1) / n * local_bytes
+//   r->s, r->p  0
+// where n is the size of the mesh axis. Plans are cached by the dist attrs,
+// the shape and the data type.
+class TEST_API ReshardPlanner {
+ public:
+  static ReshardPlanner& Instance();
+
+  // Returns nullptr if the reshard can not be planned, e.g. a tensor axis
+  // is not evenly divided by the mesh axis sharding it. reduce scatter is
+  // not used if support_reduce_scatter is false.
+  const ReshardPlan* GetPlan(const TensorDistAttr& in_dist_attr,
+                             const TensorDistAttr& out_dist_attr,
+                             const DDim& dims,
+                             DataType dtype,
+                             bool support_reduce_scatter);
+
+  // Plans with the status of every mesh axis, see kReplicatedStatus.
+  static std::unique_ptr<ReshardPlan> Plan(
+      const std::vector<int64_t>& mesh_shape,
+      const std::vector<int64_t>& tensor_shape,
+      int64_t element_size,
+      const std::vector<int64_t>& in_status,
+      const std::vector<int64_t>& out_status,
+      bool support_reduce_scatter);
+
+  // Total estimated bytes of the plans executed so far.
+  int64_t executed_bytes() const { return executed_bytes_.load(); }
+  void AddExecutedBytes(int64_t bytes) { executed_bytes_ += bytes; }
+
+ private:
+  ReshardPlanner() = default;
+  DISABLE_COPY_AND_ASSIGN(ReshardPlanner);
+
+  std::mutex mutex_;
+  // nullptr if the reshard can not be planned
+  std::unordered_map<std::string, std::unique_ptr<ReshardPlan>> plans_;
+  std::atomic<int64_t> executed_bytes_{0};
+};
+
+}  // namespace distributed
+}  // namespace phi
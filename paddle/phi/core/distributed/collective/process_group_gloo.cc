@@ -27,6 +27,7 @@
 #include <gloo/reduce.h>
 
 #include "glog/logging.h"
+#include "paddle/phi/backends/cpu/cpu_context.h"
 #include "paddle/phi/core/distributed/collective/common.h"
 #include "paddle/phi/core/distributed/collective/process_group_gloo.h"
 #include "paddle/phi/core/distributed/comm_context_manager.h"
@@ -148,10 +149,54 @@ void set_inputs_for_scatter(P& opts,                   // NOLINT
   opts.setInputs(ret, tensor.numel() / nranks);
 }
 
+template <typename InT, typename OutT>
+static void CastTensor(const phi::CPUContext& ctx,
+                       const phi::DenseTensor& in,
+                       phi::DenseTensor* out) {
+  out->Resize(in.dims());
+  const InT* src = in.data<InT>();
+  OutT* dst = ctx.Alloc<OutT>(out);
+  for (int64_t i = 0; i < in.numel(); ++i) {
+    dst[i] = static_cast<OutT>(src[i]);
+  }
+}
+
 ProcessGroupGloo::GlooTask::GlooTask(
     int rank, const std::vector<phi::DenseTensor>& inputs, CommType comm_type)
     : ProcessGroup::Task(rank, inputs, comm_type) {}
 
+void ProcessGroupGloo::GlooTask::RunAndComplete() {
+  try {
+    Run();
+  } catch (...) {
+    exception_ = std::current_exception();
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    is_completed_ = true;
+  }
+  cv_.notify_all();
+}
+
+bool ProcessGroupGloo::GlooTask::IsCompleted() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return is_completed_;
+}
+
+bool ProcessGroupGloo::GlooTask::Wait(std::chrono::milliseconds timeout) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  auto completed = [this] { return is_completed_; };
+  if (timeout == kWaitTimeout) {
+    cv_.wait(lock, completed);
+  } else if (!cv_.wait_for(lock, timeout, completed)) {
+    return false;
+  }
+  if (exception_) {
+    std::rethrow_exception(exception_);
+  }
+  return true;
+}
+
 ProcessGroupGloo::ProcessGroupGloo(
     const std::shared_ptr<phi::distributed::Store>& store,
     int rank,
@@ -165,6 +210,59 @@ ProcessGroupGloo::ProcessGroupGloo(
   _context->connectFullMesh(*_store, options->device);
 }
 
+ProcessGroupGloo::~ProcessGroupGloo() {
+  {
+    std::lock_guard<std::mutex> lock(_queue_mutex);
+    _stop = true;
+  }
+  _queue_cv.notify_all();
+  if (_comm_thread.joinable()) {
+    _comm_thread.join();
+  }
+}
+
+void ProcessGroupGloo::RunTask(const std::shared_ptr<GlooTask>& task,
+                               bool sync_op) {
+  if (!sync_op) {
+    std::lock_guard<std::mutex> lock(_queue_mutex);
+    if (!_comm_thread.joinable()) {
+      _comm_thread = std::thread(&ProcessGroupGloo::CommLoop, this);
+    }
+    _queue.push_back(task);
+    _last_async_task = task;
+    _queue_cv.notify_one();
+    return;
+  }
+
+  std::shared_ptr<GlooTask> last_async_task;
+  {
+    std::lock_guard<std::mutex> lock(_queue_mutex);
+    last_async_task.swap(_last_async_task);
+  }
+  if (last_async_task) {
+    // the queue runs in order, so all the pending tasks are done after it
+    last_async_task->Wait();
+  }
+  task->RunAndComplete();
+  task->Wait();
+}
+
+void ProcessGroupGloo::CommLoop() {
+  while (true) {
+    std::shared_ptr<GlooTask> task;
+    {
+      std::unique_lock<std::mutex> lock(_queue_mutex);
+      _queue_cv.wait(lock, [this] { return _stop || !_queue.empty(); });
+      if (_queue.empty()) {
+        return;
+      }
+      task = std::move(_queue.front());
+      _queue.pop_front();
+    }
+    task->RunAndComplete();
+  }
+}
+
 class BroadcastGlooTask : public ProcessGroupGloo::GlooTask {
  public:
   BroadcastGlooTask(phi::distributed::GlooCommContext* comm_context,
@@ -221,12 +319,12 @@ std::shared_ptr<ProcessGroup::Task> ProcessGroupGloo::Broadcast(
   CheckTensorContiguous(outputs);
 
   auto root = opts.source_rank;
-  std::unique_ptr<BroadcastGlooTask> task;
+  std::shared_ptr<BroadcastGlooTask> task;
   auto tag = next_tag();
   auto comm_context = this->GetCommContext();
-  task = std::make_unique<BroadcastGlooTask>(
+  task = std::make_shared<BroadcastGlooTask>(
       comm_context, inputs, outputs, rank_, root, tag);
-  task->Run();
+  RunTask(task, true);
   return task;
 }
 
@@ -265,12 +363,12 @@ std::shared_ptr<ProcessGroup::Task> ProcessGroupGloo::Send(
 std::shared_ptr<ProcessGroup::Task> ProcessGroupGloo::Send(
     std::vector<phi::DenseTensor>& inputs, int dst_rank) {
   CheckTensorContiguous(inputs);
-  std::unique_ptr<SendGlooTask> task;
+  std::shared_ptr<SendGlooTask> task;
   auto tag = next_tag();
   auto comm_context = this->GetCommContext();
-  task = std::make_unique<SendGlooTask>(
+  task = std::make_shared<SendGlooTask>(
       comm_context, &inputs, rank_, dst_rank, tag);
-  task->Run();
+  RunTask(task, true);
 
   return task;
 }
@@ -309,13 +407,13 @@ std::shared_ptr<ProcessGroup::Task> ProcessGroupGloo::Recv(
 
 std::shared_ptr<ProcessGroup::Task> ProcessGroupGloo::Recv(
     std::vector<phi::DenseTensor>& outputs, int src_rank) {
-  std::unique_ptr<RecvGlooTask> task;
+  std::shared_ptr<RecvGlooTask> task;
   auto tag = next_tag();
   auto comm_context = this->GetCommContext();
 
-  task = std::make_unique<RecvGlooTask>(
+  task = std::make_shared<RecvGlooTask>(
       comm_context, &outputs, rank_, src_rank, tag);
-  task->Run();
+  RunTask(task, true);
   return task;
 }
 
@@ -326,12 +424,14 @@ class AllreduceGlooTask : public ProcessGroupGloo::GlooTask {
                     std::vector<phi::DenseTensor>& inputs,   // NOLINT
                     std::vector<phi::DenseTensor>& outputs,  // NOLINT
                     ReduceOp reduce_op,
+                    phi::DataType comm_dtype,
                     uint32_t tag)
       : ProcessGroupGloo::GlooTask(rank, inputs, CommType::ALLREDUCE),
         _comm_context(comm_context),
         _inputs(inputs),
         _outputs(outputs),
         _reduce_op(reduce_op),
+        _comm_dtype(comm_dtype),
         _tag(tag) {}
 
   void Run() override { _do_allreduce(_inputs, _outputs); }
@@ -341,13 +441,36 @@ class AllreduceGlooTask : public ProcessGroupGloo::GlooTask {
   std::vector<phi::DenseTensor> _inputs;
   std::vector<phi::DenseTensor> _outputs;
   const ReduceOp _reduce_op;
+  const phi::DataType _comm_dtype;
   uint32_t _tag;
 
   void _do_allreduce(std::vector<phi::DenseTensor>& ins,     // NOLINT
                      std::vector<phi::DenseTensor>& outs) {  // NOLINT
+    if (_comm_dtype != phi::DataType::UNDEFINED &&
+        ins[0].dtype() == phi::DataType::FLOAT32) {
+      if (_comm_dtype == phi::DataType::BFLOAT16) {
+        _do_compressed_allreduce<phi::dtype::bfloat16>(ins[0], &(outs[0]));
+      } else {
+        _do_compressed_allreduce<phi::dtype::float16>(ins[0], &(outs[0]));
+      }
+      return;
+    }
     _comm_context->AllReduce(
         &(outs[0]), ins[0], static_cast<int>(_reduce_op), _tag);
   }
+
+  // Sends and reduces a float32 tensor as T, the reduction is also done in T.
+  template <typename T>
+  void _do_compressed_allreduce(const phi::DenseTensor& in,
+                                phi::DenseTensor* out) {
+    const auto* ctx = static_cast<const phi::CPUContext*>(
+        phi::DeviceContextPool::Instance().Get(phi::CPUPlace()));
+    phi::DenseTensor buffer;
+    CastTensor<float, T>(*ctx, in, &buffer);
+    _comm_context->AllReduce(
+        &buffer, buffer, static_cast<int>(_reduce_op), _tag);
+    CastTensor<T, float>(*ctx, buffer, out);
+  }
 };
 
 std::shared_ptr<ProcessGroup::Task> ProcessGroupGloo::AllReduce(
@@ -357,7 +480,7 @@ std::shared_ptr<ProcessGroup::Task> ProcessGroupGloo::AllReduce(
     bool sync_op) {
   std::vector<phi::DenseTensor> in_wrapper{in_tensor};
   std::vector<phi::DenseTensor> out_wrapper{*out_tensor};
-  return AllReduce(in_wrapper, out_wrapper, opts, true);
+  return AllReduce(in_wrapper, out_wrapper, opts, sync_op);
 }
 
 std::shared_ptr<ProcessGroup::Task> ProcessGroupGloo::AllReduce(
@@ -375,12 +498,32 @@ std::shared_ptr<ProcessGroup::Task> ProcessGroupGloo::AllReduce(
   CheckTensorContiguous(inputs);
   CheckTensorContiguous(outputs);
 
+  PADDLE_ENFORCE_EQ(opts.comm_dtype == phi::DataType::UNDEFINED ||
+                        opts.comm_dtype == phi::DataType::FLOAT16 ||
+                        opts.comm_dtype == phi::DataType::BFLOAT16,
+                    true,
+                    common::errors::InvalidArgument(
+                        "Gloo only supports float16 or bfloat16 as the "
+                        "communication data type of allreduce, but got %s.",
+                        opts.comm_dtype));
+#ifdef _WIN32
+  PADDLE_ENFORCE_NE(opts.comm_dtype,
+                    phi::DataType::BFLOAT16,
+                    common::errors::Unimplemented(
+                        "Gloo does not support bfloat16 on Windows."));
+#endif
+
   auto tag = next_tag();
   std::shared_ptr<GlooTask> task;
   auto comm_context = this->GetCommContext();
-  task = std::make_shared<AllreduceGlooTask>(
-      rank_, comm_context, inputs, outputs, opts.reduce_op, tag);
-  task->Run();
+  task = std::make_shared<AllreduceGlooTask>(rank_,
+                                             comm_context,
+                                             inputs,
+                                             outputs,
+                                             opts.reduce_op,
+                                             opts.comm_dtype,
+                                             tag);
+  RunTask(task, sync_op);
   return task;
 }
 
@@ -404,7 +547,7 @@ std::shared_ptr<ProcessGroup::Task> ProcessGroupGloo::Barrier(
   std::shared_ptr<BarrierGlooTask> task;
   auto comm_context = this->GetCommContext();
   task = std::make_shared<BarrierGlooTask>(rank_, comm_context);
-  task->Run();
+  RunTask(task, true);
   return task;
 }
 
@@ -463,7 +606,7 @@ std::shared_ptr<ProcessGroup::Task> ProcessGroupGloo::AllGather(
   auto comm_context = this->GetCommContext();
   task = std::make_shared<AllgatherGlooTask>(
       rank_, comm_context, in_tensors, out_tensors, tag);
-  task->Run();
+  RunTask(task, true);
   return task;
 }
 
@@ -523,7 +666,7 @@ std::shared_ptr<ProcessGroup::Task> ProcessGroupGloo::Reduce(
                                           opts.reduce_op,
                                           opts.root_rank,
                                           tag);
-  task->Run();
+  RunTask(task, true);
   return task;
 }
 
@@ -583,7 +726,7 @@ std::shared_ptr<ProcessGroup::Task> ProcessGroupGloo::Scatter(
   std::vector<phi::DenseTensor> out_wrapper{*out_tensor};
   task = std::make_shared<ScatterGlooTask>(
       rank_, comm_context, in_wrapper, out_wrapper, opts.root_rank, size_, tag);
-  task->Run();
+  RunTask(task, true);
   return task;
 }
 
@@ -643,7 +786,7 @@ std::shared_ptr<ProcessGroup::Task> ProcessGroupGloo::Gather(
   auto comm_context = this->GetCommContext();
   task = std::make_shared<GatherGlooTask>(
       rank_, comm_context, in_tensor, out_tensor, opts.root_rank, tag);
-  task->Run();
+  RunTask(task, true);
   return task;
 }
 
@@ -14,9 +14,13 @@
 
 #pragma once
 
+#include <condition_variable>
+#include <deque>
+#include <exception>
 #include <future>
 #include <memory>
 #include <mutex>
+#include <thread>
 
 #include "paddle/phi/backends/context_pool.h"
 #include "paddle/phi/core/distributed/collective/process_group.h"
@@ -40,12 +44,19 @@ class ProcessGroupGloo : public ProcessGroupWithoutStream {
     ~GlooTask() = default;
 
     virtual void Run() = 0;
-    bool Wait(std::chrono::milliseconds timeout) override { return true; }
-    bool IsCompleted() override { return true; }
-    void Synchronize() override {}
+    // Block until the task is completed, rethrow the error of Run if any.
+    bool Wait(std::chrono::milliseconds timeout = kWaitTimeout) override;
+    bool IsCompleted() override;
+    void Synchronize() override { Wait(); }
 
    protected:
     friend class ProcessGroupGloo;
+
+   private:
+    void RunAndComplete();
+
+    std::condition_variable cv_;
+    std::exception_ptr exception_;
   };
 
   class GlooStore : public ::gloo::rendezvous::Store {
@@ -89,7 +100,7 @@ class ProcessGroupGloo : public ProcessGroupWithoutStream {
       int world_size,
       int gid);
 
-  ~ProcessGroupGloo() = default;
+  ~ProcessGroupGloo();
 
   std::shared_ptr<ProcessGroup::Task> AllGather(
       phi::DenseTensor* out_tensor,
@@ -213,6 +224,19 @@ class ProcessGroupGloo : public ProcessGroupWithoutStream {
   static std::shared_ptr<::gloo::transport::Device> createDefaultDevice();
 
  private:
+  // Tasks with sync_op false run on a communication thread in the order they
+  // are created, the other tasks run in the calling thread after the pending
+  // ones, so every rank issues the collectives in the same order.
+  void RunTask(const std::shared_ptr<GlooTask>& task, bool sync_op);
+  void CommLoop();
+
+  std::mutex _queue_mutex;
+  std::condition_variable _queue_cv;
+  std::deque<std::shared_ptr<GlooTask>> _queue;
+  std::shared_ptr<GlooTask> _last_async_task;
+  bool _stop{false};
+  std::thread _comm_thread;
+
   uint32_t _tag;
   std::shared_ptr<gloo::rendezvous::Context> _context;
   std::shared_ptr<::gloo::rendezvous::Store> _store;
@@ -53,6 +53,10 @@ class GlooCommContext final : public CommContext {
                  const phi::DenseTensor& in_tensor,
                  uint32_t tag = 0);
 
+  void AllToAll(phi::DenseTensor* out_tensor,
+                const phi::DenseTensor& in_tensor,
+                uint32_t tag = 0);
+
   void Gather(phi::DenseTensor* out_tensor,
               const phi::DenseTensor& in_tensor,
               int src,
@@ -18,6 +18,7 @@
 #include <cstdint>
 #include <vector>
 
+#include "paddle/phi/common/data_type.h"
 #include "paddle/phi/common/place.h"
 
 namespace phi {
@@ -29,6 +30,9 @@ enum class ReduceOp : std::uint8_t { SUM = 0, MAX, MIN, PRODUCT, AVG };
 
 struct AllreduceOptions {
   ReduceOp reduce_op = ReduceOp::SUM;
+  // data type sent over the wire for float32 tensors, UNDEFINED means no
+  // conversion. Only supported by the gloo process group.
+  phi::DataType comm_dtype = phi::DataType::UNDEFINED;
 };
 
 struct BroadcastOptions {
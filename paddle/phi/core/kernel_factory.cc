@@ -18,12 +18,14 @@
 #include "paddle/common/flags.h"
 #include "paddle/phi/core/enforce.h"
 #if defined(PADDLE_WITH_XPU)
+#include "paddle/phi/backends/xpu/xpu_info.h"
 #include "paddle/phi/backends/xpu/xpu_op_list.h"
 #include "paddle/phi/common/data_type.h"
 #include "paddle/phi/core/compat/convert_utils.h"
 #endif
 #if defined(PADDLE_WITH_CUSTOM_DEVICE)
 #include "paddle/phi/backends/custom/custom_device_op_list.h"
+#include "paddle/phi/core/compat/convert_utils.h"
 #endif
 #include "paddle/phi/core/compat/op_utils.h"
 #include "paddle/utils/string/string_helper.h"
@@ -368,6 +370,50 @@ KernelResult KernelFactory::SelectKernelOrThrowError(
   return {kernel_iter->second, false, false};
 }
 
+// The flags read by SelectKernelOrThrowError. The xpu op lists and the
+// black lists of xpu and custom devices it also checks are read once per
+// process, so for a call site their outcome only depends on the dtype of the
+// kernel key and, on xpu, on the version of the current device. They are
+// not evaluated here, the cached kernel is their outcome.
+static uint32_t KernelSelectionFlags() {
+  uint32_t flags = 0;
+  flags |= FLAGS_use_stride_kernel ? 1u : 0u;
+  flags |= FLAGS_enable_api_kernel_fallback ? 2u : 0u;
+#if defined(PADDLE_WITH_XPU_KP)
+  flags |= FLAGS_run_kp_kernel ? 4u : 0u;
+#endif
+  return flags;
+}
+
+KernelResult KernelSelectionCache::Select(const KernelKey& kernel_key,
+                                          bool use_strided_kernel) {
+  auto& factory = KernelFactory::Instance();
+  const uint64_t kernels_version = factory.KernelsVersion();
+  const uint32_t flags = KernelSelectionFlags();
+#if defined(PADDLE_WITH_XPU)
+  const int device_id = phi::backends::xpu::GetXPUCurrentDeviceId();
+#else
+  const int device_id = -1;
+#endif
+  if (kernel_ != nullptr && kernel_key_ == kernel_key &&
+      use_strided_kernel_ == use_strided_kernel && flags_ == flags &&
+      device_id_ == device_id && kernels_version_ == kernels_version) {
+    return {*kernel_, has_fallback_cpu_, is_stride_kernel_};
+  }
+
+  auto result = factory.SelectKernelOrThrowError(
+      kernel_name_, kernel_key, use_strided_kernel);
+  kernel_ = &result.kernel;
+  kernel_key_ = kernel_key;
+  use_strided_kernel_ = use_strided_kernel;
+  flags_ = flags;
+  device_id_ = device_id;
+  kernels_version_ = kernels_version;
+  has_fallback_cpu_ = result.has_fallback_cpu;
+  is_stride_kernel_ = result.is_stride_kernel;
+  return result;
+}
+
 const KernelArgsDef& KernelFactory::GetFirstKernelArgsDef(
     const std::string& kernel_name) const {
   auto iter = kernels_.find(kernel_name);
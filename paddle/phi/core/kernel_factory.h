@@ -14,6 +14,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <map>
 #include <ostream>
 #include <unordered_map>
@@ -348,15 +349,57 @@ class KernelFactory {
 
   void ClearLowPrecisionKernelList() { low_precision_kernels_.clear(); }
 
+  // Must be increased after kernels() is changed, since the cached results
+  // of KernelSelectionCache refer to the kernels in the map.
+  uint64_t KernelsVersion() const {
+    return kernels_version_.load(std::memory_order_acquire);
+  }
+
+  void IncreaseKernelsVersion() {
+    kernels_version_.fetch_add(1, std::memory_order_acq_rel);
+  }
+
  private:
   KernelFactory() = default;
 
   KernelNameMap kernels_;
 
+  std::atomic<uint64_t> kernels_version_{0};
+
   // Get the low precision kernel list of current module.
   std::map<const std::string, OpCount> low_precision_kernels_;
 };
 
+/**
+ * Note: The inline cache of KernelFactory::SelectKernelOrThrowError for one
+ *       call site, such as a generated api. It keeps the result of the last
+ *       kernel key, so a repeated selection skips the lookups by kernel name
+ *       and kernel key. The result is selected again if the kernel key, the
+ *       registered kernels, the flags used by the selection or, on xpu, the
+ *       current device change.
+ *       It is not thread safe, use a thread_local one in multithreading.
+ */
+class KernelSelectionCache {
+ public:
+  explicit KernelSelectionCache(const char* kernel_name)
+      : kernel_name_(kernel_name) {}
+
+  KernelResult Select(const KernelKey& kernel_key,
+                      bool use_strided_kernel = false);
+
+ private:
+  std::string kernel_name_;
+
+  const Kernel* kernel_{nullptr};
+  KernelKey kernel_key_;
+  bool use_strided_kernel_{false};
+  uint32_t flags_{0};
+  int device_id_{-1};
+  uint64_t kernels_version_{0};
+  bool has_fallback_cpu_{false};
+  bool is_stride_kernel_{false};
+};
+
 inline std::ostream& operator<<(std::ostream& os, const KernelKey& kernel_key) {
   os << "(" << kernel_key.backend() << ", " << kernel_key.layout() << ", "
      << kernel_key.dtype() << ")";
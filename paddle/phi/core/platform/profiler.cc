@@ -26,6 +26,7 @@
 #include "paddle/fluid/platform/profiler/host_tracer.h"
 #include "paddle/fluid/platform/profiler/profiler.h"
 #include "paddle/phi/api/profiler/device_tracer.h"
+#include "paddle/phi/api/profiler/host_event_stream.h"
 #include "paddle/phi/core/platform/profiler_helper.h"
 #ifdef PADDLE_WITH_CUDA
 #include "paddle/phi/backends/dynload/nvtx.h"
@@ -65,6 +66,11 @@ RecordInstantEvent::RecordInstantEvent(const char *name,
     return;
   }
   auto start_end_ns = phi::PosixInNsec();
+  if (UNLIKELY(phi::HostEventStream::IsEnabled())) {
+    phi::HostEventStream::GetInstance().Record(
+        name, start_end_ns, start_end_ns, type);
+    return;
+  }
   HostEventRecorder<CommonEvent>::GetInstance().RecordEvent(
       name, start_end_ns, start_end_ns, EventRole::kOrdinary, type);
 }
@@ -5867,11 +5867,11 @@ void WeightQuantizeInferMeta(const MetaTensor& x,
                              MetaTensor* scale) {
 #ifndef PADDLE_WITH_HIP
   PADDLE_ENFORCE_EQ(
-      ((arch == 70) || (arch == 75) || (arch == 80) || (arch == 86) ||
-       (arch == 89) || (arch == 90)),
+      ((arch == 0) || (arch == 70) || (arch == 75) || (arch == 80) ||
+       (arch == 86) || (arch == 89) || (arch == 90)),
       true,
       common::errors::InvalidArgument(
-          "Currently, arch only support 70, 75, 80, 86, 89, 90."));
+          "Currently, arch only support 0 (cpu), 70, 75, 80, 86, 89, 90."));
 #endif
 
   auto x_dims = x.dims();
@@ -14,9 +14,24 @@
 
 #include "paddle/phi/kernels/autotune/cache.h"
 
+#include <cctype>
+#include <cstdio>
+#include <fstream>
 #include <iomanip>
+#include <sstream>
 
 #include "glog/logging.h"
+#include "paddle/common/flags.h"
+#include "paddle/phi/backends/cpu/cpu_info.h"
+#include "paddle/phi/core/os_info.h"
+
+#ifdef PADDLE_WITH_MKLML
+#include "paddle/phi/backends/dynload/mklml.h"
+#elif defined(PADDLE_USE_OPENBLAS)
+#include <cblas.h>
+#endif
+
+COMMON_DECLARE_string(cpu_autotune_cache_file);
 
 namespace phi::autotune {
 
@@ -36,6 +51,8 @@ std::string AlgorithmTypeString(int64_t algo_type) {
   } else if (algo_type ==
              static_cast<int64_t>(AlgorithmType::kConvBackwardFilter)) {
     return "conv_backward_filter";
+  } else if (algo_type == static_cast<int64_t>(AlgorithmType::kCpuMatmul)) {
+    return "cpu_matmul";
   }
 #ifdef PADDLE_WITH_CUDNN_FRONTEND
   if (algo_type == static_cast<int64_t>(AlgorithmType::kConvForwardV8)) {
@@ -66,6 +83,149 @@ std::string AlgorithmTypeString(int64_t algo_type) {
   return std::to_string(algo_type);
 }
 
+std::string CpuAutoTuneTag() {
+  std::string model = "unknown";
+  std::ifstream cpuinfo("/proc/cpuinfo");
+  std::string line;
+  while (std::getline(cpuinfo, line)) {
+    if (line.compare(0, 10, "model name") == 0) {
+      auto pos = line.find(':');
+      if (pos != std::string::npos && pos + 2 <= line.size()) {
+        model = line.substr(pos + 2);
+      }
+      break;
+    }
+  }
+
+  namespace cpu = phi::backends::cpu;
+  const std::vector<std::pair<cpu::cpu_isa_t, const char*>> isas = {
+      {cpu::sse42, "sse42"},
+      {cpu::avx, "avx"},
+      {cpu::avx2, "avx2"},
+      {cpu::avx512f, "avx512f"},
+      {cpu::avx512_core, "avx512_core"},
+      {cpu::avx512_core_vnni, "avx512_core_vnni"},
+      {cpu::avx512_bf16, "avx512_bf16"}};
+  std::string tag = model;
+  for (auto& isa : isas) {
+    if (cpu::MayIUse(isa.first)) {
+      tag += std::string("+") + isa.second;
+    }
+  }
+  // the tag is the first field of a record of the cache file
+  for (auto& c : tag) {
+    if (std::isspace(static_cast<unsigned char>(c))) {
+      c = '_';
+    }
+  }
+  return tag;
+}
+
+int CpuMathLibraryNumThreads() {
+#ifdef PADDLE_WITH_MKLML
+  return phi::dynload::MKL_Get_Max_Threads();
+#elif defined(PADDLE_USE_OPENBLAS)
+  return openblas_get_num_threads();
+#else
+  return 1;
+#endif
+}
+
+// Each line of FLAGS_cpu_autotune_cache_file is a record of
+//   <CpuAutoTuneTag()> <algorithm type name> <key> <algorithm>
+void AutoTuneCache::LoadCpuCache() {
+  std::lock_guard<std::mutex> lock(*autotune_cache_mutex_);
+  if (cpu_cache_loaded_) {
+    return;
+  }
+  cpu_cache_loaded_ = true;
+  if (FLAGS_cpu_autotune_cache_file.empty()) {
+    return;
+  }
+  std::ifstream fin(FLAGS_cpu_autotune_cache_file);
+  if (!fin.is_open()) {
+    VLOG(3) << "No CPU autotuning results in "
+            << FLAGS_cpu_autotune_cache_file;
+    return;
+  }
+
+  std::unordered_map<std::string, int64_t> types;
+  for (auto& v : cpu_auto_tune_map_) {
+    types[AlgorithmTypeString(v.first)] = v.first;
+  }
+  const std::string tag = CpuAutoTuneTag();
+  int64_t count = 0;
+  std::string line;
+  while (std::getline(fin, line)) {
+    std::istringstream record(line);
+    std::string record_tag;
+    std::string type;
+    size_t key = 0;
+    int64_t algo = 0;
+    if (!(record >> record_tag >> type >> key >> algo) || record_tag != tag ||
+        types.count(type) == 0) {
+      continue;
+    }
+    cpu_auto_tune_map_.at(types[type]).Set(key, algo);
+    ++count;
+  }
+  VLOG(3) << "Load " << count << " CPU autotuning results of " << tag
+          << " from " << FLAGS_cpu_autotune_cache_file;
+}
+
+void AutoTuneCache::SaveCpuCache() {
+  if (FLAGS_cpu_autotune_cache_file.empty()) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(*autotune_cache_mutex_);
+  const std::string& path = FLAGS_cpu_autotune_cache_file;
+  const std::string tag = CpuAutoTuneTag();
+
+  // keep the records of other CPUs
+  std::vector<std::string> lines;
+  std::ifstream fin(path);
+  std::string line;
+  while (std::getline(fin, line)) {
+    std::istringstream record(line);
+    std::string record_tag;
+    if (record >> record_tag && record_tag != tag) {
+      lines.push_back(line);
+    }
+  }
+  fin.close();
+
+  // write a temporary file and rename it, so that processes sharing the
+  // file never read a partial one
+  const std::string tmp_path =
+      path + ".tmp" + std::to_string(phi::GetProcessId());
+  std::ofstream fout(tmp_path, std::ios::trunc);
+  if (!fout.is_open()) {
+    LOG(WARNING) << "Cannot write the CPU autotuning results to " << tmp_path;
+    return;
+  }
+  for (auto& l : lines) {
+    fout << l << "\n";
+  }
+  int64_t count = 0;
+  for (auto& v : cpu_auto_tune_map_) {
+    const std::string type = AlgorithmTypeString(v.first);
+    for (auto& entry : v.second.Entries()) {
+      fout << tag << " " << type << " " << entry.first << " " << entry.second
+           << "\n";
+      ++count;
+    }
+  }
+  fout.close();
+  if (!fout || std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+    LOG(WARNING) << "Cannot write the CPU autotuning results to " << path;
+    std::remove(tmp_path.c_str());
+    return;
+  }
+  cpu_cache_updated_ = false;
+  VLOG(3) << "Save " << count << " CPU autotuning results of " << tag
+          << " to " << path;
+}
+
 void AutoTuneCache::UpdateStatus() {
   int64_t size = 0;
   int64_t cache_hits = 0;
@@ -96,6 +256,23 @@ void AutoTuneCache::UpdateStatus() {
     cache_misses += v.second.CacheMisses();
   }
 
+  for (auto& v : cpu_auto_tune_map_) {
+    std::ostringstream chosen;
+    for (auto& count : v.second.ChosenCounts()) {
+      chosen << " " << count.first << ":" << count.second;
+    }
+    VLOG(4) << "AlgoType: " << std::setfill(' ') << std::setw(name_width)
+            << AlgorithmTypeString(v.first)
+            << " Cache Size: " << v.second.Size()
+            << " Hits: " << v.second.CacheHits()
+            << " Misses: " << v.second.CacheMisses()
+            << " Hit Rate: " << v.second.CacheHitRate()
+            << " Chosen (algo:times):" << chosen.str();
+    size += v.second.Size();
+    cache_hits += v.second.CacheHits();
+    cache_misses += v.second.CacheMisses();
+  }
+
 #ifdef PADDLE_WITH_CUDNN_FRONTEND
   for (auto& v : cudnn_v8_auto_tune_map_) {
     VLOG(4) << "AlgoType: " << std::setfill(' ') << std::setw(name_width)
@@ -16,6 +16,7 @@
 
 #include <algorithm>
 #include <numeric>
+#include <string>
 
 #include "paddle/phi/common/data_type.h"
 #include "paddle/phi/kernels/autotune/cache_base.h"
@@ -49,24 +50,41 @@ enum class AlgorithmType {
   kGatherGemmScatterFP32NN = 7,
   kGatherGemmScatterFP32TN = 8,
   kGatherGemmScatterFP32NT = 9,
+  kCpuMatmul = 10,
 #if !defined(PADDLE_WITH_CUDNN_FRONTEND)
-  kAlgorithmCount = 10
+  kAlgorithmCount = 11
 #else
-  kConvForwardV8 = 10,
-  kConvBackwardDataV8 = 11,
-  kConvBackwardFilterV8 = 12,
-  kScaleBiasReluConvBNstats = 13,
-  kBNFinalize = 14,
-  kScaleBiasAddRelu = 15,
-  kDgradDreluBnBwdWeight = 16,
-  kDbnApply = 17,
-  kBnActWgrad = 18,
-  kPoolingForwardV8 = 19,
-  kPoolingBackwardV8 = 20,
-  kAlgorithmCount = 21
+  kConvForwardV8 = 11,
+  kConvBackwardDataV8 = 12,
+  kConvBackwardFilterV8 = 13,
+  kScaleBiasReluConvBNstats = 14,
+  kBNFinalize = 15,
+  kScaleBiasAddRelu = 16,
+  kDgradDreluBnBwdWeight = 17,
+  kDbnApply = 18,
+  kBnActWgrad = 19,
+  kPoolingForwardV8 = 20,
+  kPoolingBackwardV8 = 21,
+  kAlgorithmCount = 22
 #endif
 };
 
+std::string AlgorithmTypeString(int64_t algo_type);
+
+// The algorithms tuned on CPU by CpuAutoTuner, whose results are persisted.
+inline bool IsCpuAlgorithm(const AlgorithmType& algo_type) {
+  return algo_type == AlgorithmType::kCpuMatmul;
+}
+
+// CPU model and instruction sets, which the persisted CPU autotuning results
+// are keyed by.
+std::string CpuAutoTuneTag();
+
+// The number of threads of the cpu math library, which the blas candidates
+// run with. It can change at runtime, e.g. by SetNumThreads of a predictor,
+// so it is a part of the keys of the CPU autotuning results.
+int CpuMathLibraryNumThreads();
+
 // AlgorithmsConfigKey -> AlgorithmsID
 // AlgorithmType -> AlgorithmsCache
 using AlgorithmsCacheMap = AlgorithmsCache<size_t, int64_t>;
@@ -78,6 +96,8 @@ using ConvAlgorithmsTypeMap =
     std::unordered_map<int64_t, ConvAlgorithmsCacheMap>;
 
 using MatmulAlgorithmsCacheMap = MatmulAlgorithmsCache<size_t, int64_t>;
+using CpuAlgorithmsCacheMap = CpuAlgorithmsCache<size_t, int64_t>;
+using CpuAlgorithmsTypeMap = std::unordered_map<int64_t, CpuAlgorithmsCacheMap>;
 #ifdef PADDLE_WITH_CUDNN_FRONTEND
 using CudnnV8AlgorithmsTypeMap =
     std::unordered_map<int64_t, CudnnFrontendPlanCache>;
@@ -101,6 +121,13 @@ class AutoTuneCache {
     return autotune_cache;
   }
 
+  // Saves the CPU autotuning results not saved yet.
+  ~AutoTuneCache() {
+    if (cpu_cache_updated_) {
+      SaveCpuCache();
+    }
+  }
+
   AlgorithmsCacheMap& Get(const AlgorithmType& algo_type) {
     return auto_tune_map_[static_cast<int64_t>(algo_type)];
   }
@@ -110,6 +137,32 @@ class AutoTuneCache {
   ConvAlgorithmsCacheMap& GetConv(const AlgorithmType& algo_type) {
     return conv_auto_tune_map_[static_cast<int64_t>(algo_type)];
   }
+  // The results persisted in FLAGS_cpu_autotune_cache_file are loaded on
+  // the first call.
+  CpuAlgorithmsCacheMap& GetCpu(const AlgorithmType& algo_type) {
+    LoadCpuCache();
+    std::lock_guard<std::mutex> lock(*autotune_cache_mutex_);
+    auto iter = cpu_auto_tune_map_.find(static_cast<int64_t>(algo_type));
+    PADDLE_ENFORCE_NE(
+        iter,
+        cpu_auto_tune_map_.end(),
+        common::errors::InvalidArgument(
+            "AlgorithmType %s is not tuned on CPU.",
+            AlgorithmTypeString(static_cast<int64_t>(algo_type))));
+    return iter->second;
+  }
+
+  // Called by CpuAutoTuner when a new result is tuned. The new results are
+  // saved in batch, by SaveCpuCache or at exit.
+  void MarkCpuCacheUpdated() {
+    std::lock_guard<std::mutex> lock(*autotune_cache_mutex_);
+    cpu_cache_updated_ = true;
+  }
+
+  // Writes the CPU autotuning results to FLAGS_cpu_autotune_cache_file, the
+  // records of other CPUs in the file are kept.
+  void SaveCpuCache();
+
   DEFINE_GET_GATHER_GEMM_SCATTER(phi::dtype::float16,
                                  false,
                                  false,
@@ -142,6 +195,16 @@ class AutoTuneCache {
       v.second.Clean();
     }
 
+    // The persisted results are loaded again on the next GetCpu.
+    {
+      std::lock_guard<std::mutex> lock(*autotune_cache_mutex_);
+      for (auto& v : cpu_auto_tune_map_) {
+        v.second.Clean();
+      }
+      cpu_cache_loaded_ = false;
+      cpu_cache_updated_ = false;
+    }
+
 #ifdef PADDLE_WITH_CUDNN_FRONTEND
     for (auto& v : cudnn_v8_auto_tune_map_) {
       v.second.Clean();
@@ -185,6 +248,12 @@ class AutoTuneCache {
         ConvAlgorithmsCacheMap cache;
         conv_auto_tune_map_[key] = cache;
       }
+    } else if (IsCpuAlgorithm(algo_type)) {
+      int64_t key = static_cast<int64_t>(algo_type);
+      if (cpu_auto_tune_map_.find(key) == cpu_auto_tune_map_.end()) {
+        CpuAlgorithmsCacheMap cache;
+        cpu_auto_tune_map_[key] = cache;
+      }
 #ifdef PADDLE_WITH_CUDNN_FRONTEND
     } else if (algo_type >= AlgorithmType::kConvForwardV8 &&
                algo_type < AlgorithmType::kAlgorithmCount) {
@@ -203,9 +272,14 @@ class AutoTuneCache {
     }
   }
 
+  void LoadCpuCache();
+
   AlgorithmsTypeMap auto_tune_map_;
   ConvAlgorithmsTypeMap conv_auto_tune_map_;
   MatmulAlgorithmsCacheMap matmul_auto_tune_map_;
+  CpuAlgorithmsTypeMap cpu_auto_tune_map_;
+  bool cpu_cache_loaded_{false};
+  bool cpu_cache_updated_{false};
 #ifdef PADDLE_WITH_CUDNN_FRONTEND
   CudnnV8AlgorithmsTypeMap cudnn_v8_auto_tune_map_;
 #endif
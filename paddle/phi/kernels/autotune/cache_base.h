@@ -16,6 +16,7 @@
 
 #include <mutex>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "paddle/common/errors.h"
@@ -217,5 +218,54 @@ class MatmulAlgorithmsCache : public AlgorithmsCache<KeyT, AlgorithmT> {
   std::unordered_map<KeyT, void*> sub_hash_;
 };
 
+// Cache of the algorithms tuned on CPU. It counts how many times each
+// algorithm is chosen, and its entries are persisted by AutoTuneCache.
+template <typename KeyT, typename AlgorithmT>
+class CpuAlgorithmsCache : public AlgorithmsCache<KeyT, AlgorithmT> {
+ public:
+  CpuAlgorithmsCache() : AlgorithmsCache<KeyT, AlgorithmT>() {}
+
+  AlgorithmT Get(const KeyT& key) {
+    std::lock_guard<std::mutex> lock(*(this->cache_mutex_));
+    auto iter = this->hash_.find(key);
+    PADDLE_ENFORCE_NE(
+        iter,
+        this->hash_.end(),
+        common::errors::PreconditionNotMet("The key does not exist."));
+    chosen_counts_[iter->second]++;
+    return iter->second;
+  }
+
+  void Set(const KeyT& key, AlgorithmT algo) {
+    std::lock_guard<std::mutex> lock(*(this->cache_mutex_));
+    if (this->hash_.size() >
+        static_cast<size_t>(FLAGS_search_cache_max_number)) {
+      this->hash_.clear();
+    }
+    this->hash_[key] = algo;
+  }
+
+  void Clean() {
+    AlgorithmsCache<KeyT, AlgorithmT>::Clean();
+    std::lock_guard<std::mutex> lock(*(this->cache_mutex_));
+    chosen_counts_.clear();
+  }
+
+  // algorithm -> number of times it is chosen by a cache hit
+  std::unordered_map<AlgorithmT, int64_t> ChosenCounts() const {
+    std::lock_guard<std::mutex> lock(*(this->cache_mutex_));
+    return chosen_counts_;
+  }
+
+  std::vector<std::pair<KeyT, AlgorithmT>> Entries() const {
+    std::lock_guard<std::mutex> lock(*(this->cache_mutex_));
+    return std::vector<std::pair<KeyT, AlgorithmT>>(this->hash_.begin(),
+                                                    this->hash_.end());
+  }
+
+ private:
+  std::unordered_map<AlgorithmT, int64_t> chosen_counts_;
+};
+
 }  // namespace autotune
 }  // namespace phi
@@ -0,0 +1,158 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <chrono>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "glog/logging.h"
+#include "paddle/common/flags.h"
+#include "paddle/phi/kernels/autotune/cache.h"
+
+COMMON_DECLARE_bool(use_cpu_autotune);
+
+namespace phi {
+namespace autotune {
+
+// The number of timed calls of each candidate, after a warmup call.
+constexpr int kCpuAutoTuneRepeats = 3;
+
+// Picks the fastest of several CPU kernels with the same signature for each
+// key. Unlike AutoTuneBase, the candidates are not run back to back on one
+// call, which would write the output several times and accumulate into it
+// for kernels adding to the output. Instead the first calls of a key run the
+// candidates in turn, one per call, and time them. Once every candidate has
+// run kCpuAutoTuneRepeats times after its warmup call, the fastest one is
+// cached. The new results are saved in batch by AutoTuneCache::SaveCpuCache,
+// which is also called at exit.
+template <typename T, typename ReturnType, typename... Args>
+class CpuAutoTuner {
+ public:
+  using KernelType = ReturnType (*)(Args...);
+
+  // The candidates are registered once, func is the default one.
+  template <typename... Funcs>
+  static CpuAutoTuner<T, ReturnType, Args...>* Instance(KernelType func,
+                                                        Funcs... funcs) {
+    static std::once_flag cpu_init_flag;
+    static std::unique_ptr<CpuAutoTuner<T, ReturnType, Args...>> instance;
+    std::call_once(cpu_init_flag, [&] {
+      instance.reset(new CpuAutoTuner<T, ReturnType, Args...>);
+      instance->kernels_ = {func, funcs...};
+    });
+    return instance.get();
+  }
+
+  void Run(const AlgorithmType& algo, const size_t key, Args... args) {
+    auto& cache = AutoTuneCache::Instance().GetCpu(algo);
+    if (cache.Find(key)) {
+      int64_t best_idx = cache.Get(key);
+      if (best_idx < 0 || best_idx >= static_cast<int64_t>(kernels_.size())) {
+        // e.g. loaded from a stale FLAGS_cpu_autotune_cache_file
+        VLOG(3) << "cpu kernel idx " << best_idx << " is out of range, use "
+                << "the default kernel instead";
+        best_idx = 0;
+        cache.Set(key, best_idx);
+        AutoTuneCache::Instance().MarkCpuCacheUpdated();
+      }
+      kernels_[best_idx](args...);
+      return;
+    }
+    if (!FLAGS_use_cpu_autotune || kernels_.size() == 1) {
+      kernels_[0](args...);
+      return;
+    }
+
+    size_t idx = NextCandidate(key);
+    auto start = std::chrono::steady_clock::now();
+    kernels_[idx](args...);
+    std::chrono::duration<double, std::milli> time =
+        std::chrono::steady_clock::now() - start;
+    int64_t best_idx = RecordTime(key, idx, time.count());
+    if (best_idx >= 0) {
+      cache.Set(key, best_idx);
+      AutoTuneCache::Instance().MarkCpuCacheUpdated();
+    }
+  }
+
+ private:
+  struct Trials {
+    explicit Trials(size_t num_kernels)
+        : runs(num_kernels, 0), time_cost(num_kernels, 0.) {}
+
+    size_t next{0};
+    std::vector<int> runs;
+    std::vector<double> time_cost;
+  };
+
+  size_t NextCandidate(const size_t key) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto iter = trials_.find(key);
+    if (iter == trials_.end()) {
+      iter = trials_.emplace(key, Trials(kernels_.size())).first;
+    }
+    size_t idx = iter->second.next;
+    iter->second.next = (idx + 1) % kernels_.size();
+    return idx;
+  }
+
+  // Returns the best kernel of the key once all candidates are timed, or -1.
+  int64_t RecordTime(const size_t key, const size_t idx, const double time) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto iter = trials_.find(key);
+    if (iter == trials_.end()) {
+      // tuned by another thread
+      return -1;
+    }
+    auto& trials = iter->second;
+    // regard the first run as warmup
+    if (trials.runs[idx]++ > 0) {
+      trials.time_cost[idx] += time;
+    }
+    VLOG(3) << "cpu kernel[" << idx << "][" << trials.runs[idx]
+            << "th time cost is " << time << " ms";
+    int64_t best_idx = 0;
+    double min_time = std::numeric_limits<double>::max();
+    for (size_t i = 0; i < kernels_.size(); ++i) {
+      if (trials.runs[i] <= kCpuAutoTuneRepeats) {
+        return -1;
+      }
+      if (trials.time_cost[i] < min_time) {
+        min_time = trials.time_cost[i];
+        best_idx = static_cast<int64_t>(i);
+      }
+    }
+    trials_.erase(iter);
+    VLOG(3) << "best cpu kernel idx is " << best_idx;
+    return best_idx;
+  }
+
+  std::vector<KernelType> kernels_;
+  std::unordered_map<size_t, Trials> trials_;
+  mutable std::mutex mutex_;
+};
+
+template <typename T, typename ReturnType, typename... Args, typename... Funcs>
+static CpuAutoTuner<T, ReturnType, Args...>* MakeCpuTuner(
+    ReturnType (*func)(Args...), Funcs... funcs) {
+  return CpuAutoTuner<T, ReturnType, Args...>::Instance(func, funcs...);
+}
+
+}  // namespace autotune
+}  // namespace phi
@@ -16,6 +16,9 @@
 
 #include "paddle/phi/backends/all_context.h"
 #include "paddle/phi/core/kernel_registry.h"
+#if defined(PADDLE_WITH_GLOO)
+#include "paddle/phi/core/distributed/gloo_comm_context.h"
+#endif
 #ifdef PADDLE_WITH_CUSTOM_DEVICE
 #include "paddle/phi/core/distributed/xccl_comm_context.h"
 #endif
@@ -23,11 +26,31 @@
 namespace phi {
 
 template <typename T, typename Context>
-void AllToAllKernel(const Context& dev_ctx UNUSED,
-                    const DenseTensor& x UNUSED,
-                    DenseTensor* out UNUSED) {
-  PADDLE_THROW(
-      errors::Unimplemented("Unimplemented cpu kernel for all_to_all."));
+void AllToAllKernel(const Context& dev_ctx,
+                    const DenseTensor& x,
+                    DenseTensor* out) {
+#if defined(PADDLE_WITH_GLOO)
+  out->Resize(x.dims());
+  dev_ctx.template Alloc<T>(out);
+  auto comm_ctx =
+      static_cast<distributed::GlooCommContext*>(dev_ctx.GetCommContext());
+  PADDLE_ENFORCE_NE(
+      comm_ctx,
+      nullptr,
+      errors::Unavailable("GlooCommContext is nullptr, please check whether "
+                          "the communication context is initialized."));
+  PADDLE_ENFORCE_EQ(
+      x.numel() % comm_ctx->GetSize(),
+      0,
+      errors::InvalidArgument("The numel of x (%d) should be divisible by "
+                              "the number of ranks (%d).",
+                              x.numel(),
+                              comm_ctx->GetSize()));
+  comm_ctx->AllToAll(out, x);
+#else
+  PADDLE_THROW(errors::Unavailable(
+      "PaddlePaddle should compile with GLOO by setting WITH_GLOO=ON"));
+#endif
 }
 #ifdef PADDLE_WITH_CUSTOM_DEVICE
 template <typename T>
@@ -18,49 +18,10 @@
 #include "paddle/phi/backends/cpu/cpu_context.h"
 #include "paddle/phi/core/dense_tensor.h"
 #include "paddle/phi/core/kernel_registry.h"
+#include "paddle/phi/kernels/funcs/detection/batched_nms.h"
 
 namespace phi {
 
-template <class T>
-static inline T BBoxArea(const T* box, const bool normalized) {
-  if (box[2] < box[0] || box[3] < box[1]) {
-    // If coordinate values are invalid
-    // (e.g. xmax < xmin or ymax < ymin), return 0.
-    return static_cast<T>(0.);
-  } else {
-    const T w = box[2] - box[0];
-    const T h = box[3] - box[1];
-    if (normalized) {
-      return w * h;
-    } else {
-      // If coordinate values are not within range [0, 1].
-      return (w + 1) * (h + 1);
-    }
-  }
-}
-
-template <class T>
-static inline T JaccardOverlap(const T* box1,
-                               const T* box2,
-                               const bool normalized) {
-  if (box2[0] > box1[2] || box2[2] < box1[0] || box2[1] > box1[3] ||
-      box2[3] < box1[1]) {
-    return static_cast<T>(0.);
-  } else {
-    const T inter_xmin = std::max(box1[0], box2[0]);
-    const T inter_ymin = std::max(box1[1], box2[1]);
-    const T inter_xmax = std::min(box1[2], box2[2]);
-    const T inter_ymax = std::min(box1[3], box2[3]);
-    T norm = normalized ? static_cast<T>(0.) : static_cast<T>(1.);
-    T inter_w = inter_xmax - inter_xmin + norm;
-    T inter_h = inter_ymax - inter_ymin + norm;
-    const T inter_area = inter_w * inter_h;
-    const T bbox1_area = BBoxArea<T>(box1, normalized);
-    const T bbox2_area = BBoxArea<T>(box2, normalized);
-    return inter_area / (bbox1_area + bbox2_area - inter_area);
-  }
-}
-
 template <typename T, bool gaussian>
 struct decay_score;
 
@@ -79,8 +40,9 @@ struct decay_score<T, false> {
 };
 
 template <typename T, bool gaussian>
-void NMSMatrix(const DenseTensor& bbox,
-               const DenseTensor& scores,
+void NMSMatrix(const T* bbox_ptr,
+               const T* score_ptr,
+               const int64_t num_boxes,
                const T score_threshold,
                const T post_threshold,
                const float sigma,
@@ -88,24 +50,19 @@ void NMSMatrix(const DenseTensor& bbox,
                const bool normalized,
                std::vector<int>* selected_indices,
                std::vector<T>* decayed_scores) {
-  int64_t num_boxes = bbox.dims()[0];
-  int64_t box_size = bbox.dims()[1];
-
-  auto score_ptr = scores.data<T>();
-  auto bbox_ptr = bbox.data<T>();
-
   std::vector<int32_t> perm(num_boxes);
-  std::iota(perm.begin(), perm.end(), 0);
-  auto end = std::remove_if(
-      perm.begin(), perm.end(), [&score_ptr, score_threshold](int32_t idx) {
-        return score_ptr[idx] <= score_threshold;
-      });
+  int64_t num_pre = 0;
+  // branchless compaction of the boxes over score_threshold
+  for (int64_t i = 0; i < num_boxes; ++i) {
+    perm[num_pre] = static_cast<int32_t>(i);
+    num_pre += score_ptr[i] > score_threshold;
+  }
+  auto end = perm.begin() + num_pre;
 
   auto sort_fn = [&score_ptr](int32_t lhs, int32_t rhs) {
     return score_ptr[lhs] > score_ptr[rhs];
   };
 
-  int64_t num_pre = std::distance(perm.begin(), end);
   if (num_pre <= 0) {
     return;
   }
@@ -114,19 +71,23 @@ void NMSMatrix(const DenseTensor& bbox,
   }
   std::partial_sort(perm.begin(), perm.begin() + num_pre, end, sort_fn);
 
+  funcs::BoxesSoA<T> boxes;
+  boxes.Reserve(num_pre);
+  for (int64_t i = 0; i < num_pre; ++i) {
+    // [xmin, ymin, xmax, ymax]
+    boxes.Push(bbox_ptr + perm[i] * 4, normalized);
+  }
+
   std::vector<T> iou_matrix((num_pre * (num_pre - 1)) >> 1);
   std::vector<T> iou_max(num_pre);
 
   iou_max[0] = 0.;
   for (int64_t i = 1; i < num_pre; i++) {
+    T* iou_row = iou_matrix.data() + i * (i - 1) / 2;
+    funcs::BlockJaccardOverlap<T>(boxes, i, 0, i, normalized, iou_row);
     T max_iou = 0.;
-    auto idx_a = perm[i];
     for (int64_t j = 0; j < i; j++) {
-      auto idx_b = perm[j];
-      auto iou = JaccardOverlap<T>(
-          bbox_ptr + idx_a * box_size, bbox_ptr + idx_b * box_size, normalized);
-      max_iou = std::max(max_iou, iou);
-      iou_matrix[i * (i - 1) / 2 + j] = iou;
+      max_iou = std::max(max_iou, iou_row[j]);
     }
     iou_max[i] = max_iou;
   }
@@ -138,11 +99,10 @@ void NMSMatrix(const DenseTensor& bbox,
 
   decay_score<T, gaussian> decay_fn;
   for (int64_t i = 1; i < num_pre; i++) {
+    const T* iou_row = iou_matrix.data() + i * (i - 1) / 2;
     T min_decay = 1.;
     for (int64_t j = 0; j < i; j++) {
-      auto max_iou = iou_max[j];
-      auto iou = iou_matrix[i * (i - 1) / 2 + j];
-      auto decay = decay_fn(iou, max_iou, sigma);
+      auto decay = decay_fn(iou_row[j], iou_max[j], sigma);
       min_decay = std::min(min_decay, decay);
     }
     auto ds = min_decay * score_ptr[perm[i]];
@@ -152,59 +112,34 @@ void NMSMatrix(const DenseTensor& bbox,
   }
 }
 
+// Selected indices and decayed scores of one class of one image.
 template <typename T>
-size_t MultiClassMatrixNMS(const DenseTensor& scores,
-                           const DenseTensor& bboxes,
+struct MatrixNMSResult {
+  std::vector<int> indices;
+  std::vector<T> scores;
+};
+
+template <typename T>
+size_t MultiClassMatrixNMS(const DenseTensor& bboxes,
+                           std::vector<MatrixNMSResult<T>>* class_results,
                            std::vector<T>* out,
                            std::vector<int>* indices,
                            int start,
-                           int64_t background_label,
-                           int64_t nms_top_k,
-                           int64_t keep_top_k,
-                           bool normalized,
-                           T score_threshold,
-                           T post_threshold,
-                           bool use_gaussian,
-                           float gaussian_sigma) {
+                           int64_t keep_top_k) {
   std::vector<int> all_indices;
   std::vector<T> all_scores;
   std::vector<T> all_classes;
-  all_indices.reserve(scores.numel());
-  all_scores.reserve(scores.numel());
-  all_classes.reserve(scores.numel());
 
-  size_t num_det = 0;
-  auto class_num = scores.dims()[0];
-  DenseTensor score_slice;
-  for (int64_t c = 0; c < class_num; ++c) {
-    if (c == background_label) continue;
-    score_slice = scores.Slice(c, c + 1);
-    if (use_gaussian) {
-      NMSMatrix<T, true>(bboxes,
-                         score_slice,
-                         score_threshold,
-                         post_threshold,
-                         gaussian_sigma,
-                         nms_top_k,
-                         normalized,
-                         &all_indices,
-                         &all_scores);
-    } else {
-      NMSMatrix<T, false>(bboxes,
-                          score_slice,
-                          score_threshold,
-                          post_threshold,
-                          gaussian_sigma,
-                          nms_top_k,
-                          normalized,
-                          &all_indices,
-                          &all_scores);
-    }
-    for (size_t i = 0; i < all_indices.size() - num_det; i++) {
-      all_classes.push_back(static_cast<T>(c));
-    }
-    num_det = all_indices.size();
+  for (size_t c = 0; c < class_results->size(); ++c) {
+    auto& result = (*class_results)[c];
+    all_indices.insert(
+        all_indices.end(), result.indices.begin(), result.indices.end());
+    all_scores.insert(
+        all_scores.end(), result.scores.begin(), result.scores.end());
+    all_classes.insert(
+        all_classes.end(), result.indices.size(), static_cast<T>(c));
   }
+  size_t num_det = all_indices.size();
 
   if (num_det <= 0) {
     return num_det;
@@ -263,7 +198,46 @@ void MatrixNMSKernel(const Context& ctx,
   auto box_dim = bboxes.dims()[2];
   auto out_dim = box_dim + 2;
 
-  DenseTensor boxes_slice, scores_slice;
+  // NMS of all the classes of all the images are independent.
+  const int64_t class_num = score_dims[1];
+  std::vector<std::vector<MatrixNMSResult<T>>> class_results(
+      batch_size, std::vector<MatrixNMSResult<T>>(class_num));
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for schedule(dynamic)
+#endif
+  for (int64_t task = 0; task < batch_size * class_num; ++task) {
+    int64_t i = task / class_num;
+    int64_t c = task % class_num;
+    if (c == background_label) continue;
+    const T* bbox_ptr = bboxes.data<T>() + i * num_boxes * box_dim;
+    const T* score_ptr = scores.data<T>() + (i * class_num + c) * num_boxes;
+    auto& result = class_results[i][c];
+    if (use_gaussian) {
+      NMSMatrix<T, true>(bbox_ptr,
+                         score_ptr,
+                         num_boxes,
+                         static_cast<T>(score_threshold),
+                         static_cast<T>(post_threshold),
+                         gaussian_sigma,
+                         nms_top_k,
+                         normalized,
+                         &result.indices,
+                         &result.scores);
+    } else {
+      NMSMatrix<T, false>(bbox_ptr,
+                          score_ptr,
+                          num_boxes,
+                          static_cast<T>(score_threshold),
+                          static_cast<T>(post_threshold),
+                          gaussian_sigma,
+                          nms_top_k,
+                          normalized,
+                          &result.indices,
+                          &result.scores);
+    }
+  }
+
+  DenseTensor boxes_slice;
   size_t num_out = 0;
   std::vector<size_t> offsets = {0};
   std::vector<T> detections;
@@ -273,24 +247,15 @@ void MatrixNMSKernel(const Context& ctx,
   indices.reserve(num_boxes * batch_size);
   num_per_batch.reserve(batch_size);
   for (int i = 0; i < batch_size; ++i) {
-    scores_slice = scores.Slice(i, i + 1);
-    scores_slice.Resize({score_dims[1], score_dims[2]});
     boxes_slice = bboxes.Slice(i, i + 1);
     boxes_slice.Resize({score_dims[2], box_dim});
     int start = i * score_dims[2];
-    num_out = MultiClassMatrixNMS(scores_slice,
-                                  boxes_slice,
+    num_out = MultiClassMatrixNMS(boxes_slice,
+                                  &class_results[i],
                                   &detections,
                                   &indices,
                                   start,
-                                  background_label,
-                                  nms_top_k,
-                                  keep_top_k,
-                                  normalized,
-                                  static_cast<T>(score_threshold),
-                                  static_cast<T>(post_threshold),
-                                  use_gaussian,
-                                  gaussian_sigma);
+                                  keep_top_k);
     offsets.push_back(offsets.back() + num_out);
     num_per_batch.emplace_back(num_out);
   }
@@ -16,6 +16,7 @@
 
 #include "paddle/phi/core/kernel_registry.h"
 #include "paddle/phi/core/tensor_utils.h"
+#include "paddle/phi/kernels/funcs/detection/batched_nms.h"
 #include "paddle/phi/kernels/funcs/gpc.h"
 
 namespace phi {
@@ -327,57 +328,87 @@ void NMSFast(const DenseTensor& bbox,
   }
 }
 
+// NMS of class c of one image. [xmin ymin xmax ymax] boxes are read in place
+// by funcs::GreedyNMS, polygons go through NMSFast.
+template <typename T>
+void NMSOneClass(const DenseTensor& scores,
+                 const DenseTensor& bboxes,
+                 const int scores_size,
+                 const int c,
+                 const T score_threshold,
+                 const T nms_threshold,
+                 const T nms_eta,
+                 const int nms_top_k,
+                 const bool normalized,
+                 std::vector<int>* selected_indices) {
+  if (scores_size == 3) {
+    // scores: [C, M], bboxes: [M, box_size]
+    const int64_t num_boxes = scores.dims()[1];
+    const int64_t box_size = bboxes.dims()[1];
+    if (box_size == 4) {
+      funcs::GreedyNMS<T>(bboxes.data<T>(),
+                          box_size,
+                          scores.data<T>() + c * num_boxes,
+                          1,
+                          num_boxes,
+                          score_threshold,
+                          nms_threshold,
+                          nms_eta,
+                          nms_top_k,
+                          normalized,
+                          selected_indices);
+    } else {
+      NMSFast<T>(bboxes,
+                 scores.Slice(c, c + 1),
+                 score_threshold,
+                 nms_threshold,
+                 nms_eta,
+                 nms_top_k,
+                 selected_indices,
+                 normalized);
+    }
+  } else {
+    // scores: [M, C], bboxes: [M, C, 4]
+    const int64_t num_boxes = scores.dims()[0];
+    const int64_t class_num = scores.dims()[1];
+    funcs::GreedyNMS<T>(bboxes.data<T>() + c * 4,
+                        class_num * 4,
+                        scores.data<T>() + c,
+                        class_num,
+                        num_boxes,
+                        score_threshold,
+                        nms_threshold,
+                        nms_eta,
+                        nms_top_k,
+                        normalized,
+                        selected_indices);
+    std::sort(selected_indices->begin(), selected_indices->end());
+  }
+}
+
+// Keeps the top keep_top_k detections of one image over all the classes,
+// class_indices are the results of NMSOneClass.
 template <typename T, typename Context>
 void MultiClassNMS(const Context& ctx,
                    const DenseTensor& scores,
-                   const DenseTensor& bboxes,
                    const int scores_size,
-                   float scorethreshold,
-                   int nms_top_k,
                    int keep_top_k,
-                   float nmsthreshold,
-                   bool normalized,
-                   float nmseta,
                    int background_label,
+                   std::vector<std::vector<int>>* class_indices,
                    std::map<int, std::vector<int>>* indices,
                    int* num_nmsed_out) {
-  T nms_threshold = static_cast<T>(nmsthreshold);
-  T nms_eta = static_cast<T>(nmseta);
-  T score_threshold = static_cast<T>(scorethreshold);
-
   int num_det = 0;
-
-  int class_num =
-      static_cast<int>(scores_size == 3 ? scores.dims()[0] : scores.dims()[1]);
-  DenseTensor bbox_slice, score_slice;
+  int class_num = static_cast<int>(class_indices->size());
   for (int c = 0; c < class_num; ++c) {
     if (c == background_label) continue;
-    if (scores_size == 3) {
-      score_slice = scores.Slice(c, c + 1);
-      bbox_slice = bboxes;
-    } else {
-      score_slice.Resize({scores.dims()[0], 1});
-      bbox_slice.Resize({scores.dims()[0], 4});
-      SliceOneClass<T, Context>(ctx, scores, c, &score_slice);
-      SliceOneClass<T, Context>(ctx, bboxes, c, &bbox_slice);
-    }
-    NMSFast<T>(bbox_slice,
-               score_slice,
-               score_threshold,
-               nms_threshold,
-               nms_eta,
-               nms_top_k,
-               &((*indices)[c]),
-               normalized);
-    if (scores_size == 2) {
-      std::stable_sort((*indices)[c].begin(), (*indices)[c].end());
-    }
-    num_det += static_cast<int>((*indices)[c].size());
+    num_det += static_cast<int>((*class_indices)[c].size());
+    (*indices)[c] = std::move((*class_indices)[c]);
   }
 
   *num_nmsed_out = num_det;
   const T* scores_data = scores.data<T>();
   if (keep_top_k > -1 && num_det > keep_top_k) {
+    DenseTensor score_slice;
     const T* sdata = nullptr;
     std::vector<std::pair<float, std::pair<int, int>>> score_index_pairs;
     for (const auto& it : *indices) {
@@ -500,7 +531,6 @@ void MultiClassNMSKernel(const Context& ctx,
   int64_t box_dim = bboxes.dims()[2];
   int64_t out_dim = box_dim + 2;
   int num_nmsed_out = 0;
-  DenseTensor boxes_slice, scores_slice;
   int n = 0;
   if (has_roisnum) {
     n = static_cast<int>(score_size == 3 ? batch_size
@@ -509,39 +539,67 @@ void MultiClassNMSKernel(const Context& ctx,
     n = static_cast<int>(score_size == 3 ? batch_size
                                          : bboxes.lod().back().size() - 1);
   }
+  std::vector<DenseTensor> all_scores(n);
+  std::vector<DenseTensor> all_boxes(n);
+  std::vector<bool> is_empty(n, false);
+  std::vector<size_t> boxes_lod;
+  if (score_size != 3) {
+    if (has_roisnum) {
+      boxes_lod = GetNmsLodFromRoisNum(rois_num.get_ptr());
+    } else {
+      boxes_lod = bboxes.lod().back();
+    }
+  }
   for (int i = 0; i < n; ++i) {
-    std::map<int, std::vector<int>> indices;
     if (score_size == 3) {
-      scores_slice = scores.Slice(i, i + 1);
-      scores_slice.Resize({score_dims[1], score_dims[2]});
-      boxes_slice = bboxes.Slice(i, i + 1);
-      boxes_slice.Resize({score_dims[2], box_dim});
+      all_scores[i] = scores.Slice(i, i + 1);
+      all_scores[i].Resize({score_dims[1], score_dims[2]});
+      all_boxes[i] = bboxes.Slice(i, i + 1);
+      all_boxes[i].Resize({score_dims[2], box_dim});
+    } else if (boxes_lod[i] == boxes_lod[i + 1]) {
+      is_empty[i] = true;
     } else {
-      std::vector<size_t> boxes_lod;
-      if (has_roisnum) {
-        boxes_lod = GetNmsLodFromRoisNum(rois_num.get_ptr());
-      } else {
-        boxes_lod = bboxes.lod().back();
-      }
-      if (boxes_lod[i] == boxes_lod[i + 1]) {
-        all_indices.push_back(indices);
-        batch_starts.push_back(batch_starts.back());
-        continue;
-      }
-      scores_slice = scores.Slice(boxes_lod[i], boxes_lod[i + 1]);  // NOLINT
-      boxes_slice = bboxes.Slice(boxes_lod[i], boxes_lod[i + 1]);   // NOLINT
+      all_scores[i] = scores.Slice(boxes_lod[i], boxes_lod[i + 1]);  // NOLINT
+      all_boxes[i] = bboxes.Slice(boxes_lod[i], boxes_lod[i + 1]);   // NOLINT
+    }
+  }
+
+  // NMS of all the classes of all the images are independent.
+  const int class_num = score_dims[1];
+  std::vector<std::vector<std::vector<int>>> class_indices(
+      n, std::vector<std::vector<int>>(class_num));
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for schedule(dynamic)
+#endif
+  for (int64_t task = 0; task < static_cast<int64_t>(n) * class_num; ++task) {
+    int i = static_cast<int>(task / class_num);
+    int c = static_cast<int>(task % class_num);
+    if (is_empty[i] || c == background_label) continue;
+    NMSOneClass<T>(all_scores[i],
+                   all_boxes[i],
+                   static_cast<int>(score_size),
+                   c,
+                   static_cast<T>(score_threshold),
+                   static_cast<T>(nms_threshold),
+                   static_cast<T>(nms_eta),
+                   nms_top_k,
+                   normalized,
+                   &class_indices[i][c]);
+  }
+
+  for (int i = 0; i < n; ++i) {
+    std::map<int, std::vector<int>> indices;
+    if (is_empty[i]) {
+      all_indices.push_back(indices);
+      batch_starts.push_back(batch_starts.back());
+      continue;
     }
     MultiClassNMS<T, Context>(ctx,
-                              scores_slice,
-                              boxes_slice,
-                              score_size,
-                              score_threshold,
-                              nms_top_k,
+                              all_scores[i],
+                              static_cast<int>(score_size),
                               keep_top_k,
-                              nms_threshold,
-                              normalized,
-                              nms_eta,
                               background_label,
+                              &class_indices[i],
                               &indices,
                               &num_nmsed_out);
     all_indices.push_back(indices);
@@ -567,27 +625,11 @@ void MultiClassNMSKernel(const Context& ctx,
     int offset = 0;
     int* oindices = nullptr;
     for (int i = 0; i < n; ++i) {
-      if (score_size == 3) {
-        scores_slice = scores.Slice(i, i + 1);
-        boxes_slice = bboxes.Slice(i, i + 1);
-        scores_slice.Resize({score_dims[1], score_dims[2]});
-        boxes_slice.Resize({score_dims[2], box_dim});
-        if (return_index) {
-          offset = i * score_dims[2];
-        }
-      } else {
-        std::vector<size_t> boxes_lod;
-        if (has_roisnum) {
-          boxes_lod = GetNmsLodFromRoisNum(rois_num.get_ptr());
-        } else {
-          boxes_lod = bboxes.lod().back();
-        }
-        if (boxes_lod[i] == boxes_lod[i + 1]) continue;
-        scores_slice = scores.Slice(boxes_lod[i], boxes_lod[i + 1]);  // NOLINT
-        boxes_slice = bboxes.Slice(boxes_lod[i], boxes_lod[i + 1]);   // NOLINT
-        if (return_index) {
-          offset = static_cast<int>(boxes_lod[i] * score_dims[1]);
-        }
+      if (is_empty[i]) continue;
+      if (return_index) {
+        offset = score_size == 3
+                     ? i * score_dims[2]
+                     : static_cast<int>(boxes_lod[i] * score_dims[1]);
       }
 
       int64_t s = static_cast<int64_t>(batch_starts[i]);
@@ -600,8 +642,8 @@ void MultiClassNMSKernel(const Context& ctx,
           oindices = output_idx + s;
         }
         MultiClassOutput<T, Context>(ctx,
-                                     scores_slice,
-                                     boxes_slice,
+                                     all_scores[i],
+                                     all_boxes[i],
                                      all_indices[i],
                                      score_dims.size(),
                                      &nout,
@@ -0,0 +1,221 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <immintrin.h>
+#include <algorithm>
+
+#include "paddle/phi/backends/cpu/cpu_context.h"
+#include "paddle/phi/backends/cpu/cpu_info.h"
+#include "paddle/phi/core/kernel_registry.h"
+#include "paddle/phi/kernels/weight_only_linear_kernel.h"
+
+namespace phi {
+
+namespace {
+
+// Weights are in the layout written by weight_quantize with arch = 0:
+//   int8: [n, k], row major.
+//   int4: [n / 2, k], row major, the low 4 bits of byte (j, kk) are the
+//         weight of channel 2 * j and the high 4 bits of channel 2 * j + 1.
+// so the k weights of a channel are contiguous, and the product with a row
+// of x is a dot product along k. They are dequantized in registers, 16 at a
+// time, and multiplied with the fp32 x, i.e. x is not quantized.
+
+// number of channels and rows of x of a micro kernel
+constexpr int kNR = 4;
+constexpr int kMaxMR = 4;
+// rows of x sharing the weights loaded in cache
+constexpr int64_t kMBlock = 64;
+
+template <int bits>
+inline void LoadWeights(const int8_t* weight,
+                        int64_t k,
+                        int64_t kk,
+                        __m512 w[kNR]) {
+  if (bits == 8) {
+    for (int j = 0; j < kNR; ++j) {
+      __m128i v = _mm_loadu_si128(
+          reinterpret_cast<const __m128i*>(weight + j * k + kk));
+      w[j] = _mm512_cvtepi32_ps(_mm512_cvtepi8_epi32(v));
+    }
+  } else {
+    for (int j = 0; j < kNR / 2; ++j) {
+      __m128i v = _mm_loadu_si128(
+          reinterpret_cast<const __m128i*>(weight + j * k + kk));
+      __m512i packed = _mm512_cvtepi8_epi32(v);
+      __m512i low = _mm512_srai_epi32(_mm512_slli_epi32(packed, 28), 28);
+      __m512i high = _mm512_srai_epi32(packed, 4);
+      w[2 * j] = _mm512_cvtepi32_ps(low);
+      w[2 * j + 1] = _mm512_cvtepi32_ps(high);
+    }
+  }
+}
+
+// out[i][j] = sum_kk x[i][kk] * dequant(w[j][kk]) for mr rows of x and kNR
+// channels starting at channel n0. `weight` points to the first byte row of
+// the channels. Group-wise scales are multiplied into the dequantized
+// weights, which are shared by the mr rows, and per-channel scales into the
+// sums, so that only mr * kNR accumulators are live.
+template <int bits, int mr>
+void MicroKernel(const float* x,
+                 int64_t k,
+                 const int8_t* weight,
+                 const float* scale,
+                 int64_t n,
+                 int64_t n0,
+                 int group_size,
+                 float* out,
+                 int64_t ldo) {
+  __m512 acc[mr][kNR];
+  for (int i = 0; i < mr; ++i) {
+    for (int j = 0; j < kNR; ++j) {
+      acc[i][j] = _mm512_setzero_ps();
+    }
+  }
+  const int64_t group = group_size > 0 ? group_size : k;
+  for (int64_t g0 = 0; g0 < k; g0 += group) {
+    __m512 vs[kNR];
+    if (group_size > 0) {
+      const float* group_scale = scale + (g0 / group_size) * n + n0;
+      for (int j = 0; j < kNR; ++j) {
+        vs[j] = _mm512_set1_ps(group_scale[j]);
+      }
+    }
+    // the last group is partial if k is not a multiple of the group size
+    const int64_t g1 = std::min(g0 + group, k);
+    for (int64_t kk = g0; kk < g1; kk += 16) {
+      __m512 w[kNR];
+      LoadWeights<bits>(weight, k, kk, w);
+      if (group_size > 0) {
+        for (int j = 0; j < kNR; ++j) {
+          w[j] = _mm512_mul_ps(w[j], vs[j]);
+        }
+      }
+      for (int i = 0; i < mr; ++i) {
+        __m512 vx = _mm512_loadu_ps(x + i * k + kk);
+        for (int j = 0; j < kNR; ++j) {
+          acc[i][j] = _mm512_fmadd_ps(vx, w[j], acc[i][j]);
+        }
+      }
+    }
+  }
+  for (int i = 0; i < mr; ++i) {
+    for (int j = 0; j < kNR; ++j) {
+      float sum = _mm512_reduce_add_ps(acc[i][j]);
+      out[i * ldo + j] = group_size > 0 ? sum : sum * scale[n0 + j];
+    }
+  }
+}
+
+template <int bits>
+void WeightOnlyGemm(const float* x,
+                    int64_t m,
+                    int64_t k,
+                    const int8_t* weight,
+                    const float* scale,
+                    const float* bias,
+                    int64_t n,
+                    int group_size,
+                    float* out) {
+  // byte rows of kNR channels
+  const int64_t weight_rows = bits == 8 ? kNR : kNR / 2;
+  for (int64_t m0 = 0; m0 < m; m0 += kMBlock) {
+    const int64_t m1 = std::min(m0 + kMBlock, m);
+#pragma omp parallel for
+    for (int64_t n0 = 0; n0 < n; n0 += kNR) {
+      const int8_t* w = weight + (n0 / kNR) * weight_rows * k;
+      int64_t i = m0;
+      for (; i + kMaxMR <= m1; i += kMaxMR) {
+        MicroKernel<bits, kMaxMR>(
+            x + i * k, k, w, scale, n, n0, group_size, out + i * n + n0, n);
+      }
+      for (; i < m1; ++i) {
+        MicroKernel<bits, 1>(
+            x + i * k, k, w, scale, n, n0, group_size, out + i * n + n0, n);
+      }
+      if (bias != nullptr) {
+        for (int64_t r = m0; r < m1; ++r) {
+          for (int j = 0; j < kNR; ++j) {
+            out[r * n + n0 + j] += bias[n0 + j];
+          }
+        }
+      }
+    }
+  }
+}
+
+}  // namespace
+
+template <typename T, typename Context>
+void WeightOnlyLinearKernel(const Context& dev_ctx,
+                            const DenseTensor& x,
+                            const DenseTensor& weight,
+                            const paddle::optional<DenseTensor>& bias,
+                            const DenseTensor& weight_scale,
+                            const std::string& weight_dtype,
+                            const int32_t arch,
+                            const int32_t group_size,
+                            DenseTensor* out) {
+  PADDLE_ENFORCE_EQ(
+      arch,
+      0,
+      common::errors::InvalidArgument(
+          "The cpu kernel of weight_only_linear needs the weight quantized "
+          "by weight_quantize with arch 0, but got arch %d.",
+          arch));
+  PADDLE_ENFORCE_EQ(
+      backends::cpu::MayIUse(backends::cpu::avx512f),
+      true,
+      common::errors::Unavailable(
+          "The cpu kernel of weight_only_linear needs avx512f."));
+
+  dev_ctx.template Alloc<T>(out);
+  const int64_t n =
+      group_size > 0 ? weight_scale.dims()[1] : weight_scale.dims()[0];
+  const int64_t k = weight.dims()[1];
+  const int64_t m = x.numel() / k;
+  const T* bias_data = bias ? bias.get().data<T>() : nullptr;
+  if (weight_dtype == "int8") {
+    WeightOnlyGemm<8>(x.data<T>(),
+                      m,
+                      k,
+                      weight.data<int8_t>(),
+                      weight_scale.data<T>(),
+                      bias_data,
+                      n,
+                      group_size,
+                      out->data<T>());
+  } else if (weight_dtype == "int4") {
+    WeightOnlyGemm<4>(x.data<T>(),
+                      m,
+                      k,
+                      weight.data<int8_t>(),
+                      weight_scale.data<T>(),
+                      bias_data,
+                      n,
+                      group_size,
+                      out->data<T>());
+  } else {
+    PADDLE_THROW(common::errors::InvalidArgument(
+        "weight_dtype must be int8 or int4, but got %s.", weight_dtype));
+  }
+}
+
+}  // namespace phi
+
+PD_REGISTER_KERNEL(weight_only_linear,
+                   CPU,
+                   ALL_LAYOUT,
+                   phi::WeightOnlyLinearKernel,
+                   float) {}
@@ -36,11 +36,11 @@ void quant_compute(const DeviceContext& dev_ctx,
                    const int32_t group_size) {
 #ifndef PADDLE_WITH_HIP
   PADDLE_ENFORCE_EQ(
-      ((arch == 70) || (arch == 75) || (arch == 80) || (arch == 86) ||
-       (arch == 89) || (arch == 90)),
+      ((arch == 0) || (arch == 70) || (arch == 75) || (arch == 80) ||
+       (arch == 86) || (arch == 89) || (arch == 90)),
       true,
       common::errors::InvalidArgument(
-          "Currently, arch only support 70, 75, 80, 86, 89, 90."));
+          "Currently, arch only support 0 (cpu), 70, 75, 80, 86, 89, 90."));
 
 #endif
   const auto x_dims = x.dims();
@@ -62,8 +62,8 @@ void quant_compute(const DeviceContext& dev_ctx,
 #ifdef PADDLE_WITH_HIP
   x_int.Resize({static_cast<int64_t>(m), static_cast<int64_t>(n)});
 #else
-  if ((arch == 80) || (arch == 75) || (arch == 86) || (arch == 89) ||
-      (arch == 90)) {
+  if ((arch == 0) || (arch == 80) || (arch == 75) || (arch == 86) ||
+      (arch == 89) || (arch == 90)) {
     x_int.Resize({static_cast<int64_t>(m), static_cast<int64_t>(n)});
   } else {
     // phi::Copy may change tensor meta info, here we transpose the quanted
@@ -109,6 +109,18 @@ void quant_compute(const DeviceContext& dev_ctx,
     std::vector<int> axis = {1, 0};
     funcs::Transpose<DeviceContext, int8_t, 2> trans;
     trans(dev_ctx, x_int, out, axis);
+  } else if (arch == 0) {
+    // Row major [n, k] for int8 and [n / 2, k] for int4, the layout of the
+    // cpu weight_only_linear kernel. Only the left half of x_int is valid in
+    // int4 mode.
+    DenseTensor x_int_valid(x_int.type());
+    x_int_valid.Resize({static_cast<int64_t>(m),
+                        static_cast<int64_t>(bits == 8 ? n : n / 2)});
+    dev_ctx.template Alloc<D>(&x_int_valid);
+    std::copy_n(x_int_data, x_int_valid.numel(), x_int_valid.data<D>());
+    std::vector<int> axis = {1, 0};
+    funcs::Transpose<DeviceContext, int8_t, 2> trans;
+    trans(dev_ctx, x_int_valid, out, axis);
   } else {
 #ifdef PADDLE_WITH_HIP
     if (bits == 8) {
@@ -182,5 +194,6 @@ PD_REGISTER_KERNEL(weight_quantize,
                    CPU,
                    ALL_LAYOUT,
                    phi::WeightQuantizeKernel,
+                   float,
                    phi::dtype::float16,
                    phi::dtype::bfloat16) {}
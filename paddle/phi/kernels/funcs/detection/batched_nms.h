@@ -0,0 +1,254 @@
+/* Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+#ifdef __AVX__
+#include <immintrin.h>
+#endif
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace phi {
+namespace funcs {
+
+// NMS helpers of the CPU detection kernels for [xmin ymin xmax ymax] boxes.
+// Boxes are kept in structure of arrays layout so that the IoU of one box
+// against a block of boxes is computed by vectorizable loops, with the same
+// formula as JaccardOverlap in nms_util.h.
+
+constexpr int64_t kNMSBlockSize = 16;
+
+template <typename T>
+struct BoxesSoA {
+  std::vector<T> xmin;
+  std::vector<T> ymin;
+  std::vector<T> xmax;
+  std::vector<T> ymax;
+  std::vector<T> area;
+
+  int64_t size() const { return static_cast<int64_t>(xmin.size()); }
+
+  void Reserve(int64_t n) {
+    xmin.reserve(n);
+    ymin.reserve(n);
+    xmax.reserve(n);
+    ymax.reserve(n);
+    area.reserve(n);
+  }
+
+  void Push(const T* box, bool normalized) {
+    xmin.push_back(box[0]);
+    ymin.push_back(box[1]);
+    xmax.push_back(box[2]);
+    ymax.push_back(box[3]);
+    area.push_back(BoxArea(box[0], box[1], box[2], box[3], normalized));
+  }
+
+  static T BoxArea(T x0, T y0, T x1, T y1, bool normalized) {
+    if (x1 < x0 || y1 < y0) {
+      return static_cast<T>(0.);
+    }
+    T norm = normalized ? static_cast<T>(0.) : static_cast<T>(1.);
+    return (x1 - x0 + norm) * (y1 - y0 + norm);
+  }
+};
+
+// iou[j - begin] = IoU of box i of `boxes` (as box1) and box j (as box2).
+template <typename T>
+inline void ScalarJaccardOverlap(const BoxesSoA<T>& boxes,
+                                 int64_t i,
+                                 int64_t begin,
+                                 int64_t end,
+                                 bool normalized,
+                                 T* iou) {
+  const T x0 = boxes.xmin[i];
+  const T y0 = boxes.ymin[i];
+  const T x1 = boxes.xmax[i];
+  const T y1 = boxes.ymax[i];
+  const T area = boxes.area[i];
+  const T norm = normalized ? static_cast<T>(0.) : static_cast<T>(1.);
+  const T* xmin = boxes.xmin.data();
+  const T* ymin = boxes.ymin.data();
+  const T* xmax = boxes.xmax.data();
+  const T* ymax = boxes.ymax.data();
+  const T* areas = boxes.area.data();
+  for (int64_t j = begin; j < end; ++j) {
+    // branchless, the boxes overlap or not at random
+    const bool disjoint =
+        (xmin[j] > x1) | (xmax[j] < x0) | (ymin[j] > y1) | (ymax[j] < y0);
+    const T inter_w = std::min(x1, xmax[j]) - std::max(x0, xmin[j]) + norm;
+    const T inter_h = std::min(y1, ymax[j]) - std::max(y0, ymin[j]) + norm;
+    const T inter_area = inter_w * inter_h;
+    const T value = inter_area / (area + areas[j] - inter_area);
+    iou[j - begin] = disjoint ? static_cast<T>(0.) : value;
+  }
+}
+
+template <typename T>
+inline void BlockJaccardOverlap(const BoxesSoA<T>& boxes,
+                                int64_t i,
+                                int64_t begin,
+                                int64_t end,
+                                bool normalized,
+                                T* iou) {
+  ScalarJaccardOverlap<T>(boxes, i, begin, end, normalized, iou);
+}
+
+#ifdef __AVX__
+template <>
+inline void BlockJaccardOverlap<float>(const BoxesSoA<float>& boxes,
+                                       int64_t i,
+                                       int64_t begin,
+                                       int64_t end,
+                                       bool normalized,
+                                       float* iou) {
+  constexpr int64_t block = 8;
+  const __m256 x0 = _mm256_set1_ps(boxes.xmin[i]);
+  const __m256 y0 = _mm256_set1_ps(boxes.ymin[i]);
+  const __m256 x1 = _mm256_set1_ps(boxes.xmax[i]);
+  const __m256 y1 = _mm256_set1_ps(boxes.ymax[i]);
+  const __m256 area = _mm256_set1_ps(boxes.area[i]);
+  const __m256 norm = _mm256_set1_ps(normalized ? 0.f : 1.f);
+  const __m256 zero = _mm256_setzero_ps();
+  int64_t j = begin;
+  for (; j + block <= end; j += block) {
+    const __m256 bx0 = _mm256_loadu_ps(boxes.xmin.data() + j);
+    const __m256 by0 = _mm256_loadu_ps(boxes.ymin.data() + j);
+    const __m256 bx1 = _mm256_loadu_ps(boxes.xmax.data() + j);
+    const __m256 by1 = _mm256_loadu_ps(boxes.ymax.data() + j);
+    const __m256 barea = _mm256_loadu_ps(boxes.area.data() + j);
+    __m256 disjoint = _mm256_or_ps(_mm256_cmp_ps(bx0, x1, _CMP_GT_OQ),
+                                   _mm256_cmp_ps(bx1, x0, _CMP_LT_OQ));
+    disjoint = _mm256_or_ps(disjoint, _mm256_cmp_ps(by0, y1, _CMP_GT_OQ));
+    disjoint = _mm256_or_ps(disjoint, _mm256_cmp_ps(by1, y0, _CMP_LT_OQ));
+    // _mm256_min_ps(b, a) and _mm256_max_ps(b, a) select the same operand
+    // as std::min(a, b) and std::max(a, b)
+    const __m256 inter_w = _mm256_add_ps(
+        _mm256_sub_ps(_mm256_min_ps(bx1, x1), _mm256_max_ps(bx0, x0)), norm);
+    const __m256 inter_h = _mm256_add_ps(
+        _mm256_sub_ps(_mm256_min_ps(by1, y1), _mm256_max_ps(by0, y0)), norm);
+    const __m256 inter_area = _mm256_mul_ps(inter_w, inter_h);
+    const __m256 value = _mm256_div_ps(
+        inter_area, _mm256_sub_ps(_mm256_add_ps(area, barea), inter_area));
+    _mm256_storeu_ps(iou + j - begin, _mm256_blendv_ps(value, zero, disjoint));
+  }
+  ScalarJaccardOverlap<float>(boxes, i, j, end, normalized, iou + j - begin);
+}
+#endif
+
+// Indices of the scores greater than threshold, sorted by the score in
+// descending order and then by the index, i.e. the order of stable sorting
+// (score, index) pairs with SortScorePairDescend, which compares the scores
+// as float. At most top_k indices are kept if top_k > -1.
+template <typename T>
+void GetSortedScoreIndices(const T* scores,
+                           int64_t stride,
+                           int64_t num,
+                           T threshold,
+                           int64_t top_k,
+                           std::vector<int>* indices) {
+  std::vector<std::pair<float, int>> pairs(num);
+  int64_t count = 0;
+  // branchless compaction, the store is always done and only the count
+  // depends on the score
+  for (int64_t i = 0; i < num; ++i) {
+    const T score = scores[i * stride];
+    pairs[count] =
+        std::make_pair(static_cast<float>(score), static_cast<int>(i));
+    count += score > threshold;
+  }
+  pairs.resize(count);
+
+  auto cmp = [](const std::pair<float, int>& lhs,
+                const std::pair<float, int>& rhs) {
+    return lhs.first > rhs.first ||
+           (lhs.first == rhs.first && lhs.second < rhs.second);
+  };
+  if (top_k > -1 && top_k < count) {
+    std::nth_element(pairs.begin(), pairs.begin() + top_k, pairs.end(), cmp);
+    pairs.resize(top_k);
+  }
+  std::sort(pairs.begin(), pairs.end(), cmp);
+
+  indices->resize(pairs.size());
+  for (size_t i = 0; i < pairs.size(); ++i) {
+    (*indices)[i] = pairs[i].second;
+  }
+}
+
+// Greedy NMS of one class, the same as NMSFast of the multiclass_nms kernels
+// for [xmin ymin xmax ymax] boxes. box i is boxes[i * box_stride] and its
+// score is scores[i * score_stride]. The kept boxes are checked block by
+// block, so most candidates are suppressed after the first block.
+template <typename T>
+void GreedyNMS(const T* boxes,
+               int64_t box_stride,
+               const T* scores,
+               int64_t score_stride,
+               int64_t num_boxes,
+               T score_threshold,
+               T nms_threshold,
+               T eta,
+               int64_t top_k,
+               bool normalized,
+               std::vector<int>* selected_indices) {
+  std::vector<int> sorted_indices;
+  GetSortedScoreIndices<T>(scores,
+                           score_stride,
+                           num_boxes,
+                           score_threshold,
+                           top_k,
+                           &sorted_indices);
+  selected_indices->clear();
+  if (sorted_indices.empty()) {
+    return;
+  }
+
+  // the kept boxes followed by the current candidate
+  BoxesSoA<T> kept;
+  kept.Reserve(static_cast<int64_t>(sorted_indices.size()) + 1);
+  T iou[kNMSBlockSize];
+  T adaptive_threshold = nms_threshold;
+  for (int idx : sorted_indices) {
+    kept.Push(boxes + idx * box_stride, normalized);
+    const int64_t candidate = kept.size() - 1;
+    bool keep = true;
+    for (int64_t begin = 0; begin < candidate && keep;
+         begin += kNMSBlockSize) {
+      int64_t end = std::min(begin + kNMSBlockSize, candidate);
+      BlockJaccardOverlap<T>(kept, candidate, begin, end, normalized, iou);
+      for (int64_t j = 0; j < end - begin; ++j) {
+        // NaN overlaps suppress the candidate as well
+        keep &= iou[j] <= adaptive_threshold;
+      }
+    }
+    if (keep) {
+      selected_indices->push_back(idx);
+      if (eta < 1 && adaptive_threshold > 0.5) {
+        adaptive_threshold *= eta;
+      }
+    } else {
+      kept.xmin.pop_back();
+      kept.ymin.pop_back();
+      kept.xmax.pop_back();
+      kept.ymax.pop_back();
+      kept.area.pop_back();
+    }
+  }
+}
+
+}  // namespace funcs
+}  // namespace phi
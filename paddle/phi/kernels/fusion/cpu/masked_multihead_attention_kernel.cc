@@ -0,0 +1,487 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <vector>
+
+#ifdef PADDLE_WITH_MKLML
+#include <omp.h>
+#endif
+
+#include "paddle/phi/backends/cpu/cpu_context.h"
+#include "paddle/phi/common/bfloat16.h"
+#include "paddle/phi/core/kernel_registry.h"
+#include "paddle/phi/core/tensor_utils.h"
+
+namespace phi {
+namespace fusion {
+
+namespace {
+
+// Decode attention of one query token against the cache, the CPU version of
+// masked_multihead_attention. The cache has the layout of the GPU kernel:
+//   cache_k: [bsz, kv_num_head, dim_head / x, max_seq_len, x]
+//   cache_v: [cache_bsz, kv_num_head, max_seq_len, dim_head]
+// where x = 16 / sizeof(T). The heads of a group share the keys and values,
+// so they are computed together and the cache is read once per group with
+// an online softmax over blocks of timesteps.
+
+// timesteps scored at once by the online softmax
+constexpr int kStepBlock = 64;
+// min timesteps of a split when the cache is split over threads
+constexpr int kSplitSteps = 256;
+
+struct MMHAParams {
+  int bsz;
+  int cache_bsz;
+  int num_head;
+  int kv_num_head;
+  int dim_head;
+  int max_seq_len;
+  int timestep;
+  int rotary_emb_dims;
+  bool neox_rotary_style;
+  bool mask_broadcast_num_heads;
+  float inv_sqrt_dh;
+};
+
+// Adds the bias to head `head` of x and applies the rotary embedding.
+template <typename T>
+void LoadHead(const T* x,
+              const T* bias,
+              const float* rotary_emb,
+              const MMHAParams& p,
+              int bi,
+              int head,
+              bool rotary,
+              float* dst) {
+  const int dh = p.dim_head;
+  const int64_t offset =
+      (static_cast<int64_t>(bi) * (p.num_head + 2 * p.kv_num_head) + head) *
+      dh;
+  for (int d = 0; d < dh; ++d) {
+    dst[d] = static_cast<float>(x[offset + d]);
+    if (bias != nullptr) {
+      dst[d] += static_cast<float>(bias[head * dh + d]);
+    }
+  }
+  if (!rotary || p.rotary_emb_dims == 0) {
+    return;
+  }
+  const float* cos_emb = rotary_emb + bi * dh;
+  const float* sin_emb = rotary_emb + (p.bsz + bi) * dh;
+  if (!p.neox_rotary_style) {
+    for (int d = 0; d < dh; d += 2) {
+      const float v0 = dst[d];
+      const float v1 = dst[d + 1];
+      dst[d] = v0 * cos_emb[d] - v1 * sin_emb[d];
+      dst[d + 1] = v1 * cos_emb[d + 1] + v0 * sin_emb[d + 1];
+    }
+  } else {
+    const int last_dim = dh / p.rotary_emb_dims;
+    const int half_last_dim = last_dim / 2;
+    std::vector<float> src(dst, dst + dh);
+    for (int d = 0; d < dh; ++d) {
+      const bool left = d % last_dim < half_last_dim;
+      const float right = left ? -src[d + half_last_dim]
+                               : src[d - half_last_dim];
+      dst[d] = src[d] * cos_emb[d] + right * sin_emb[d];
+    }
+  }
+}
+
+// Online softmax state and output of the heads of a group over a range of
+// timesteps.
+struct PartialAttention {
+  std::vector<float> max;
+  std::vector<float> sum;
+  std::vector<float> acc;  // [group, dim_head]
+};
+
+// x is the number of elements of a 16 bytes chunk of the key cache.
+template <typename T, int x>
+void AttendRange(const float* q,
+                 const T* k_cache,
+                 const T* v_cache,
+                 const T* mask,
+                 const MMHAParams& p,
+                 int bi,
+                 int kv_hi,
+                 int begin,
+                 int end,
+                 PartialAttention* partial) {
+  const int dh = p.dim_head;
+  const int group = p.num_head / p.kv_num_head;
+  const int64_t max_seq_len = p.max_seq_len;
+  partial->max.assign(group, -FLT_MAX);
+  partial->sum.assign(group, 0.f);
+  partial->acc.assign(group * dh, 0.f);
+
+  // q * k of the elements of the chunks, the products of a timestep are
+  // summed after all chunks so that the loops have no reduction
+  constexpr int kLanes = 16;
+  static_assert(kLanes % x == 0, "");
+  float products[kStepBlock * x];
+  float q_lanes[kLanes];
+  float scores[kStepBlock];
+  std::vector<float> probs(group * kStepBlock);
+  for (int t0 = begin; t0 < end; t0 += kStepBlock) {
+    const int steps = std::min(kStepBlock, end - t0);
+    const int elements = steps * x;
+    const int lane_end = elements / kLanes * kLanes;
+    for (int g = 0; g < group; ++g) {
+      const float* qg = q + g * dh;
+      std::fill(products, products + elements, 0.f);
+      // the chunk co of the keys of all timesteps is contiguous
+      for (int co = 0; co < dh / x; ++co) {
+        const T* kc = k_cache + co * max_seq_len * x + t0 * x;
+        for (int l = 0; l < kLanes; ++l) {
+          q_lanes[l] = qg[co * x + l % x];
+        }
+        for (int j = 0; j < lane_end; j += kLanes) {
+          for (int l = 0; l < kLanes; ++l) {
+            products[j + l] += q_lanes[l] * static_cast<float>(kc[j + l]);
+          }
+        }
+        for (int j = lane_end; j < elements; ++j) {
+          products[j] += q_lanes[j % x] * static_cast<float>(kc[j]);
+        }
+      }
+      for (int t = 0; t < steps; ++t) {
+        float s = 0.f;
+        for (int i = 0; i < x; ++i) {
+          s += products[t * x + i];
+        }
+        scores[t] = s;
+      }
+
+      const int hi = kv_hi * group + g;
+      const T* mask_row =
+          mask == nullptr
+              ? nullptr
+              : mask + static_cast<int64_t>(
+                           p.mask_broadcast_num_heads ? bi
+                                                      : bi * p.num_head + hi) *
+                           (p.timestep + 1);
+      float block_max = -FLT_MAX;
+      for (int t = 0; t < steps; ++t) {
+        scores[t] *= p.inv_sqrt_dh;
+        if (mask_row != nullptr) {
+          scores[t] += static_cast<float>(mask_row[t0 + t]);
+        }
+        block_max = std::max(block_max, scores[t]);
+      }
+
+      const float new_max = std::max(partial->max[g], block_max);
+      const float alpha = std::exp(partial->max[g] - new_max);
+      float* prob = probs.data() + g * kStepBlock;
+      float block_sum = 0.f;
+      for (int t = 0; t < steps; ++t) {
+        prob[t] = std::exp(scores[t] - new_max);
+        block_sum += prob[t];
+      }
+      partial->max[g] = new_max;
+      partial->sum[g] = partial->sum[g] * alpha + block_sum;
+      if (alpha != 1.f) {
+        float* acc = partial->acc.data() + g * dh;
+        for (int d = 0; d < dh; ++d) {
+          acc[d] *= alpha;
+        }
+      }
+    }
+
+    // every value row is loaded once for the heads of the group
+    for (int t = 0; t < steps; ++t) {
+      const T* v = v_cache + static_cast<int64_t>(t0 + t) * dh;
+      for (int g = 0; g < group; ++g) {
+        const float prob = probs[g * kStepBlock + t];
+        float* acc = partial->acc.data() + g * dh;
+        for (int d = 0; d < dh; ++d) {
+          acc[d] += prob * static_cast<float>(v[d]);
+        }
+      }
+    }
+  }
+}
+
+template <typename T>
+void MMHACompute(const T* x,
+                 const T* bias,
+                 const T* mask,
+                 const int* sequence_lengths,
+                 const float* rotary_emb,
+                 const MMHAParams& p,
+                 T* cache_kv,
+                 T* out) {
+  constexpr int kChunk = 16 / sizeof(T);
+  const int dh = p.dim_head;
+  const int group = p.num_head / p.kv_num_head;
+  const int64_t head_cache_size = static_cast<int64_t>(p.max_seq_len) * dh;
+  T* v_cache_base = cache_kv + static_cast<int64_t>(p.cache_bsz) *
+                                   p.kv_num_head * head_cache_size;
+
+  std::vector<int> act_time_steps(p.bsz);
+  int max_time_step = 0;
+  for (int bi = 0; bi < p.bsz; ++bi) {
+    act_time_steps[bi] =
+        sequence_lengths == nullptr ? p.timestep : sequence_lengths[bi];
+    PADDLE_ENFORCE_LT(
+        act_time_steps[bi],
+        p.max_seq_len,
+        common::errors::InvalidArgument(
+            "The time step %d of batch %d is out of the cache, whose "
+            "max_seq_len is %d.",
+            act_time_steps[bi],
+            bi,
+            p.max_seq_len));
+    max_time_step = std::max(max_time_step, act_time_steps[bi]);
+  }
+
+  // The queries with bias and rotary embedding, and the new keys and values
+  // appended to the cache.
+  std::vector<float> q_buf(static_cast<int64_t>(p.bsz) * p.num_head * dh);
+  const int kv_tasks = p.bsz * p.kv_num_head;
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
+  for (int task = 0; task < kv_tasks; ++task) {
+    const int bi = task / p.kv_num_head;
+    const int kv_hi = task % p.kv_num_head;
+    const int t = act_time_steps[bi];
+    if (t < 0) {
+      continue;
+    }
+    for (int g = 0; g < group; ++g) {
+      const int hi = kv_hi * group + g;
+      LoadHead<T>(x,
+                  bias,
+                  rotary_emb,
+                  p,
+                  bi,
+                  hi,
+                  true,
+                  q_buf.data() + (static_cast<int64_t>(bi) * p.num_head + hi) *
+                                     dh);
+    }
+    std::vector<float> kv(dh);
+    LoadHead<T>(
+        x, bias, rotary_emb, p, bi, p.num_head + kv_hi, true, kv.data());
+    T* k_cache = cache_kv + static_cast<int64_t>(task) * head_cache_size;
+    for (int d = 0; d < dh; ++d) {
+      k_cache[(d / kChunk) * p.max_seq_len * kChunk + t * kChunk +
+              d % kChunk] = static_cast<T>(kv[d]);
+    }
+    LoadHead<T>(x,
+                bias,
+                rotary_emb,
+                p,
+                bi,
+                p.num_head + p.kv_num_head + kv_hi,
+                false,
+                kv.data());
+    T* v_cache = v_cache_base + static_cast<int64_t>(task) * head_cache_size;
+    for (int d = 0; d < dh; ++d) {
+      v_cache[static_cast<int64_t>(t) * dh + d] = static_cast<T>(kv[d]);
+    }
+  }
+
+  // Split the timesteps if there are fewer groups than threads, e.g. the
+  // decoding of one long sequence.
+#ifdef PADDLE_WITH_MKLML
+  const int num_threads = omp_get_max_threads();
+#else
+  const int num_threads = 1;
+#endif
+  int split_seq = 1;
+  if (kv_tasks < num_threads) {
+    split_seq = std::min((num_threads + kv_tasks - 1) / kv_tasks,
+                         (max_time_step + kSplitSteps) / kSplitSteps);
+    split_seq = std::max(split_seq, 1);
+  }
+  const int steps_per_split =
+      ((max_time_step + split_seq) / split_seq + kStepBlock - 1) /
+      kStepBlock * kStepBlock;
+
+  std::vector<PartialAttention> partials(kv_tasks * split_seq);
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
+  for (int task = 0; task < kv_tasks * split_seq; ++task) {
+    const int kv_task = task / split_seq;
+    const int bi = kv_task / p.kv_num_head;
+    const int kv_hi = kv_task % p.kv_num_head;
+    const int begin = task % split_seq * steps_per_split;
+    const int end = std::min(begin + steps_per_split, act_time_steps[bi] + 1);
+    AttendRange<T, kChunk>(
+        q_buf.data() +
+            (static_cast<int64_t>(bi) * p.num_head + kv_hi * group) * dh,
+        cache_kv + static_cast<int64_t>(kv_task) * head_cache_size,
+        v_cache_base + static_cast<int64_t>(kv_task) * head_cache_size,
+        mask,
+        p,
+        bi,
+        kv_hi,
+        begin,
+        end,
+        &partials[task]);
+  }
+
+  // merge the splits and normalize
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
+  for (int kv_task = 0; kv_task < kv_tasks; ++kv_task) {
+    const int bi = kv_task / p.kv_num_head;
+    const int kv_hi = kv_task % p.kv_num_head;
+    for (int g = 0; g < group; ++g) {
+      T* dst = out + (static_cast<int64_t>(bi) * p.num_head + kv_hi * group +
+                      g) *
+                         dh;
+      if (act_time_steps[bi] < 0) {
+        std::fill(dst, dst + dh, static_cast<T>(0));
+        continue;
+      }
+      float max = -FLT_MAX;
+      for (int s = 0; s < split_seq; ++s) {
+        max = std::max(max, partials[kv_task * split_seq + s].max[g]);
+      }
+      float sum = 0.f;
+      std::vector<float> acc(dh, 0.f);
+      for (int s = 0; s < split_seq; ++s) {
+        const PartialAttention& partial = partials[kv_task * split_seq + s];
+        if (partial.sum[g] == 0.f) {
+          continue;
+        }
+        const float scale = std::exp(partial.max[g] - max);
+        sum += partial.sum[g] * scale;
+        for (int d = 0; d < dh; ++d) {
+          acc[d] += partial.acc[g * dh + d] * scale;
+        }
+      }
+      const float inv_sum = 1.f / (sum + 1.e-6f);
+      for (int d = 0; d < dh; ++d) {
+        dst[d] = static_cast<T>(acc[d] * inv_sum);
+      }
+    }
+  }
+}
+
+}  // namespace
+
+template <typename T, typename Context>
+void MMHAKernel(const Context& dev_ctx,
+                const DenseTensor& x,
+                const DenseTensor& cache_kv,
+                const paddle::optional<DenseTensor>& bias,
+                const paddle::optional<DenseTensor>& src_mask,
+                const paddle::optional<DenseTensor>& cum_offsets,
+                const paddle::optional<DenseTensor>& sequence_lengths,
+                const paddle::optional<DenseTensor>& rotary_tensor,
+                const paddle::optional<DenseTensor>& beam_cache_offset,
+                const paddle::optional<DenseTensor>& qkv_out_scale,
+                const paddle::optional<DenseTensor>& out_shift,
+                const paddle::optional<DenseTensor>& out_smooth,
+                int seq_len,
+                int rotary_emb_dims,
+                const bool use_neox_rotary_style,
+                const std::string& compute_dtype,
+                const float out_scale,
+                const int quant_round_type,
+                const float quant_max_bound,
+                const float quant_min_bound,
+                DenseTensor* out,
+                DenseTensor* cache_kv_out,
+                DenseTensor* beam_cache_offset_out) {
+  PADDLE_ENFORCE_EQ(
+      cum_offsets || beam_cache_offset || qkv_out_scale || out_shift ||
+          out_scale > 0,
+      false,
+      common::errors::Unimplemented(
+          "The cpu kernel of masked_multihead_attention does not support "
+          "cum_offsets, beam search and quantization."));
+
+  MMHAParams params;
+  params.bsz = static_cast<int>(x.dims()[0]);
+  params.cache_bsz = static_cast<int>(cache_kv.dims()[1]);
+  params.kv_num_head = static_cast<int>(cache_kv.dims()[2]);
+  params.max_seq_len = static_cast<int>(cache_kv.dims()[3]);
+  params.dim_head = static_cast<int>(cache_kv.dims()[4]);
+  params.num_head =
+      static_cast<int>(x.dims()[x.dims().size() - 1] / params.dim_head) -
+      2 * params.kv_num_head;
+  params.timestep = params.max_seq_len;
+  params.rotary_emb_dims = rotary_emb_dims;
+  params.neox_rotary_style = use_neox_rotary_style;
+  params.mask_broadcast_num_heads = true;
+  params.inv_sqrt_dh = 1.f / std::sqrt(static_cast<float>(params.dim_head));
+  PADDLE_ENFORCE_EQ(
+      params.dim_head % (16 / sizeof(T)),
+      0,
+      common::errors::InvalidArgument(
+          "The dim_head of masked_multihead_attention must be divisible by "
+          "%d, but got %d.",
+          16 / sizeof(T),
+          params.dim_head));
+
+  const T* mask_data = nullptr;
+  if (src_mask) {
+    if (src_mask->dims()[1] == 1) {
+      params.mask_broadcast_num_heads = true;
+    } else if (src_mask->dims()[1] == params.num_head) {
+      params.mask_broadcast_num_heads = false;
+    } else {
+      PADDLE_THROW(common::errors::InvalidArgument(
+          "Unknow dimension for attn_mask, the num_head(2nd) "
+          "dimension is invalid, it should be 1 or num_head(%d), "
+          "but got %d",
+          params.num_head,
+          src_mask->dims()[1]));
+    }
+    mask_data = src_mask->data<T>();
+    params.timestep = static_cast<int>(src_mask->dims()[3] - 1);
+  }
+  if (rotary_emb_dims > 0) {
+    PADDLE_ENFORCE_NOT_NULL(
+        rotary_tensor.get_ptr(),
+        common::errors::InvalidArgument(
+            "rotary_tensor is needed if rotary_emb_dims > 0."));
+  }
+
+  // cache_kv_out is inplace of cache_kv
+  if (!cache_kv_out->IsSharedWith(cache_kv)) {
+    phi::Copy(dev_ctx, cache_kv, dev_ctx.GetPlace(), false, cache_kv_out);
+  }
+  dev_ctx.template Alloc<T>(out);
+
+  MMHACompute<T>(x.data<T>(),
+                 bias ? bias->data<T>() : nullptr,
+                 mask_data,
+                 sequence_lengths ? sequence_lengths->data<int>() : nullptr,
+                 rotary_emb_dims > 0 ? rotary_tensor->data<float>() : nullptr,
+                 params,
+                 cache_kv_out->data<T>(),
+                 out->data<T>());
+}
+
+}  // namespace fusion
+}  // namespace phi
+
+PD_REGISTER_KERNEL(masked_multihead_attention,
+                   CPU,
+                   ALL_LAYOUT,
+                   phi::fusion::MMHAKernel,
+                   float,
+                   phi::dtype::bfloat16) {}
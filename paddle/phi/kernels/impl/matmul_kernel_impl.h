@@ -14,11 +14,14 @@ limitations under the License. */
 
 #pragma once
 
+#include "Eigen/Core"
 #include "glog/logging.h"
 
+#include "paddle/phi/backends/cpu/cpu_context.h"
 #include "paddle/phi/common/memory_utils.h"
 #include "paddle/phi/core/dense_tensor.h"
 #include "paddle/phi/kernels/autotune/cache_base.h"
+#include "paddle/phi/kernels/autotune/cpu_auto_tune.h"
 #include "paddle/phi/kernels/cast_kernel.h"
 #include "paddle/phi/kernels/funcs/blas/blas.h"
 #include "paddle/phi/kernels/funcs/blas/blaslt_impl.cu.h"
@@ -486,6 +489,77 @@ void MatMulFunctionImplWithBlas(
   }
 }
 
+template <typename OutT, typename LhsT, typename RhsT>
+inline void EigenGEMM(OutT* out, const LhsT& lhs, const RhsT& rhs, bool flag) {
+  if (flag) {
+    out->noalias() += lhs * rhs;
+  } else {
+    out->noalias() = lhs * rhs;
+  }
+}
+
+// Matmul of 2-D tensors with Eigen, which is faster than blas for some small
+// shapes. It is compared with MatMulFunctionImplWithBlas when CPU autotune is
+// on, and falls back to it for other ranks.
+template <typename Context, typename T>
+void MatMulFunctionImplWithEigen(
+    const Context& dev_ctx,
+    const DenseTensor& X,
+    const DenseTensor& Y,
+    const std::vector<std::int64_t>& x_dims,
+    const std::vector<std::int64_t>& y_dims,
+    DenseTensor* Out,
+    bool trans_x,
+    bool trans_y,
+    bool flag = false,
+    phi::funcs::MatmulPlanner* matmul_planner = nullptr) {
+  if (x_dims.size() != 2 || y_dims.size() != 2) {
+    MatMulFunctionImplWithBlas<Context, T>(dev_ctx,
+                                           X,
+                                           Y,
+                                           x_dims,
+                                           y_dims,
+                                           Out,
+                                           trans_x,
+                                           trans_y,
+                                           flag,
+                                           matmul_planner);
+    return;
+  }
+
+  const std::int64_t M = trans_x ? x_dims[1] : x_dims[0];
+  const std::int64_t K = trans_x ? x_dims[0] : x_dims[1];
+  const std::int64_t N = trans_y ? y_dims[0] : y_dims[1];
+  const int y_k_axis = trans_y ? 1 : 0;
+  PADDLE_ENFORCE_EQ(y_dims[y_k_axis],
+                    K,
+                    common::errors::InvalidArgument(
+                        "Input(Y) has error dim. "
+                        "Y'dims[%d] must be equal to %d, "
+                        "but received Y'dims[%d] is %d.",
+                        y_k_axis,
+                        K,
+                        y_k_axis,
+                        y_dims[y_k_axis]));
+  Out->ResizeAndAllocate(common::make_ddim({M, N}));
+
+  using Matrix =
+      Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+  Eigen::Map<const Matrix> x(X.data<T>(), x_dims[0], x_dims[1]);
+  Eigen::Map<const Matrix> y(Y.data<T>(), y_dims[0], y_dims[1]);
+  Eigen::Map<Matrix> out(dev_ctx.template Alloc<T>(Out), M, N);
+  VLOG(3) << "MatMul's case 15";
+  if (trans_x && trans_y) {
+    EigenGEMM(&out, x.transpose(), y.transpose(), flag);
+  } else if (trans_x) {
+    EigenGEMM(&out, x.transpose(), y, flag);
+  } else if (trans_y) {
+    EigenGEMM(&out, x, y.transpose(), flag);
+  } else {
+    EigenGEMM(&out, x, y, flag);
+  }
+}
+
 #if defined(PADDLE_WITH_CUDA) && CUDA_VERSION >= 11060
 // This is almost a copy from MatMulFunctionImplWithBlas,
 // compare cublas with cublasLt kernels when Matmul autotune is on
@@ -956,6 +1030,59 @@ struct MatMulDispatcher<phi::GPUContext, T> {
 
 #endif  // PADDLE_WITH_CUDA
 
+// Matmul of 2-D float tensors on CPU runs blas or Eigen, whichever is faster
+// for the shape, when FLAGS_use_cpu_autotune is on. Otherwise it runs blas
+// directly, without touching the autotune cache.
+template <typename T>
+struct CpuAutoTuneMatMulDispatcher {
+  void operator()(const phi::CPUContext& ctx,
+                  const DenseTensor& x,
+                  const DenseTensor& y,
+                  const std::vector<std::int64_t>& x_dims,
+                  const std::vector<std::int64_t>& y_dims,
+                  DenseTensor* out,
+                  bool trans_x,
+                  bool trans_y,
+                  bool flag = false) {
+    if (!FLAGS_use_cpu_autotune || x_dims.size() != 2 || y_dims.size() != 2) {
+      MatMulFunctionImplWithBlas<phi::CPUContext, T>(
+          ctx, x, y, x_dims, y_dims, out, trans_x, trans_y, flag);
+      return;
+    }
+    auto* tuner = phi::autotune::MakeCpuTuner<T>(
+        MatMulFunctionImplWithBlas<phi::CPUContext, T>,
+        MatMulFunctionImplWithEigen<phi::CPUContext, T>);
+    size_t key = phi::autotune::GenKey(
+        x_dims,
+        y_dims,
+        trans_x,
+        trans_y,
+        flag,
+        static_cast<int64_t>(phi::CppTypeToDataType<T>::Type()),
+        phi::autotune::CpuMathLibraryNumThreads());
+    tuner->Run(phi::autotune::AlgorithmType::kCpuMatmul,
+               key,
+               ctx,
+               x,
+               y,
+               x_dims,
+               y_dims,
+               out,
+               trans_x,
+               trans_y,
+               flag,
+               nullptr);
+  }
+};
+
+template <>
+struct MatMulDispatcher<phi::CPUContext, float>
+    : public CpuAutoTuneMatMulDispatcher<float> {};
+
+template <>
+struct MatMulDispatcher<phi::CPUContext, double>
+    : public CpuAutoTuneMatMulDispatcher<double> {};
+
 template <typename Context, typename T>
 void MatMulFunction(const Context& ctx,
                     const DenseTensor& x,
@@ -14,7 +14,8 @@ limitations under the License. */
 
 #pragma once
 
-#include <set>
+#include <algorithm>
+#include <vector>
 
 #include "paddle/phi/core/dense_tensor.h"
 #include "paddle/phi/core/kernel_registry.h"
@@ -28,9 +29,56 @@ namespace sparse {
 
 using Dims4D = phi::funcs::sparse::Dims4D;
 
+// Open addressing (linear probing) map from a linearized coordinate to a
+// row index. It replaces std::set for the submanifold input lookup and for
+// ranking the output points. Keys must be non-negative.
+template <typename IntT>
+class CoordHashTable {
+ public:
+  explicit CoordHashTable(int64_t n) {
+    int64_t capacity = 16;
+    while (capacity < 2 * n) {
+      capacity <<= 1;
+    }
+    mask_ = capacity - 1;
+    keys_.assign(capacity, -1);
+    values_.resize(capacity);
+  }
+
+  void Insert(IntT key, IntT value) {
+    int64_t slot = Slot(key);
+    while (keys_[slot] != -1 && keys_[slot] != key) {
+      slot = (slot + 1) & mask_;
+    }
+    keys_[slot] = key;
+    values_[slot] = value;
+  }
+
+  // returns -1 if the key is not in the table
+  IntT Find(IntT key) const {
+    int64_t slot = Slot(key);
+    while (keys_[slot] != -1) {
+      if (keys_[slot] == key) {
+        return values_[slot];
+      }
+      slot = (slot + 1) & mask_;
+    }
+    return -1;
+  }
+
+ private:
+  int64_t Slot(IntT key) const {
+    uint64_t h = static_cast<uint64_t>(key) * 0x9E3779B97F4A7C15ULL;
+    return static_cast<int64_t>(h ^ (h >> 32)) & mask_;
+  }
+
+  int64_t mask_;
+  std::vector<IntT> keys_;
+  std::vector<IntT> values_;
+};
+
 // such as: kernel(3, 3, 3), kernel_size = 27
 // counter_per_weight: (kernel_size)
-// TODO(zhangkaihuo): optimize performance with multithreading
 template <typename T, typename Context, typename IntT = int>
 void ProductRuleBook(const Context& dev_ctx,
                      const SparseCooTensor& x,
@@ -50,8 +98,6 @@ void ProductRuleBook(const Context& dev_ctx,
                          : kernel_sizes[0] * kernel_sizes[1] * kernel_sizes[2];
   memset(counter_per_kernel, 0, kernel_size * sizeof(int));
 
-  int rulebook_len = 0;
-  // calc the rulebook_len
   const auto& x_dims = x.dims();
 
   int xdim0, xdim1, xdim2, xdim3;
@@ -98,9 +144,9 @@ void ProductRuleBook(const Context& dev_ctx,
   const Dims4D c_strides(sdim0, sdim1, sdim2, sdim3);
   const Dims4D c_dilations(ddim0, ddim1, ddim2, ddim3);
 
-  std::set<IntT> hash_in;
+  CoordHashTable<IntT> hash_in(subm ? non_zero_num : 0);
   if (subm) {
-    for (int i = 0; i < non_zero_num; i++) {
+    for (int64_t i = 0; i < non_zero_num; i++) {
       IntT batch = indices_ptr[i];
       IntT in_z = is2D ? 0 : indices_ptr[i + non_zero_num];
       IntT in_y = is2D ? indices_ptr[i + non_zero_num]
@@ -109,79 +155,102 @@ void ProductRuleBook(const Context& dev_ctx,
                        : indices_ptr[i + 3 * non_zero_num];
       IntT index = phi::funcs::sparse::PointToIndex<Dims4D>(
           batch, in_x, in_y, in_z, c_x_dims);
-      hash_in.insert(index);
+      hash_in.Insert(index, static_cast<IntT>(i));
     }
   }
 
-  auto f_calc_rulebook = [&](IntT* rulebook_ptr) {
-    int kernel_index = 0, rulebook_index = 0;
-    int zceil = is2D ? 1 : kernel_sizes[0];
-    int yceil = is2D ? kernel_sizes[0] : kernel_sizes[1];
-    int xceil = is2D ? kernel_sizes[1] : kernel_sizes[2];
-    for (int kz = 0; kz < zceil; kz++) {
-      for (int ky = 0; ky < yceil; ky++) {
-        for (int kx = 0; kx < xceil; kx++) {
-          ++kernel_index;
-          for (int64_t i = 0; i < non_zero_num; i++) {
-            IntT batch = indices_ptr[i];
-            IntT in_z = is2D ? 0 : indices_ptr[i + non_zero_num];
-            IntT in_y = is2D ? indices_ptr[i + non_zero_num]
-                             : indices_ptr[i + 2 * non_zero_num];
-            IntT in_x = is2D ? indices_ptr[i + 2 * non_zero_num]
-                             : indices_ptr[i + 3 * non_zero_num];
-
-            IntT out_z =
-                is2D ? 0
-                     : (in_z + paddings[0] - kz * dilations[0]) / strides[0];
-            IntT out_y =
-                (in_y + c_paddings[2] - ky * c_dilations[2]) / c_strides[2];
-            IntT out_x =
-                (in_x + c_paddings[3] - kx * c_dilations[3]) / c_strides[3];
-            if (phi::funcs::sparse::Check(c_x_dims,
-                                          c_kernel_dims,
-                                          c_paddings,
-                                          c_dilations,
-                                          c_strides,
-                                          in_x,
-                                          in_y,
-                                          in_z,
-                                          kx,
-                                          ky,
-                                          kz)) {
-              if (subm) {
-                IntT out_index = phi::funcs::sparse::PointToIndex<Dims4D>(
-                    batch, out_x, out_y, out_z, c_out_dims);
-                if (hash_in.find(out_index) == hash_in.end()) {
-                  continue;
-                }
-              }
-
-              if (rulebook_ptr == nullptr) {
-                counter_per_kernel[kernel_index - 1] += 1;
-                ++rulebook_len;
-              } else {
-                rulebook_ptr[rulebook_index] = kernel_index - 1;
-                rulebook_ptr[rulebook_index + rulebook_len] = i;  // in_i
-                rulebook_ptr[rulebook_index + rulebook_len * 2] =
-                    phi::funcs::sparse::PointToIndex<Dims4D>(
-                        batch, out_x, out_y, out_z, c_out_dims);  // out_index
-                ++rulebook_index;
-              }
-            }
-          }
-        }
-      }
+  // returns the out index of the rule (kernel offset, i), or -1 if there is
+  // no such rule
+  const int zceil = is2D ? 1 : kernel_sizes[0];
+  const int yceil = is2D ? kernel_sizes[0] : kernel_sizes[1];
+  const int xceil = is2D ? kernel_sizes[1] : kernel_sizes[2];
+  auto f_out_index = [&](int kernel_index, int64_t i) -> IntT {
+    const int kx = kernel_index % xceil;
+    const int ky = (kernel_index / xceil) % yceil;
+    const int kz = kernel_index / (xceil * yceil);
+    IntT batch = indices_ptr[i];
+    IntT in_z = is2D ? 0 : indices_ptr[i + non_zero_num];
+    IntT in_y = is2D ? indices_ptr[i + non_zero_num]
+                     : indices_ptr[i + 2 * non_zero_num];
+    IntT in_x = is2D ? indices_ptr[i + 2 * non_zero_num]
+                     : indices_ptr[i + 3 * non_zero_num];
+    if (!phi::funcs::sparse::Check(c_x_dims,
+                                   c_kernel_dims,
+                                   c_paddings,
+                                   c_dilations,
+                                   c_strides,
+                                   in_x,
+                                   in_y,
+                                   in_z,
+                                   kx,
+                                   ky,
+                                   kz)) {
+      return -1;
+    }
+    IntT out_z =
+        is2D ? 0 : (in_z + paddings[0] - kz * dilations[0]) / strides[0];
+    IntT out_y = (in_y + c_paddings[2] - ky * c_dilations[2]) / c_strides[2];
+    IntT out_x = (in_x + c_paddings[3] - kx * c_dilations[3]) / c_strides[3];
+    IntT out_index = phi::funcs::sparse::PointToIndex<Dims4D>(
+        batch, out_x, out_y, out_z, c_out_dims);
+    if (subm && hash_in.Find(out_index) < 0) {
+      return -1;
     }
+    return out_index;
   };
 
-  f_calc_rulebook(nullptr);
+  // The rules are generated in parallel over (kernel offset, chunk of
+  // non-zeros) blocks: count every block, prefix sum, then fill every block
+  // at its offset. The rulebook is ordered by kernel offset and then by
+  // input index, the same as a serial walk.
+  constexpr int64_t kChunkSize = 4096;
+  const int64_t chunk_num = (non_zero_num + kChunkSize - 1) / kChunkSize;
+  const int64_t block_num = kernel_size * chunk_num;
+  std::vector<int64_t> block_offsets(block_num + 1, 0);
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
+  for (int64_t b = 0; b < block_num; b++) {
+    const int kernel_index = static_cast<int>(b / chunk_num);
+    const int64_t begin = (b % chunk_num) * kChunkSize;
+    const int64_t end = std::min(begin + kChunkSize, non_zero_num);
+    int64_t count = 0;
+    for (int64_t i = begin; i < end; i++) {
+      count += f_out_index(kernel_index, i) >= 0;
+    }
+    block_offsets[b + 1] = count;
+  }
+  for (int64_t b = 0; b < block_num; b++) {
+    counter_per_kernel[b / chunk_num] += block_offsets[b + 1];
+    block_offsets[b + 1] += block_offsets[b];
+  }
+  const int rulebook_len = static_cast<int>(block_offsets[block_num]);
+
   // alloc the rulebook
   *rulebook = phi::Empty(dev_ctx,
                          DenseTensorMeta(phi::CppTypeToDataType<IntT>::Type(),
                                          {3, rulebook_len},
                                          DataLayout::NCHW));
   IntT* rulebook_ptr = rulebook->data<IntT>();
-  f_calc_rulebook(rulebook_ptr);
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
+  for (int64_t b = 0; b < block_num; b++) {
+    const int kernel_index = static_cast<int>(b / chunk_num);
+    const int64_t begin = (b % chunk_num) * kChunkSize;
+    const int64_t end = std::min(begin + kChunkSize, non_zero_num);
+    int64_t rulebook_index = block_offsets[b];
+    for (int64_t i = begin; i < end; i++) {
+      IntT out_index = f_out_index(kernel_index, i);
+      if (out_index < 0) {
+        continue;
+      }
+      rulebook_ptr[rulebook_index] = kernel_index;
+      rulebook_ptr[rulebook_index + rulebook_len] = i;  // in_i
+      rulebook_ptr[rulebook_index + rulebook_len * 2] = out_index;
+      ++rulebook_index;
+    }
+  }
 }
 
 template <typename T, typename Context, typename IntT = int>
@@ -194,14 +263,15 @@ void UpdateRulebookAndOutIndex(const Context& dev_ctx,
                                SparseCooTensor* out) {
   const bool is2D = out_dims.size() == 4 ? true : false;
 
-  std::set<IntT> out_indexs;
+  // the sorted unique out indices, ranked through a coordinate hash
   int n = rulebook->dims()[1];
   IntT* rulebook_ptr = rulebook->data<IntT>();
-  for (int i = 0; i < n; i++) {
-    out_indexs.insert(rulebook_ptr[i + n * 2]);
-  }
+  std::vector<IntT> out_indexs(rulebook_ptr + n * 2, rulebook_ptr + n * 3);
+  std::sort(out_indexs.begin(), out_indexs.end());
+  out_indexs.erase(std::unique(out_indexs.begin(), out_indexs.end()),
+                   out_indexs.end());
 
-  int out_non_zero_num = out_indexs.size();
+  int out_non_zero_num = static_cast<int>(out_indexs.size());
   const int64_t sparse_dim = is2D ? 3 : 4;
   DenseTensorMeta indices_meta(phi::CppTypeToDataType<IntT>::Type(),
                                {sparse_dim, out_non_zero_num},
@@ -220,8 +290,10 @@ void UpdateRulebookAndOutIndex(const Context& dev_ctx,
   odim3 = is2D ? 1 : out_dims[1];
   const Dims4D c_out_dims(odim0, odim1, odim2, odim3);
 
-  for (auto it = out_indexs.begin(); it != out_indexs.end(); it++, i++) {
-    const IntT index = *it;
+  CoordHashTable<IntT> out_index_to_rank(out_non_zero_num);
+  for (; i < out_non_zero_num; i++) {
+    const IntT index = out_indexs[i];
+    out_index_to_rank.Insert(index, static_cast<IntT>(i));
     IntT batch, x, y, z;
     phi::funcs::sparse::IndexToPoint<Dims4D>(
         index, c_out_dims, &batch, &x, &y, &z);
@@ -235,10 +307,11 @@ void UpdateRulebookAndOutIndex(const Context& dev_ctx,
       out_indices_ptr[i + out_non_zero_num * 3] = x;
     }
   }
-  for (i = 0; i < n; i++) {
-    IntT out_index = rulebook_ptr[i + n * 2];
-    rulebook_ptr[i + n * 2] =
-        std::distance(out_indexs.begin(), out_indexs.find(out_index));
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
+  for (int j = 0; j < n; j++) {
+    rulebook_ptr[j + n * 2] = out_index_to_rank.Find(rulebook_ptr[j + n * 2]);
   }
 
   out->SetMember(out_indices, out_values, out_dims, true);
@@ -247,6 +320,9 @@ void UpdateRulebookAndOutIndex(const Context& dev_ctx,
 template <typename T, typename IntT = int>
 void Gather(
     const T* x, const IntT* indexs, const int n, const int channels, T* out) {
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
   for (int i = 0; i < n; i++) {
     IntT real_i = indexs[i];
     memcpy(out + i * channels, x + real_i * channels, channels * sizeof(T));
@@ -12,6 +12,9 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License. */
 
+#include <map>
+#include <vector>
+
 #include "paddle/phi/core/kernel_registry.h"
 #include "paddle/phi/core/tensor_meta.h"
 #include "paddle/phi/core/tensor_utils.h"
@@ -137,7 +140,7 @@ void Conv3dCooCPUKernel(const CPUContext& dev_ctx,
   Gather<T, IntT>(
       x.values().data<T>(), rulebook_ptr + n, n, in_channels, in_features_ptr);
 
-  // 3. call gemm for every weight
+  // 3. call gemm for every weight, grouped by rule count
   auto blas = phi::funcs::GetBlas<CPUContext, T>(dev_ctx);
   int offset = 0;
   for (int i = 0; i < kernel_size; i++) {
@@ -146,29 +149,51 @@ void Conv3dCooCPUKernel(const CPUContext& dev_ctx,
   }
   h_offsets_ptr[kernel_size] = offset;
 
+  // kernel offsets with the same number of rules share one batched gemm:
+  // (n, in_channels) * (in_channels, out_channels)
   const T* kernel_ptr = kernel.data<T>();
+  std::map<int, std::vector<int>> offsets_per_count;
   for (int i = 0; i < kernel_size; i++) {
-    if (h_counter_ptr[i] <= 0) {
-      continue;
+    if (h_counter_ptr[i] > 0) {
+      offsets_per_count[h_counter_ptr[i]].push_back(i);
+    }
+  }
+  const int K = in_channels;   // in_channels
+  const int N = out_channels;  // out_channels
+  for (const auto& group : offsets_per_count) {
+    const int M = group.first;
+    const std::vector<int>& offsets = group.second;
+    std::vector<const T*> a_array, b_array;
+    std::vector<T*> c_array;
+    for (int i : offsets) {
+      a_array.push_back(in_features_ptr + h_offsets_ptr[i] * in_channels);
+      b_array.push_back(kernel_ptr + i * K * N);
+      c_array.push_back(out_features_ptr + h_offsets_ptr[i] * out_channels);
+    }
+    if (offsets.size() == 1) {
+      blas.GEMM(CblasNoTrans,
+                CblasNoTrans,
+                M,
+                N,
+                K,
+                static_cast<T>(1),
+                a_array[0],
+                b_array[0],
+                static_cast<T>(0),
+                c_array[0]);
+    } else {
+      blas.BatchedGEMM(CblasNoTrans,
+                       CblasNoTrans,
+                       M,
+                       N,
+                       K,
+                       static_cast<T>(1),
+                       a_array.data(),
+                       b_array.data(),
+                       static_cast<T>(0),
+                       c_array.data(),
+                       static_cast<int>(offsets.size()));
     }
-
-    // call gemm: (n, in_channels) * (in_channels, out_channels)
-    const int M = h_counter_ptr[i];
-    const int K = in_channels;   // in_channels
-    const int N = out_channels;  // out_channels
-    T* tmp_in_ptr = in_features_ptr + h_offsets_ptr[i] * in_channels;
-    const T* tmp_kernel_ptr = kernel_ptr + i * K * N;
-    T* tmp_out_ptr = out_features_ptr + h_offsets_ptr[i] * out_channels;
-    blas.GEMM(CblasNoTrans,
-              CblasNoTrans,
-              M,
-              N,
-              K,
-              static_cast<T>(1),
-              tmp_in_ptr,
-              tmp_kernel_ptr,
-              static_cast<T>(0),
-              tmp_out_ptr);
   }
 
   // 4. scatter
@@ -27,6 +27,7 @@ namespace pir {
 ///
 // struct StorageManagerImpl;
 struct ParametricStorageManager;
+struct ParametricStorageRegistry;
 
 ///
 /// \brief A utility class for getting or creating Storage class instances.
@@ -137,11 +138,10 @@ class IR_API StorageManager {
   void RegisterParameterlessStorageImpl(
       TypeId type_id, std::function<StorageBase *()> constructor);
 
-  // This map is a mapping between type id and parametric type storage.
-  std::unordered_map<TypeId, std::unique_ptr<ParametricStorageManager>>
-      parametric_instance_;
-
-  pir::SpinLock parametric_instance_lock_;
+  // This registry is a mapping between type id and parametric type storage.
+  // Lookups of already registered type ids and already constructed storages
+  // are lock-free, only insertions take a (sharded) lock.
+  std::unique_ptr<ParametricStorageRegistry> parametric_instance_;
 
   // This map is a mapping between type id and parameterless type storage.
   std::unordered_map<TypeId, StorageBase *> parameterless_instance_;
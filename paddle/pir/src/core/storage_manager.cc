@@ -15,46 +15,157 @@
 #include "paddle/pir/include/core/storage_manager.h"
 
 #include <glog/logging.h>
+#include <atomic>
 #include <memory>
 #include <unordered_map>
+#include <vector>
 
 #include "paddle/common/enforce.h"
 
 namespace pir {
+namespace {
+// An open-addressing hash table whose lookups are lock-free. Entries are only
+// ever appended (storages live as long as the IrContext), so a reader can
+// probe a published table without synchronization: a slot is either empty or
+// holds an immutable (hash, value) pair. Writers must be serialized by the
+// caller. When the table grows, the old slot array is retired rather than
+// freed, so that concurrent readers still probing it stay valid; a reader that
+// misses on a retired array falls back to the caller's locked slow path.
+template <typename T>
+class AppendOnlyHashTable {
+ public:
+  AppendOnlyHashTable() { Publish(std::make_unique<Slots>(kInitCapacity)); }
+
+  template <typename EqualFunc>
+  T *Find(std::size_t hash_value, const EqualFunc &equal_func) const {
+    const Slots *slots = slots_.load(std::memory_order_acquire);
+    std::size_t mask = slots->capacity - 1;
+    for (std::size_t i = hash_value & mask;; i = (i + 1) & mask) {
+      const Slot &slot = slots->data[i];
+      T *value = slot.value.load(std::memory_order_acquire);
+      if (value == nullptr) return nullptr;
+      if (slot.hash == hash_value && equal_func(value)) return value;
+    }
+  }
+
+  // Must be called with the writer lock held.
+  void Insert(std::size_t hash_value, T *value) {
+    Slots *slots = slots_.load(std::memory_order_relaxed);
+    if ((size_ + 1) * 2 > slots->capacity) {
+      auto grown = std::make_unique<Slots>(slots->capacity * 2);
+      for (std::size_t i = 0; i < slots->capacity; ++i) {
+        T *old_value = slots->data[i].value.load(std::memory_order_relaxed);
+        if (old_value != nullptr) {
+          InsertInto(grown.get(), slots->data[i].hash, old_value);
+        }
+      }
+      slots = Publish(std::move(grown));
+    }
+    InsertInto(slots, hash_value, value);
+    ++size_;
+  }
+
+  template <typename Visitor>
+  void ForEach(const Visitor &visitor) const {
+    const Slots *slots = slots_.load(std::memory_order_acquire);
+    for (std::size_t i = 0; i < slots->capacity; ++i) {
+      T *value = slots->data[i].value.load(std::memory_order_acquire);
+      if (value != nullptr) visitor(value);
+    }
+  }
+
+  std::size_t size() const { return size_; }
+
+ private:
+  static constexpr std::size_t kInitCapacity = 8;
+
+  struct Slot {
+    std::size_t hash{0};
+    std::atomic<T *> value{nullptr};
+  };
+
+  struct Slots {
+    explicit Slots(std::size_t cap)
+        : capacity(cap), data(std::make_unique<Slot[]>(cap)) {}
+    std::size_t capacity;
+    std::unique_ptr<Slot[]> data;
+  };
+
+  static void InsertInto(Slots *slots, std::size_t hash_value, T *value) {
+    std::size_t mask = slots->capacity - 1;
+    std::size_t i = hash_value & mask;
+    while (slots->data[i].value.load(std::memory_order_relaxed) != nullptr) {
+      i = (i + 1) & mask;
+    }
+    slots->data[i].hash = hash_value;
+    // Release so that readers observing the value also observe its hash.
+    slots->data[i].value.store(value, std::memory_order_release);
+  }
+
+  Slots *Publish(std::unique_ptr<Slots> slots) {
+    Slots *raw = slots.get();
+    all_slots_.emplace_back(std::move(slots));
+    slots_.store(raw, std::memory_order_release);
+    return raw;
+  }
+
+  std::atomic<Slots *> slots_{nullptr};
+  // Every slot array ever published, the last one is the current one.
+  std::vector<std::unique_ptr<Slots>> all_slots_;
+  std::size_t size_{0};
+};
+
+// Spreads the bits of a hash value, since many storages hash to small or
+// poorly mixed values (e.g. combined enum fields).
+inline std::size_t MixHash(std::size_t hash_value) {
+  hash_value ^= hash_value >> 33;
+  hash_value *= 0xff51afd7ed558ccdULL;
+  hash_value ^= hash_value >> 33;
+  return hash_value;
+}
+}  // namespace
+
 // This is a structure for creating, caching, and looking up Storage of
-// parametric types.
+// parametric types. Storages are spread over several independently locked
+// shards, and looking up an existing storage does not take any lock.
 struct ParametricStorageManager {
   using StorageBase = StorageManager::StorageBase;
 
-  explicit ParametricStorageManager(std::function<void(StorageBase *)> destroy)
-      : destroy_(destroy) {}
+  ParametricStorageManager(TypeId type_id,
+                           std::function<void(StorageBase *)> destroy)
+      : type_id_(type_id), destroy_(destroy) {}
 
   ~ParametricStorageManager() {  // NOLINT
-    for (const auto &instance : parametric_instances_) {
-      destroy_(instance.second);
+    for (auto &shard : shards_) {
+      shard.instances.ForEach(
+          [this](StorageBase *instance) { destroy_(instance); });
     }
-    parametric_instances_.clear();
   }
 
+  TypeId type_id() const { return type_id_; }
+
   // Get the storage of parametric type, if not in the cache, create and
   // insert the cache.
-  StorageBase *GetOrCreate(std::size_t hash_value,
-                           std::function<bool(StorageBase *)> equal_func,
-                           std::function<StorageBase *()> constructor) {
-    if (parametric_instances_.count(hash_value) != 0) {
-      auto pr = parametric_instances_.equal_range(hash_value);
-      while (pr.first != pr.second) {
-        if (equal_func(pr.first->second)) {
-          VLOG(10) << "Found a cached parametric storage of: [param_hash="
-                   << hash_value << ", storage_ptr=" << pr.first->second
-                   << "].";
-          return pr.first->second;
-        }
-        ++pr.first;
-      }
+  StorageBase *GetOrCreate(
+      std::size_t hash_value,
+      const std::function<bool(const StorageBase *)> &equal_func,
+      const std::function<StorageBase *()> &constructor) {
+    std::size_t mixed_hash = MixHash(hash_value);
+    Shard &shard = shards_[mixed_hash >> (64 - kShardBits)];
+    StorageBase *storage = shard.instances.Find(mixed_hash, equal_func);
+    if (storage != nullptr) {
+      return storage;
+    }
+    std::lock_guard<pir::SpinLock> guard(shard.lock);
+    // Another thread may have constructed it while we were waiting.
+    storage = shard.instances.Find(mixed_hash, equal_func);
+    if (storage != nullptr) {
+      VLOG(10) << "Found a cached parametric storage of: [param_hash="
+               << hash_value << ", storage_ptr=" << storage << "].";
+      return storage;
     }
-    StorageBase *storage = constructor();
-    parametric_instances_.emplace(hash_value, storage);
+    storage = constructor();
+    shard.instances.Insert(mixed_hash, storage);
     VLOG(10) << "No cache found, construct and cache a new parametric storage "
                 "of: [param_hash="
              << hash_value << ", storage_ptr=" << storage << "].";
@@ -62,13 +173,53 @@ struct ParametricStorageManager {
   }
 
  private:
-  // In order to prevent hash conflicts, the unordered_multimap data structure
-  // is used for storage.
-  std::unordered_multimap<size_t, StorageBase *> parametric_instances_;
+  static_assert(sizeof(std::size_t) == 8, "64-bit size_t is required.");
+  static constexpr std::size_t kShardBits = 4;
+  static constexpr std::size_t kNumShards = 1 << kShardBits;
+
+  // Aligned to avoid false sharing between the locks of adjacent shards.
+  struct alignas(64) Shard {
+    pir::SpinLock lock;
+    // Hash conflicts are resolved by probing, equal hashes are told apart by
+    // equal_func.
+    AppendOnlyHashTable<StorageBase> instances;
+  };
+
+  TypeId type_id_;
+  Shard shards_[kNumShards];
   std::function<void(StorageBase *)> destroy_;
 };
 
-StorageManager::StorageManager() = default;
+// A mapping between type id and parametric storage manager, lookups are
+// lock-free and registration is serialized by a lock.
+struct ParametricStorageRegistry {
+  ParametricStorageManager *Find(TypeId type_id) const {
+    return managers_.Find(
+        std::hash<TypeId>()(type_id),
+        [type_id](const ParametricStorageManager *manager) {
+          return manager->type_id() == type_id;
+        });
+  }
+
+  void Register(TypeId type_id,
+                std::function<void(StorageManager::StorageBase *)> destroy) {
+    std::lock_guard<pir::SpinLock> guard(lock_);
+    if (Find(type_id) != nullptr) {
+      return;
+    }
+    owned_.emplace_back(
+        std::make_unique<ParametricStorageManager>(type_id, destroy));
+    managers_.Insert(std::hash<TypeId>()(type_id), owned_.back().get());
+  }
+
+ private:
+  AppendOnlyHashTable<ParametricStorageManager> managers_;
+  std::vector<std::unique_ptr<ParametricStorageManager>> owned_;
+  pir::SpinLock lock_;
+};
+
+StorageManager::StorageManager()
+    : parametric_instance_(std::make_unique<ParametricStorageRegistry>()) {}
 
 StorageManager::~StorageManager() = default;
 
@@ -77,15 +228,12 @@ StorageManager::StorageBase *StorageManager::GetParametricStorageImpl(
     std::size_t hash_value,
     std::function<bool(const StorageBase *)> equal_func,
     std::function<StorageBase *()> constructor) {
-  std::lock_guard<pir::SpinLock> guard(parametric_instance_lock_);
-  VLOG(10) << "Try to get a parametric storage of: [TypeId_hash="
-           << std::hash<pir::TypeId>()(type_id) << ", param_hash=" << hash_value
-           << "].";
-  if (parametric_instance_.find(type_id) == parametric_instance_.end()) {
+  ParametricStorageManager *parametric_storage =
+      parametric_instance_->Find(type_id);
+  if (parametric_storage == nullptr) {
     IR_THROW("The input data pointer is null.");
   }
-  ParametricStorageManager &parametric_storage = *parametric_instance_[type_id];
-  return parametric_storage.GetOrCreate(hash_value, equal_func, constructor);
+  return parametric_storage->GetOrCreate(hash_value, equal_func, constructor);
 }
 
 StorageManager::StorageBase *StorageManager::GetParameterlessStorageImpl(
@@ -101,11 +249,9 @@ StorageManager::StorageBase *StorageManager::GetParameterlessStorageImpl(
 
 void StorageManager::RegisterParametricStorageImpl(
     TypeId type_id, std::function<void(StorageBase *)> destroy) {
-  std::lock_guard<pir::SpinLock> guard(parametric_instance_lock_);
   VLOG(10) << "Register a parametric storage of: [TypeId_hash="
            << std::hash<pir::TypeId>()(type_id) << "].";
-  parametric_instance_.emplace(
-      type_id, std::make_unique<ParametricStorageManager>(destroy));
+  parametric_instance_->Register(type_id, destroy);
 }
 
 void StorageManager::RegisterParameterlessStorageImpl(
@@ -40,7 +40,8 @@ def masked_multihead_attention(
     r"""
     Masked Multi-head attention for text summarization.
     This is a fusion operator to compute masked multi-head attention in transformer model architecture.
-    This operator only supports running on GPU.
+    This operator supports running on GPU, and on CPU for float32 and bfloat16
+    without beam search and quantization.
 
     Args:
         x (Tensor): The input tensor could be 2-D tensor. Its shape is [batch_size, 3 * num_head * head_dim].
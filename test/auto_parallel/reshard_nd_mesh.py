@@ -160,6 +160,28 @@ class TestReshardNdMesh:
 
         assert np.equal(out.shape, input_tensor.shape).all()
 
+    def test_shard_to_shard_on_same_mesh_axis(self, dev_ctx):
+        paddle.seed(self._seeds)
+        a = paddle.randn(self._shape).astype(self._dtype)
+
+        input_tensor = dist.shard_tensor(
+            a, self._mesh, [dist.Shard(1), dist.Replicate()]
+        )
+        # planned as a single all to all on mesh axis "x"
+        out = dist.reshard(
+            input_tensor, self._mesh, [dist.Shard(0), dist.Replicate()]
+        )
+
+        out_expected_local_tensor_list = paddle.split(
+            a, num_or_sections=self._mesh.shape[0], axis=0
+        )
+        index = dist.get_rank() % self._mesh.shape[0]
+        np.testing.assert_equal(
+            out._local_value().numpy(),
+            out_expected_local_tensor_list[index].numpy(),
+        )
+        assert np.equal(out.shape, input_tensor.shape).all()
+
     def test_partial_replicate_to_shard_replicated(self, dev_ctx):
         paddle.seed(self._seeds)
         a = paddle.randn(self._shape).astype(self._dtype)
@@ -195,10 +217,9 @@ class TestReshardNdMesh:
         self.test_shard_to_shard(dev_ctx)
         self.test_shard_partial_to_shard_replicated(dev_ctx)
         self.test_shard_partial_to_replicated(dev_ctx)
-
-        if self._backend == "gpu":
-            # reduce_scatter is not supported on CPU
-            self.test_partial_replicate_to_shard_replicated(dev_ctx)
+        self.test_shard_to_shard_on_same_mesh_axis(dev_ctx)
+        # planned as allreduce and slice on CPU, without reduce_scatter
+        self.test_partial_replicate_to_shard_replicated(dev_ctx)
 
     def cross_mesh_reshard(self):
         a = paddle.zeros([20, 20])
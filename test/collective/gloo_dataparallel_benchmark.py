@@ -0,0 +1,101 @@
+# Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+# Step time of CPU data parallel training with gloo, with the gradient
+# allreduce run synchronously, overlapped with the backward, and overlapped
+# with bfloat16 on the wire. Run on several local processes over loopback:
+#
+#   python -m paddle.distributed.launch --nproc_per_node 4 \
+#       gloo_dataparallel_benchmark.py
+
+import time
+
+import numpy as np
+
+import paddle
+from paddle import nn
+from paddle.distributed import fleet
+
+HIDDEN = 1024
+LAYERS = 8
+BATCH = 64
+WARMUP_STEPS = 3
+STEPS = 20
+
+
+class MLP(nn.Layer):
+    def __init__(self):
+        super().__init__()
+        self.layers = nn.LayerList(
+            [nn.Linear(HIDDEN, HIDDEN) for _ in range(LAYERS)]
+        )
+
+    def forward(self, x):
+        for layer in self.layers:
+            x = paddle.nn.functional.relu(layer(x))
+        return x
+
+
+def run(model, optimizer, flags):
+    paddle.set_flags(flags)
+    x = paddle.to_tensor(np.random.random((BATCH, HIDDEN)).astype('float32'))
+    for step in range(WARMUP_STEPS + STEPS):
+        if step == WARMUP_STEPS:
+            start = time.perf_counter()
+        loss = model(x).mean()
+        loss.backward()
+        optimizer.step()
+        optimizer.clear_grad()
+    return (time.perf_counter() - start) / STEPS * 1000
+
+
+def main():
+    paddle.set_device('cpu')
+    fleet.init(is_collective=True)
+    paddle.seed(2024)
+    np.random.seed(2024 + paddle.distributed.get_rank())
+
+    model = paddle.DataParallel(MLP(), comm_buffer_size=4)
+    optimizer = paddle.optimizer.SGD(
+        learning_rate=0.001, parameters=model.parameters()
+    )
+
+    configs = [
+        ("sync", {"FLAGS_gloo_async_allreduce": False}),
+        (
+            "overlapped",
+            {
+                "FLAGS_gloo_async_allreduce": True,
+                "FLAGS_gloo_allreduce_comm_dtype": "",
+            },
+        ),
+        (
+            "overlapped bf16",
+            {
+                "FLAGS_gloo_async_allreduce": True,
+                "FLAGS_gloo_allreduce_comm_dtype": "bfloat16",
+            },
+        ),
+    ]
+    for name, flags in configs:
+        step_ms = run(model, optimizer, flags)
+        if paddle.distributed.get_rank() == 0:
+            print(
+                f"nranks {paddle.distributed.get_world_size()} {name}: "
+                f"{step_ms:.2f} ms per step"
+            )
+
+
+if __name__ == "__main__":
+    main()
@@ -84,6 +84,20 @@ class TestProcessGroupFp32(unittest.TestCase):
 
         print("test allreduce max api ok")
 
+        # test async allreduce, several tasks in flight
+        xs = [np.random.random(self.shape).astype(self.dtype) for _ in range(4)]
+        ys = [np.random.random(self.shape).astype(self.dtype) for _ in range(4)]
+        tensors = [paddle.to_tensor(v) for v in (xs if rank == 0 else ys)]
+        tasks = [
+            pg.all_reduce(t, core.ReduceOp.SUM, sync_op=False) for t in tensors
+        ]
+        for task in tasks:
+            task.wait()
+        for t, x, y in zip(tensors, xs, ys):
+            np.testing.assert_allclose(t, x + y, rtol=1e-6)
+
+        print("test async allreduce sum api ok")
+
         # test broadcast
         # rank 0
         x = np.random.random(self.shape).astype(self.dtype)
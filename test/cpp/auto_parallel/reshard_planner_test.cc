@@ -0,0 +1,114 @@
+/* Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/phi/core/distributed/auto_parallel/reshard/reshard_planner.h"
+
+#include <algorithm>
+
+#include "gtest/gtest.h"
+
+#include "paddle/phi/core/distributed/auto_parallel/dist_attr.h"
+#include "paddle/phi/core/distributed/auto_parallel/process_mesh.h"
+
+namespace phi {
+namespace distributed {
+namespace tests {
+
+using StepType = ReshardStep::Type;
+
+TEST(reshard_planner, shard_to_shard_uses_all_to_all) {
+  // [S(1), R] -> [S(0), R] on a 2x2 mesh
+  auto plan = ReshardPlanner::Plan(
+      {2, 2}, {8, 8}, 4, {1, kReplicatedStatus}, {0, kReplicatedStatus}, true);
+  ASSERT_NE(plan, nullptr);
+  ASSERT_EQ(plan->steps.size(), 1UL);
+  EXPECT_EQ(plan->steps[0].type, StepType::kSToS);
+  EXPECT_EQ(plan->steps[0].mesh_axis, 0);
+  EXPECT_EQ(plan->steps[0].in_tensor_axis, 1);
+  EXPECT_EQ(plan->steps[0].out_tensor_axis, 0);
+  // local 128 bytes, half of them are sent
+  EXPECT_EQ(plan->bytes, 64);
+}
+
+TEST(reshard_planner, swap_is_cheaper_than_allgather) {
+  // [S(0), S(1)] -> [S(1), S(0)]: allgathering every axis and sharding again
+  // sends 16 + 32 bytes
+  auto plan = ReshardPlanner::Plan({2, 2}, {4, 4}, 4, {0, 1}, {1, 0}, true);
+  ASSERT_NE(plan, nullptr);
+  EXPECT_LT(plan->bytes, 48);
+  for (const auto& step : plan->steps) {
+    EXPECT_NE(step.type, StepType::kSToR);
+  }
+}
+
+TEST(reshard_planner, partial_to_shard) {
+  std::vector<int64_t> in_status = {kPartialStatus, kReplicatedStatus};
+  std::vector<int64_t> out_status = {0, kReplicatedStatus};
+  auto count_steps = [](const ReshardPlan& plan, StepType type) {
+    return std::count_if(
+        plan.steps.begin(), plan.steps.end(), [&](const ReshardStep& step) {
+          return step.type == type;
+        });
+  };
+
+  // allreduce of the whole tensor sends 2 * 256 * 3 / 4 bytes, sharding on
+  // the other mesh axis first makes the reduction smaller
+  auto plan =
+      ReshardPlanner::Plan({4, 2}, {8, 8}, 4, in_status, out_status, true);
+  ASSERT_NE(plan, nullptr);
+  EXPECT_EQ(count_steps(*plan, StepType::kPToS), 1);
+  EXPECT_EQ(count_steps(*plan, StepType::kPToR), 0);
+  EXPECT_EQ(plan->bytes, 128);
+
+  // no reduce scatter
+  plan = ReshardPlanner::Plan({4, 2}, {8, 8}, 4, in_status, out_status, false);
+  ASSERT_NE(plan, nullptr);
+  EXPECT_EQ(count_steps(*plan, StepType::kPToS), 0);
+  EXPECT_EQ(count_steps(*plan, StepType::kPToR), 1);
+  EXPECT_EQ(plan->bytes, 224);
+}
+
+TEST(reshard_planner, uneven_shard_is_not_planned) {
+  auto plan = ReshardPlanner::Plan(
+      {2, 2}, {3, 8}, 4, {1, kReplicatedStatus}, {0, kReplicatedStatus}, true);
+  EXPECT_EQ(plan, nullptr);
+}
+
+TEST(reshard_planner, plan_is_cached) {
+  ProcessMesh mesh({2, 2}, {0, 1, 2, 3}, {"x", "y"});
+  TensorDistAttr in_dist_attr(std::vector<int64_t>{8, 8});
+  in_dist_attr.set_process_mesh(mesh);
+  in_dist_attr.set_dims_mapping({-1, 0});
+  in_dist_attr.set_partial_status(std::vector<int64_t>{1});
+  TensorDistAttr out_dist_attr(std::vector<int64_t>{8, 8});
+  out_dist_attr.set_process_mesh(mesh);
+  out_dist_attr.set_dims_mapping({0, -1});
+
+  auto& planner = ReshardPlanner::Instance();
+  const ReshardPlan* plan = planner.GetPlan(
+      in_dist_attr, out_dist_attr, {8, 8}, DataType::FLOAT32, true);
+  ASSERT_NE(plan, nullptr);
+  EXPECT_EQ(plan, planner.GetPlan(in_dist_attr,
+                                  out_dist_attr,
+                                  {8, 8},
+                                  DataType::FLOAT32,
+                                  true));
+  // s->s on mesh axis 0 and p->r on mesh axis 1
+  ASSERT_EQ(plan->steps.size(), 2UL);
+  EXPECT_EQ(plan->bytes, 192);
+}
+
+}  // namespace tests
+}  // namespace distributed
+}  // namespace phi
@@ -0,0 +1,128 @@
+/* Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/operators/string/faster_tokenizer_op.h"
+
+#include <chrono>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace paddle {
+namespace operators {
+
+framework::Vocab MakeVocab() {
+  framework::Vocab vocab;
+  int32_t id = 0;
+  const vector<wstring> tokens = {L"[PAD]",  L"[UNK]", L"[CLS]", L"[SEP]",
+                                  L"[MASK]", L"un",    L"##aff", L"##able",
+                                  L"runn",   L"##ing", L"want",  L"##ed",
+                                  L"wa",     L",",     L"\u4f60", L"\u597d",
+                                  L"##",     L"hel",   L"hello", L"##lo"};
+  for (const auto& token : tokens) {
+    vocab.emplace(token, id++);
+  }
+  return vocab;
+}
+
+TEST(FasterTokenizer, WordPiece) {
+  framework::Vocab vocab = MakeVocab();
+  BertTokenizer tokenizer(&vocab, true);
+
+  vector<int64_t> ids;
+  tokenizer.Tokenize("UNaffable, Running \xe4\xbd\xa0\xe5\xa5\xbd xyz wanted",
+                     &ids);
+  EXPECT_EQ(ids, (vector<int64_t>{5, 6, 7, 13, 8, 9, 14, 15, 1, 10, 11}));
+
+  // '#' is punctuation, so "hello##" is not matched as a continuation.
+  ids.clear();
+  tokenizer.Tokenize("hello hello##", &ids);
+  EXPECT_EQ(ids, (vector<int64_t>{18, 18, 1, 1}));
+
+  // invalid UTF-8 yields no tokens
+  ids.clear();
+  tokenizer.Tokenize("bad \xff utf8", &ids);
+  EXPECT_TRUE(ids.empty());
+
+  std::unordered_map<string, vector<int64_t>> encoded;
+  tokenizer.Encode(&encoded, "\xe4\xbd\xa0x\xe5\xa5\xbd", "", true);
+  EXPECT_EQ(encoded["input_ids"], (vector<int64_t>{2, 14, 1, 15, 3}));
+}
+
+TEST(FasterTokenizer, TrieOfVocab) {
+  framework::Vocab vocab = MakeVocab();
+  auto trie = WordPieceTrie::Get(&vocab);
+  EXPECT_EQ(trie, WordPieceTrie::Get(&vocab));
+  EXPECT_EQ(trie->Find("hello", 5), 18);
+  EXPECT_EQ(trie->Find("xyz", 3), -1);
+
+  // a changed vocab gets a new trie
+  vocab.emplace(L"xyz", 20);
+  auto changed = WordPieceTrie::Get(&vocab);
+  EXPECT_NE(trie, changed);
+  EXPECT_EQ(changed->Find("xyz", 3), 20);
+
+  // and so does another vocab, even at the same address
+  vocab = framework::Vocab(MakeVocab());
+  EXPECT_EQ(WordPieceTrie::Get(&vocab)->Find("xyz", 3), -1);
+
+  // a copy is another vocab, and moving from a vocab changes it
+  framework::Vocab copy(vocab);
+  EXPECT_NE(copy.version(), vocab.version());
+  uint64_t version = vocab.version();
+  framework::Vocab moved(std::move(vocab));
+  EXPECT_NE(vocab.version(), version);  // NOLINT
+}
+
+TEST(FasterTokenizer, BatchEncodeThroughput) {
+  framework::Vocab vocab = MakeVocab();
+  BertTokenizer tokenizer(&vocab, true);
+
+  const char* words[] = {"unaffable",
+                         "Running",
+                         "wanted",
+                         "hello",
+                         "xyzzy",
+                         "\xe4\xbd\xa0\xe5\xa5\xbd",
+                         ","};
+  framework::Strings batch;
+  size_t bytes = 0;
+  for (int row = 0; row < 2000; ++row) {
+    string text;
+    for (int i = 0; i < 100; ++i) {
+      text += words[(row * 7 + i * 13) % 7];
+      text += " ";
+    }
+    bytes += text.size();
+    batch.emplace_back(std::move(text));
+  }
+
+  vector<unordered_map<string, vector<int64_t>>> encoded(batch.size());
+  auto start = std::chrono::steady_clock::now();
+  tokenizer.BatchEncode(&encoded, batch);
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  LOG(INFO) << "faster_tokenizer BatchEncode: " << bytes / 1e6 / seconds
+            << " MB/s";
+  for (auto& row : encoded) {
+    EXPECT_EQ(row["input_ids"].front(), 2);
+    EXPECT_EQ(row["input_ids"].back(), 3);
+  }
+}
+
+}  // namespace operators
+}  // namespace paddle
@@ -14,6 +14,11 @@ limitations under the License. */
 
 #include "paddle/fluid/framework/scope.h"
 
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <thread>
+
 #include "gtest/gtest.h"
 
 namespace paddle {
@@ -23,6 +28,7 @@ class Variable;
 }  // namespace paddle
 
 using paddle::framework::Scope;
+using paddle::framework::VarNameId;
 using paddle::framework::Variable;
 
 TEST(Scope, VarsShadowing) {
@@ -77,3 +83,192 @@ TEST(Scope, GetAllNames) {
 
   EXPECT_STREQ("a", str.c_str());
 }
+
+TEST(Scope, FindVarById) {
+  Scope s;
+  Scope& ss = s.NewScope();
+  Variable* v = s.Var("find_var_by_id");
+  VarNameId id = paddle::framework::FindVarNameId("find_var_by_id");
+  EXPECT_NE(id, paddle::framework::kInvalidVarNameId);
+  EXPECT_EQ(id, paddle::framework::FindVarNameId("find_var_by_id"));
+  EXPECT_EQ(paddle::framework::VarNameOfId(id), "find_var_by_id");
+  EXPECT_EQ(v, ss.FindVarById(id));
+  EXPECT_EQ(paddle::framework::kInvalidVarNameId,
+            paddle::framework::FindVarNameId("never_created"));
+  EXPECT_EQ(nullptr, ss.FindVar("never_created"));
+}
+
+TEST(Scope, EraseAndRename) {
+  Scope s;
+  std::vector<Variable*> vars;
+  for (int i = 0; i < 1000; ++i) {
+    vars.push_back(s.Var("v" + std::to_string(i)));
+  }
+  EXPECT_EQ(s.Size(), 1000UL);
+  s.EraseVars({"v1", "v2"});
+  EXPECT_EQ(nullptr, s.FindVar("v1"));
+  EXPECT_EQ(vars[3], s.FindVar("v3"));
+  EXPECT_EQ(s.Size(), 998UL);
+
+  s.Rename("v3", "w3");
+  EXPECT_EQ(nullptr, s.FindVar("v3"));
+  EXPECT_EQ(vars[3], s.FindVar("w3"));
+  EXPECT_ANY_THROW(s.Rename("v4", "v5"));
+  EXPECT_EQ(s.Size(), 998UL);
+  EXPECT_EQ(s.LocalVarNames().size(), 998UL);
+
+  s.EraseVarsExcept({vars[10]});
+  EXPECT_EQ(s.Size(), 1UL);
+  EXPECT_EQ(vars[10], s.FindVar("v10"));
+  EXPECT_EQ(nullptr, s.FindVar("v11"));
+
+  // erased slots are dropped when the table is replaced
+  for (int i = 0; i < 10000; ++i) {
+    std::string name = "tmp" + std::to_string(i);
+    s.Var(name);
+    s.EraseVars({name});
+  }
+  EXPECT_EQ(s.Size(), 1UL);
+  EXPECT_EQ(vars[10], s.FindVar("v10"));
+}
+
+TEST(Scope, NamesReleased) {
+  size_t num_names = paddle::framework::NumInternedVarNames();
+  for (int round = 0; round < 3; ++round) {
+    Scope s;
+    Scope& kid = s.NewScope();
+    // unique to a round, as the temporaries of an executor
+    for (int i = 0; i < 1000; ++i) {
+      kid.Var("released_" + std::to_string(round) + "_" + std::to_string(i));
+    }
+    s.Var("released");
+    kid.Var("released");
+    EXPECT_EQ(paddle::framework::NumInternedVarNames(), num_names + 1001);
+  }
+  EXPECT_EQ(paddle::framework::NumInternedVarNames(), num_names);
+
+  // an erased name is released when the table is replaced, and its id is
+  // not reused
+  Scope s;
+  s.Var("erased");
+  VarNameId id = paddle::framework::FindVarNameId("erased");
+  s.EraseVars({"erased"});
+  for (int i = 0; i < 1000; ++i) {
+    std::string name = "tmp" + std::to_string(i);
+    s.Var(name);
+    s.EraseVars({name});
+  }
+  EXPECT_EQ(paddle::framework::kInvalidVarNameId,
+            paddle::framework::FindVarNameId("erased"));
+  EXPECT_LE(paddle::framework::NumInternedVarNames(), num_names + 16);
+  Variable* v = s.Var("erased");
+  EXPECT_NE(id, paddle::framework::FindVarNameId("erased"));
+  EXPECT_EQ(nullptr, s.FindVarById(id));
+  EXPECT_EQ(v, s.FindVar("erased"));
+}
+
+TEST(Scope, GeneratedNamesNotInterned) {
+  Scope s;
+  Scope& kid = s.NewScope();
+  std::string name;
+  Variable* v = s.Var(&name);
+  EXPECT_EQ(paddle::framework::kInvalidVarNameId,
+            paddle::framework::FindVarNameId(name));
+  EXPECT_EQ(v, s.FindVar(name));
+  EXPECT_EQ(v, s.FindLocalVar(name));
+  EXPECT_EQ(v, kid.FindVar(name));
+  EXPECT_EQ(nullptr, kid.FindLocalVar(name));
+  EXPECT_EQ(&s, kid.FindScope(name));
+  EXPECT_EQ(&s, kid.FindScope(v));
+  EXPECT_EQ(s.LocalVarNames(), std::vector<std::string>{name});
+
+  // renamed to a generated name and back
+  std::string generated = s.Rename(name);
+  EXPECT_EQ(paddle::framework::kInvalidVarNameId,
+            paddle::framework::FindVarNameId(generated));
+  EXPECT_EQ(nullptr, s.FindVar(name));
+  EXPECT_EQ(v, s.FindVar(generated));
+  s.Rename(generated, "named");
+  EXPECT_EQ(v, s.FindVar("named"));
+  EXPECT_EQ(nullptr, s.FindVar(generated));
+  EXPECT_EQ(s.Size(), 1UL);
+
+  Variable* w = s.Var(&name);
+  EXPECT_ANY_THROW(s.Rename("named", name));
+  EXPECT_EQ(s.Size(), 2UL);
+  s.EraseVars({name});
+  EXPECT_EQ(nullptr, s.FindVar(name));
+  EXPECT_EQ(s.Size(), 1UL);
+  EXPECT_NE(w, s.FindVar("named"));
+}
+
+TEST(Scope, ConcurrentFindVar) {
+  Scope s;
+  std::vector<std::string> names;
+  for (int i = 0; i < 64; ++i) {
+    names.push_back("r" + std::to_string(i));
+    s.Var(names.back());
+  }
+  std::atomic<bool> stop{false};
+  std::atomic<int> missing{0};
+  std::vector<std::thread> readers;
+  for (int t = 0; t < 4; ++t) {
+    readers.emplace_back([&] {
+      while (!stop) {
+        for (auto& name : names) {
+          missing += s.FindVar(name) == nullptr;
+        }
+      }
+    });
+  }
+  // the writer grows and replaces the table while the readers run
+  for (int i = 0; i < 100000; ++i) {
+    std::string name = "w" + std::to_string(i);
+    s.Var(name);
+    if (i % 2 == 0) {
+      s.EraseVars({name});
+    }
+  }
+  stop = true;
+  for (auto& reader : readers) {
+    reader.join();
+  }
+  EXPECT_EQ(missing, 0);
+}
+
+TEST(Scope, FindVarBenchmark) {
+  Scope s;
+  std::vector<std::string> names;
+  for (int i = 0; i < 200; ++i) {
+    names.push_back("fc_" + std::to_string(i) + ".tmp_0");
+    s.Var(names.back());
+  }
+  std::vector<VarNameId> ids;
+  for (auto& name : names) {
+    ids.push_back(paddle::framework::FindVarNameId(name));
+  }
+  // the variables are in the parent scope, as the parameters of a program
+  Scope& kid = s.NewScope();
+  constexpr int kRepeat = 10000;
+  size_t found = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int r = 0; r < kRepeat; ++r) {
+    for (auto& name : names) {
+      found += kid.FindVar(name) != nullptr;
+    }
+  }
+  auto mid = std::chrono::steady_clock::now();
+  for (int r = 0; r < kRepeat; ++r) {
+    for (auto id : ids) {
+      found += kid.FindVarById(id) != nullptr;
+    }
+  }
+  auto end = std::chrono::steady_clock::now();
+  EXPECT_EQ(found, 2UL * kRepeat * names.size());
+  double lookups = static_cast<double>(kRepeat) * names.size();
+  std::cout << "FindVar: "
+            << lookups / std::chrono::duration<double>(mid - start).count()
+            << " lookups/s, FindVarById: "
+            << lookups / std::chrono::duration<double>(end - mid).count()
+            << " lookups/s" << std::endl;
+}
@@ -16,12 +16,16 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
 #include <chrono>
+#include <cmath>
+#include <functional>
 #include <iostream>
 #include <string>
 
 #include "paddle/phi/core/kernel_registry.h"
 
+#include "paddle/fluid/framework/new_executor/garbage_collector/batched_garbage_collector.h"
 #include "paddle/fluid/framework/new_executor/pir_interpreter.h"
 #include "paddle/fluid/pir/dialect/operator/ir/control_flow_op.h"
 #include "paddle/fluid/pir/dialect/operator/ir/op_dialect.h"
@@ -33,12 +37,17 @@
 
 #include "paddle/fluid/pir/dialect/operator/ir/op_type.h"
 
+#include "paddle/common/flags.h"
 #include "paddle/common/macros.h"
 #include "paddle/pir/include/dialect/control_flow/ir/cf_dialect.h"
 #include "paddle/pir/include/dialect/control_flow/ir/cf_op.h"
 
 DECLARE_FILE_SYMBOLS(kernel_dialect);
 
+COMMON_DECLARE_bool(enable_pir_shape_specialization);
+COMMON_DECLARE_bool(enable_pir_cpu_replay);
+COMMON_DECLARE_bool(new_executor_batched_gc);
+
 PD_DECLARE_KERNEL(full, CPU, ALL_LAYOUT);
 PD_DECLARE_KERNEL(full_int_array, CPU, ALL_LAYOUT);
 PD_DECLARE_KERNEL(uniform, CPU, ALL_LAYOUT);
@@ -176,6 +185,262 @@ TEST(StandaloneExecutor, run_feed_tensor) {
   EXPECT_EQ(res0, true);
 }
 
+TEST(StandaloneExecutor, run_shape_specialization) {
+  FLAGS_enable_pir_shape_specialization = true;
+  pir::IrContext* ctx = pir::IrContext::Instance();
+  pir::Program program(ctx);
+
+  ctx->GetOrRegisterDialect<paddle::dialect::OperatorDialect>();
+
+  pir::Builder builder = pir::Builder(ctx, program.block());
+
+  pir::OpInfo feed_op_info =
+      ctx->GetRegisteredOpInfo(paddle::dialect::FeedOp::name());
+
+  pir::Type fp32_dtype = pir::Float32Type::get(ctx);
+  phi::DDim dims = {-1};
+  phi::DataLayout data_layout = phi::DataLayout::NCHW;
+  phi::LoD lod = {{0}};
+  size_t offset = 0;
+  pir::Type dense_tensor_dtype = paddle::dialect::DenseTensorType::get(
+      ctx, fp32_dtype, dims, data_layout, lod, offset);
+
+  std::vector<pir::Operation*> feed_ops;
+  for (const char* name : {"x", "y"}) {
+    pir::AttributeMap attr_map;
+    attr_map.insert(std::pair<std::string, pir::Attribute>(
+        "name", pir::StrAttribute::get(ctx, name)));
+    attr_map.insert(std::pair<std::string, pir::Attribute>(
+        "col", pir::Int32Attribute::get(ctx, 0)));
+    pir::Operation* feed_op = pir::Operation::Create(
+        {}, attr_map, {dense_tensor_dtype}, feed_op_info);
+    program.block()->push_back(feed_op);
+    feed_ops.push_back(feed_op);
+  }
+
+  auto add_op = builder.Build<paddle::dialect::AddOp>(feed_ops[0]->result(0),
+                                                      feed_ops[1]->result(0));
+  auto sqrt_op = builder.Build<paddle::dialect::SqrtOp>(add_op->result(0));
+  std::string out_name = "sqrt_out";
+  builder.Build<pir::ShadowOutputOp>(sqrt_op->result(0), out_name);
+
+  auto kernel_program = paddle::dialect::PdOpLowerToKernelPass(&program);
+
+  auto place = phi::CPUPlace();
+  Scope scope;
+  InterpreterCore test_core(place, {}, kernel_program->block(), &scope);
+
+  test_core.SetSkipGcVars({out_name});
+
+  phi::DeviceContext* dev_ctx =
+      phi::DeviceContextPool::Instance().Get(phi::CPUPlace());
+  auto make_tensor = [&](int64_t numel, float value) {
+    phi::DenseTensor tensor;
+    tensor.set_meta(phi::DenseTensorMeta(
+        phi::DataType::FLOAT32, {numel}, data_layout, lod, offset));
+    dev_ctx->Alloc(&tensor, phi::DataType::FLOAT32);
+    std::fill_n(tensor.data<float>(), numel, value);
+    return tensor;
+  };
+
+  // the second run reuses the metas of the first one, and the third one
+  // changes the shape and runs InferMeta again
+  std::vector<int64_t> numels = {4, 4, 6, 6, 4};
+  for (size_t i = 0; i < numels.size(); ++i) {
+    float value = static_cast<float>(i + 1);
+    test_core.Run(
+        {"x", "y"},
+        {make_tensor(numels[i], value), make_tensor(numels[i], value)});
+
+    auto out_tensor =
+        test_core.local_scope() == nullptr
+            ? scope.FindVar(out_name)->Get<phi::DenseTensor>()
+            : test_core.local_scope()
+                  ->FindVar(out_name)
+                  ->Get<phi::DenseTensor>();
+    EXPECT_EQ(out_tensor.dims(), common::make_ddim({numels[i]}));
+    for (int64_t j = 0; j < numels[i]; ++j) {
+      EXPECT_TRUE(
+          simple_cmp(out_tensor.data<float>()[j], std::sqrt(2.0f * value)));
+    }
+  }
+  FLAGS_enable_pir_shape_specialization = false;
+}
+
+// A chain of adds of numel elements, where the interpreter overhead
+// dominates for small numel. Runs it num_runs times with the current flags
+// and returns the last element of the result.
+static float RunAddChain(
+    int64_t numel,
+    int num_runs,
+    size_t* replayed_runs = nullptr,
+    double* us_per_run = nullptr,
+    const std::function<void(const PirInterpreter&)>& after_runs = nullptr) {
+  pir::IrContext* ctx = pir::IrContext::Instance();
+  pir::Program program(ctx);
+  ctx->GetOrRegisterDialect<paddle::dialect::OperatorDialect>();
+  pir::Builder builder = pir::Builder(ctx, program.block());
+
+  paddle::dialect::FullOp one = builder.Build<paddle::dialect::FullOp>(
+      std::vector<int64_t>{numel},
+      1.0,
+      phi::DataType::FLOAT32,
+      phi::CPUPlace());
+  paddle::dialect::FullOp zero = builder.Build<paddle::dialect::FullOp>(
+      std::vector<int64_t>{numel},
+      0.0,
+      phi::DataType::FLOAT32,
+      phi::CPUPlace());
+  pir::Value out = zero->result(0);
+  for (int i = 0; i < 64; ++i) {
+    auto add_op = builder.Build<paddle::dialect::AddOp>(out, one->result(0));
+    out = add_op->result(0);
+  }
+  std::string out_name = "chain_out";
+  builder.Build<pir::ShadowOutputOp>(out, out_name);
+
+  auto kernel_program = paddle::dialect::PdOpLowerToKernelPass(&program);
+  Scope scope;
+  InterpreterCore test_core(
+      phi::CPUPlace(), {}, kernel_program->block(), &scope);
+  test_core.SetSkipGcVars({out_name});
+
+  // the first run builds the instructions
+  test_core.Run({});
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 1; i < num_runs; ++i) {
+    test_core.Run({});
+  }
+  if (us_per_run != nullptr) {
+    *us_per_run = std::chrono::duration<double, std::micro>(
+                      std::chrono::steady_clock::now() - start)
+                      .count() /
+                  std::max(num_runs - 1, 1);
+  }
+  if (replayed_runs != nullptr) {
+    *replayed_runs = dynamic_cast<const PirInterpreter*>(test_core.Impl())
+                         ->ReplayedRunCount();
+  }
+  if (after_runs != nullptr) {
+    after_runs(*dynamic_cast<const PirInterpreter*>(test_core.Impl()));
+  }
+
+  auto out_tensor =
+      test_core.local_scope() == nullptr
+          ? scope.FindVar(out_name)->Get<phi::DenseTensor>()
+          : test_core.local_scope()->FindVar(out_name)->Get<phi::DenseTensor>();
+  return out_tensor.data<float>()[numel - 1];
+}
+
+TEST(StandaloneExecutor, run_cpu_replay) {
+  size_t trace_replayed_runs = 0;
+  size_t replayed_runs = 0;
+  float trace_result = RunAddChain(16, 5, &trace_replayed_runs);
+  FLAGS_enable_pir_cpu_replay = true;
+  FLAGS_enable_pir_shape_specialization = true;
+  float replay_result = RunAddChain(16, 5, &replayed_runs);
+  FLAGS_enable_pir_cpu_replay = false;
+  FLAGS_enable_pir_shape_specialization = false;
+  EXPECT_TRUE(simple_cmp(trace_result, 64.0));
+  EXPECT_TRUE(simple_cmp(replay_result, 64.0));
+  // the first run traces the execute order, the others are replayed
+  EXPECT_EQ(trace_replayed_runs, 0UL);
+  EXPECT_EQ(replayed_runs, 4UL);
+}
+
+TEST(StandaloneExecutor, release_var_names) {
+  // the names of the variables of an interpreter are unique to it, and are
+  // released with its scope
+  RunAddChain(16, 1);
+  size_t num_names = NumInternedVarNames();
+  for (int i = 0; i < 10; ++i) {
+    RunAddChain(16, 1);
+  }
+  EXPECT_EQ(NumInternedVarNames(), num_names);
+}
+
+// The per-op overhead of InferMeta, i.e. the latency of the add chain with
+// and without shape specialization, where the small adds take little time.
+TEST(StandaloneExecutor, DISABLED_shape_specialization_benchmark) {
+  constexpr int kRuns = 1000;
+  double infer_meta_us = 0;
+  double specialized_us = 0;
+  RunAddChain(16, kRuns, nullptr, &infer_meta_us);
+  FLAGS_enable_pir_shape_specialization = true;
+  RunAddChain(16, kRuns, nullptr, &specialized_us);
+  FLAGS_enable_pir_shape_specialization = false;
+  LOG(INFO) << "64 adds: " << infer_meta_us << " us per run, "
+            << specialized_us << " us per run with shape specialization, "
+            << (infer_meta_us - specialized_us) / 64 << " us per op saved";
+}
+
+// The scheduling overhead saved by the replay, i.e. the latency of the add
+// chain run through the work queue and replayed in the traced order. Shape
+// specialization is on in both, so only the scheduling differs.
+TEST(StandaloneExecutor, DISABLED_cpu_replay_benchmark) {
+  constexpr int kRuns = 1000;
+  double scheduled_us = 0;
+  double replay_us = 0;
+  size_t replayed_runs = 0;
+  FLAGS_enable_pir_shape_specialization = true;
+  RunAddChain(16, kRuns, nullptr, &scheduled_us);
+  FLAGS_enable_pir_cpu_replay = true;
+  RunAddChain(16, kRuns, &replayed_runs, &replay_us);
+  FLAGS_enable_pir_cpu_replay = false;
+  FLAGS_enable_pir_shape_specialization = false;
+  EXPECT_EQ(replayed_runs, static_cast<size_t>(kRuns - 1));
+  LOG(INFO) << "64 adds: " << scheduled_us << " us per run scheduled, "
+            << replay_us << " us per run replayed, "
+            << (scheduled_us - replay_us) / 64 << " us per op saved";
+}
+
+// Sets a bool flag in a scope, and restores it also when a failed assertion
+// returns early.
+class ScopedBoolFlag {
+ public:
+  ScopedBoolFlag(bool* flag, bool value) : flag_(flag), old_value_(*flag) {
+    *flag_ = value;
+  }
+  ~ScopedBoolFlag() { *flag_ = old_value_; }
+
+ private:
+  bool* flag_;
+  bool old_value_;
+};
+
+TEST(StandaloneExecutor, run_batched_gc) {
+  using Collector = InterpreterCoreBatchedGarbageCollector;
+  ScopedBoolFlag batched_gc(&FLAGS_new_executor_batched_gc, true);
+  constexpr int kRuns = 50;
+  // the batches of 64 bytes intermediates are bounded by their number, the
+  // ones of 16 MB intermediates by their memory
+  for (int64_t numel : {16, 1 << 22}) {
+    size_t batches = 0;
+    size_t garbages = 0;
+    size_t held = 0;
+    float result = RunAddChain(
+        numel, kRuns, nullptr, nullptr, [&](const PirInterpreter& core) {
+          auto* gc = dynamic_cast<const Collector*>(core.GarbageCollector());
+          ASSERT_NE(gc, nullptr);
+          batches = gc->NumQueuedBatches();
+          garbages = gc->NumAddedGarbages();
+          held = gc->NumHeldGarbages();
+        });
+    EXPECT_TRUE(simple_cmp(result, 64.0));
+    // at least the 63 intermediate sums of each run are collected
+    EXPECT_GE(garbages, 63UL * kRuns);
+    // each run flushes what is left in its batch
+    EXPECT_EQ(held, 0UL);
+    EXPECT_GE(batches, static_cast<size_t>(kRuns));
+    // all batches but the last one of a run are full
+    size_t bytes = numel * sizeof(float);
+    size_t batch_size = std::min<size_t>(Collector::kMaxBatchSize,
+                                         Collector::kMaxHeldMemorySize / bytes);
+    EXPECT_GE(batches, garbages / batch_size);
+    EXPECT_LE(batches, garbages / batch_size + kRuns);
+  }
+}
+
 TEST(StandaloneExecutor, run_inplace_sqrt) {
   pir::IrContext* ctx = pir::IrContext::Instance();
   pir::Program program((ctx));
@@ -331,16 +596,26 @@ TEST(StandaloneExecutor, while_op) {
 
   test_core.SetSkipGcVars({out_name});
 
-  test_core.Run({});
-
-  auto out_tensor =
-      test_core.local_scope() == nullptr
-          ? scope.FindVar(out_name)->Get<phi::DenseTensor>()
-          : test_core.local_scope()->FindVar(out_name)->Get<phi::DenseTensor>();
-
-  bool res0 = out_tensor.data<int>()[0] == 11;
-
-  EXPECT_EQ(res0, true);
+  // the programs with control flow are not replayed
+  FLAGS_enable_pir_cpu_replay = true;
+  for (int run = 0; run < 2; ++run) {
+    test_core.Run({});
+
+    auto out_tensor =
+        test_core.local_scope() == nullptr
+            ? scope.FindVar(out_name)->Get<phi::DenseTensor>()
+            : test_core.local_scope()
+                  ->FindVar(out_name)
+                  ->Get<phi::DenseTensor>();
+
+    bool res0 = out_tensor.data<int>()[0] == 11;
+
+    EXPECT_EQ(res0, true);
+  }
+  EXPECT_EQ(dynamic_cast<const PirInterpreter*>(test_core.Impl())
+                ->ReplayedRunCount(),
+            0UL);
+  FLAGS_enable_pir_cpu_replay = false;
 }
 
 }  // namespace framework
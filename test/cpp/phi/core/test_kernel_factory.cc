@@ -12,10 +12,12 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License. */
 
+#include <chrono>
 #include <iostream>
 #include <sstream>
 
 #include "gtest/gtest.h"
+#include "paddle/common/flags.h"
 #include "paddle/phi/common/float16.h"
 #include "paddle/phi/core/dense_tensor.h"
 #include "paddle/phi/core/kernel_factory.h"
@@ -23,6 +25,8 @@ limitations under the License. */
 
 PD_DECLARE_KERNEL(scale, CPU, ALL_LAYOUT);
 
+COMMON_DECLARE_bool(enable_api_kernel_fallback);
+
 namespace phi {
 namespace tests {
 
@@ -48,6 +52,79 @@ TEST(KernelFactory, SelectedKernelMap) {
   }
 }
 
+TEST(KernelSelectionCache, Select) {
+  auto& factory = phi::KernelFactory::Instance();
+  phi::KernelKey fp32_key(
+      phi::Backend::CPU, phi::DataLayout::ALL_LAYOUT, phi::DataType::FLOAT32);
+  phi::KernelKey fp64_key(
+      phi::Backend::CPU, phi::DataLayout::ALL_LAYOUT, phi::DataType::FLOAT64);
+  const auto& fp32_kernel =
+      factory.SelectKernelOrThrowError("scale", fp32_key).kernel;
+  const auto& fp64_kernel =
+      factory.SelectKernelOrThrowError("scale", fp64_key).kernel;
+
+  phi::KernelSelectionCache cache("scale");
+  EXPECT_EQ(&cache.Select(fp32_key).kernel, &fp32_kernel);
+  EXPECT_EQ(&cache.Select(fp32_key).kernel, &fp32_kernel);
+  EXPECT_EQ(&cache.Select(fp64_key).kernel, &fp64_kernel);
+  factory.IncreaseKernelsVersion();
+  EXPECT_EQ(&cache.Select(fp64_key).kernel, &fp64_kernel);
+  EXPECT_EQ(&cache.Select(fp32_key).kernel, &fp32_kernel);
+
+  phi::KernelSelectionCache missing_cache("scale_not_registered");
+  EXPECT_ANY_THROW(missing_cache.Select(fp32_key));
+
+  // "test" has cpu kernels only, so a gpu key falls back to cpu, and the
+  // cached result follows FLAGS_enable_api_kernel_fallback
+  phi::KernelKey gpu_key(
+      phi::Backend::GPU, phi::DataLayout::ALL_LAYOUT, phi::DataType::FLOAT32);
+  phi::KernelKey cpu_key(
+      phi::Backend::CPU, phi::DataLayout::ALL_LAYOUT, phi::DataType::FLOAT32);
+  const auto& cpu_kernel =
+      factory.SelectKernelOrThrowError("test", cpu_key).kernel;
+  phi::KernelSelectionCache fallback_cache("test");
+  const bool fallback = FLAGS_enable_api_kernel_fallback;
+  FLAGS_enable_api_kernel_fallback = true;
+  for (int i = 0; i < 2; ++i) {
+    auto result = fallback_cache.Select(gpu_key);
+    EXPECT_EQ(&result.kernel, &cpu_kernel);
+    EXPECT_TRUE(result.has_fallback_cpu);
+  }
+#if !defined(PADDLE_WITH_XPU)
+  FLAGS_enable_api_kernel_fallback = false;
+  EXPECT_ANY_THROW(fallback_cache.Select(gpu_key));
+#endif
+  FLAGS_enable_api_kernel_fallback = fallback;
+  EXPECT_TRUE(fallback_cache.Select(cpu_key).kernel.IsValid());
+  EXPECT_FALSE(fallback_cache.Select(cpu_key).has_fallback_cpu);
+}
+
+// The host overhead of the kernel selection of a small op, with and without
+// the cache.
+TEST(KernelSelectionCache, DISABLED_Benchmark) {
+  auto& factory = phi::KernelFactory::Instance();
+  phi::KernelKey fp32_key(
+      phi::Backend::CPU, phi::DataLayout::ALL_LAYOUT, phi::DataType::FLOAT32);
+  phi::KernelSelectionCache cache("scale");
+  constexpr int kRepeat = 1000000;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < kRepeat; ++i) {
+    factory.SelectKernelOrThrowError("scale", fp32_key, true);
+  }
+  auto mid = std::chrono::steady_clock::now();
+  for (int i = 0; i < kRepeat; ++i) {
+    cache.Select(fp32_key, true);
+  }
+  auto end = std::chrono::steady_clock::now();
+  std::cout << "SelectKernelOrThrowError: "
+            << std::chrono::duration<double, std::nano>(mid - start).count() /
+                   kRepeat
+            << " ns, KernelSelectionCache: "
+            << std::chrono::duration<double, std::nano>(end - mid).count() /
+                   kRepeat
+            << " ns" << std::endl;
+}
+
 template <typename T, typename Context>
 void TestKernel(const Context& dev_ctx,
                 const DenseTensor& x,
@@ -0,0 +1,178 @@
+/* Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <chrono>
+#include <random>
+#include <vector>
+
+#include "glog/logging.h"
+#include "gtest/gtest.h"
+#include "paddle/phi/kernels/funcs/detection/batched_nms.h"
+#include "paddle/phi/kernels/funcs/detection/nms_util.h"
+
+namespace phi {
+namespace tests {
+
+// The NMSFast of the multiclass_nms kernels for [xmin ymin xmax ymax] boxes.
+template <typename T>
+void RefNMS(const std::vector<T>& boxes,
+            const std::vector<T>& scores,
+            T score_threshold,
+            T nms_threshold,
+            T eta,
+            int top_k,
+            bool normalized,
+            std::vector<int>* selected_indices) {
+  std::vector<std::pair<T, int>> sorted_indices;
+  funcs::GetMaxScoreIndex<T>(scores, score_threshold, top_k, &sorted_indices);
+  selected_indices->clear();
+  T adaptive_threshold = nms_threshold;
+  for (const auto& item : sorted_indices) {
+    const int idx = item.second;
+    bool keep = true;
+    for (const auto kept_idx : *selected_indices) {
+      T overlap = funcs::JaccardOverlap<T>(
+          boxes.data() + idx * 4, boxes.data() + kept_idx * 4, normalized);
+      if (!(overlap <= adaptive_threshold)) {
+        keep = false;
+        break;
+      }
+    }
+    if (keep) {
+      selected_indices->push_back(idx);
+      if (eta < 1 && adaptive_threshold > 0.5) {
+        adaptive_threshold *= eta;
+      }
+    }
+  }
+}
+
+// Detector like candidates: boxes jittered around a few objects, so that
+// most of them overlap with some others, and mostly low scores.
+template <typename T>
+void RandomDetections(int num_boxes,
+                      int num_objects,
+                      unsigned int seed,
+                      std::vector<T>* boxes,
+                      std::vector<T>* scores) {
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<double> uniform(0, 1);
+  std::normal_distribution<double> jitter(0, 8);
+  std::vector<double> objects(num_objects * 4);
+  for (int i = 0; i < num_objects; ++i) {
+    double cx = uniform(rng) * 640;
+    double cy = uniform(rng) * 640;
+    double w = 16 + uniform(rng) * 200;
+    double h = 16 + uniform(rng) * 200;
+    objects[i * 4] = cx - w / 2;
+    objects[i * 4 + 1] = cy - h / 2;
+    objects[i * 4 + 2] = cx + w / 2;
+    objects[i * 4 + 3] = cy + h / 2;
+  }
+  boxes->resize(num_boxes * 4);
+  scores->resize(num_boxes);
+  for (int i = 0; i < num_boxes; ++i) {
+    int obj = static_cast<int>(uniform(rng) * num_objects) % num_objects;
+    for (int k = 0; k < 4; ++k) {
+      (*boxes)[i * 4 + k] = static_cast<T>(objects[obj * 4 + k] + jitter(rng));
+    }
+    double score = uniform(rng);
+    (*scores)[i] = static_cast<T>(score * score * score);
+  }
+  // some ties
+  for (int i = 1; i < num_boxes; i += 7) {
+    (*scores)[i] = (*scores)[i - 1];
+  }
+}
+
+template <typename T>
+void TestAndBench(int num_boxes,
+                  int num_classes,
+                  T score_threshold,
+                  T nms_threshold,
+                  T eta,
+                  int top_k,
+                  bool normalized) {
+  std::vector<std::vector<T>> boxes(num_classes);
+  std::vector<std::vector<T>> scores(num_classes);
+  for (int c = 0; c < num_classes; ++c) {
+    RandomDetections<T>(num_boxes, 20, 2024 + c, &boxes[c], &scores[c]);
+  }
+
+  std::vector<std::vector<int>> tgt(num_classes), ref(num_classes);
+  auto st = std::chrono::steady_clock::now();
+  for (int c = 0; c < num_classes; ++c) {
+    funcs::GreedyNMS<T>(boxes[c].data(),
+                        4,
+                        scores[c].data(),
+                        1,
+                        num_boxes,
+                        score_threshold,
+                        nms_threshold,
+                        eta,
+                        top_k,
+                        normalized,
+                        &tgt[c]);
+  }
+  auto mt = std::chrono::steady_clock::now();
+  for (int c = 0; c < num_classes; ++c) {
+    RefNMS<T>(boxes[c],
+              scores[c],
+              score_threshold,
+              nms_threshold,
+              eta,
+              top_k,
+              normalized,
+              &ref[c]);
+  }
+  auto et = std::chrono::steady_clock::now();
+
+  VLOG(3) << num_classes << " classes x " << num_boxes
+          << " boxes, score_threshold " << score_threshold
+          << ": refer takes: "
+          << std::chrono::duration<double, std::milli>(et - mt).count()
+          << " ms, tgt takes: "
+          << std::chrono::duration<double, std::milli>(mt - st).count()
+          << " ms";
+  for (int c = 0; c < num_classes; ++c) {
+    EXPECT_EQ(tgt[c], ref[c]);
+  }
+}
+
+TEST(BatchedNMSTest, sorted_score_indices) {
+  std::vector<float> scores = {0.1f, 0.9f, 0.5f, 0.9f, 0.05f, 0.5f};
+  std::vector<int> indices;
+  funcs::GetSortedScoreIndices<float>(
+      scores.data(), 1, scores.size(), 0.08f, -1, &indices);
+  EXPECT_EQ(indices, std::vector<int>({1, 3, 2, 5, 0}));
+  funcs::GetSortedScoreIndices<float>(
+      scores.data(), 1, scores.size(), 0.08f, 3, &indices);
+  EXPECT_EQ(indices, std::vector<int>({1, 3, 2}));
+  // strided, the scores of class 1 of [M, 2] scores
+  funcs::GetSortedScoreIndices<float>(
+      scores.data() + 1, 2, scores.size() / 2, 0.08f, -1, &indices);
+  EXPECT_EQ(indices, std::vector<int>({0, 1, 2}));
+}
+
+TEST(BatchedNMSTest, greedy_nms) {
+  // yolo like post process and eval like settings
+  TestAndBench<float>(8400, 16, 0.25f, 0.45f, 1.0f, 1000, false);
+  TestAndBench<float>(8400, 16, 0.01f, 0.6f, 1.0f, 1000, false);
+  TestAndBench<float>(8400, 4, 0.01f, 0.6f, 1.0f, -1, false);
+  TestAndBench<float>(1000, 4, 0.05f, 0.7f, 0.9f, 300, false);
+  TestAndBench<double>(1000, 4, 0.05, 0.5, 1.0, 300, false);
+}
+
+}  // namespace tests
+}  // namespace phi
@@ -0,0 +1,106 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+#include "paddle/phi/kernels/autotune/cpu_auto_tune.h"
+
+COMMON_DECLARE_string(cpu_autotune_cache_file);
+
+namespace tune = phi::autotune;
+
+void SlowKernel(int* calls) {
+  std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  calls[0]++;
+}
+
+void FastKernel(int* calls) { calls[1]++; }
+
+TEST(CpuAutoTune, MathLibraryNumThreads) {
+  // a part of the matmul keys, the blas candidates run with it
+  EXPECT_GE(tune::CpuMathLibraryNumThreads(), 1);
+}
+
+TEST(CpuAutoTune, PickAndPersist) {
+  FLAGS_use_cpu_autotune = true;
+  FLAGS_cpu_autotune_cache_file = "./test_cpu_auto_tune_cache.txt";
+  std::remove(FLAGS_cpu_autotune_cache_file.c_str());
+  tune::AutoTuneCache::Instance().Clean();
+
+  auto* tuner = tune::MakeCpuTuner<float>(SlowKernel, FastKernel);
+  const auto algo_type = tune::AlgorithmType::kCpuMatmul;
+  const size_t key = tune::GenKey(std::vector<int64_t>{3, 4}, true);
+
+  // every candidate runs once as warmup and then kCpuAutoTuneRepeats times
+  int calls[2] = {0, 0};
+  const int num_trials = 2 * (tune::kCpuAutoTuneRepeats + 1);
+  for (int i = 0; i < num_trials; ++i) {
+    tuner->Run(algo_type, key, calls);
+  }
+  EXPECT_EQ(calls[0], tune::kCpuAutoTuneRepeats + 1);
+  EXPECT_EQ(calls[1], tune::kCpuAutoTuneRepeats + 1);
+
+  auto& cache = tune::AutoTuneCache::Instance().GetCpu(algo_type);
+  EXPECT_EQ(cache.Size(), 1);
+  tuner->Run(algo_type, key, calls);
+  tuner->Run(algo_type, key, calls);
+  EXPECT_EQ(calls[0], tune::kCpuAutoTuneRepeats + 1);
+  EXPECT_EQ(calls[1], tune::kCpuAutoTuneRepeats + 3);
+  EXPECT_EQ(cache.ChosenCounts()[1], 2);
+  EXPECT_EQ(cache.CacheMisses(), num_trials);
+
+  // the result is saved with the tag of this CPU, in batch
+  std::ifstream not_saved(FLAGS_cpu_autotune_cache_file);
+  EXPECT_FALSE(not_saved.is_open());
+  tune::AutoTuneCache::Instance().SaveCpuCache();
+  std::ifstream fin(FLAGS_cpu_autotune_cache_file);
+  std::stringstream content;
+  content << fin.rdbuf();
+  EXPECT_NE(content.str().find(tune::CpuAutoTuneTag() + " cpu_matmul " +
+                               std::to_string(key) + " 1"),
+            std::string::npos);
+
+  // and loaded by the next process, without tuning again
+  tune::AutoTuneCache::Instance().Clean();
+  EXPECT_EQ(cache.Size(), 0);
+  tuner->Run(algo_type, key, calls);
+  EXPECT_EQ(calls[0], tune::kCpuAutoTuneRepeats + 1);
+  EXPECT_EQ(calls[1], tune::kCpuAutoTuneRepeats + 4);
+  EXPECT_EQ(cache.CacheHits(), 1);
+
+  tune::AutoTuneCache::Instance().UpdateStatus();
+  EXPECT_GE(tune::AutoTuneCache::Instance().CacheHits(), 1);
+
+  // an out of range result, e.g. of a stale file, falls back to the default
+  const size_t stale_key = tune::GenKey(std::vector<int64_t>{5, 6}, true);
+  {
+    std::ofstream fout(FLAGS_cpu_autotune_cache_file, std::ios::app);
+    fout << tune::CpuAutoTuneTag() << " cpu_matmul " << stale_key << " 7\n";
+  }
+  tune::AutoTuneCache::Instance().Clean();
+  tuner->Run(algo_type, stale_key, calls);
+  EXPECT_EQ(calls[0], tune::kCpuAutoTuneRepeats + 2);
+  EXPECT_EQ(cache.Get(stale_key), 0);
+
+  std::remove(FLAGS_cpu_autotune_cache_file.c_str());
+  FLAGS_cpu_autotune_cache_file = "";
+  FLAGS_use_cpu_autotune = false;
+  tune::AutoTuneCache::Instance().Clean();
+}
@@ -0,0 +1,231 @@
+/* Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <chrono>
+#include <map>
+#include <random>
+#include <set>
+#include <vector>
+
+#include "glog/logging.h"
+#include "paddle/phi/api/lib/utils/allocator.h"
+#include "paddle/phi/backends/context_pool.h"
+#include "paddle/phi/backends/cpu/cpu_context.h"
+#include "paddle/phi/common/place.h"
+#include "paddle/phi/core/dense_tensor.h"
+#include "paddle/phi/core/sparse_coo_tensor.h"
+#include "paddle/phi/kernels/sparse/conv_kernel.h"
+
+namespace phi {
+namespace tests {
+
+// (batch, z, y, x)
+using Point = std::array<int, 4>;
+
+struct PointCloud {
+  std::vector<Point> points;
+  std::vector<float> features;
+};
+
+// voxels of a few sweeps clustered around the ground plane, the way a
+// voxelized LiDAR scan looks
+PointCloud RandomPointCloud(
+    int batch, int depth, int height, int width, int nnz, int channels) {
+  std::mt19937 rng(2024);
+  std::uniform_int_distribution<int> dist_y(0, height - 1);
+  std::uniform_int_distribution<int> dist_x(0, width - 1);
+  std::geometric_distribution<int> dist_z(0.3);
+  std::uniform_real_distribution<float> dist_v(-1.0f, 1.0f);
+  std::set<Point> unique_points;
+  while (static_cast<int>(unique_points.size()) < nnz) {
+    int b = static_cast<int>(unique_points.size()) % batch;
+    int y = dist_y(rng), x = dist_x(rng);
+    int z = std::min(dist_z(rng), depth - 1);
+    // grow small objects around every seed
+    for (int dy = 0; dy < 2; ++dy) {
+      for (int dx = 0; dx < 2; ++dx) {
+        if (y + dy < height && x + dx < width) {
+          unique_points.insert({b, z, y + dy, x + dx});
+        }
+      }
+    }
+  }
+  PointCloud cloud;
+  cloud.points.assign(unique_points.begin(), unique_points.end());
+  cloud.features.resize(cloud.points.size() * channels);
+  for (auto& v : cloud.features) {
+    v = dist_v(rng);
+  }
+  return cloud;
+}
+
+SparseCooTensor MakeCoo(const phi::CPUContext& dev_ctx,
+                        const PointCloud& cloud,
+                        const std::vector<int64_t>& dims) {
+  const int64_t nnz = static_cast<int64_t>(cloud.points.size());
+  const int64_t channels = dims[4];
+  DenseTensor indices;
+  indices.Resize(common::make_ddim({4, nnz}));
+  int* indices_ptr = dev_ctx.template Alloc<int>(&indices);
+  for (int64_t i = 0; i < nnz; ++i) {
+    for (int d = 0; d < 4; ++d) {
+      indices_ptr[d * nnz + i] = cloud.points[i][d];
+    }
+  }
+  DenseTensor values;
+  values.Resize(common::make_ddim({nnz, channels}));
+  float* values_ptr = dev_ctx.template Alloc<float>(&values);
+  std::copy(cloud.features.begin(), cloud.features.end(), values_ptr);
+  return SparseCooTensor(indices, values, common::make_ddim(dims));
+}
+
+// naive scatter of every (input point, kernel offset) pair
+std::map<Point, std::vector<float>> ReferenceConv(
+    const PointCloud& cloud,
+    const std::vector<float>& weight,
+    const std::array<int, 3>& out_dims,
+    int kernel,
+    int pad,
+    int stride,
+    int in_channels,
+    int out_channels,
+    bool subm) {
+  std::set<Point> inputs(cloud.points.begin(), cloud.points.end());
+  std::map<Point, std::vector<float>> out;
+  for (size_t i = 0; i < cloud.points.size(); ++i) {
+    const Point& p = cloud.points[i];
+    for (int kz = 0; kz < kernel; ++kz) {
+      for (int ky = 0; ky < kernel; ++ky) {
+        for (int kx = 0; kx < kernel; ++kx) {
+          std::array<int, 3> k = {kz, ky, kx};
+          Point o = {p[0], 0, 0, 0};
+          bool valid = true;
+          for (int d = 0; d < 3; ++d) {
+            int shifted = p[d + 1] + pad - k[d];
+            valid = valid && shifted >= 0 && shifted % stride == 0 &&
+                    shifted / stride < out_dims[d];
+            o[d + 1] = shifted / stride;
+          }
+          if (!valid || (subm && inputs.count(o) == 0)) {
+            continue;
+          }
+          auto& row = out[o];
+          row.resize(out_channels, 0.0f);
+          const float* w =
+              weight.data() +
+              ((kz * kernel + ky) * kernel + kx) * in_channels * out_channels;
+          for (int c = 0; c < in_channels; ++c) {
+            for (int oc = 0; oc < out_channels; ++oc) {
+              row[oc] += cloud.features[i * in_channels + c] *
+                         w[c * out_channels + oc];
+            }
+          }
+        }
+      }
+    }
+  }
+  return out;
+}
+
+void CheckConv(bool subm, int stride, int nnz, int repeat) {
+  const int batch = 2, depth = 41, height = 400, width = 352;
+  const int kernel = 3, in_channels = 16, out_channels = 32;
+  const int pad = 1;
+  auto* dev_ctx = static_cast<phi::CPUContext*>(
+      phi::DeviceContextPool::Instance().Get(phi::CPUPlace()));
+
+  PointCloud cloud =
+      RandomPointCloud(batch, depth, height, width, nnz, in_channels);
+  SparseCooTensor x = MakeCoo(
+      *dev_ctx, cloud, {batch, depth, height, width, in_channels});
+
+  std::vector<float> weight(kernel * kernel * kernel * in_channels *
+                            out_channels);
+  std::mt19937 rng(7);
+  std::uniform_real_distribution<float> dist(-0.5f, 0.5f);
+  for (auto& w : weight) {
+    w = dist(rng);
+  }
+  DenseTensor kernel_tensor;
+  kernel_tensor.Resize(common::make_ddim(
+      {kernel, kernel, kernel, in_channels, out_channels}));
+  float* kernel_ptr = dev_ctx->template Alloc<float>(&kernel_tensor);
+  std::copy(weight.begin(), weight.end(), kernel_ptr);
+
+  const std::vector<int> paddings(3, pad), dilations(3, 1),
+      strides(3, stride);
+  SparseCooTensor out;
+  double total_ms = 0;
+  for (int r = 0; r < repeat; ++r) {
+    DenseTensor rulebook, counter;
+    auto start = std::chrono::steady_clock::now();
+    out = sparse::Conv3dCoo<float>(*dev_ctx,
+                                   x,
+                                   kernel_tensor,
+                                   paddings,
+                                   dilations,
+                                   strides,
+                                   1,
+                                   subm,
+                                   "",
+                                   &rulebook,
+                                   &counter);
+    total_ms += std::chrono::duration<double, std::milli>(
+                    std::chrono::steady_clock::now() - start)
+                    .count();
+  }
+  LOG(INFO) << (subm ? "subm_conv3d" : "conv3d") << " stride " << stride
+            << ", " << cloud.points.size() << " voxels: "
+            << total_ms / repeat << " ms";
+
+  std::array<int, 3> out_dims = {depth, height, width};
+  if (!subm) {
+    for (auto& d : out_dims) {
+      d = (d + 2 * pad - kernel) / stride + 1;
+    }
+  }
+  auto expected = ReferenceConv(cloud,
+                                weight,
+                                out_dims,
+                                kernel,
+                                pad,
+                                subm ? 1 : stride,
+                                in_channels,
+                                out_channels,
+                                subm);
+  ASSERT_EQ(out.nnz(), static_cast<int64_t>(expected.size()));
+  const int64_t out_nnz = out.nnz();
+  const int* out_indices = out.indices().data<int>();
+  const float* out_values = out.values().data<float>();
+  int64_t i = 0;
+  for (const auto& item : expected) {
+    for (int d = 0; d < 4; ++d) {
+      ASSERT_EQ(out_indices[d * out_nnz + i], item.first[d]);
+    }
+    for (int oc = 0; oc < out_channels; ++oc) {
+      ASSERT_NEAR(out_values[i * out_channels + oc], item.second[oc], 1e-3);
+    }
+    ++i;
+  }
+}
+
+TEST(DEV_API, sparse_subm_conv3d_point_cloud) { CheckConv(true, 1, 20000, 5); }
+
+TEST(DEV_API, sparse_conv3d_point_cloud) { CheckConv(false, 2, 20000, 5); }
+
+}  // namespace tests
+}  // namespace phi
@@ -0,0 +1,196 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <functional>
+#include <random>
+#include <vector>
+
+#include "glog/logging.h"
+#include "paddle/phi/backends/context_pool.h"
+#include "paddle/phi/backends/cpu/cpu_context.h"
+#include "paddle/phi/backends/cpu/cpu_info.h"
+#include "paddle/phi/kernels/matmul_kernel.h"
+#include "paddle/phi/kernels/weight_only_linear_kernel.h"
+
+namespace phi {
+namespace tests {
+
+// Random int8 weights of n channels in the layout of weight_quantize with
+// arch 0, i.e. [n, k], per-channel or group-wise scales, and the same
+// weights dequantized to fp32 in the layout of matmul, i.e. [k, n].
+struct Weights {
+  Weights(const CPUContext& ctx, int64_t k, int64_t n, int group_size = -1) {
+    std::mt19937 rng(2024);
+    std::uniform_int_distribution<int> dist(-127, 127);
+    quantized.Resize({n, k});
+    if (group_size > 0) {
+      scale.Resize({(k + group_size - 1) / group_size, n});
+    } else {
+      scale.Resize({n});
+    }
+    dequantized.Resize({k, n});
+    int8_t* q = ctx.Alloc<int8_t>(&quantized);
+    float* s = ctx.Alloc<float>(&scale);
+    float* w = ctx.Alloc<float>(&dequantized);
+    for (int64_t i = 0; i < scale.numel(); ++i) {
+      s[i] = 0.001f * static_cast<float>(i % 7 + 1);
+    }
+    for (int64_t c = 0; c < n; ++c) {
+      for (int64_t r = 0; r < k; ++r) {
+        q[c * k + r] = static_cast<int8_t>(dist(rng));
+        w[r * n + c] =
+            q[c * k + r] * s[group_size > 0 ? r / group_size * n + c : c];
+      }
+    }
+  }
+
+  DenseTensor quantized;
+  DenseTensor scale;
+  DenseTensor dequantized;
+};
+
+static DenseTensor RandomInput(const CPUContext& ctx, int64_t m, int64_t k) {
+  std::mt19937 rng(1);
+  std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+  DenseTensor x;
+  x.Resize({m, k});
+  float* data = ctx.Alloc<float>(&x);
+  for (int64_t i = 0; i < x.numel(); ++i) {
+    data[i] = dist(rng);
+  }
+  return x;
+}
+
+static bool HasAvx512() {
+  return backends::cpu::MayIUse(backends::cpu::avx512f);
+}
+
+TEST(WeightOnlyLinearCPU, MatchesMatmul) {
+  if (!HasAvx512()) {
+    GTEST_SKIP() << "weight_only_linear on cpu needs avx512f";
+  }
+  auto* ctx = static_cast<CPUContext*>(
+      DeviceContextPool::Instance().Get(CPUPlace()));
+  const int64_t k = 256;
+  const int64_t n = 64;
+  Weights weights(*ctx, k, n);
+  for (int64_t m : {1, 5, 67}) {
+    DenseTensor x = RandomInput(*ctx, m, k);
+    DenseTensor out;
+    DenseTensor expected;
+    out.Resize({m, n});
+    expected.Resize({m, n});
+    WeightOnlyLinearKernel<float, CPUContext>(*ctx,
+                                              x,
+                                              weights.quantized,
+                                              paddle::none,
+                                              weights.scale,
+                                              "int8",
+                                              0,
+                                              -1,
+                                              &out);
+    MatmulKernel<float, CPUContext>(
+        *ctx, x, weights.dequantized, false, false, &expected);
+    for (int64_t i = 0; i < out.numel(); ++i) {
+      EXPECT_NEAR(out.data<float>()[i], expected.data<float>()[i], 1e-3);
+    }
+  }
+}
+
+TEST(WeightOnlyLinearCPU, GroupWiseMatchesMatmul) {
+  if (!HasAvx512()) {
+    GTEST_SKIP() << "weight_only_linear on cpu needs avx512f";
+  }
+  auto* ctx = static_cast<CPUContext*>(
+      DeviceContextPool::Instance().Get(CPUPlace()));
+  const int64_t n = 64;
+  // k = 192 leaves a partial last group of 128
+  for (int64_t k : {256, 192}) {
+    Weights weights(*ctx, k, n, 128);
+    DenseTensor x = RandomInput(*ctx, 5, k);
+    DenseTensor out;
+    DenseTensor expected;
+    out.Resize({5, n});
+    expected.Resize({5, n});
+    WeightOnlyLinearKernel<float, CPUContext>(*ctx,
+                                              x,
+                                              weights.quantized,
+                                              paddle::none,
+                                              weights.scale,
+                                              "int8",
+                                              0,
+                                              128,
+                                              &out);
+    MatmulKernel<float, CPUContext>(
+        *ctx, x, weights.dequantized, false, false, &expected);
+    for (int64_t i = 0; i < out.numel(); ++i) {
+      EXPECT_NEAR(out.data<float>()[i], expected.data<float>()[i], 1e-3);
+    }
+  }
+}
+
+// The shapes of a decoding step of a 7B model, where reading the weights
+// dominates. Compared with matmul of the dequantized weights, i.e. sgemm
+// of MKL.
+TEST(WeightOnlyLinearCPU, DISABLED_Benchmark) {
+  if (!HasAvx512()) {
+    GTEST_SKIP() << "weight_only_linear on cpu needs avx512f";
+  }
+  auto* ctx = static_cast<CPUContext*>(
+      DeviceContextPool::Instance().Get(CPUPlace()));
+  const int64_t k = 4096;
+  const int64_t n = 4096;
+  Weights weights(*ctx, k, n);
+  auto time_us = [](const std::function<void()>& run) {
+    run();
+    constexpr int kRepeat = 20;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kRepeat; ++i) {
+      run();
+    }
+    return std::chrono::duration<double, std::micro>(
+               std::chrono::steady_clock::now() - start)
+               .count() /
+           kRepeat;
+  };
+  for (int64_t m : {1, 4, 16, 64}) {
+    DenseTensor x = RandomInput(*ctx, m, k);
+    DenseTensor out;
+    out.Resize({m, n});
+    double weight_only_us = time_us([&]() {
+      WeightOnlyLinearKernel<float, CPUContext>(*ctx,
+                                                x,
+                                                weights.quantized,
+                                                paddle::none,
+                                                weights.scale,
+                                                "int8",
+                                                0,
+                                                -1,
+                                                &out);
+    });
+    double matmul_us = time_us([&]() {
+      MatmulKernel<float, CPUContext>(
+          *ctx, x, weights.dequantized, false, false, &out);
+    });
+    LOG(INFO) << "m " << m << ", k " << k << ", n " << n
+              << ": weight_only_linear int8 " << weight_only_us
+              << " us, matmul " << matmul_us << " us";
+  }
+}
+
+}  // namespace tests
+}  // namespace phi
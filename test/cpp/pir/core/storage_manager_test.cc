@@ -0,0 +1,96 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "paddle/pir/include/core/builtin_attribute.h"
+#include "paddle/pir/include/core/builtin_type.h"
+#include "paddle/pir/include/core/ir_context.h"
+
+namespace {
+constexpr int64_t kNumShapes = 4096;
+
+pir::DenseTensorType GetTensorType(pir::IrContext *ctx, int64_t i) {
+  std::vector<int64_t> dims = {i % 64 + 1, i / 64 + 1};
+  return pir::DenseTensorType::get(ctx,
+                                   pir::Float32Type::get(ctx),
+                                   common::make_ddim(dims),
+                                   common::DataLayout::NCHW,
+                                   pir::LoD(),
+                                   0);
+}
+}  // namespace
+
+TEST(storage_manager_test, concurrent_uniquing) {
+  pir::IrContext *ctx = pir::IrContext::Instance();
+  constexpr int kNumThreads = 8;
+  std::vector<std::vector<pir::Type>> types(kNumThreads);
+  std::vector<std::vector<pir::Attribute>> attrs(kNumThreads);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kNumThreads; ++t) {
+    threads.emplace_back([&, t]() {
+      // Each thread walks the keys in a different order so that lookups and
+      // constructions of the same storage race with each other.
+      for (int64_t n = 0; n < kNumShapes; ++n) {
+        int64_t i = (n * (2 * t + 1)) % kNumShapes;
+        types[t].push_back(GetTensorType(ctx, i));
+        attrs[t].push_back(pir::Int64Attribute::get(ctx, i));
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  for (int t = 0; t < kNumThreads; ++t) {
+    for (int64_t n = 0; n < kNumShapes; ++n) {
+      int64_t i = (n * (2 * t + 1)) % kNumShapes;
+      EXPECT_EQ(types[t][n], GetTensorType(ctx, i));
+      EXPECT_EQ(attrs[t][n], pir::Int64Attribute::get(ctx, i));
+    }
+  }
+}
+
+TEST(storage_manager_test, type_creation_throughput) {
+  pir::IrContext *ctx = pir::IrContext::Instance();
+  // Warm up so that the measured loop only hits existing storages, which is
+  // the common case during translation and pass execution.
+  for (int64_t i = 0; i < kNumShapes; ++i) {
+    GetTensorType(ctx, i);
+  }
+  constexpr int64_t kIters = 200000;
+  for (int num_threads : {1, 2, 4, 8}) {
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; ++t) {
+      threads.emplace_back([ctx, t]() {
+        for (int64_t n = 0; n < kIters; ++n) {
+          GetTensorType(ctx, (n + t) % kNumShapes);
+        }
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    double seconds = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+    LOG(INFO) << "DenseTensorType::get with " << num_threads
+              << " threads: " << kIters * num_threads / seconds / 1e6
+              << " M lookups/s";
+  }
+}
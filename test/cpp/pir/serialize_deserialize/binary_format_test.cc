@@ -0,0 +1,159 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "paddle/fluid/framework/program_desc.h"
+#include "paddle/fluid/ir_adaptor/translator/translate.h"
+#include "paddle/fluid/pir/dialect/operator/ir/op_dialect.h"
+#include "paddle/fluid/pir/serialize_deserialize/include/binary_format.h"
+#include "paddle/fluid/pir/serialize_deserialize/include/interface.h"
+#include "paddle/pir/include/core/builtin_dialect.h"
+#include "paddle/pir/include/core/program.h"
+
+using ProgramDesc = paddle::framework::ProgramDesc;
+using VarType = paddle::framework::proto::VarType;
+
+// A chain of num_ops scale ops on a parameter.
+static ProgramDesc BuildScaleChain(int num_ops) {
+  ProgramDesc program_desc;
+  auto* block = program_desc.MutableBlock(0);
+  auto add_var = [&](const std::string& name) {
+    auto* var = block->Var(name);
+    var->SetType(VarType::LOD_TENSOR);
+    var->SetDataType(VarType::FP32);
+    var->SetShape({-1, 128});
+    return var;
+  };
+  add_var("x")->SetPersistable(true);
+  std::string in = "x";
+  for (int i = 0; i < num_ops; ++i) {
+    std::string out = "scale_" + std::to_string(i) + ".tmp_0";
+    add_var(out);
+    auto* op = block->AppendOp();
+    op->SetType("scale");
+    op->SetInput("X", {in});
+    op->SetOutput("Out", {out});
+    op->SetAttr("scale", 1.5f);
+    op->SetAttr("bias", 0.25f);
+    op->SetAttr("bias_after_scale", true);
+    in = out;
+  }
+  return program_desc;
+}
+
+static std::string ReadFile(const std::string& file_path) {
+  std::ifstream fin(file_path, std::ios::in | std::ios::binary);
+  std::stringstream ss;
+  ss << fin.rdbuf();
+  return ss.str();
+}
+
+static std::string PrintProgram(const pir::Program& program) {
+  std::stringstream ss;
+  program.Print(ss);
+  return ss.str();
+}
+
+TEST(BinaryFormatTest, json_round_trip) {
+  Json json = {{"s", "str"},
+               {"i", -42},
+               {"u", uint64_t(1) << 63},
+               {"f", 0.1},
+               {"b", true},
+               {"n", nullptr},
+               {"a", Json::array({"str", 1, Json::array(), Json::object()})}};
+  std::string content = pir::EncodeBinaryModule(json);
+  EXPECT_TRUE(pir::IsBinaryModule(content));
+  EXPECT_FALSE(pir::IsBinaryModule(json.dump()));
+  EXPECT_EQ(pir::DecodeBinaryModule(content), json);
+  EXPECT_ANY_THROW(
+      pir::DecodeBinaryModule(content.substr(0, content.size() - 1)));
+}
+
+TEST(BinaryFormatTest, float_byte_order) {
+  // floats are stored little endian on every host, 1.0 is 0x3ff0000000000000
+  std::string content = pir::EncodeBinaryModule(Json(1.0));
+  ASSERT_GE(content.size(), 8UL);
+  EXPECT_EQ(content.substr(content.size() - 8),
+            std::string("\x00\x00\x00\x00\x00\x00\xf0\x3f", 8));
+  EXPECT_EQ(pir::DecodeBinaryModule(content), Json(1.0));
+}
+
+TEST(BinaryFormatTest, nesting_depth) {
+  Json json = nullptr;
+  for (int i = 0; i < 100; ++i) {
+    json = Json::array({json});
+  }
+  EXPECT_EQ(pir::DecodeBinaryModule(pir::EncodeBinaryModule(json)), json);
+
+  // a corrupt file of deeply nested arrays is rejected, instead of
+  // overflowing the stack
+  std::string content = pir::EncodeBinaryModule(Json(nullptr));
+  content.pop_back();
+  for (int i = 0; i < 1000000; ++i) {
+    content.push_back(7);  // an array
+    content.push_back(1);  // of 1 value
+  }
+  content.push_back(0);
+  EXPECT_ANY_THROW(pir::DecodeBinaryModule(content));
+}
+
+TEST(BinaryFormatTest, load_time) {
+  pir::IrContext* ctx = pir::IrContext::Instance();
+  ctx->GetOrRegisterDialect<paddle::dialect::OperatorDialect>();
+  ctx->GetOrRegisterDialect<pir::BuiltinDialect>();
+
+  constexpr int kNumOps = 20000;
+  std::string proto_str;
+  BuildScaleChain(kNumOps).Proto()->SerializeToString(&proto_str);
+
+  auto start = std::chrono::steady_clock::now();
+  auto program =
+      paddle::TranslateLegacyProgramToProgram(ProgramDesc(proto_str));
+  auto end = std::chrono::steady_clock::now();
+  double proto_ms =
+      std::chrono::duration<double, std::milli>(end - start).count();
+
+  pir::WriteModule(*program, "./scale_chain.json", 1, true, false, true);
+  pir::WriteModule(
+      *program, "./scale_chain.pirb", 1, true, false, true, /*binary*/ true);
+
+  pir::Program json_program(ctx);
+  start = std::chrono::steady_clock::now();
+  pir::ReadModule("./scale_chain.json", &json_program, 1);
+  end = std::chrono::steady_clock::now();
+  double json_ms =
+      std::chrono::duration<double, std::milli>(end - start).count();
+
+  pir::Program binary_program(ctx);
+  start = std::chrono::steady_clock::now();
+  pir::ReadModule("./scale_chain.pirb", &binary_program, 1);
+  end = std::chrono::steady_clock::now();
+  double binary_ms =
+      std::chrono::duration<double, std::milli>(end - start).count();
+
+  EXPECT_EQ(binary_program.block()->size(), program->block()->size());
+  EXPECT_EQ(PrintProgram(binary_program), PrintProgram(json_program));
+  std::cout << program->block()->size() << " ops, protobuf "
+            << proto_str.size() << " bytes " << proto_ms << " ms, json "
+            << ReadFile("./scale_chain.json").size() << " bytes " << json_ms
+            << " ms, binary " << ReadFile("./scale_chain.pirb").size()
+            << " bytes " << binary_ms << " ms" << std::endl;
+}
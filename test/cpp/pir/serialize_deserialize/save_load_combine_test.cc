@@ -0,0 +1,88 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+#include "paddle/fluid/pir/serialize_deserialize/include/interface.h"
+#include "paddle/phi/common/place.h"
+#include "paddle/phi/core/dense_tensor.h"
+
+static phi::DenseTensor MakeTensor(const std::vector<int64_t>& shape,
+                                   float start) {
+  phi::DenseTensor tensor;
+  tensor.Resize(common::make_ddim(shape));
+  float* data = tensor.mutable_data<float>(phi::CPUPlace());
+  for (int64_t i = 0; i < tensor.numel(); ++i) {
+    data[i] = start + static_cast<float>(i);
+  }
+  return tensor;
+}
+
+static void ExpectTensorEqual(const phi::DenseTensor& x,
+                              const phi::DenseTensor& y) {
+  ASSERT_EQ(x.dims(), y.dims());
+  ASSERT_EQ(x.dtype(), y.dtype());
+  for (int64_t i = 0; i < x.numel(); ++i) {
+    EXPECT_EQ(x.data<float>()[i], y.data<float>()[i]);
+  }
+}
+
+TEST(SaveLoadCombine, load_all_in_saved_order) {
+  // The predictor saves and loads the parameters in the order of their
+  // names, so "linear_10" comes before "linear_2".
+  std::vector<std::string> names = {"linear_10.w_0", "linear_2.b_0", "x"};
+  std::vector<phi::DenseTensor> tensors = {
+      MakeTensor({2, 3}, 0.f), MakeTensor({3}, 10.f), MakeTensor({4, 1}, 20.f)};
+  std::vector<const phi::DenseTensor*> to_save;
+  for (auto& tensor : tensors) {
+    to_save.push_back(&tensor);
+  }
+  const std::string path = "./save_load_combine_test.pdiparams";
+  pir::SaveCombineFunction(to_save, names, path, true, false, false);
+
+  // without the names
+  std::vector<phi::DenseTensor> loaded;
+  pir::LoadCombineFunction(path, &loaded, false, phi::CPUPlace());
+  ASSERT_EQ(loaded.size(), tensors.size());
+  for (size_t i = 0; i < tensors.size(); ++i) {
+    ExpectTensorEqual(loaded[i], tensors[i]);
+  }
+
+  // the same tensors as loading them by names
+  std::vector<phi::DenseTensor> by_names(names.size());
+  std::vector<phi::DenseTensor*> out;
+  for (auto& tensor : by_names) {
+    out.push_back(&tensor);
+  }
+  pir::LoadCombineFunction(path, names, &out, false, phi::CPUPlace());
+  for (size_t i = 0; i < tensors.size(); ++i) {
+    ExpectTensorEqual(loaded[i], by_names[i]);
+  }
+
+  // the previous content of out is dropped, and fp16 is honored
+  pir::LoadCombineFunction(path, &loaded, true, phi::CPUPlace());
+  ASSERT_EQ(loaded.size(), tensors.size());
+  for (size_t i = 0; i < tensors.size(); ++i) {
+    EXPECT_EQ(loaded[i].dims(), tensors[i].dims());
+    EXPECT_EQ(loaded[i].dtype(), phi::DataType::FLOAT16);
+  }
+}
+
+TEST(SaveLoadCombine, load_all_from_missing_file) {
+  std::vector<phi::DenseTensor> loaded;
+  EXPECT_ANY_THROW(pir::LoadCombineFunction(
+      "./save_load_combine_test_missing", &loaded, false, phi::CPUPlace()));
+}
@@ -0,0 +1,139 @@
+# Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+import glob
+import os
+import tempfile
+import unittest
+
+import numpy as np
+
+import paddle
+from paddle.inference import Config, create_predictor
+
+
+class TestNet(paddle.nn.Layer):
+    def __init__(self):
+        super().__init__()
+        self.fc1 = paddle.nn.Linear(4, 4)
+        self.fc2 = paddle.nn.Linear(4, 4)
+
+    def forward(self, x):
+        return self.fc2(paddle.nn.functional.relu(self.fc1(x)))
+
+
+class TestOptimizedPirModelCache(unittest.TestCase):
+    def setUp(self):
+        self.temp_dir = tempfile.TemporaryDirectory()
+        self.path_prefix = os.path.join(self.temp_dir.name, 'model/inference')
+        self.cache_dir = os.path.join(self.temp_dir.name, 'cache')
+        paddle.seed(2024)
+        self.net = TestNet()
+        self.input = np.random.random([2, 4]).astype(np.float32)
+
+    def tearDown(self):
+        self.temp_dir.cleanup()
+
+    def save_model(self):
+        with paddle.pir_utils.DygraphPirGuard():
+            model = paddle.jit.to_static(
+                self.net,
+                input_spec=[
+                    paddle.static.InputSpec(
+                        shape=[None, 4], dtype='float32', name='x'
+                    )
+                ],
+                full_graph=True,
+            )
+            paddle.jit.save(model, self.path_prefix)
+
+    def create_predictor(self, use_optimized_model=True):
+        config = Config(
+            self.path_prefix + '.json', self.path_prefix + '.pdiparams'
+        )
+        config.disable_gpu()
+        config.enable_new_executor()
+        config.enable_new_ir()
+        if use_optimized_model:
+            config.set_optim_cache_dir(self.cache_dir)
+            config.use_optimized_model(True)
+        return create_predictor(config)
+
+    def run_predictor(self, use_optimized_model=True, predictor=None):
+        if predictor is None:
+            predictor = self.create_predictor(use_optimized_model)
+        outputs = predictor.run([paddle.to_tensor(self.input)])
+        return outputs[0].numpy()
+
+    def snapshots(self):
+        return sorted(glob.glob(os.path.join(self.cache_dir, '_optimized_*')))
+
+    def test_warm_start(self):
+        self.save_model()
+        cold_output = self.run_predictor()
+        snapshots = self.snapshots()
+        self.assertEqual(len(snapshots), 2)
+
+        # a hit reuses the snapshot
+        warm_output = self.run_predictor()
+        self.assertEqual(self.snapshots(), snapshots)
+        np.testing.assert_allclose(cold_output, warm_output, rtol=1e-6)
+
+        # retrained params with the same shapes miss the cache
+        with paddle.no_grad():
+            for param in self.net.parameters():
+                param.set_value(param * 2.0 + 1.0)
+        self.save_model()
+        retrained_output = self.run_predictor()
+        self.assertEqual(len(self.snapshots()), 4)
+        np.testing.assert_allclose(
+            retrained_output,
+            self.run_predictor(use_optimized_model=False),
+            rtol=1e-6,
+        )
+        self.assertFalse(np.allclose(retrained_output, cold_output))
+
+    def test_files_hash_sidecar(self):
+        self.save_model()
+        self.run_predictor()
+        sidecars = glob.glob(os.path.join(self.cache_dir, '_model_files_*'))
+        self.assertEqual(len(sidecars), 1)
+        with open(sidecars[0]) as f:
+            fingerprint, files_hash = f.read().split('\n')[:2]
+        self.assertIn(self.path_prefix + '.pdiparams', fingerprint)
+
+        # a warm start reuses the hash of unchanged files
+        self.run_predictor()
+        with open(sidecars[0]) as f:
+            self.assertEqual(
+                f.read().split('\n')[:2], [fingerprint, files_hash]
+            )
+
+    def test_clone_keeps_key(self):
+        self.save_model()
+        cold_output = self.run_predictor()
+        snapshots = self.snapshots()
+
+        # the predictor of a hit points at the snapshot, its clones keep the
+        # key of the original model instead of hashing the snapshot
+        predictor = self.create_predictor()
+        clone = predictor.clone()
+        np.testing.assert_allclose(
+            self.run_predictor(predictor=clone), cold_output, rtol=1e-6
+        )
+        self.assertEqual(self.snapshots(), snapshots)
+
+
+if __name__ == '__main__':
+    unittest.main()
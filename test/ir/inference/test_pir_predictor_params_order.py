@@ -0,0 +1,85 @@
+# Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+import os
+import tempfile
+import unittest
+
+import numpy as np
+
+import paddle
+from paddle.inference import Config, create_predictor
+
+
+class TestNet(paddle.nn.Layer):
+    def __init__(self):
+        super().__init__()
+        # more than 10 layers of the same shape, so that the order of the
+        # parameter names differs from the order they are created in
+        self.fcs = paddle.nn.LayerList(
+            [paddle.nn.Linear(4, 4) for _ in range(12)]
+        )
+
+    def forward(self, x):
+        for fc in self.fcs:
+            x = paddle.nn.functional.relu(fc(x))
+        return x
+
+
+class TestPirPredictorParamsOrder(unittest.TestCase):
+    def setUp(self):
+        self.temp_dir = tempfile.TemporaryDirectory()
+        self.path_prefix = os.path.join(self.temp_dir.name, 'model/inference')
+        paddle.seed(2024)
+        self.net = TestNet()
+        with paddle.no_grad():
+            for i, param in enumerate(self.net.parameters()):
+                param.set_value(param + 0.1 * i)
+        self.input = np.random.random([2, 4]).astype(np.float32)
+
+    def tearDown(self):
+        self.temp_dir.cleanup()
+
+    def test_params_order(self):
+        with paddle.pir_utils.DygraphPirGuard():
+            model = paddle.jit.to_static(
+                self.net,
+                input_spec=[
+                    paddle.static.InputSpec(
+                        shape=[None, 4], dtype='float32', name='x'
+                    )
+                ],
+                full_graph=True,
+            )
+            paddle.jit.save(model, self.path_prefix)
+        expected = self.net(paddle.to_tensor(self.input)).numpy()
+
+        # the params file is read while the program is read, and its tensors
+        # are given to the parameters in the order of their names
+        config = Config(
+            self.path_prefix + '.json', self.path_prefix + '.pdiparams'
+        )
+        config.disable_gpu()
+        config.enable_new_executor()
+        config.enable_new_ir()
+        config.switch_ir_optim(False)
+        predictor = create_predictor(config)
+        outputs = predictor.run([paddle.to_tensor(self.input)])
+        np.testing.assert_allclose(
+            outputs[0].numpy(), expected, rtol=1e-5, atol=1e-6
+        )
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,89 @@
+# Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+# Decoding throughput of the cpu masked_multihead_attention kernel against
+# matmul + softmax + matmul over the same cache, for one decoder layer.
+#   python benchmark_masked_multihead_attention_cpu.py --kv_num_head 8
+
+import argparse
+import time
+
+import paddle
+from paddle.incubate.nn.functional import masked_multihead_attention
+
+
+def parse_args():
+    parser = argparse.ArgumentParser()
+    parser.add_argument('--bsz', type=int, default=1)
+    parser.add_argument('--num_head', type=int, default=32)
+    parser.add_argument('--kv_num_head', type=int, default=32)
+    parser.add_argument('--dim_head', type=int, default=128)
+    parser.add_argument('--num_layers', type=int, default=32)
+    parser.add_argument(
+        '--context_lengths', type=str, default='128,512,2048,8192'
+    )
+    parser.add_argument('--dtype', type=str, default='float32')
+    parser.add_argument('--repeat', type=int, default=20)
+    return parser.parse_args()
+
+
+def timeit(func, repeat):
+    func()
+    start = time.perf_counter()
+    for _ in range(repeat):
+        func()
+    return (time.perf_counter() - start) / repeat
+
+
+def main():
+    args = parse_args()
+    paddle.set_device('cpu')
+    group = args.num_head // args.kv_num_head
+    heads = args.num_head + 2 * args.kv_num_head
+    print(
+        f"bsz {args.bsz}, num_head {args.num_head}, kv_num_head "
+        f"{args.kv_num_head}, dim_head {args.dim_head}, {args.dtype}"
+    )
+    for context in [int(c) for c in args.context_lengths.split(',')]:
+        x = paddle.randn([args.bsz, heads * args.dim_head]).astype(args.dtype)
+        cache_kv = paddle.randn(
+            [2, args.bsz, args.kv_num_head, context + 1, args.dim_head]
+        ).astype(args.dtype)
+        src_mask = paddle.zeros([args.bsz, 1, 1, context + 1], args.dtype)
+
+        def fused():
+            masked_multihead_attention(x, cache_kv, src_mask=src_mask)
+
+        q = x.reshape([args.bsz, heads, 1, args.dim_head])[:, : args.num_head]
+        cache_k = cache_kv[0].repeat_interleave(group, axis=1)
+        cache_v = cache_kv[1].repeat_interleave(group, axis=1)
+
+        def unfused():
+            qk = paddle.matmul(q, cache_k, transpose_y=True)
+            qk = qk * (args.dim_head**-0.5) + src_mask
+            paddle.matmul(paddle.nn.functional.softmax(qk, -1), cache_v)
+
+        fused_time = timeit(fused, args.repeat)
+        unfused_time = timeit(unfused, args.repeat)
+        tokens_per_second = args.bsz / (fused_time * args.num_layers)
+        print(
+            f"context {context}: fused {fused_time * 1000:.3f} ms, "
+            f"unfused {unfused_time * 1000:.3f} ms, "
+            f"{tokens_per_second:.1f} tokens/s over {args.num_layers} "
+            "layers of attention"
+        )
+
+
+if __name__ == '__main__':
+    main()
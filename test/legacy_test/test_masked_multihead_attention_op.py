@@ -496,5 +496,212 @@ class TestLayerNormStaticInt8Op(unittest.TestCase):
         )
 
 
+class TestMMHAOpCPU(unittest.TestCase):
+    def setUp(self):
+        np.random.seed(0)
+        self.bsz = 3
+        self.num_head = 8
+        self.kv_num_head = 2
+        self.dim_head = 64
+        self.max_seq_len = 80
+        self.sequence_lengths = [70, 45, 3]
+        self.dtype = 'float32'
+        self.rotary_emb_dims = 0
+        self.use_neox_rotary_style = False
+        self.num_threads = None
+        self.atol = 1e-5
+        self.config()
+
+    def config(self):
+        pass
+
+    def tearDown(self):
+        if self.num_threads is not None:
+            core.set_num_threads(
+                paddle.get_flags('FLAGS_paddle_num_threads')[
+                    'FLAGS_paddle_num_threads'
+                ]
+            )
+
+    def round_to_dtype(self, array):
+        # the values the kernel sees in its dtype, as float32
+        return (
+            paddle.to_tensor(array, dtype='float32')
+            .astype(self.dtype)
+            .astype('float32')
+            .numpy()
+        )
+
+    def apply_rotary(self, head, cos, sin):
+        if self.rotary_emb_dims == 0:
+            return head
+        out = np.empty_like(head)
+        if not self.use_neox_rotary_style:
+            out[0::2] = head[0::2] * cos[0::2] - head[1::2] * sin[0::2]
+            out[1::2] = head[1::2] * cos[1::2] + head[0::2] * sin[1::2]
+        else:
+            last_dim = self.dim_head // self.rotary_emb_dims
+            half = last_dim // 2
+            for start in range(0, self.dim_head, last_dim):
+                left = head[start : start + half]
+                right = head[start + half : start + last_dim]
+                rotated = np.concatenate([-right, left])
+                out[start : start + last_dim] = (
+                    head[start : start + last_dim]
+                    * cos[start : start + last_dim]
+                    + rotated * sin[start : start + last_dim]
+                )
+        return out
+
+    def mmha_naive(self, x, bias, cache_kv, src_mask, rotary):
+        # cache_k of the kernel is [bsz, kv_num_head, dim_head / c,
+        # max_seq_len, c] with c = 16 / sizeof(dtype)
+        c = 8 if self.dtype == 'bfloat16' else 4
+        cache_k = cache_kv[0].reshape(
+            [
+                self.bsz,
+                self.kv_num_head,
+                self.dim_head // c,
+                self.max_seq_len,
+                c,
+            ]
+        )
+        cache_k = cache_k.transpose([0, 1, 3, 2, 4]).reshape(
+            [self.bsz, self.kv_num_head, self.max_seq_len, self.dim_head]
+        )
+        cache_v = cache_kv[1]
+        x = x.reshape([self.bsz, -1, self.dim_head]) + bias.reshape(
+            [-1, self.dim_head]
+        )
+        group = self.num_head // self.kv_num_head
+        q = x[:, : self.num_head]
+        k = x[:, self.num_head : self.num_head + self.kv_num_head]
+        v = x[:, self.num_head + self.kv_num_head :]
+        out = np.zeros([self.bsz, self.num_head, self.dim_head])
+        for b, t in enumerate(self.sequence_lengths):
+            cos = rotary[0, b, 0, 0]
+            sin = rotary[1, b, 0, 0]
+            for h in range(self.num_head):
+                kv_h = h // group
+                new_k = self.apply_rotary(k[b, kv_h], cos, sin)
+                keys = np.concatenate([cache_k[b, kv_h, :t], new_k[None]])
+                values = np.concatenate(
+                    [cache_v[b, kv_h, :t], v[b, kv_h][None]]
+                )
+                qk = (
+                    keys
+                    @ self.apply_rotary(q[b, h], cos, sin)
+                    / np.sqrt(self.dim_head)
+                )
+                qk = qk + src_mask[b, 0, 0, : t + 1]
+                p = np.exp(qk - qk.max())
+                out[b, h] = p @ values / p.sum()
+        return out.reshape([self.bsz, -1])
+
+    def test_mmha_cpu(self):
+        paddle.disable_static(paddle.CPUPlace())
+        if self.num_threads is not None:
+            core.set_num_threads(self.num_threads)
+        heads = self.num_head + 2 * self.kv_num_head
+        x = self.round_to_dtype(
+            np.random.uniform(-1, 1, [self.bsz, heads * self.dim_head])
+        )
+        bias = self.round_to_dtype(
+            np.random.uniform(-0.1, 0.1, [heads * self.dim_head])
+        )
+        cache_kv = self.round_to_dtype(
+            np.random.uniform(
+                -1,
+                1,
+                [
+                    2,
+                    self.bsz,
+                    self.kv_num_head,
+                    self.max_seq_len,
+                    self.dim_head,
+                ],
+            )
+        )
+        src_mask = np.zeros([self.bsz, 1, 1, self.max_seq_len])
+        src_mask[:, :, :, 1::5] = -10000.0
+        # cos and sin of the rotary embedding, [2, bsz, 1, 1, dim_head]
+        angles = np.random.uniform(
+            -np.pi, np.pi, [1, self.bsz, 1, 1, self.dim_head]
+        )
+        rotary = np.concatenate([np.cos(angles), np.sin(angles)]).astype(
+            'float32'
+        )
+        out_expect = self.mmha_naive(x, bias, cache_kv, src_mask, rotary)
+
+        cache_kv_tensor = paddle.to_tensor(cache_kv).astype(self.dtype)
+        out = masked_multihead_attention(
+            paddle.to_tensor(x).astype(self.dtype),
+            cache_kv_tensor,
+            paddle.to_tensor(bias).astype(self.dtype),
+            paddle.to_tensor(src_mask, dtype=self.dtype),
+            sequence_lengths=paddle.to_tensor(
+                self.sequence_lengths, dtype='int32'
+            ),
+            rotary_tensor=(
+                paddle.to_tensor(rotary) if self.rotary_emb_dims > 0 else None
+            ),
+            rotary_emb_dims=self.rotary_emb_dims,
+            use_neox_rotary_style=self.use_neox_rotary_style,
+        )[0]
+        np.testing.assert_allclose(
+            out.astype('float32').numpy(),
+            out_expect,
+            rtol=self.atol,
+            atol=self.atol,
+        )
+        # the new value is appended to the cache
+        v = (x + bias).reshape([self.bsz, heads, self.dim_head])
+        for b, t in enumerate(self.sequence_lengths):
+            np.testing.assert_allclose(
+                cache_kv_tensor.astype('float32').numpy()[1, b, :, t],
+                v[b, self.num_head + self.kv_num_head :],
+                rtol=self.atol,
+                atol=self.atol,
+            )
+        paddle.enable_static()
+
+
+class TestMMHAOpCPUSplitSeq(TestMMHAOpCPU):
+    # one group of heads and more threads than groups, so a sequence longer
+    # than kSplitSteps is split over the threads and the splits are merged
+    def config(self):
+        self.bsz = 1
+        self.num_head = 4
+        self.kv_num_head = 1
+        self.max_seq_len = 1100
+        self.sequence_lengths = [1000]
+        self.num_threads = 4
+
+
+class TestMMHAOpCPUBF16(TestMMHAOpCPU):
+    def config(self):
+        self.dtype = 'bfloat16'
+        self.atol = 2e-2
+
+
+class TestMMHAOpCPURotary(TestMMHAOpCPU):
+    def config(self):
+        self.rotary_emb_dims = 1
+
+
+class TestMMHAOpCPUNeoxRotary(TestMMHAOpCPU):
+    def config(self):
+        self.rotary_emb_dims = 1
+        self.use_neox_rotary_style = True
+
+
+class TestMMHAOpCPUBF16SplitSeqRotary(TestMMHAOpCPUSplitSeq):
+    def config(self):
+        super().config()
+        self.dtype = 'bfloat16'
+        self.rotary_emb_dims = 1
+        self.atol = 2e-2
+
+
 if __name__ == '__main__':
     unittest.main()
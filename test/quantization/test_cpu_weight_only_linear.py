@@ -0,0 +1,121 @@
+# Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+import unittest
+
+import numpy as np
+
+import paddle
+import paddle.nn.quant as Q
+from paddle.base import core
+
+
+@unittest.skipIf(
+    paddle.version.mkl() != 'ON'
+    or not core.is_compiled_with_avx()
+    or not core.supports_avx512f(),
+    "the cpu kernel of weight_only_linear requires MKL and avx512f",
+)
+class WeightOnlyLinearCPUTestCase(unittest.TestCase):
+    def setUp(self):
+        self.place = paddle.get_device()
+        paddle.set_device('cpu')
+        self.token = 5
+        self.in_features = 256
+        self.out_features = 128
+
+    def tearDown(self):
+        paddle.set_device(self.place)
+
+    def check(self, algo, weight_dtype, group_size, arch=0):
+        x = paddle.randn([2, self.token, self.in_features], dtype='float32')
+        weight = paddle.randn(
+            [self.in_features, self.out_features], dtype='float32'
+        )
+        bias = paddle.randn([self.out_features], dtype='float32')
+        quant_weight, quant_scale = Q.weight_quantize(
+            x=weight, algo=algo, arch=arch, group_size=group_size
+        )
+        self.assertEqual(quant_weight.dtype, paddle.int8)
+        if weight_dtype == "int8":
+            self.assertEqual(
+                quant_weight.shape, [self.out_features, self.in_features]
+            )
+        else:
+            self.assertEqual(
+                quant_weight.shape, [self.out_features // 2, self.in_features]
+            )
+
+        # dequantize with numpy by the layout of arch 0
+        w = quant_weight.numpy().astype('int32')
+        if weight_dtype == "int4":
+            low = (w << 28) >> 28
+            high = w >> 4
+            w = np.stack([low, high], axis=1).reshape(
+                [self.out_features, self.in_features]
+            )
+        scale = quant_scale.numpy()
+        if group_size == -1:
+            dequant_weight = w.T * scale
+        else:
+            # the last group is partial if in_features is not a multiple
+            # of group_size
+            dequant_weight = (
+                w.T
+                * np.repeat(scale, group_size, axis=0)[: self.in_features]
+            )
+
+        out = Q.weight_only_linear(
+            x,
+            quant_weight,
+            bias=bias,
+            weight_scale=quant_scale,
+            weight_dtype=weight_dtype,
+            arch=arch,
+            group_size=group_size,
+        )
+        self.assertTrue(out.place.is_cpu_place())
+        out_expect = np.matmul(x.numpy(), dequant_weight) + bias.numpy()
+        np.testing.assert_allclose(out, out_expect, rtol=1e-4, atol=1e-4)
+        # the rounding error is at most half of the scale
+        np.testing.assert_allclose(
+            dequant_weight,
+            weight.numpy(),
+            rtol=0,
+            atol=0.05 if weight_dtype == "int8" else 0.5,
+        )
+
+    def test_int8(self):
+        self.check("weight_only_int8", "int8", -1)
+
+    def test_int4(self):
+        self.check("weight_only_int4", "int4", -1)
+
+    def test_int8_group(self):
+        self.check("weight_only_int8", "int8", 64)
+
+    def test_int4_group(self):
+        self.check("weight_only_int4", "int4", 128)
+
+    def test_int8_partial_group(self):
+        self.in_features = 192
+        self.check("weight_only_int8", "int8", 128)
+
+    def test_default_arch(self):
+        # arch 0 is taken on the cpu
+        self.check("weight_only_int8", "int8", -1, arch=None)
+
+
+if __name__ == '__main__':
+    unittest.main()